@@ -0,0 +1,122 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// @dart=2.9
+
+// Measures asynchronous RandomAccessFile operations, which are performed
+// with io_uring where it is available. Run with --disable-io-uring to measure
+// them through the IO service.
+
+import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:benchmark_harness/benchmark_harness.dart'
+    show PrintEmitter, ScoreEmitter;
+
+// Number of operations per run.
+const int operations = 100;
+const int fileSize = operations * 4096;
+
+enum Operation { readInto, writeFrom, flush }
+
+class FileIOBenchmark extends AsyncBenchmarkBase {
+  FileIOBenchmark(String name, this.operation, this.size) : super(name);
+
+  @override
+  Future<void> run() async {
+    await file.setPosition(0);
+    switch (operation) {
+      case Operation.readInto:
+        for (int i = 0; i < operations; i++) {
+          await file.readInto(buffer);
+        }
+        break;
+      case Operation.writeFrom:
+        for (int i = 0; i < operations; i++) {
+          await file.writeFrom(buffer);
+        }
+        break;
+      case Operation.flush:
+        for (int i = 0; i < operations; i++) {
+          await file.flush();
+        }
+        break;
+    }
+  }
+
+  @override
+  Future<void> setup() async {
+    directory = await Directory.systemTemp.createTemp('FileIO');
+    final path = '${directory.path}/data';
+    await File(path).writeAsBytes(Uint8List(fileSize));
+    file = await File(path).open(mode: FileMode.append);
+    buffer = Uint8List(size);
+  }
+
+  @override
+  Future<void> teardown() async {
+    await file.close();
+    await directory.delete(recursive: true);
+  }
+
+  final Operation operation;
+  final int size;
+  Directory directory;
+  RandomAccessFile file;
+  Uint8List buffer;
+}
+
+// Identical to BenchmarkBase from package:benchmark_harness but async.
+abstract class AsyncBenchmarkBase {
+  final String name;
+  final ScoreEmitter emitter;
+
+  Future<void> run();
+  Future<void> setup();
+  Future<void> teardown();
+
+  const AsyncBenchmarkBase(this.name, {this.emitter = const PrintEmitter()});
+
+  // Returns the number of microseconds per call.
+  Future<double> measureFor(int minimumMillis) async {
+    final minimumMicros = minimumMillis * 1000;
+    int iter = 0;
+    final watch = Stopwatch();
+    watch.start();
+    int elapsed = 0;
+    while (elapsed < minimumMicros) {
+      await run();
+      elapsed = watch.elapsedMicroseconds;
+      iter++;
+    }
+    return elapsed / iter;
+  }
+
+  // Measures the score for the benchmark and returns it.
+  Future<double> measure() async {
+    await setup();
+    await measureFor(500); // warm-up
+    final result = await measureFor(4000); // actual measurement
+    await teardown();
+    return result;
+  }
+
+  Future<void> report() async {
+    emitter.emit(name, await measure());
+  }
+}
+
+Future<void> main() async {
+  final benchmarks = [
+    FileIOBenchmark('FileIO.ReadInto64B', Operation.readInto, 64),
+    FileIOBenchmark('FileIO.ReadInto4KB', Operation.readInto, 4096),
+    FileIOBenchmark('FileIO.WriteFrom64B', Operation.writeFrom, 64),
+    FileIOBenchmark('FileIO.WriteFrom4KB', Operation.writeFrom, 4096),
+    FileIOBenchmark('FileIO.Flush', Operation.flush, 0),
+  ];
+  for (final benchmark in benchmarks) {
+    await benchmark.report();
+  }
+}
@@ -8,6 +8,7 @@
 #include "bin/directory.h"
 #include "bin/eventhandler.h"
 #include "bin/io_natives.h"
+#include "bin/io_uring.h"
 #include "bin/platform.h"
 #include "bin/process.h"
 #if !defined(DART_IO_SECURE_SOCKET_DISABLED)
@@ -27,9 +28,11 @@ void BootstrapDartIo() {
   SSLFilter::Init();
 #endif
   EventHandler::Start();
+  IOUring::Init();
 }
 
 void CleanupDartIo() {
+  IOUring::Cleanup();
   EventHandler::Stop();
 #if !defined(DART_IO_SECURE_SOCKET_DISABLED)
   SSLFilter::Cleanup();
@@ -15,6 +15,8 @@
 namespace dart {
 namespace bin {
 
+intptr_t EventHandler::thread_count_ = 1;
+
 static EventHandler* event_handler = NULL;
 static Monitor* shutdown_monitor = NULL;
 
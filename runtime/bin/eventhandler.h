@@ -626,10 +626,18 @@ class EventHandler {
 
   static void SendFromNative(intptr_t id, Dart_Port port, int64_t data);
 
+  // The number of threads polling for events. Only used on Linux, where the
+  // file descriptors are sharded across the threads. Must be set before
+  // Start.
+  static intptr_t thread_count() { return thread_count_; }
+  static void set_thread_count(intptr_t count) { thread_count_ = count; }
+
  private:
   friend class EventHandlerImplementation;
   EventHandlerImplementation delegate_;
 
+  static intptr_t thread_count_;
+
   DISALLOW_COPY_AND_ASSIGN(EventHandler);
 };
 
@@ -68,8 +68,11 @@ static void AddToEpollInstance(intptr_t epoll_fd_, DescriptorInfo* di) {
   }
 }
 
-EventHandlerImplementation::EventHandlerImplementation()
-    : socket_map_(&SimpleHashMap::SamePointerValue, 16) {
+EventHandlerLoop::EventHandlerLoop(EventHandlerImplementation* owner,
+                                   intptr_t index)
+    : owner_(owner),
+      index_(index),
+      socket_map_(&SimpleHashMap::SamePointerValue, 16) {
   intptr_t result;
   result = NO_RETRY_EXPECTED(pipe(interrupt_fds_));
   if (result != 0) {
@@ -125,7 +128,7 @@ static void DeleteDescriptorInfo(void* info) {
   delete di;
 }
 
-EventHandlerImplementation::~EventHandlerImplementation() {
+EventHandlerLoop::~EventHandlerLoop() {
   socket_map_.Clear(DeleteDescriptorInfo);
   close(epoll_fd_);
   close(timer_fd_);
@@ -133,8 +136,8 @@ EventHandlerImplementation::~EventHandlerImplementation() {
   close(interrupt_fds_[1]);
 }
 
-void EventHandlerImplementation::UpdateEpollInstance(intptr_t old_mask,
-                                                     DescriptorInfo* di) {
+void EventHandlerLoop::UpdateEpollInstance(intptr_t old_mask,
+                                           DescriptorInfo* di) {
   intptr_t new_mask = di->Mask();
   if ((old_mask != 0) && (new_mask == 0)) {
     RemoveFromEpollInstance(epoll_fd_, di);
@@ -147,9 +150,8 @@ void EventHandlerImplementation::UpdateEpollInstance(intptr_t old_mask,
   }
 }
 
-DescriptorInfo* EventHandlerImplementation::GetDescriptorInfo(
-    intptr_t fd,
-    bool is_listening) {
+DescriptorInfo* EventHandlerLoop::GetDescriptorInfo(intptr_t fd,
+                                                   bool is_listening) {
   ASSERT(fd >= 0);
   SimpleHashMap::Entry* entry = socket_map_.Lookup(
       GetHashmapKeyFromFd(fd), GetHashmapHashFromFd(fd), true);
@@ -169,9 +171,9 @@ DescriptorInfo* EventHandlerImplementation::GetDescriptorInfo(
   return di;
 }
 
-void EventHandlerImplementation::WakeupHandler(intptr_t id,
-                                               Dart_Port dart_port,
-                                               int64_t data) {
+void EventHandlerLoop::WakeupHandler(intptr_t id,
+                                     Dart_Port dart_port,
+                                     int64_t data) {
   InterruptMessage msg;
   msg.id = id;
   msg.dart_port = dart_port;
@@ -190,13 +192,14 @@ void EventHandlerImplementation::WakeupHandler(intptr_t id,
   }
 }
 
-void EventHandlerImplementation::HandleInterruptFd() {
+void EventHandlerLoop::HandleInterruptFd() {
   const intptr_t MAX_MESSAGES = kInterruptMessageSize;
   InterruptMessage msg[MAX_MESSAGES];
   ssize_t bytes = TEMP_FAILURE_RETRY_NO_SIGNAL_BLOCKER(
       read(interrupt_fds_[0], msg, MAX_MESSAGES * kInterruptMessageSize));
   for (ssize_t i = 0; i < bytes / kInterruptMessageSize; i++) {
     if (msg[i].id == kTimerId) {
+      ASSERT(index_ == 0);
       timeout_queue_.UpdateTimeout(msg[i].dart_port, msg[i].data);
       UpdateTimerFd();
     } else if (msg[i].id == kShutdownId) {
@@ -276,7 +279,7 @@ void EventHandlerImplementation::HandleInterruptFd() {
   }
 }
 
-void EventHandlerImplementation::UpdateTimerFd() {
+void EventHandlerLoop::UpdateTimerFd() {
   struct itimerspec it;
   memset(&it, 0, sizeof(it));
   if (timeout_queue_.HasTimeout()) {
@@ -320,8 +323,8 @@ static void PrintEventMask(intptr_t fd, intptr_t events) {
 }
 #endif
 
-intptr_t EventHandlerImplementation::GetPollEvents(intptr_t events,
-                                                   DescriptorInfo* di) {
+intptr_t EventHandlerLoop::GetPollEvents(intptr_t events,
+                                         DescriptorInfo* di) {
 #ifdef DEBUG_POLL
   PrintEventMask(di->fd(), events);
 #endif
@@ -342,8 +345,7 @@ intptr_t EventHandlerImplementation::GetPollEvents(intptr_t events,
   return event_mask;
 }
 
-void EventHandlerImplementation::HandleEvents(struct epoll_event* events,
-                                              int size) {
+void EventHandlerLoop::HandleEvents(struct epoll_event* events, int size) {
   bool interrupt_seen = false;
   for (int i = 0; i < size; i++) {
     if (events[i].data.ptr == NULL) {
@@ -380,12 +382,11 @@ void EventHandlerImplementation::HandleEvents(struct epoll_event* events,
   }
 }
 
-void EventHandlerImplementation::Poll(uword args) {
+void EventHandlerLoop::Poll(uword args) {
   ThreadSignalBlocker signal_blocker(SIGPROF);
   static const intptr_t kMaxEvents = 16;
   struct epoll_event events[kMaxEvents];
-  EventHandler* handler = reinterpret_cast<EventHandler*>(args);
-  EventHandlerImplementation* handler_impl = &handler->delegate_;
+  EventHandlerLoop* handler_impl = reinterpret_cast<EventHandlerLoop*>(args);
   ASSERT(handler_impl != NULL);
 
   while (!handler_impl->shutdown_) {
@@ -400,39 +401,92 @@ void EventHandlerImplementation::Poll(uword args) {
       handler_impl->HandleEvents(events, result);
     }
   }
-  DEBUG_ASSERT(ReferenceCounted<Socket>::instances() == 0);
-  handler->NotifyShutdownDone();
+  handler_impl->owner_->LoopDone();
 }
 
-void EventHandlerImplementation::Start(EventHandler* handler) {
-  int result =
-      Thread::Start("dart:io EventHandler", &EventHandlerImplementation::Poll,
-                    reinterpret_cast<uword>(handler));
+void EventHandlerLoop::Start() {
+  int result = Thread::Start("dart:io EventHandler", &EventHandlerLoop::Poll,
+                             reinterpret_cast<uword>(this));
   if (result != 0) {
     FATAL1("Failed to start event handler thread %d", result);
   }
 }
 
-void EventHandlerImplementation::Shutdown() {
-  SendData(kShutdownId, 0, 0);
-}
-
-void EventHandlerImplementation::SendData(intptr_t id,
-                                          Dart_Port dart_port,
-                                          int64_t data) {
+void EventHandlerLoop::SendData(intptr_t id,
+                                Dart_Port dart_port,
+                                int64_t data) {
   WakeupHandler(id, dart_port, data);
 }
 
-void* EventHandlerImplementation::GetHashmapKeyFromFd(intptr_t fd) {
+void* EventHandlerLoop::GetHashmapKeyFromFd(intptr_t fd) {
   // The hashmap does not support keys with value 0.
   return reinterpret_cast<void*>(fd + 1);
 }
 
-uint32_t EventHandlerImplementation::GetHashmapHashFromFd(intptr_t fd) {
+uint32_t EventHandlerLoop::GetHashmapHashFromFd(intptr_t fd) {
   // The hashmap does not support keys with value 0.
   return dart::Utils::WordHash(fd + 1);
 }
 
+EventHandlerImplementation::EventHandlerImplementation()
+    : handler_(NULL),
+      loops_(NULL),
+      loop_count_(EventHandler::thread_count()),
+      running_loops_(0) {
+  ASSERT(loop_count_ > 0);
+  loops_ = new EventHandlerLoop*[loop_count_];
+  for (intptr_t i = 0; i < loop_count_; i++) {
+    loops_[i] = new EventHandlerLoop(this, i);
+  }
+}
+
+EventHandlerImplementation::~EventHandlerImplementation() {
+  for (intptr_t i = 0; i < loop_count_; i++) {
+    delete loops_[i];
+  }
+  delete[] loops_;
+}
+
+EventHandlerLoop* EventHandlerImplementation::LoopFor(intptr_t id) {
+  if ((id == kTimerId) || (loop_count_ == 1)) {
+    return loops_[0];
+  }
+  // All the Socket objects of a descriptor, e.g. of a shared listening
+  // socket, are handled by the loop owning the descriptor. The loop is
+  // chosen by the descriptor the Socket was created with, as fd() is reset
+  // by the owning loop when it closes the socket, after which the loop skips
+  // its messages.
+  const intptr_t fd = reinterpret_cast<Socket*>(id)->initial_fd();
+  return loops_[(fd < 0) ? 0 : (fd % loop_count_)];
+}
+
+void EventHandlerImplementation::LoopDone() {
+  if (running_loops_.fetch_sub(1) == 1) {
+    DEBUG_ASSERT(ReferenceCounted<Socket>::instances() == 0);
+    handler_->NotifyShutdownDone();
+  }
+}
+
+void EventHandlerImplementation::Start(EventHandler* handler) {
+  handler_ = handler;
+  running_loops_ = loop_count_;
+  for (intptr_t i = 0; i < loop_count_; i++) {
+    loops_[i]->Start();
+  }
+}
+
+void EventHandlerImplementation::Shutdown() {
+  for (intptr_t i = 0; i < loop_count_; i++) {
+    loops_[i]->SendData(kShutdownId, 0, 0);
+  }
+}
+
+void EventHandlerImplementation::SendData(intptr_t id,
+                                          Dart_Port dart_port,
+                                          int64_t data) {
+  LoopFor(id)->SendData(id, dart_port, data);
+}
+
 }  // namespace bin
 }  // namespace dart
 
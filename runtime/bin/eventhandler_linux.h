@@ -14,6 +14,8 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <atomic>
+
 #include "platform/hashmap.h"
 #include "platform/signal_blocker.h"
 
@@ -58,10 +60,15 @@ class DescriptorInfoMultiple
   DISALLOW_COPY_AND_ASSIGN(DescriptorInfoMultiple);
 };
 
-class EventHandlerImplementation {
+class EventHandlerImplementation;
+
+// An epoll instance and the thread polling it. The descriptors of the process
+// are sharded across the loops of the EventHandlerImplementation by file
+// descriptor, so all the messages for a descriptor are handled by one loop.
+class EventHandlerLoop {
  public:
-  EventHandlerImplementation();
-  ~EventHandlerImplementation();
+  EventHandlerLoop(EventHandlerImplementation* owner, intptr_t index);
+  ~EventHandlerLoop();
 
   void UpdateEpollInstance(intptr_t old_mask, DescriptorInfo* di);
 
@@ -69,8 +76,7 @@ class EventHandlerImplementation {
   // descriptor. Creates a new one if one is not found.
   DescriptorInfo* GetDescriptorInfo(intptr_t fd, bool is_listening);
   void SendData(intptr_t id, Dart_Port dart_port, int64_t data);
-  void Start(EventHandler* handler);
-  void Shutdown();
+  void Start();
 
  private:
   void HandleEvents(struct epoll_event* events, int size);
@@ -78,11 +84,12 @@ class EventHandlerImplementation {
   void WakeupHandler(intptr_t id, Dart_Port dart_port, int64_t data);
   void HandleInterruptFd();
   void UpdateTimerFd();
-  void SetPort(intptr_t fd, Dart_Port dart_port, intptr_t mask);
   intptr_t GetPollEvents(intptr_t events, DescriptorInfo* di);
   static void* GetHashmapKeyFromFd(intptr_t fd);
   static uint32_t GetHashmapHashFromFd(intptr_t fd);
 
+  EventHandlerImplementation* owner_;
+  intptr_t index_;
   SimpleHashMap socket_map_;
   TimeoutQueue timeout_queue_;
   bool shutdown_;
@@ -90,6 +97,33 @@ class EventHandlerImplementation {
   int epoll_fd_;
   int timer_fd_;
 
+  DISALLOW_COPY_AND_ASSIGN(EventHandlerLoop);
+};
+
+class EventHandlerImplementation {
+ public:
+  EventHandlerImplementation();
+  ~EventHandlerImplementation();
+
+  void SendData(intptr_t id, Dart_Port dart_port, int64_t data);
+  void Start(EventHandler* handler);
+  void Shutdown();
+
+ private:
+  friend class EventHandlerLoop;
+
+  // Returns the loop handling the messages with the given id. Timers are
+  // handled by the first loop.
+  EventHandlerLoop* LoopFor(intptr_t id);
+
+  // Called by each loop when its thread exits.
+  void LoopDone();
+
+  EventHandler* handler_;
+  EventHandlerLoop** loops_;
+  intptr_t loop_count_;
+  std::atomic<intptr_t> running_loops_;
+
   DISALLOW_COPY_AND_ASSIGN(EventHandlerImplementation);
 };
 
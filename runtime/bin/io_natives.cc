@@ -85,6 +85,11 @@ namespace bin {
   V(InternetAddress_ParseScopedLinkLocalAddress, 1)                            \
   V(InternetAddress_RawAddrToString, 1)                                        \
   V(IOService_NewServicePort, 0)                                               \
+  V(IOUring_Flush, 3)                                                          \
+  V(IOUring_IsSupported, 0)                                                    \
+  V(IOUring_Read, 5)                                                           \
+  V(IOUring_Submit, 0)                                                         \
+  V(IOUring_Write, 6)                                                          \
   V(Namespace_Create, 2)                                                       \
   V(Namespace_GetDefault, 0)                                                   \
   V(Namespace_GetPointer, 1)                                                   \
@@ -155,12 +160,14 @@ namespace bin {
   V(Socket_JoinMulticast, 4)                                                   \
   V(Socket_LeaveMulticast, 4)                                                  \
   V(Socket_Read, 2)                                                            \
-  V(Socket_RecvFrom, 1)                                                        \
+  V(Socket_RecvFromBatch, 2)                                                   \
+  V(Socket_SendFile, 4)                                                        \
   V(Socket_SendTo, 6)                                                          \
   V(Socket_SetOption, 4)                                                       \
   V(Socket_SetRawOption, 4)                                                    \
   V(Socket_SetSocketId, 3)                                                     \
   V(Socket_WriteList, 4)                                                       \
+  V(Socket_WriteVector, 2)                                                     \
   V(Stdin_ReadByte, 1)                                                         \
   V(Stdin_GetEchoMode, 1)                                                      \
   V(Stdin_SetEchoMode, 2)                                                      \
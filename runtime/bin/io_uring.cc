@@ -0,0 +1,139 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "bin/io_uring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bin/builtin.h"
+#include "bin/dartutils.h"
+#include "bin/file.h"
+#include "include/dart_api.h"
+#include "platform/assert.h"
+
+namespace dart {
+namespace bin {
+
+bool IOUring::disabled_ = false;
+bool IOUring::forced_ = false;
+bool IOUring::short_write_ = false;
+
+static Dart_Port GetReplyPort(Dart_NativeArguments args, intptr_t index) {
+  Dart_Port port = ILLEGAL_PORT;
+  ThrowIfError(Dart_SendPortGetId(Dart_GetNativeArgument(args, index), &port));
+  return port;
+}
+
+static int32_t GetRequestId(Dart_NativeArguments args, intptr_t index) {
+  return static_cast<int32_t>(DartUtils::GetNativeIntegerArgument(args, index));
+}
+
+void FUNCTION_NAME(IOUring_IsSupported)(Dart_NativeArguments args) {
+  Dart_SetBooleanReturnValue(args, IOUring::IsSupported());
+}
+
+// The file pointers passed to the natives below come from File_GetPointer.
+// When a request is accepted its reference is released by IOUring, otherwise
+// the request is sent to the IO service which releases it.
+void FUNCTION_NAME(IOUring_Read)(Dart_NativeArguments args) {
+  File* file =
+      reinterpret_cast<File*>(DartUtils::GetNativeIntptrArgument(args, 0));
+  const int64_t length = DartUtils::GetNativeIntegerArgument(args, 1);
+  const bool into = DartUtils::GetNativeBooleanArgument(args, 2);
+  const int32_t id = GetRequestId(args, 3);
+  const Dart_Port reply_port = GetReplyPort(args, 4);
+  const bool accepted =
+      !file->IsClosed() && IOUring::Read(file, length, into, reply_port, id);
+  Dart_SetBooleanReturnValue(args, accepted);
+}
+
+void FUNCTION_NAME(IOUring_Write)(Dart_NativeArguments args) {
+  File* file =
+      reinterpret_cast<File*>(DartUtils::GetNativeIntptrArgument(args, 0));
+  Dart_Handle buffer_obj = Dart_GetNativeArgument(args, 1);
+  const intptr_t start = DartUtils::GetNativeIntptrArgument(args, 2);
+  const intptr_t end = DartUtils::GetNativeIntptrArgument(args, 3);
+  const int32_t id = GetRequestId(args, 4);
+  const Dart_Port reply_port = GetReplyPort(args, 5);
+  if (file->IsClosed()) {
+    Dart_SetBooleanReturnValue(args, false);
+    return;
+  }
+
+  // The buffer has been made fast and serializable by the caller, so it is a
+  // list of bytes. It is copied because the request outlives this call.
+  Dart_TypedData_Type type;
+  void* data = NULL;
+  intptr_t data_length = 0;
+  ThrowIfError(
+      Dart_TypedDataAcquireData(buffer_obj, &type, &data, &data_length));
+  ASSERT((type == Dart_TypedData_kUint8) || (type == Dart_TypedData_kInt8) ||
+         (type == Dart_TypedData_kUint8Clamped));
+  ASSERT((0 <= start) && (start <= end) && (end <= data_length));
+  const intptr_t length = end - start;
+  uint8_t* buffer = reinterpret_cast<uint8_t*>(malloc(length));
+  if (buffer != NULL) {
+    memmove(buffer, reinterpret_cast<uint8_t*>(data) + start, length);
+  }
+  ThrowIfError(Dart_TypedDataReleaseData(buffer_obj));
+
+  const bool accepted = (buffer != NULL) &&
+                        IOUring::Write(file, buffer, length, reply_port, id);
+  if (!accepted) {
+    free(buffer);
+  }
+  Dart_SetBooleanReturnValue(args, accepted);
+}
+
+void FUNCTION_NAME(IOUring_Flush)(Dart_NativeArguments args) {
+  File* file =
+      reinterpret_cast<File*>(DartUtils::GetNativeIntptrArgument(args, 0));
+  const int32_t id = GetRequestId(args, 1);
+  const Dart_Port reply_port = GetReplyPort(args, 2);
+  const bool accepted =
+      !file->IsClosed() && IOUring::Flush(file, reply_port, id);
+  Dart_SetBooleanReturnValue(args, accepted);
+}
+
+void FUNCTION_NAME(IOUring_Submit)(Dart_NativeArguments args) {
+  IOUring::Submit();
+}
+
+#if !defined(DART_HOST_OS_LINUX)
+
+void IOUring::Init() {}
+
+void IOUring::Cleanup() {}
+
+bool IOUring::IsSupported() {
+  return false;
+}
+
+bool IOUring::Read(File* file,
+                   int64_t length,
+                   bool into,
+                   Dart_Port reply_port,
+                   int32_t id) {
+  return false;
+}
+
+bool IOUring::Write(File* file,
+                    uint8_t* buffer,
+                    int64_t length,
+                    Dart_Port reply_port,
+                    int32_t id) {
+  return false;
+}
+
+bool IOUring::Flush(File* file, Dart_Port reply_port, int32_t id) {
+  return false;
+}
+
+void IOUring::Submit() {}
+
+#endif  // !defined(DART_HOST_OS_LINUX)
+
+}  // namespace bin
+}  // namespace dart
@@ -0,0 +1,82 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_BIN_IO_URING_H_
+#define RUNTIME_BIN_IO_URING_H_
+
+#include "bin/builtin.h"
+#include "include/dart_api.h"
+#include "platform/globals.h"
+
+namespace dart {
+namespace bin {
+
+class File;
+
+// Performs the reads, writes and flushes of asynchronous RandomAccessFile
+// operations with a Linux io_uring instead of an IO service port.
+//
+// Requests are queued by the isolates issuing them and submitted to the
+// kernel in batches by Submit. A completion thread reaps the completed
+// requests and posts the same responses as the IO service to their reply
+// ports. Data is read directly into the external typed data of the response.
+// Requests which are not accepted, e.g. because io_uring is not available,
+// go through the IO service.
+class IOUring {
+ public:
+  static void Init();
+  static void Cleanup();
+
+  // Whether requests may be accepted.
+  static bool IsSupported();
+
+  // Queues a read of up to [length] bytes at the current position of [file],
+  // answered like a File::ReadRequest or, if [into] is true, like a
+  // File::ReadIntoRequest. If the request is accepted the reference to
+  // [file] is released once it completes.
+  static bool Read(File* file,
+                   int64_t length,
+                   bool into,
+                   Dart_Port reply_port,
+                   int32_t id);
+
+  // Queues a write of the [length] bytes of [buffer], which must be
+  // allocated with malloc and is freed once the request completes. Answered
+  // like a File::WriteFromRequest.
+  static bool Write(File* file,
+                    uint8_t* buffer,
+                    int64_t length,
+                    Dart_Port reply_port,
+                    int32_t id);
+
+  // Queues a flush of [file], answered like a File::FlushRequest.
+  static bool Flush(File* file, Dart_Port reply_port, int32_t id);
+
+  // Submits the queued requests to the kernel.
+  static void Submit();
+
+  static void set_disabled(bool disabled) { disabled_ = disabled; }
+
+  // Exits instead of leaving requests to the IO service when io_uring is not
+  // available. Used by tests of this backend.
+  static void set_forced(bool forced) { forced_ = forced; }
+
+  // Submits at most half of the remaining bytes of every write, like
+  // Socket::short_socket_write, to test that the rest is resubmitted.
+  static void set_short_write(bool short_write) { short_write_ = short_write; }
+  static bool short_write() { return short_write_; }
+
+ private:
+  static bool disabled_;
+  static bool forced_;
+  static bool short_write_;
+
+  DISALLOW_ALLOCATION();
+  DISALLOW_IMPLICIT_CONSTRUCTORS(IOUring);
+};
+
+}  // namespace bin
+}  // namespace dart
+
+#endif  // RUNTIME_BIN_IO_URING_H_
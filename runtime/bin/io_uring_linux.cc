@@ -0,0 +1,606 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/globals.h"
+#if defined(DART_HOST_OS_LINUX)
+
+#include "bin/io_uring.h"
+
+#include <errno.h>        // NOLINT
+#include <string.h>       // NOLINT
+#include <sys/mman.h>     // NOLINT
+#include <sys/syscall.h>  // NOLINT
+#include <unistd.h>       // NOLINT
+
+#include "bin/dartutils.h"
+#include "bin/error_exit.h"
+#include "bin/file.h"
+#include "bin/io_buffer.h"
+#include "bin/lockers.h"
+#include "bin/platform.h"
+#include "bin/thread.h"
+#include "bin/utils.h"
+#include "platform/syslog.h"
+
+// Reads and writes at the current file position need Linux 5.6, whose
+// headers define IORING_FEAT_RW_CUR_POS. The kernel is checked at runtime.
+#if defined(__NR_io_uring_setup) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>  // NOLINT
+#endif
+
+namespace dart {
+namespace bin {
+
+#if defined(IORING_FEAT_RW_CUR_POS)
+
+struct IOUringRequest {
+  enum Kind { kRead, kReadInto, kWrite, kFlush };
+
+  Kind kind;
+  File* file;
+  Dart_Port reply_port;
+  int32_t id;
+  uint8_t* buffer;
+  int64_t length;
+  // Bytes of a write written so far.
+  int64_t written = 0;
+  // Next write to resubmit after a short write.
+  IOUringRequest* next = nullptr;
+};
+
+// A ring shared by all isolates. A null request is used to stop the
+// completion thread.
+class IOUringRing {
+ public:
+  static IOUringRing* Create();
+
+  ~IOUringRing();
+
+  bool Enqueue(IOUringRequest* request);
+  void Submit();
+
+  // Waits for the requests in flight to complete and stops the completion
+  // thread.
+  void Shutdown();
+
+ private:
+  // Number of entries of the submission queue. Requests are not accepted
+  // while it is full.
+  static const uint32_t kEntries = 256;
+
+  IOUringRing(int fd, const struct io_uring_params& params);
+
+  bool Map();
+  bool EnqueueLocked(IOUringRequest* request);
+  void SubmitLocked();
+
+  static void CompletionThreadMain(uword parameter);
+  void ReapCompletions();
+  void ResubmitLocked();
+  // Returns false if the request was resubmitted.
+  bool Complete(IOUringRequest* request, int32_t result);
+
+  const int fd_;
+  const struct io_uring_params params_;
+
+  uint8_t* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  uint8_t* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe* sqes_ = nullptr;
+
+  uint32_t* sq_head_ = nullptr;
+  uint32_t* sq_tail_ = nullptr;
+  uint32_t* sq_array_ = nullptr;
+  uint32_t* cq_head_ = nullptr;
+  uint32_t* cq_tail_ = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+
+  // Guards the submission queue and the counters below.
+  Mutex mutex_;
+  // Entries added to the submission queue but not submitted to the kernel.
+  uint32_t pending_ = 0;
+  // Requests submitted but not reaped. Limited to the size of the completion
+  // queue so that it never overflows.
+  uint32_t in_flight_ = 0;
+  bool shutting_down_ = false;
+  // Short writes whose rest is to be submitted. Only used by the completion
+  // thread.
+  IOUringRequest* resubmit_ = nullptr;
+
+  Monitor done_monitor_;
+  bool done_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(IOUringRing);
+};
+
+static int IOUringSetup(uint32_t entries, struct io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int IOUringEnter(int fd,
+                        uint32_t to_submit,
+                        uint32_t min_complete,
+                        uint32_t flags) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 nullptr, 0);
+}
+
+IOUringRing* IOUringRing::Create() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int fd = IOUringSetup(kEntries, &params);
+  if (fd < 0) {
+    return nullptr;
+  }
+  if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+    close(fd);
+    return nullptr;
+  }
+  IOUringRing* ring = new IOUringRing(fd, params);
+  if (!ring->Map() ||
+      (Thread::Start("dart:io IOUring", &CompletionThreadMain,
+                     reinterpret_cast<uword>(ring)) != 0)) {
+    delete ring;
+    return nullptr;
+  }
+  return ring;
+}
+
+IOUringRing::IOUringRing(int fd, const struct io_uring_params& params)
+    : fd_(fd), params_(params) {}
+
+IOUringRing::~IOUringRing() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, params_.sq_entries * sizeof(struct io_uring_sqe));
+  }
+  if ((cq_ring_ != nullptr) && (cq_ring_ != sq_ring_)) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  close(fd_);
+}
+
+static uint8_t* MapRing(int fd, size_t size, off_t offset) {
+  void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, offset);
+  return (address == MAP_FAILED) ? nullptr
+                                 : reinterpret_cast<uint8_t*>(address);
+}
+
+bool IOUringRing::Map() {
+  sq_ring_size_ = params_.sq_off.array + params_.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ =
+      params_.cq_off.cqes + params_.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = Utils::Maximum(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = sq_ring_size_;
+  }
+  sq_ring_ = MapRing(fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == nullptr) {
+    return false;
+  }
+  cq_ring_ = single_mmap ? sq_ring_
+                         : MapRing(fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+  if (cq_ring_ == nullptr) {
+    return false;
+  }
+  sqes_ = reinterpret_cast<struct io_uring_sqe*>(
+      MapRing(fd_, params_.sq_entries * sizeof(struct io_uring_sqe),
+              IORING_OFF_SQES));
+  if (sqes_ == nullptr) {
+    return false;
+  }
+
+  sq_head_ = reinterpret_cast<uint32_t*>(sq_ring_ + params_.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq_ring_ + params_.sq_off.tail);
+  sq_array_ = reinterpret_cast<uint32_t*>(sq_ring_ + params_.sq_off.array);
+  cq_head_ = reinterpret_cast<uint32_t*>(cq_ring_ + params_.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(cq_ring_ + params_.cq_off.tail);
+  cqes_ =
+      reinterpret_cast<struct io_uring_cqe*>(cq_ring_ + params_.cq_off.cqes);
+  return true;
+}
+
+bool IOUringRing::Enqueue(IOUringRequest* request) {
+  MutexLocker ml(&mutex_);
+  if (shutting_down_ || (in_flight_ + pending_ >= params_.cq_entries)) {
+    return false;
+  }
+  return EnqueueLocked(request);
+}
+
+bool IOUringRing::EnqueueLocked(IOUringRequest* request) {
+  const uint32_t tail = *sq_tail_;
+  const uint32_t head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  // The last entry is kept for the request stopping the completion thread.
+  const uint32_t capacity =
+      (request == nullptr) ? params_.sq_entries : (params_.sq_entries - 1);
+  if (tail - head >= capacity) {
+    return false;
+  }
+
+  const uint32_t mask =
+      *reinterpret_cast<uint32_t*>(sq_ring_ + params_.sq_off.ring_mask);
+  const uint32_t slot = tail & mask;
+  struct io_uring_sqe* sqe = &sqes_[slot];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+  } else {
+    sqe->fd = request->file->GetFD();
+    switch (request->kind) {
+      case IOUringRequest::kRead:
+      case IOUringRequest::kReadInto:
+        sqe->opcode = IORING_OP_READ;
+        break;
+      case IOUringRequest::kWrite:
+        sqe->opcode = IORING_OP_WRITE;
+        break;
+      case IOUringRequest::kFlush:
+        sqe->opcode = IORING_OP_FSYNC;
+        break;
+    }
+    if (request->kind != IOUringRequest::kFlush) {
+      // An offset of -1 reads or writes at the current file position and
+      // advances it, like read and write.
+      sqe->off = static_cast<uint64_t>(-1);
+      int64_t length = request->length - request->written;
+      if ((request->kind == IOUringRequest::kWrite) && IOUring::short_write() &&
+          (length > 1)) {
+        length = (length + 1) / 2;
+      }
+      sqe->addr =
+          reinterpret_cast<uint64_t>(request->buffer + request->written);
+      sqe->len = static_cast<uint32_t>(length);
+    }
+  }
+  sq_array_[slot] = slot;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  pending_++;
+  return true;
+}
+
+void IOUringRing::Submit() {
+  MutexLocker ml(&mutex_);
+  SubmitLocked();
+}
+
+void IOUringRing::SubmitLocked() {
+  while (pending_ > 0) {
+    const int submitted = IOUringEnter(fd_, pending_, 0, 0);
+    if (submitted < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if ((errno == EAGAIN) || (errno == EBUSY)) {
+        // Retried once requests in flight have completed.
+        return;
+      }
+      FATAL1("Failed to submit to io_uring: %d", errno);
+    }
+    pending_ -= submitted;
+    in_flight_ += submitted;
+  }
+}
+
+void IOUringRing::CompletionThreadMain(uword parameter) {
+  IOUringRing* ring = reinterpret_cast<IOUringRing*>(parameter);
+  ring->ReapCompletions();
+  MonitorLocker ml(&ring->done_monitor_);
+  ring->done_ = true;
+  ml.Notify();
+}
+
+void IOUringRing::ReapCompletions() {
+  const uint32_t mask =
+      *reinterpret_cast<uint32_t*>(cq_ring_ + params_.cq_off.ring_mask);
+  bool stop_requested = false;
+  while (true) {
+    const int result = IOUringEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    if ((result < 0) && (errno != EINTR) && (errno != EAGAIN)) {
+      FATAL1("Failed to wait for io_uring completions: %d", errno);
+    }
+
+    uint32_t head = *cq_head_;
+    const uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    const uint32_t completed = tail - head;
+    for (; head != tail; head++) {
+      const struct io_uring_cqe& cqe = cqes_[head & mask];
+      IOUringRequest* request =
+          reinterpret_cast<IOUringRequest*>(cqe.user_data);
+      if (request == nullptr) {
+        stop_requested = true;
+      } else if (!Complete(request, cqe.res)) {
+        request->next = resubmit_;
+        resubmit_ = request;
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    MutexLocker ml(&mutex_);
+    in_flight_ -= completed;
+    ResubmitLocked();
+    if (stop_requested && (in_flight_ == 0) && (pending_ == 0) &&
+        (resubmit_ == nullptr)) {
+      return;
+    }
+    SubmitLocked();
+    // Writes which did not fit into the submission queue before it was
+    // submitted.
+    ResubmitLocked();
+    SubmitLocked();
+  }
+}
+
+void IOUringRing::ResubmitLocked() {
+  while ((resubmit_ != nullptr) && EnqueueLocked(resubmit_)) {
+    resubmit_ = resubmit_->next;
+  }
+}
+
+static void PostResponse(IOUringRequest* request, Dart_CObject* response) {
+  Dart_CObject id;
+  id.type = Dart_CObject_kInt32;
+  id.value.as_int32 = request->id;
+  Dart_CObject* values[] = {&id, response};
+  Dart_CObject message;
+  message.type = Dart_CObject_kArray;
+  message.value.as_array.length = 2;
+  message.value.as_array.values = values;
+  Dart_PostCObject(request->reply_port, &message);
+}
+
+// Posts the same response as CObject::NewOSError.
+static void PostOSError(IOUringRequest* request, OSError* os_error) {
+  Dart_CObject kind;
+  kind.type = Dart_CObject_kInt32;
+  kind.value.as_int32 = CObject::kOSError;
+  Dart_CObject code;
+  code.type = Dart_CObject_kInt32;
+  code.value.as_int32 = os_error->code();
+  Dart_CObject message;
+  message.type = Dart_CObject_kString;
+  message.value.as_string = os_error->message();
+  Dart_CObject* values[] = {&kind, &code, &message};
+  Dart_CObject response;
+  response.type = Dart_CObject_kArray;
+  response.value.as_array.length = 3;
+  response.value.as_array.values = values;
+  PostResponse(request, &response);
+}
+
+// Posts the same responses as File::ReadRequest and File::ReadIntoRequest.
+static void PostReadResponse(IOUringRequest* request, int64_t bytes_read) {
+  Dart_CObject data;
+  data.type = Dart_CObject_kExternalTypedData;
+  data.value.as_external_typed_data.type = Dart_TypedData_kUint8;
+  data.value.as_external_typed_data.length = request->length;
+  data.value.as_external_typed_data.data = request->buffer;
+  data.value.as_external_typed_data.peer = request->buffer;
+  data.value.as_external_typed_data.callback = IOBuffer::Finalizer;
+  CObject::ShrinkIOBuffer(&data, bytes_read);
+  // The buffer is owned by the response now.
+  request->buffer = nullptr;
+
+  Dart_CObject success;
+  success.type = Dart_CObject_kInt32;
+  success.value.as_int32 = 0;
+  Dart_CObject length;
+  length.type = Dart_CObject_kInt64;
+  length.value.as_int64 = bytes_read;
+  Dart_CObject* read_values[] = {&success, &data};
+  Dart_CObject* read_into_values[] = {&success, &length, &data};
+  Dart_CObject response;
+  response.type = Dart_CObject_kArray;
+  if (request->kind == IOUringRequest::kRead) {
+    response.value.as_array.length = 2;
+    response.value.as_array.values = read_values;
+  } else {
+    response.value.as_array.length = 3;
+    response.value.as_array.values = read_into_values;
+  }
+  PostResponse(request, &response);
+}
+
+bool IOUringRing::Complete(IOUringRequest* request, int32_t result) {
+  if (result < 0) {
+    OSError os_error;
+    os_error.SetCodeAndMessage(OSError::kSystem, -result);
+    PostOSError(request, &os_error);
+  } else {
+    switch (request->kind) {
+      case IOUringRequest::kRead:
+      case IOUringRequest::kReadInto:
+        PostReadResponse(request, result);
+        break;
+      case IOUringRequest::kWrite: {
+        // Like File::WriteFully, write what the kernel did not. The rest is
+        // submitted as another request rather than written here, so that the
+        // completion thread does not block.
+        request->written += result;
+        if (request->written < request->length) {
+          if (result > 0) {
+            return false;
+          }
+          OSError os_error;
+          os_error.SetCodeAndMessage(OSError::kSystem, EIO);
+          PostOSError(request, &os_error);
+          break;
+        }
+        Dart_CObject response;
+        response.type = Dart_CObject_kInt64;
+        response.value.as_int64 = request->length;
+        PostResponse(request, &response);
+        break;
+      }
+      case IOUringRequest::kFlush: {
+        Dart_CObject response;
+        response.type = Dart_CObject_kBool;
+        response.value.as_bool = true;
+        PostResponse(request, &response);
+        break;
+      }
+    }
+  }
+
+  if (request->buffer != nullptr) {
+    if (request->kind == IOUringRequest::kWrite) {
+      free(request->buffer);
+    } else {
+      IOBuffer::Free(request->buffer);
+    }
+  }
+  request->file->Release();
+  delete request;
+  return true;
+}
+
+void IOUringRing::Shutdown() {
+  {
+    MutexLocker ml(&mutex_);
+    shutting_down_ = true;
+    const bool enqueued = EnqueueLocked(nullptr);
+    ASSERT(enqueued);
+    SubmitLocked();
+  }
+  MonitorLocker ml(&done_monitor_);
+  while (!done_) {
+    ml.Wait();
+  }
+}
+
+// Created on first use, guarded by [ring_mutex].
+static Mutex* ring_mutex = nullptr;
+static IOUringRing* ring = nullptr;
+static bool ring_created = false;
+
+void IOUring::Init() {
+  ASSERT(ring_mutex == nullptr);
+  ring_mutex = new Mutex();
+}
+
+void IOUring::Cleanup() {
+  if (ring != nullptr) {
+    ring->Shutdown();
+    delete ring;
+    ring = nullptr;
+  }
+  ring_created = false;
+  delete ring_mutex;
+  ring_mutex = nullptr;
+}
+
+bool IOUring::IsSupported() {
+  if (disabled_ || (ring_mutex == nullptr)) {
+    return false;
+  }
+  MutexLocker ml(ring_mutex);
+  if (!ring_created) {
+    ring = IOUringRing::Create();
+    ring_created = true;
+    if ((ring == nullptr) && forced_) {
+      Syslog::PrintErr("io_uring is not available.\n");
+      Platform::Exit(kErrorExitCode);
+    }
+  }
+  return ring != nullptr;
+}
+
+static bool Enqueue(IOUringRequest* request) {
+  if (!IOUring::IsSupported() || !ring->Enqueue(request)) {
+    delete request;
+    return false;
+  }
+  return true;
+}
+
+bool IOUring::Read(File* file,
+                   int64_t length,
+                   bool into,
+                   Dart_Port reply_port,
+                   int32_t id) {
+  // Longer reads are left to the IO service.
+  if ((length < 0) || (length > kMaxUint32)) {
+    return false;
+  }
+  uint8_t* buffer = IOBuffer::Allocate(static_cast<intptr_t>(length));
+  if (buffer == nullptr) {
+    return false;
+  }
+  const auto kind = into ? IOUringRequest::kReadInto : IOUringRequest::kRead;
+  auto request =
+      new IOUringRequest{kind, file, reply_port, id, buffer, length};
+  if (!Enqueue(request)) {
+    IOBuffer::Free(buffer);
+    return false;
+  }
+  return true;
+}
+
+bool IOUring::Write(File* file,
+                    uint8_t* buffer,
+                    int64_t length,
+                    Dart_Port reply_port,
+                    int32_t id) {
+  if ((length < 0) || (length > kMaxUint32)) {
+    return false;
+  }
+  return Enqueue(new IOUringRequest{IOUringRequest::kWrite, file, reply_port,
+                                    id, buffer, length});
+}
+
+bool IOUring::Flush(File* file, Dart_Port reply_port, int32_t id) {
+  return Enqueue(new IOUringRequest{IOUringRequest::kFlush, file, reply_port,
+                                    id, nullptr, 0});
+}
+
+void IOUring::Submit() {
+  if (IsSupported()) {
+    ring->Submit();
+  }
+}
+
+#else  // defined(IORING_FEAT_RW_CUR_POS)
+
+void IOUring::Init() {}
+
+void IOUring::Cleanup() {}
+
+bool IOUring::IsSupported() {
+  return false;
+}
+
+bool IOUring::Read(File* file,
+                   int64_t length,
+                   bool into,
+                   Dart_Port reply_port,
+                   int32_t id) {
+  return false;
+}
+
+bool IOUring::Write(File* file,
+                    uint8_t* buffer,
+                    int64_t length,
+                    Dart_Port reply_port,
+                    int32_t id) {
+  return false;
+}
+
+bool IOUring::Flush(File* file, Dart_Port reply_port, int32_t id) {
+  return false;
+}
+
+void IOUring::Submit() {}
+
+#endif  // defined(IORING_FEAT_RW_CUR_POS)
+
+}  // namespace bin
+}  // namespace dart
+
+#endif  // defined(DART_HOST_OS_LINUX)
@@ -10,7 +10,9 @@
 
 #include "bin/dartdev_isolate.h"
 #include "bin/error_exit.h"
+#include "bin/eventhandler.h"
 #include "bin/file_system_watcher.h"
+#include "bin/io_uring.h"
 #include "bin/options.h"
 #include "bin/platform.h"
 #include "bin/utils.h"
@@ -86,6 +88,15 @@ DFE* Options::dfe_ = NULL;
 DEFINE_STRING_OPTION_CB(dfe, { Options::dfe()->set_frontend_filename(value); });
 #endif  // !defined(DART_PRECOMPILED_RUNTIME)
 
+DEFINE_STRING_OPTION_CB(event_handler_threads, {
+  const int count = atoi(value);
+  if (count <= 0) {
+    Syslog::PrintErr("Invalid value for option event_handler_threads\n");
+    return false;
+  }
+  EventHandler::set_thread_count(count);
+});
+
 static void hot_reload_test_mode_callback(CommandLineOptions* vm_options) {
   // Identity reload.
   vm_options->AddArgument("--identity_reload");
@@ -475,6 +486,9 @@ bool Options::ParseArguments(int argc,
 
   Socket::set_short_socket_read(Options::short_socket_read());
   Socket::set_short_socket_write(Options::short_socket_write());
+  IOUring::set_disabled(Options::disable_io_uring());
+  IOUring::set_forced(Options::force_io_uring());
+  IOUring::set_short_write(Options::short_io_uring_write());
 #if !defined(DART_IO_SECURE_SOCKET_DISABLED)
   SSLCertContext::set_root_certs_file(Options::root_certs_file());
   SSLCertContext::set_root_certs_cache(Options::root_certs_cache());
@@ -39,6 +39,9 @@ namespace bin {
   V(trace_loading, trace_loading)                                              \
   V(short_socket_read, short_socket_read)                                      \
   V(short_socket_write, short_socket_write)                                    \
+  V(disable_io_uring, disable_io_uring)                                        \
+  V(force_io_uring, force_io_uring)                                            \
+  V(short_io_uring_write, short_io_uring_write)                                \
   V(disable_exit, exit_disabled)                                               \
   V(preview_dart_2, nop_option)                                                \
   V(suppress_core_dump, suppress_core_dump)                                    \
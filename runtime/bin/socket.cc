@@ -4,6 +4,8 @@
 
 #include "bin/socket.h"
 
+#include <errno.h>  // NOLINT
+
 #include "bin/dartutils.h"
 #include "bin/eventhandler.h"
 #include "bin/file.h"
@@ -566,91 +568,111 @@ void FUNCTION_NAME(Socket_Read)(Dart_NativeArguments args) {
   }
 }
 
-void FUNCTION_NAME(Socket_RecvFrom)(Dart_NativeArguments args) {
-  // TODO(sgjesse): Use a MTU value here. Only the loopback adapter can
-  // handle 64k datagrams.
-  const int kReceiveBufferLen = 65536;
-  Socket* socket =
-      Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
-
-  // Ensure that a receive buffer for the UDP socket exists.
-  ASSERT(socket != nullptr);
-  uint8_t* recv_buffer = socket->udp_receive_buffer();
-  if (recv_buffer == nullptr) {
-    recv_buffer = reinterpret_cast<uint8_t*>(malloc(kReceiveBufferLen));
-    socket->set_udp_receive_buffer(recv_buffer);
-  }
-
-  // Read data into the buffer.
-  RawAddr addr;
-  const intptr_t bytes_read = SocketBase::RecvFrom(
-      socket->fd(), recv_buffer, kReceiveBufferLen, &addr, SocketBase::kAsync);
-  if (bytes_read == 0) {
-    Dart_SetReturnValue(args, Dart_Null());
-    return;
-  }
-  if (bytes_read < 0) {
-    ASSERT(bytes_read == -1);
-    Dart_ThrowException(DartUtils::NewDartOSError());
-  }
-
-  // Datagram data read. Copy into buffer of the exact size,
-  ASSERT(bytes_read >= 0);
-  uint8_t* data_buffer = nullptr;
-  Dart_Handle data = IOBuffer::Allocate(bytes_read, &data_buffer);
-  if (Dart_IsNull(data)) {
-    Dart_ThrowException(DartUtils::NewDartOSError());
-  }
-  if (Dart_IsError(data)) {
-    Dart_PropagateError(data);
-  }
-  ASSERT(data_buffer != nullptr);
-  memmove(data_buffer, recv_buffer, bytes_read);
-
+// Sets [dart_args] to the address, in_addr, port and type arguments of
+// _makeDatagram for a datagram received from [addr].
+static void GetDatagramAddress(RawAddr* addr, Dart_Handle* dart_args) {
   // Memory Sanitizer complains addr not being initialized, which is done
-  // through RecvFrom().
+  // through RecvFromMultiple().
   // Issue: https://github.com/google/sanitizers/issues/1201
-  MSAN_UNPOISON(&addr, sizeof(RawAddr));
+  MSAN_UNPOISON(addr, sizeof(RawAddr));
 
   // Get the port and clear it in the sockaddr structure.
-  int port = SocketAddress::GetAddrPort(addr);
+  int port = SocketAddress::GetAddrPort(*addr);
   // TODO(21403): Add checks for AF_UNIX, if unix domain sockets
   // are used in SOCK_DGRAM.
   enum internet_type { IPv4, IPv6 };
   internet_type type;
-  if (addr.addr.sa_family == AF_INET) {
-    addr.in.sin_port = 0;
+  if (addr->addr.sa_family == AF_INET) {
+    addr->in.sin_port = 0;
     type = IPv4;
   } else {
-    ASSERT(addr.addr.sa_family == AF_INET6);
-    addr.in6.sin6_port = 0;
+    ASSERT(addr->addr.sa_family == AF_INET6);
+    addr->in6.sin6_port = 0;
     type = IPv6;
   }
   // Format the address to a string using the numeric format.
   char numeric_address[INET6_ADDRSTRLEN];
-  SocketBase::FormatNumericAddress(addr, numeric_address, INET6_ADDRSTRLEN);
-
-  // Create a Datagram object with the data and sender address and port.
-  const int kNumArgs = 5;
-  Dart_Handle dart_args[kNumArgs];
-  dart_args[0] = data;
-  dart_args[1] = Dart_NewStringFromCString(numeric_address);
-  if (Dart_IsError(dart_args[1])) {
-    Dart_PropagateError(dart_args[1]);
-  }
-  dart_args[2] = SocketAddress::ToTypedData(addr);
-  dart_args[3] = Dart_NewInteger(port);
-  dart_args[4] = Dart_NewInteger(type);
-  if (Dart_IsError(dart_args[3])) {
-    Dart_PropagateError(dart_args[3]);
-  }
-  // TODO(sgjesse): Cache the _makeDatagram function somewhere.
-  Dart_Handle io_lib = Dart_LookupLibrary(DartUtils::NewString("dart:io"));
-  if (Dart_IsError(io_lib)) {
-    Dart_PropagateError(io_lib);
-  }
-  Dart_Handle result = Dart_Invoke(
-      io_lib, DartUtils::NewString("_makeDatagram"), kNumArgs, dart_args);
+  SocketBase::FormatNumericAddress(*addr, numeric_address, INET6_ADDRSTRLEN);
+
+  dart_args[0] = Dart_NewStringFromCString(numeric_address);
+  if (Dart_IsError(dart_args[0])) {
+    Dart_PropagateError(dart_args[0]);
+  }
+  dart_args[1] = SocketAddress::ToTypedData(*addr);
+  dart_args[2] = Dart_NewInteger(port);
+  dart_args[3] = Dart_NewInteger(type);
+  if (Dart_IsError(dart_args[2])) {
+    Dart_PropagateError(dart_args[2]);
+  }
+}
+
+uint8_t* Socket::UdpReceiveBuffer(intptr_t count) {
+  if (udp_receive_buffer_count_ < count) {
+    free(udp_receive_buffer_);
+    udp_receive_buffer_ =
+        reinterpret_cast<uint8_t*>(malloc(count * kUdpReceiveBufferSize));
+    udp_receive_buffer_count_ = count;
+  }
+  return udp_receive_buffer_;
+}
+
+// Receives the available datagrams, up to the given count, with as few
+// system calls as possible. Returns null if none is available, otherwise a
+// list of the _makeDatagram arguments of each datagram, which are null for
+// datagrams without data.
+void FUNCTION_NAME(Socket_RecvFromBatch)(Dart_NativeArguments args) {
+  static const intptr_t kMaxCount = 64;
+  Socket* socket =
+      Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
+  ASSERT(socket != nullptr);
+  const intptr_t count =
+      DartUtils::GetIntptrValue(Dart_GetNativeArgument(args, 1));
+  ASSERT((count > 0) && (count <= kMaxCount));
+
+  uint8_t* recv_buffer = socket->UdpReceiveBuffer(count);
+  intptr_t lengths[kMaxCount];
+  RawAddr addrs[kMaxCount];
+  const intptr_t received = SocketBase::RecvFromMultiple(
+      socket->fd(), recv_buffer, Socket::kUdpReceiveBufferSize, count,
+      lengths, addrs, SocketBase::kAsync);
+  if (received == 0) {
+    Dart_SetReturnValue(args, Dart_Null());
+    return;
+  }
+  if (received < 0) {
+    ASSERT(received == -1);
+    Dart_ThrowException(DartUtils::NewDartOSError());
+  }
+
+  const intptr_t kNumArgs = 5;
+  Dart_Handle result = Dart_NewList(received * kNumArgs);
+  if (Dart_IsError(result)) {
+    Dart_PropagateError(result);
+  }
+  for (intptr_t i = 0; i < received; i++) {
+    if (lengths[i] == 0) {
+      // Like an unavailable datagram, a datagram without data is received as
+      // null.
+      continue;
+    }
+    // Each datagram gets a buffer of its own, so that code using the buffer
+    // of the data of a datagram keeps working.
+    uint8_t* data_buffer = nullptr;
+    Dart_Handle dart_args[kNumArgs];
+    dart_args[0] = IOBuffer::Allocate(lengths[i], &data_buffer);
+    if (Dart_IsNull(dart_args[0])) {
+      Dart_ThrowException(DartUtils::NewDartOSError());
+    }
+    if (Dart_IsError(dart_args[0])) {
+      Dart_PropagateError(dart_args[0]);
+    }
+    memmove(data_buffer, recv_buffer + i * Socket::kUdpReceiveBufferSize,
+            lengths[i]);
+    GetDatagramAddress(&addrs[i], &dart_args[1]);
+    for (intptr_t j = 0; j < kNumArgs; j++) {
+      ThrowIfError(Dart_ListSetAt(result, i * kNumArgs + j, dart_args[j]));
+    }
+  }
   Dart_SetReturnValue(args, result);
 }
 
@@ -701,6 +723,93 @@ void FUNCTION_NAME(Socket_WriteList)(Dart_NativeArguments args) {
   }
 }
 
+// Writes the buffers of a list of (buffer, start, end) triples with a single
+// system call. The buffers are typed data, which are acquired together for
+// the duration of the write.
+void FUNCTION_NAME(Socket_WriteVector)(Dart_NativeArguments args) {
+  Socket* socket =
+      Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
+  Dart_Handle list_obj = Dart_GetNativeArgument(args, 1);
+  ASSERT(Dart_IsList(list_obj));
+  intptr_t list_length = 0;
+  ThrowIfError(Dart_ListLength(list_obj, &list_length));
+  intptr_t count = list_length / 3;
+  ASSERT((0 < count) && (count <= SocketBase::kMaxWriteVectorCount));
+  Dart_Handle buffer_objs[SocketBase::kMaxWriteVectorCount];
+  // The index of the first entry using the same buffer, which is only
+  // acquired once.
+  intptr_t acquired_index[SocketBase::kMaxWriteVectorCount];
+  const uint8_t* buffers[SocketBase::kMaxWriteVectorCount];
+  intptr_t starts[SocketBase::kMaxWriteVectorCount];
+  intptr_t lengths[SocketBase::kMaxWriteVectorCount];
+  for (intptr_t i = 0; i < count; i++) {
+    buffer_objs[i] = ThrowIfError(Dart_ListGetAt(list_obj, i * 3));
+    starts[i] = DartUtils::GetIntptrValue(
+        ThrowIfError(Dart_ListGetAt(list_obj, i * 3 + 1)));
+    lengths[i] = DartUtils::GetIntptrValue(
+                     ThrowIfError(Dart_ListGetAt(list_obj, i * 3 + 2))) -
+                 starts[i];
+    acquired_index[i] = i;
+    for (intptr_t j = 0; j < i; j++) {
+      if (Dart_IdentityEquals(buffer_objs[i], buffer_objs[j])) {
+        acquired_index[i] = j;
+        break;
+      }
+    }
+  }
+  bool short_write = false;
+  if (Socket::short_socket_write()) {
+    // Only write half of the first buffer, like Socket_WriteList.
+    if (lengths[0] > 1) {
+      short_write = true;
+    }
+    lengths[0] = (lengths[0] + 1) / 2;
+    count = 1;
+  }
+  intptr_t acquired = 0;
+  Dart_Handle result = Dart_Null();
+  for (; acquired < count; acquired++) {
+    const intptr_t i = acquired;
+    if (acquired_index[i] != i) {
+      buffers[i] = buffers[acquired_index[i]] - starts[acquired_index[i]];
+    } else {
+      Dart_TypedData_Type type;
+      void* data = nullptr;
+      intptr_t len;
+      result = Dart_TypedDataAcquireData(buffer_objs[i], &type, &data, &len);
+      if (Dart_IsError(result)) break;
+      ASSERT((starts[i] + lengths[i]) <= len);
+      buffers[i] = reinterpret_cast<uint8_t*>(data);
+    }
+    buffers[i] += starts[i];
+  }
+  intptr_t bytes_written = -1;
+  if (!Dart_IsError(result)) {
+    bytes_written = SocketBase::WriteVector(socket->fd(), buffers, lengths,
+                                            count, SocketBase::kAsync);
+  }
+  OSError os_error(0, nullptr, OSError::kUnknown);
+  if (bytes_written < 0) {
+    // Extract OSError before we release data, as it may override the error.
+    os_error.Reload();
+  }
+  for (intptr_t i = 0; i < acquired; i++) {
+    if (acquired_index[i] == i) {
+      Dart_TypedDataReleaseData(buffer_objs[i]);
+    }
+  }
+  if (Dart_IsError(result)) {
+    Dart_PropagateError(result);
+  }
+  if (bytes_written < 0) {
+    Dart_ThrowException(DartUtils::NewDartOSError(&os_error));
+  }
+  // A forced short write is indicated by a negative number of bytes, as in
+  // Socket_WriteList.
+  Dart_SetIntegerReturnValue(args,
+                             short_write ? -bytes_written : bytes_written);
+}
+
 void FUNCTION_NAME(Socket_SendTo)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
@@ -741,6 +850,49 @@ void FUNCTION_NAME(Socket_SendTo)(Dart_NativeArguments args) {
   }
 }
 
+void FUNCTION_NAME(Socket_SendFile)(Dart_NativeArguments args) {
+  Socket* socket =
+      Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
+  int64_t position = DartUtils::GetNativeIntegerArgument(args, 2);
+  intptr_t count = DartUtils::GetNativeIntptrArgument(args, 3);
+  // The file pointer comes from File_GetPointer, which retains the file. It
+  // is released explicitly, as Dart_ThrowException does not return and would
+  // skip the destructor of a RefCntReleaseScope.
+  File* file =
+      reinterpret_cast<File*>(DartUtils::GetNativeIntptrArgument(args, 1));
+  if (file->IsClosed()) {
+    file->Release();
+    Dart_ThrowException(DartUtils::NewDartArgumentError("File is closed"));
+  }
+  intptr_t bytes_sent =
+      SocketBase::SendFile(socket->fd(), file->GetFD(), position, count);
+  if (bytes_sent >= 0) {
+    file->Release();
+    Dart_SetIntegerReturnValue(args, bytes_sent);
+    return;
+  }
+  Dart_Handle error;
+  {
+    // Extract OSError before we release the file, as it may override the
+    // error.
+    OSError os_error;
+    file->Release();
+    if (os_error.code() == EWOULDBLOCK) {
+      // The socket is full, so the caller waits for a write event.
+      Dart_SetReturnValue(args, Dart_Null());
+      return;
+    }
+    if ((os_error.code() == EINVAL) || (os_error.code() == ENOSYS)) {
+      // sendfile does not support the file, e.g. because it is not a regular
+      // file, so the caller copies it instead.
+      Dart_SetIntegerReturnValue(args, -1);
+      return;
+    }
+    error = DartUtils::NewDartOSError(&os_error);
+  }
+  Dart_ThrowException(error);
+}
+
 void FUNCTION_NAME(Socket_GetPort)(Dart_NativeArguments args) {
   Socket* socket =
       Socket::GetSocketIdNativeField(Dart_GetNativeArgument(args, 0));
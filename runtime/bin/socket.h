@@ -50,6 +50,9 @@ class Socket : public ReferenceCounted<Socket> {
   explicit Socket(intptr_t fd);
 
   intptr_t fd() const { return fd_; }
+  // The descriptor the socket was created with. Unlike fd() it does not
+  // change when the socket is closed, so it may be read from any thread.
+  intptr_t initial_fd() const { return initial_fd_; }
 
   // Close fd and may need to decrement the count of handle by calling
   // release().
@@ -63,8 +66,14 @@ class Socket : public ReferenceCounted<Socket> {
   Dart_Port port() const { return port_; }
   void set_port(Dart_Port port) { port_ = port; }
 
-  uint8_t* udp_receive_buffer() const { return udp_receive_buffer_; }
-  void set_udp_receive_buffer(uint8_t* buffer) { udp_receive_buffer_ = buffer; }
+  // TODO(sgjesse): Use a MTU value here. Only the loopback adapter can
+  // handle 64k datagrams.
+  static const intptr_t kUdpReceiveBufferSize = 65536;
+
+  // Returns a buffer for receiving up to [count] datagrams, made of [count]
+  // consecutive buffers of kUdpReceiveBufferSize bytes. The buffer is reused
+  // by the next receives and grows when more datagrams are requested.
+  uint8_t* UdpReceiveBuffer(intptr_t count);
 
   static bool Initialize();
 
@@ -125,9 +134,11 @@ class Socket : public ReferenceCounted<Socket> {
   static bool short_socket_write_;
 
   intptr_t fd_;
+  const intptr_t initial_fd_;
   Dart_Port isolate_port_;
   Dart_Port port_;
   uint8_t* udp_receive_buffer_;
+  intptr_t udp_receive_buffer_count_;
 
   friend class ReferenceCounted<Socket>;
   DISALLOW_COPY_AND_ASSIGN(Socket);
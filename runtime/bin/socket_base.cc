@@ -306,5 +306,56 @@ void FUNCTION_NAME(SocketBase_IsBindError)(Dart_NativeArguments args) {
   Dart_SetBooleanReturnValue(args, is_bind_error ? true : false);
 }
 
+#if !defined(DART_HOST_OS_LINUX)
+intptr_t SocketBase::RecvFromMultiple(intptr_t fd,
+                                      uint8_t* buffer,
+                                      intptr_t buffer_size,
+                                      intptr_t count,
+                                      intptr_t* lengths,
+                                      RawAddr* addrs,
+                                      SocketOpKind sync) {
+  // Without a system call receiving several datagrams, receive one, as
+  // another RecvFrom may not be able to tell that none is available.
+  ASSERT(count > 0);
+  const intptr_t bytes_read = RecvFrom(fd, buffer, buffer_size, addrs, sync);
+  if (bytes_read <= 0) {
+    return bytes_read;
+  }
+  lengths[0] = bytes_read;
+  return 1;
+}
+#endif  // !defined(DART_HOST_OS_LINUX)
+
+#if defined(DART_HOST_OS_FUCHSIA) || defined(DART_HOST_OS_WINDOWS)
+intptr_t SocketBase::WriteVector(intptr_t fd,
+                                 const uint8_t* const* buffers,
+                                 const intptr_t* lengths,
+                                 intptr_t count,
+                                 SocketOpKind sync) {
+  // Write the buffers one at a time, stopping at the first short write.
+  intptr_t total = 0;
+  for (intptr_t i = 0; i < count; i++) {
+    const intptr_t written = Write(fd, buffers[i], lengths[i], sync);
+    if (written < 0) {
+      return (total > 0) ? total : written;
+    }
+    total += written;
+    if (written < lengths[i]) break;
+  }
+  return total;
+}
+#endif  // defined(DART_HOST_OS_FUCHSIA) || defined(DART_HOST_OS_WINDOWS)
+
+#if !defined(DART_HOST_OS_LINUX) && !defined(DART_HOST_OS_ANDROID)
+intptr_t SocketBase::SendFile(intptr_t fd,
+                              intptr_t file_fd,
+                              int64_t offset,
+                              intptr_t count) {
+  // Socket_SendFile is only called on Linux and Android.
+  UNREACHABLE();
+  return -1;
+}
+#endif  // !defined(DART_HOST_OS_LINUX) && !defined(DART_HOST_OS_ANDROID)
+
 }  // namespace bin
 }  // namespace dart
@@ -174,6 +174,15 @@ class SocketBase : public AllStatic {
                         const void* buffer,
                         intptr_t num_bytes,
                         SocketOpKind sync);
+  // Writes the [count] buffers in [buffers], of the sizes in [lengths], with
+  // a single system call where possible. Like Write, returns the number of
+  // bytes written, which may end in the middle of any of the buffers.
+  static const intptr_t kMaxWriteVectorCount = 64;
+  static intptr_t WriteVector(intptr_t fd,
+                              const uint8_t* const* buffers,
+                              const intptr_t* lengths,
+                              intptr_t count,
+                              SocketOpKind sync);
   // Send data on a socket. The port to send to is specified in the port
   // component of the passed RawAddr structure. The RawAddr structure is only
   // used for datagram sockets.
@@ -187,6 +196,29 @@ class SocketBase : public AllStatic {
                            intptr_t num_bytes,
                            RawAddr* addr,
                            SocketOpKind sync);
+  // Sends up to [count] bytes of the file [file_fd] starting at [offset] on
+  // a socket without copying them to user space. Returns the number of
+  // bytes sent, which is 0 at the end of the file, or -1 on error. The error
+  // is EWOULDBLOCK when the socket is full, and EINVAL or ENOSYS when the
+  // file cannot be sent this way, e.g. because it is not a regular file, in
+  // which case the caller copies it instead. Only supported on Linux and
+  // Android.
+  static intptr_t SendFile(intptr_t fd,
+                           intptr_t file_fd,
+                           int64_t offset,
+                           intptr_t count);
+  // Receives up to [count] datagrams into consecutive buffers of
+  // [buffer_size] bytes starting at [buffer], storing the length and sender
+  // of each in [lengths] and [addrs]. Returns the number of datagrams
+  // received, which is 0 if none is available for a kAsync receive, or -1 on
+  // error.
+  static intptr_t RecvFromMultiple(intptr_t fd,
+                                   uint8_t* buffer,
+                                   intptr_t buffer_size,
+                                   intptr_t count,
+                                   intptr_t* lengths,
+                                   RawAddr* addrs,
+                                   SocketOpKind sync);
   static bool AvailableDatagram(intptr_t fd, void* buffer, intptr_t num_bytes);
   // Returns true if the given error-number is because the system was not able
   // to bind the socket to a specific IP.
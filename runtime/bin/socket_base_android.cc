@@ -14,7 +14,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "bin/fdutils.h"
@@ -123,6 +125,37 @@ intptr_t SocketBase::Write(intptr_t fd,
   return written_bytes;
 }
 
+intptr_t SocketBase::SendFile(intptr_t fd,
+                              intptr_t file_fd,
+                              int64_t offset,
+                              intptr_t count) {
+  ASSERT(fd >= 0);
+  off_t file_offset = offset;
+  return TEMP_FAILURE_RETRY(sendfile(fd, file_fd, &file_offset, count));
+}
+
+intptr_t SocketBase::WriteVector(intptr_t fd,
+                                 const uint8_t* const* buffers,
+                                 const intptr_t* lengths,
+                                 intptr_t count,
+                                 SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  ASSERT((0 < count) && (count <= kMaxWriteVectorCount));
+  struct iovec iov[kMaxWriteVectorCount];
+  for (intptr_t i = 0; i < count; i++) {
+    iov[i].iov_base = const_cast<uint8_t*>(buffers[i]);
+    iov[i].iov_len = lengths[i];
+  }
+  ssize_t written_bytes = TEMP_FAILURE_RETRY(writev(fd, iov, count));
+  ASSERT(EAGAIN == EWOULDBLOCK);
+  if ((sync == kAsync) && (written_bytes == -1) && (errno == EWOULDBLOCK)) {
+    // If the would block we need to retry and therefore return 0 as
+    // the number of bytes written.
+    written_bytes = 0;
+  }
+  return written_bytes;
+}
+
 intptr_t SocketBase::SendTo(intptr_t fd,
                             const void* buffer,
                             intptr_t num_bytes,
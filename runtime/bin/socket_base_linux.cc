@@ -7,15 +7,17 @@
 
 #include "bin/socket_base.h"
 
-#include <errno.h>        // NOLINT
-#include <ifaddrs.h>      // NOLINT
-#include <net/if.h>       // NOLINT
-#include <netinet/tcp.h>  // NOLINT
-#include <stdio.h>        // NOLINT
-#include <stdlib.h>       // NOLINT
-#include <string.h>       // NOLINT
-#include <sys/stat.h>     // NOLINT
-#include <unistd.h>       // NOLINT
+#include <errno.h>         // NOLINT
+#include <ifaddrs.h>       // NOLINT
+#include <net/if.h>        // NOLINT
+#include <netinet/tcp.h>   // NOLINT
+#include <stdio.h>         // NOLINT
+#include <stdlib.h>        // NOLINT
+#include <string.h>        // NOLINT
+#include <sys/sendfile.h>  // NOLINT
+#include <sys/stat.h>      // NOLINT
+#include <sys/uio.h>       // NOLINT
+#include <unistd.h>        // NOLINT
 
 #include "bin/fdutils.h"
 #include "bin/file.h"
@@ -99,6 +101,39 @@ intptr_t SocketBase::RecvFrom(intptr_t fd,
   return read_bytes;
 }
 
+intptr_t SocketBase::RecvFromMultiple(intptr_t fd,
+                                      uint8_t* buffer,
+                                      intptr_t buffer_size,
+                                      intptr_t count,
+                                      intptr_t* lengths,
+                                      RawAddr* addrs,
+                                      SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  static const intptr_t kMaxCount = 64;
+  ASSERT(count <= kMaxCount);
+  struct mmsghdr messages[kMaxCount];
+  struct iovec iovecs[kMaxCount];
+  memset(messages, 0, count * sizeof(struct mmsghdr));
+  for (intptr_t i = 0; i < count; i++) {
+    iovecs[i].iov_base = buffer + i * buffer_size;
+    iovecs[i].iov_len = buffer_size;
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_name = &addrs[i].addr;
+    messages[i].msg_hdr.msg_namelen = sizeof(addrs[i].ss);
+  }
+  int received = TEMP_FAILURE_RETRY(recvmmsg(fd, messages, count, 0, NULL));
+  if ((sync == kAsync) && (received == -1) && (errno == EWOULDBLOCK)) {
+    // If the receive would block we need to retry and therefore return 0
+    // as the number of datagrams received.
+    received = 0;
+  }
+  for (intptr_t i = 0; i < received; i++) {
+    lengths[i] = messages[i].msg_len;
+  }
+  return received;
+}
+
 bool SocketBase::AvailableDatagram(intptr_t fd,
                                    void* buffer,
                                    intptr_t num_bytes) {
@@ -123,6 +158,37 @@ intptr_t SocketBase::Write(intptr_t fd,
   return written_bytes;
 }
 
+intptr_t SocketBase::SendFile(intptr_t fd,
+                              intptr_t file_fd,
+                              int64_t offset,
+                              intptr_t count) {
+  ASSERT(fd >= 0);
+  off64_t file_offset = offset;
+  return TEMP_FAILURE_RETRY(sendfile64(fd, file_fd, &file_offset, count));
+}
+
+intptr_t SocketBase::WriteVector(intptr_t fd,
+                                 const uint8_t* const* buffers,
+                                 const intptr_t* lengths,
+                                 intptr_t count,
+                                 SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  ASSERT((0 < count) && (count <= kMaxWriteVectorCount));
+  struct iovec iov[kMaxWriteVectorCount];
+  for (intptr_t i = 0; i < count; i++) {
+    iov[i].iov_base = const_cast<uint8_t*>(buffers[i]);
+    iov[i].iov_len = lengths[i];
+  }
+  ssize_t written_bytes = TEMP_FAILURE_RETRY(writev(fd, iov, count));
+  ASSERT(EAGAIN == EWOULDBLOCK);
+  if ((sync == kAsync) && (written_bytes == -1) && (errno == EWOULDBLOCK)) {
+    // If the would block we need to retry and therefore return 0 as
+    // the number of bytes written.
+    written_bytes = 0;
+  }
+  return written_bytes;
+}
+
 intptr_t SocketBase::SendTo(intptr_t fd,
                             const void* buffer,
                             intptr_t num_bytes,
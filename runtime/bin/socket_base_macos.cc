@@ -15,6 +15,7 @@
 #include <stdlib.h>       // NOLINT
 #include <string.h>       // NOLINT
 #include <sys/stat.h>     // NOLINT
+#include <sys/uio.h>      // NOLINT
 #include <unistd.h>       // NOLINT
 
 #include "bin/fdutils.h"
@@ -122,6 +123,28 @@ intptr_t SocketBase::Write(intptr_t fd,
   return written_bytes;
 }
 
+intptr_t SocketBase::WriteVector(intptr_t fd,
+                                 const uint8_t* const* buffers,
+                                 const intptr_t* lengths,
+                                 intptr_t count,
+                                 SocketOpKind sync) {
+  ASSERT(fd >= 0);
+  ASSERT((0 < count) && (count <= kMaxWriteVectorCount));
+  struct iovec iov[kMaxWriteVectorCount];
+  for (intptr_t i = 0; i < count; i++) {
+    iov[i].iov_base = const_cast<uint8_t*>(buffers[i]);
+    iov[i].iov_len = lengths[i];
+  }
+  ssize_t written_bytes = TEMP_FAILURE_RETRY(writev(fd, iov, count));
+  ASSERT(EAGAIN == EWOULDBLOCK);
+  if ((sync == kAsync) && (written_bytes == -1) && (errno == EWOULDBLOCK)) {
+    // If the would block we need to retry and therefore return 0 as
+    // the number of bytes written.
+    written_bytes = 0;
+  }
+  return written_bytes;
+}
+
 intptr_t SocketBase::SendTo(intptr_t fd,
                             const void* buffer,
                             intptr_t num_bytes,
@@ -18,9 +18,11 @@ namespace bin {
 Socket::Socket(intptr_t fd)
     : ReferenceCounted(),
       fd_(fd),
+      initial_fd_(fd),
       isolate_port_(Dart_GetMainPortId()),
       port_(ILLEGAL_PORT),
-      udp_receive_buffer_(NULL) {}
+      udp_receive_buffer_(NULL),
+      udp_receive_buffer_count_(0) {}
 
 void Socket::CloseFd() {
   SetClosedFd();
@@ -20,6 +20,7 @@
 #include "vm/longjump.h"
 #include "vm/message_handler.h"
 #include "vm/object.h"
+#include "vm/object_graph_copy.h"
 #include "vm/object_store.h"
 #include "vm/port.h"
 #include "vm/resolver.h"
@@ -110,12 +111,31 @@ DEFINE_NATIVE_ENTRY(SendPortImpl_sendInternal_, 0, 2) {
   if (ApiObjectConverter::CanConvert(obj.ptr())) {
     PortMap::PostMessage(
         Message::New(destination_port_id, obj.ptr(), Message::kNormalPriority));
-  } else {
-    MessageWriter writer(can_send_any_object);
-    // TODO(turnidge): Throw an exception when the return value is false?
-    PortMap::PostMessage(writer.WriteMessage(obj, destination_port_id,
-                                             Message::kNormalPriority));
+    return Object::null();
+  }
+
+  if (FLAG_enable_fast_object_copy && can_send_any_object &&
+      PortMap::IsReceiverInThisIsolateGroup(destination_port_id,
+                                            isolate->group())) {
+    // The receiver shares our heap: copy the message graph directly instead
+    // of serializing and deserializing it.
+    // msg_array = [<message>, <objects-in-message-to-rehash>]
+    const auto& msg_array = Array::Handle(zone, CopyMutableObjectGraph(obj));
+    if (!msg_array.IsNull()) {
+      PersistentHandle* handle =
+          isolate->group()->api_state()->AllocatePersistentHandle();
+      handle->set_ptr(msg_array);
+      PortMap::PostMessage(Message::New(destination_port_id, handle,
+                                        Message::kNormalPriority));
+      return Object::null();
+    }
+    // Fall back to a snapshot, which also reports illegal message objects.
   }
+
+  MessageWriter writer(can_send_any_object);
+  // TODO(turnidge): Throw an exception when the return value is false?
+  PortMap::PostMessage(
+      writer.WriteMessage(obj, destination_port_id, Message::kNormalPriority));
   return Object::null();
 }
 
@@ -0,0 +1,81 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Verify creating an AOT snapshot twice generates the same bits.
+
+import "dart:async";
+import "dart:io";
+
+import 'package:expect/expect.dart';
+import 'package:path/path.dart' as path;
+
+import 'use_flag_test_helper.dart';
+
+main(List<String> args) async {
+  if (!isAOTRuntime) {
+    return; // Running in JIT: AOT binaries not available.
+  }
+
+  if (Platform.isAndroid) {
+    return; // SDK tree and gen_snapshot not available on the test device.
+  }
+
+  await withTempDir('aot-determinism-test', (String tempDir) async {
+    final script = path.join(sdkDir, 'pkg/kernel/bin/dump.dart');
+    final scriptDill = path.join(tempDir, 'kernel_dump.dill');
+
+    // Compile script to Kernel IR.
+    await run(genKernel, <String>[
+      '--aot',
+      '--platform=$platformDill',
+      '-o',
+      scriptDill,
+      script,
+    ]);
+
+    // Run the AOT compiler twice.
+    await expectSameSnapshots(tempDir, scriptDill, 'snapshot', [], []);
+
+    // Functions compiled in batches on helper threads must not depend on the
+    // number of helpers.
+    await expectSameSnapshots(tempDir, scriptDill, 'workers',
+        ['--precompiler_workers=1'], ['--precompiler_workers=4']);
+  });
+}
+
+// Runs the AOT compiler on [scriptDill] with [flags1] and with [flags2] and
+// checks that both snapshots have the same bits.
+Future<void> expectSameSnapshots(String tempDir, String scriptDill,
+    String name, List<String> flags1, List<String> flags2) async {
+  final snapshot1 = path.join(tempDir, '${name}1.so');
+  final snapshot2 = path.join(tempDir, '${name}2.so');
+  await Future.wait(<Future>[
+    run(genSnapshot, <String>[
+      ...flags1,
+      '--deterministic',
+      '--snapshot-kind=app-aot-elf',
+      '--elf=$snapshot1',
+      scriptDill,
+    ]),
+    run(genSnapshot, <String>[
+      ...flags2,
+      '--deterministic',
+      '--snapshot-kind=app-aot-elf',
+      '--elf=$snapshot2',
+      scriptDill,
+    ]),
+  ]);
+
+  final snapshot1Bytes = await new File(snapshot1).readAsBytes();
+  final snapshot2Bytes = await new File(snapshot2).readAsBytes();
+  final minLength = snapshot1Bytes.length < snapshot2Bytes.length
+      ? snapshot1Bytes.length
+      : snapshot2Bytes.length;
+  for (var i = 0; i < minLength; i++) {
+    if (snapshot1Bytes[i] != snapshot2Bytes[i]) {
+      Expect.fail("Snapshots $name differ at byte $i");
+    }
+  }
+  Expect.equals(snapshot1Bytes.length, snapshot2Bytes.length);
+}
@@ -16,9 +16,16 @@
 #include "platform/utils.h"
 
 #include "vm/clustered_snapshot.h"
+#if !defined(DART_PRECOMPILED_RUNTIME)
+#include "vm/compiler/backend/il_test_helper.h"
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
 #include "vm/dart_api_impl.h"
 #include "vm/datastream.h"
+#include "vm/lockers.h"
+#include "vm/message_handler.h"
+#include "vm/port.h"
 #include "vm/stack_frame.h"
+#include "vm/thread_pool.h"
 #include "vm/timer.h"
 
 using dart::bin::File;
@@ -612,6 +619,202 @@ BENCHMARK(LargeMap) {
   benchmark->set_score(elapsed_time);
 }
 
+class PortLookupMessageHandler : public MessageHandler {
+ public:
+  PortLookupMessageHandler() {}
+
+  MessageStatus HandleMessage(std::unique_ptr<Message> message) {
+    return kOK;
+  }
+};
+
+class PortLookupTask : public ThreadPool::Task {
+ public:
+  PortLookupTask(const Dart_Port* ports,
+                 intptr_t num_ports,
+                 intptr_t num_lookups,
+                 Monitor* monitor,
+                 intptr_t* done)
+      : ports_(ports),
+        num_ports_(num_ports),
+        num_lookups_(num_lookups),
+        monitor_(monitor),
+        done_(done) {}
+
+  virtual void Run() {
+    intptr_t live = 0;
+    for (intptr_t i = 0; i < num_lookups_; i++) {
+      if (PortMap::IsLivePort(ports_[i % num_ports_])) {
+        live++;
+      }
+    }
+    EXPECT_EQ(num_lookups_, live);
+    MonitorLocker ml(monitor_);
+    ++*done_;
+    ml.Notify();
+  }
+
+ private:
+  const Dart_Port* ports_;
+  const intptr_t num_ports_;
+  const intptr_t num_lookups_;
+  Monitor* monitor_;
+  intptr_t* done_;
+};
+
+//
+// Measure concurrent port lookups, as done when posting messages, from
+// several threads at once.
+//
+BENCHMARK(PortMapLookup) {
+  const intptr_t kNumPorts = 1024;
+  const intptr_t kNumTasks = 8;
+  const intptr_t kLookupsPerTask = 1000000;
+  PortLookupMessageHandler handler;
+  Dart_Port* ports = new Dart_Port[kNumPorts];
+  for (intptr_t i = 0; i < kNumPorts; i++) {
+    ports[i] = PortMap::CreatePort(&handler);
+    PortMap::SetPortState(ports[i], PortMap::kLivePort);
+  }
+
+  Monitor monitor;
+  intptr_t done = 0;
+  Timer timer;
+  timer.Start();
+  for (intptr_t i = 0; i < kNumTasks; i++) {
+    // Start each task at a different port.
+    const intptr_t first = (i * kNumPorts) / kNumTasks;
+    Dart::thread_pool()->Run<PortLookupTask>(&ports[first], kNumPorts - first,
+                                             kLookupsPerTask, &monitor, &done);
+  }
+  {
+    MonitorLocker ml(&monitor);
+    while (done < kNumTasks) {
+      ml.Wait();
+    }
+  }
+  timer.Stop();
+  int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+
+  PortMap::ClosePorts(&handler);
+  delete[] ports;
+}
+
+#if defined(DART_PRECOMPILER)
+
+DECLARE_FLAG(bool, coalescing_aot_allocator);
+
+// A tokenizer shaped like the hot loops of parsers and state machines: many
+// values live across a loop with several joins.
+static const char* kStateMachineScriptChars = R"(
+  int tokenize(String s) {
+    int state = 0, start = 0, tokens = 0, idents = 0, numbers = 0;
+    int value = 0, hash = 7, depth = 0, maxDepth = 0;
+    for (int i = 0; i < s.length; i++) {
+      final int c = s.codeUnitAt(i);
+      switch (state) {
+        case 0:
+          if (c >= 48 && c <= 57) {
+            state = 1;
+            start = i;
+            value = c - 48;
+          } else if (c >= 97 && c <= 122) {
+            state = 2;
+            start = i;
+            hash = hash * 31 + c;
+          } else if (c == 40) {
+            depth++;
+            if (depth > maxDepth) maxDepth = depth;
+          } else if (c == 41) {
+            depth--;
+          }
+          break;
+        case 1:
+          if (c >= 48 && c <= 57) {
+            value = value * 10 + (c - 48);
+          } else {
+            state = 0;
+            numbers += value;
+            tokens++;
+          }
+          break;
+        case 2:
+          if ((c >= 97 && c <= 122) || (c >= 48 && c <= 57)) {
+            hash = (hash * 31 + c) & 0x3fffffff;
+          } else {
+            state = 0;
+            idents += i - start;
+            tokens++;
+          }
+          break;
+      }
+    }
+    return tokens + idents + numbers + hash + maxDepth;
+  }
+  main() => tokenize('(foo 12 (bar3 45) baz)');
+)";
+
+// Compiles "tokenize" with the AOT pipeline and returns the size of the
+// generated code and the number of spill slots the register allocator
+// needed.
+static void CompileStateMachine(Thread* thread,
+                                bool coalesce_phi_moves,
+                                intptr_t* code_size,
+                                intptr_t* spill_slot_count) {
+  TransitionNativeToVM transition(thread);
+  StackZone zone(thread);
+  HANDLESCOPE(thread);
+
+  const bool saved_coalescing_aot_allocator = FLAG_coalescing_aot_allocator;
+  FLAG_coalescing_aot_allocator = coalesce_phi_moves;
+  const auto& root_library =
+      Library::Handle(LoadTestScript(kStateMachineScriptChars));
+  const auto& function =
+      Function::Handle(GetFunction(root_library, "tokenize"));
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  pipeline.CompileGraphAndAttachFunction();
+  FLAG_coalescing_aot_allocator = saved_coalescing_aot_allocator;
+
+  *code_size = Code::Handle(function.CurrentCode()).Size();
+  *spill_slot_count = flow_graph->graph_entry()->spill_slot_count();
+}
+
+//
+// Compare the AOT register allocator with and without coalescing of phi
+// moves (CompilerPass::kAllocateRegisters).
+//
+BENCHMARK_SIZE(AllocateRegistersCodeSize) {
+  intptr_t code_size = 0, spill_slot_count = 0;
+  CompileStateMachine(thread, /*coalesce_phi_moves=*/true, &code_size,
+                      &spill_slot_count);
+  benchmark->set_score(code_size);
+}
+
+BENCHMARK_SIZE(AllocateRegistersSpillSlots) {
+  intptr_t code_size = 0, spill_slot_count = 0;
+  CompileStateMachine(thread, /*coalesce_phi_moves=*/true, &code_size,
+                      &spill_slot_count);
+  benchmark->set_score(spill_slot_count);
+}
+
+BENCHMARK_SIZE(AllocateRegistersNoCoalescingCodeSize) {
+  intptr_t code_size = 0, spill_slot_count = 0;
+  CompileStateMachine(thread, /*coalesce_phi_moves=*/false, &code_size,
+                      &spill_slot_count);
+  benchmark->set_score(code_size);
+}
+
+BENCHMARK_SIZE(AllocateRegistersNoCoalescingSpillSlots) {
+  intptr_t code_size = 0, spill_slot_count = 0;
+  CompileStateMachine(thread, /*coalesce_phi_moves=*/false, &code_size,
+                      &spill_slot_count);
+  benchmark->set_score(spill_slot_count);
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
 BENCHMARK_MEMORY(InitialRSS) {
   benchmark->set_score(bin::Process::MaxRSS());
 }
@@ -35,6 +35,7 @@
 #if !defined(DART_PRECOMPILED_RUNTIME)
 #include "vm/compiler/backend/code_statistics.h"
 #include "vm/compiler/backend/il_printer.h"
+#include "vm/compiler/function_order.h"
 #include "vm/compiler/relocation.h"
 #endif  // !defined(DART_PRECOMPILED_RUNTIME)
 
@@ -6528,6 +6529,12 @@ intptr_t Serializer::PrepareInstructions() {
   // that allows for mapping return addresses back to Code objects depends on
   // this sorting.
   if (code_cluster_ != nullptr) {
+#if defined(DART_PRECOMPILER)
+    // Lay out the code of the hottest functions of a training run first.
+    if (kind() == Snapshot::kFullAOT) {
+      FunctionOrder::SortIfRequested(zone(), code_cluster_->objects());
+    }
+#endif  // defined(DART_PRECOMPILER)
     CodeSerializationCluster::Sort(code_cluster_->objects());
   }
   if ((loading_units_ != nullptr) &&
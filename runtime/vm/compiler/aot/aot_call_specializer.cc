@@ -17,6 +17,7 @@
 #include "vm/compiler/frontend/flow_graph_builder.h"
 #include "vm/compiler/jit/compiler.h"
 #include "vm/compiler/jit/jit_call_specializer.h"
+#include "vm/compiler/type_feedback.h"
 #include "vm/cpu.h"
 #include "vm/dart_entry.h"
 #include "vm/exceptions.h"
@@ -927,6 +928,10 @@ void AotCallSpecializer::VisitInstanceCall(InstanceCallInstr* instr) {
     }
   }
 
+  if (targets.is_empty() && TryUseTypeFeedback(instr)) {
+    return;
+  }
+
   // More than one target. Generate generic polymorphic call without
   // deoptimization.
   if (targets.length() > 0) {
@@ -941,6 +946,63 @@ void AotCallSpecializer::VisitInstanceCall(InstanceCallInstr* instr) {
   }
 }
 
+bool AotCallSpecializer::TryUseTypeFeedback(InstanceCallInstr* instr) {
+  if ((precompiler_ == nullptr) || (precompiler_->type_feedback() == nullptr)) {
+    return false;
+  }
+  // The targets recorded for this call were already inlined.
+  if (instr->is_speculation_fallback()) {
+    return false;
+  }
+  // Token positions of inlined calls refer to the script of the inlined
+  // function.
+  if (instr->inlining_id() > 0) {
+    return false;
+  }
+
+  const Function& function = flow_graph()->function();
+  const auto* receivers = precompiler_->type_feedback()->LookupReceivers(
+      Script::Handle(Z, function.script()), instr->token_pos(),
+      instr->function_name());
+  if (receivers == nullptr) {
+    return false;
+  }
+
+  const Array& args_desc_array =
+      Array::Handle(Z, instr->GetArgumentsDescriptor());
+  const ICData& ic_data = ICData::Handle(
+      Z, ICData::New(function, instr->function_name(), args_desc_array,
+                     DeoptId::kNone, /* args_tested = */ 1,
+                     ICData::kOptimized));
+  Class& cls = Class::Handle(Z);
+  Function& target = Function::Handle(Z);
+  for (intptr_t i = 0; i < receivers->length(); i++) {
+    const TypeFeedback::Receiver& receiver = receivers->At(i);
+    if (receiver.cid == kIllegalCid) continue;
+    cls = IG->class_table()->At(receiver.cid);
+    target = instr->ResolveForReceiverClass(cls, /*allow_add=*/false);
+    if (target.IsNull() || target.IsInvokeFieldDispatcher() ||
+        target.IsNoSuchMethodDispatcher()) {
+      continue;
+    }
+    ic_data.AddReceiverCheck(receiver.cid, target, receiver.count);
+  }
+  if (ic_data.NumberOfChecks() == 0 ||
+      ic_data.NumberOfChecks() > FLAG_max_polymorphic_checks) {
+    return false;
+  }
+
+  // The generic call for receivers not covered by the speculative targets
+  // needs the ICData of the original call.
+  EnsureICData(Z, function, instr);
+  const CallTargets* targets = CallTargets::Create(Z, ic_data);
+  PolymorphicInstanceCallInstr* call = PolymorphicInstanceCallInstr::FromCall(
+      Z, instr, *targets, /* complete = */ false);
+  call->set_has_speculative_targets(true);
+  instr->ReplaceWith(call, current_iterator());
+  return true;
+}
+
 void AotCallSpecializer::VisitStaticCall(StaticCallInstr* instr) {
   if (TryInlineFieldAccess(instr)) {
     return;
@@ -75,6 +75,12 @@ class AotCallSpecializer : public CallSpecializer {
   bool TryExpandCallThroughGetter(const Class& receiver_class,
                                   InstanceCallInstr* call);
 
+  // Replace an instance call which could not be devirtualized by a
+  // polymorphic call with speculative targets for the receiver classes
+  // recorded by a JIT training run, which the inliner can inline behind class
+  // id checks.
+  bool TryUseTypeFeedback(InstanceCallInstr* call);
+
   Definition* TryOptimizeMod(TemplateDartCall<0>* instr,
                              Token::Kind op_kind,
                              Value* left_value,
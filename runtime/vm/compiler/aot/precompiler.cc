@@ -31,11 +31,14 @@
 #include "vm/compiler/frontend/flow_graph_builder.h"
 #include "vm/compiler/frontend/kernel_to_il.h"
 #include "vm/compiler/jit/compiler.h"
+#include "vm/compiler/type_feedback.h"
+#include "vm/dart.h"
 #include "vm/dart_entry.h"
 #include "vm/exceptions.h"
 #include "vm/flags.h"
 #include "vm/hash_table.h"
 #include "vm/isolate.h"
+#include "vm/lockers.h"
 #include "vm/log.h"
 #include "vm/longjump.h"
 #include "vm/object.h"
@@ -49,6 +52,7 @@
 #include "vm/runtime_entry.h"
 #include "vm/symbols.h"
 #include "vm/tags.h"
+#include "vm/thread_pool.h"
 #include "vm/timeline.h"
 #include "vm/timer.h"
 #include "vm/type_testing_stubs.h"
@@ -73,6 +77,12 @@ DEFINE_FLAG(
     max_speculative_inlining_attempts,
     1,
     "Max number of attempts with speculative inlining (precompilation only)");
+DEFINE_FLAG(int,
+            precompiler_workers,
+            0,
+            "Number of helper threads building and optimizing flow graphs while "
+            "precompiling (0 compiles all functions on the precompiler's "
+            "thread).");
 DEFINE_FLAG(charp,
             write_retained_reasons_to,
             nullptr,
@@ -324,11 +334,15 @@ class PrecompileParsedFunctionHelper : public ValueObject {
  public:
   PrecompileParsedFunctionHelper(Precompiler* precompiler,
                                  ParsedFunction* parsed_function,
-                                 bool optimized)
+                                 bool optimized,
+                                 PrecompilerBatch* batch = nullptr,
+                                 intptr_t batch_index = -1)
       : precompiler_(precompiler),
         parsed_function_(parsed_function),
         optimized_(optimized),
-        thread_(Thread::Current()) {}
+        thread_(Thread::Current()),
+        batch_(batch),
+        batch_index_(batch_index) {}
 
   bool Compile(CompilationPipeline* pipeline);
 
@@ -347,10 +361,134 @@ class PrecompileParsedFunctionHelper : public ValueObject {
   ParsedFunction* parsed_function_;
   const bool optimized_;
   Thread* const thread_;
+  PrecompilerBatch* const batch_;
+  const intptr_t batch_index_;
 
   DISALLOW_COPY_AND_ASSIGN(PrecompileParsedFunctionHelper);
 };
 
+// Functions the precompiler compiles together, building and optimizing their
+// flow graphs concurrently on helper threads (see --precompiler_workers).
+//
+// Code is generated, installed and committed to the global object pool one
+// function at a time, in the order the functions were taken off the pending
+// list, and the precompiler only looks at the results once the whole batch is
+// done (see Precompiler::ProcessBatch). The compilations of a batch don't
+// cache anything on the functions they look at (see
+// CompilerState::is_batch_compilation), and a helper that would need an
+// object only the mutator creates (e.g. a closure function) gives its
+// function back to the precompiler's thread, which compiles it when its turn
+// comes. The generated code therefore depends neither on the number of
+// helpers nor on their timing.
+class PrecompilerBatch : public ValueObject {
+ public:
+  // Fixed rather than derived from --precompiler_workers: which functions
+  // share a batch, and so don't see what the others cache, must not depend on
+  // the number of helpers.
+  static constexpr intptr_t kMaxLength = 128;
+
+  enum class State {
+    kPending,     // Not claimed by a helper yet.
+    kCompiling,   // A helper builds and optimizes the flow graph.
+    kWaiting,     // The helper waits for its turn to generate code.
+    kGenerating,  // The helper generates and commits code.
+    kCommitted,   // The helper waits for the results to be taken.
+    kDone,        // The results were taken.
+    kFallback,    // Left to the precompiler's thread.
+  };
+
+  struct Item {
+    const Function* function;
+    State state;
+
+    // Set by a helper which committed the function, see Commit.
+    FlowGraphCompiler* graph_compiler;
+    const CompilerPassState* pass_state;
+
+    // The results of the compilation, see TakeResults.
+    ZoneGrowableArray<const Field*>* used_static_fields;
+    ZoneGrowableArray<const compiler::TableSelector*>* call_selectors;
+    intptr_t instruction_count;
+    intptr_t call_site_count;
+    intptr_t inlining_depth;
+    // End of the global object pool entries added while compiling the
+    // function, they start at the end of the previous function's.
+    intptr_t gop_end;
+  };
+
+  explicit PrecompilerBatch(Precompiler* precompiler)
+      : precompiler_(precompiler),
+        isolate_group_(precompiler->thread()->isolate_group()),
+        type_usage_info_(precompiler->thread()->type_usage_info()),
+        items_(precompiler->zone(), kMaxLength) {}
+
+  intptr_t length() const { return items_.length(); }
+  const Item& At(intptr_t index) const { return items_[index]; }
+
+  void Add(const Function& function) {
+    ASSERT(length() < kMaxLength);
+    Item item = {};
+    item.function = &Function::ZoneHandle(precompiler_->zone(), function.ptr());
+    // Only the mutator installs unoptimized code, and ffi trampolines are
+    // left to it as well.
+    const bool needs_mutator =
+        !function.IsOptimizable() ||
+        (function.kind() == UntaggedFunction::kFfiTrampoline);
+    item.state = needs_mutator ? State::kFallback : State::kPending;
+    items_.Add(item);
+  }
+
+  // Compiles all functions of the batch on the precompiler's thread and the
+  // helpers. Returns the first error, if any.
+  ErrorPtr Compile();
+
+  // Called by the compilation of the [index]th function before it generates
+  // code. On a helper, waits until the functions before it are committed.
+  void WaitForTurn(intptr_t index);
+
+  // Called by the compilation of the [index]th function once its code is
+  // installed and its object pool committed.
+  void Commit(intptr_t index,
+              FlowGraphCompiler* graph_compiler,
+              const CompilerPassState& pass_state);
+
+  // Claims and compiles functions on a helper until none are left.
+  void RunWorker();
+
+ private:
+  void CompileOnWorker(intptr_t index);
+  ErrorPtr CompileOnPrecompilerThread(intptr_t index);
+  void TakeResults(Item* item,
+                   FlowGraphCompiler* graph_compiler,
+                   const CompilerPassState& pass_state);
+
+  Precompiler* const precompiler_;
+  IsolateGroup* const isolate_group_;
+  // Shared with the helper that holds the turn.
+  TypeUsageInfo* const type_usage_info_;
+  GrowableArray<Item> items_;
+
+  // Guards the states of the items and the fields below.
+  Monitor monitor_;
+  intptr_t next_pending_ = 0;
+  intptr_t active_workers_ = 0;
+  bool cancelled_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(PrecompilerBatch);
+};
+
+class PrecompilerWorkerTask : public ThreadPool::Task {
+ public:
+  explicit PrecompilerWorkerTask(PrecompilerBatch* batch) : batch_(batch) {}
+
+  virtual void Run() { batch_->RunWorker(); }
+
+ private:
+  PrecompilerBatch* const batch_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrecompilerWorkerTask);
+};
+
 static void Jump(const Error& error) {
   Thread::Current()->long_jump_base()->Jump(1, error);
 }
@@ -451,6 +589,8 @@ void Precompiler::DoCompileAll() {
       retained_reasons_writer_ = &reasons_writer;
     }
 
+    type_feedback_ = TypeFeedback::ReadIfRequested(zone_);
+
     if (FLAG_use_bare_instructions) {
       // Since we keep the object pool until the end of AOT compilation, it
       // will hang on to its entries until the very end. Therefore we have
@@ -703,6 +843,9 @@ void Precompiler::PrecompileConstructors() {
     Zone* zone_;
   };
 
+  // Constructors are compiled one by one on the precompiler's thread, without
+  // generating code, and never in batches (see PrecompilerBatch): the counts
+  // cached on each of them are what later compilations are meant to see.
   phase_ = Phase::kCompilingConstructorsForInstructionCounts;
   HANDLESCOPE(T);
   ConstructorVisitor visitor(this, Z);
@@ -758,6 +901,10 @@ void Precompiler::Iterate() {
     changed_ = false;
 
     while (pending_functions_.Length() > 0) {
+      if (CanCompileInBatches()) {
+        ProcessBatch();
+        continue;
+      }
       function ^= pending_functions_.RemoveLast();
       ProcessFunction(function);
     }
@@ -863,10 +1010,80 @@ void Precompiler::ProcessFunction(const Function& function) {
 
   // Used in the JIT to save type-feedback across compilations.
   function.ClearICDataArray();
-  AddCalleesOf(function, gop_offset);
+  AddCalleesOf(function, gop_offset,
+               FLAG_use_bare_instructions
+                   ? global_object_pool_builder()->CurrentLength()
+                   : 0);
+}
+
+bool Precompiler::CanCompileInBatches() {
+  // The tracer and the obfuscator are not thread-safe, and disassembling is
+  // left to PrecompileFunctionHelper.
+  return (FLAG_precompiler_workers > 0) && (tracer_ == nullptr) &&
+         !IG->obfuscate() && !FLAG_disassemble && !FLAG_disassemble_optimized;
+}
+
+void Precompiler::ProcessBatch() {
+  PrecompilerBatch batch(this);
+  Function& function = Function::Handle(Z);
+  while ((batch.length() < PrecompilerBatch::kMaxLength) &&
+         (pending_functions_.Length() > 0)) {
+    function ^= pending_functions_.RemoveLast();
+    RELEASE_ASSERT(!function.HasCode());
+    // Ffi trampoline functions have no signature.
+    ASSERT(function.kind() == UntaggedFunction::kFfiTrampoline ||
+           FunctionType::Handle(Z, function.signature()).IsFinalized());
+    ASSERT(!function.is_abstract());
+    batch.Add(function);
+  }
+
+  intptr_t gop_offset = FLAG_use_bare_instructions
+                            ? global_object_pool_builder()->CurrentLength()
+                            : 0;
+  error_ = batch.Compile();
+  if (!error_.IsNull()) {
+    Jump(error_);
+  }
+
+  // Record what the functions use in the order a sequential compilation
+  // would have, and only now cache what their compilations computed.
+  for (intptr_t i = 0; i < batch.length(); i++) {
+    const PrecompilerBatch::Item& item = batch.At(i);
+    ASSERT(item.state == PrecompilerBatch::State::kDone);
+    const Function& function = *item.function;
+    function_count_++;
+
+    if (FLAG_trace_precompiler) {
+      THR_Print("Precompiling %" Pd " %s (%s, %s)\n", function_count_,
+                function.ToLibNamePrefixedQualifiedCString(),
+                function.token_pos().ToCString(),
+                Function::KindToCString(function.kind()));
+    }
+
+    if (function.IsOptimizable()) {
+      // See the FinalizeGraph pass.
+      function.SetOptimizedInstructionCountClamped(item.instruction_count);
+      function.SetOptimizedCallSiteCountClamped(item.call_site_count);
+      function.set_inlining_depth(item.inlining_depth);
+    }
+
+    for (intptr_t j = 0; j < item.used_static_fields->length(); j++) {
+      AddField(*item.used_static_fields->At(j));
+    }
+    for (intptr_t j = 0; j < item.call_selectors->length(); j++) {
+      AddTableSelector(item.call_selectors->At(j));
+    }
+
+    // Used in the JIT to save type-feedback across compilations.
+    function.ClearICDataArray();
+    AddCalleesOf(function, gop_offset, item.gop_end);
+    gop_offset = item.gop_end;
+  }
 }
 
-void Precompiler::AddCalleesOf(const Function& function, intptr_t gop_offset) {
+void Precompiler::AddCalleesOf(const Function& function,
+                               intptr_t gop_offset,
+                               intptr_t gop_end) {
   ASSERT(function.HasCode());
 
   const Code& code = Code::Handle(Z, function.CurrentCode());
@@ -932,8 +1149,7 @@ void Precompiler::AddCalleesOf(const Function& function, intptr_t gop_offset) {
   // *all* outgoing references into the trace. Scanning GOP would exclude
   // references that have been deduplicated.
   if (FLAG_use_bare_instructions && !is_tracing()) {
-    for (intptr_t i = gop_offset;
-         i < global_object_pool_builder()->CurrentLength(); i++) {
+    for (intptr_t i = gop_offset; i < gop_end; i++) {
       const auto& wrapper_entry = global_object_pool_builder()->EntryAt(i);
       if (wrapper_entry.type() ==
           compiler::ObjectPoolBuilderEntry::kTaggedObject) {
@@ -3000,7 +3216,7 @@ void PrecompileParsedFunctionHelper::FinalizeCompilation(
 
   if (optimized()) {
     // Installs code while at safepoint.
-    ASSERT(thread()->IsMutatorThread());
+    ASSERT(thread()->IsMutatorThread() || (batch_ != nullptr));
     function.InstallOptimizedCode(code);
   } else {  // not optimized.
     function.set_unoptimized_code(code);
@@ -3052,6 +3268,7 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
 
       CompilerState compiler_state(thread(), /*is_aot=*/true, optimized(),
                                    CompilerState::ShouldTrace(function));
+      compiler_state.set_is_batch_compilation(batch_ != nullptr);
 
       {
         ic_data_array = new (zone) ZoneGrowableArray<const ICData*>();
@@ -3101,6 +3318,20 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
 
       ASSERT(!FLAG_use_bare_instructions || precompiler_ != nullptr);
 
+      if (precompiler_->phase() ==
+          Precompiler::Phase::kCompilingConstructorsForInstructionCounts) {
+        // Constructors are only compiled at this point for the instruction
+        // and call site counts cached on them by the FinalizeGraph pass. Their
+        // code is cleared right afterwards, so don't generate it.
+        is_compiled = true;
+        done = true;
+        continue;
+      }
+
+      if (batch_ != nullptr) {
+        batch_->WaitForTurn(batch_index_);
+      }
+
       if (FLAG_use_bare_instructions) {
         // When generating code in bare instruction mode all code objects
         // share the same global object pool. To reduce interleaving of
@@ -3151,13 +3382,15 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
       {
         COMPILER_TIMINGS_TIMER_SCOPE(thread(), FinalizeCode);
         TIMELINE_DURATION(thread(), CompilerVerbose, "FinalizeCompilation");
-        ASSERT(thread()->IsMutatorThread());
+        ASSERT(thread()->IsMutatorThread() || (batch_ != nullptr));
         FinalizeCompilation(&assembler, &graph_compiler, flow_graph,
                             function_stats);
       }
 
-      if (precompiler_->phase() ==
-          Precompiler::Phase::kFixpointCodeGeneration) {
+      // We should not be generating code outside of the fixpoint.
+      RELEASE_ASSERT(precompiler_->phase() ==
+                     Precompiler::Phase::kFixpointCodeGeneration);
+      if (batch_ == nullptr) {
         for (intptr_t i = 0; i < graph_compiler.used_static_fields().length();
              i++) {
           precompiler_->AddField(*graph_compiler.used_static_fields().At(i));
@@ -3168,12 +3401,6 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         for (intptr_t i = 0; i < call_selectors.length(); i++) {
           precompiler_->AddTableSelector(call_selectors[i]);
         }
-      } else {
-        // We should not be generating code outside of these two specific
-        // precompilation phases.
-        RELEASE_ASSERT(
-            precompiler_->phase() ==
-            Precompiler::Phase::kCompilingConstructorsForInstructionCounts);
       }
 
       // In bare instructions mode try adding all entries from the object
@@ -3194,6 +3421,9 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         done = false;
         continue;
       }
+      if (batch_ != nullptr) {
+        batch_->Commit(batch_index_, &graph_compiler, pass_state);
+      }
       // Exit the loop and the function with the correct result value.
       is_compiled = true;
       done = true;
@@ -3247,7 +3477,9 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
 static ErrorPtr PrecompileFunctionHelper(Precompiler* precompiler,
                                          CompilationPipeline* pipeline,
                                          const Function& function,
-                                         bool optimized) {
+                                         bool optimized,
+                                         PrecompilerBatch* batch,
+                                         intptr_t batch_index) {
   // Check that we optimize, except if the function is not optimizable.
   ASSERT(CompilerState::Current().is_aot());
   ASSERT(!function.IsOptimizable() || optimized);
@@ -3276,7 +3508,7 @@ static ErrorPtr PrecompileFunctionHelper(Precompiler* precompiler,
     }
 
     PrecompileParsedFunctionHelper helper(precompiler, parsed_function,
-                                          optimized);
+                                          optimized, batch, batch_index);
     const bool success = helper.Compile(pipeline);
     if (!success) {
       // We got an error during compilation.
@@ -3288,6 +3520,11 @@ static ErrorPtr PrecompileFunctionHelper(Precompiler* precompiler,
 
     per_compile_timer.Stop();
 
+    // Constructors compiled for their instruction counts have no code.
+    if (!function.HasCode()) {
+      return Error::null();
+    }
+
     if (trace_compiler) {
       THR_Print("--> '%s' entry: %#" Px " size: %" Pd " time: %" Pd64 " us\n",
                 function.ToFullyQualifiedCString(),
@@ -3322,7 +3559,9 @@ static ErrorPtr PrecompileFunctionHelper(Precompiler* precompiler,
 ErrorPtr Precompiler::CompileFunction(Precompiler* precompiler,
                                       Thread* thread,
                                       Zone* zone,
-                                      const Function& function) {
+                                      const Function& function,
+                                      PrecompilerBatch* batch,
+                                      intptr_t batch_index) {
   PRECOMPILER_TIMER_SCOPE(precompiler, CompileFunction);
   NoActiveIsolateScope no_isolate_scope;
 
@@ -3336,7 +3575,245 @@ ErrorPtr Precompiler::CompileFunction(Precompiler* precompiler,
     precompiler->tracer_->WriteCompileFunctionEvent(function);
   }
 
-  return PrecompileFunctionHelper(precompiler, &pipeline, function, optimized);
+  return PrecompileFunctionHelper(precompiler, &pipeline, function, optimized,
+                                  batch, batch_index);
+}
+
+ErrorPtr PrecompilerBatch::Compile() {
+  Thread* const thread = Thread::Current();
+  ASSERT(thread->IsMutatorThread());
+  {
+    SafepointMonitorLocker ml(&monitor_);
+    const intptr_t num_workers =
+        Utils::Minimum<intptr_t>(FLAG_precompiler_workers, length());
+    for (intptr_t i = 0; i < num_workers; i++) {
+      if (!Dart::thread_pool()->Run<PrecompilerWorkerTask>(this)) {
+        break;
+      }
+      active_workers_++;
+    }
+  }
+
+  Error& error = Error::Handle(precompiler_->zone());
+  for (intptr_t i = 0; i < length(); i++) {
+    Item* const item = &items_[i];
+    bool committed = false;
+    {
+      SafepointMonitorLocker ml(&monitor_);
+      while (true) {
+        if ((item->state == State::kPending) && (active_workers_ == 0)) {
+          // No helper could be started.
+          item->state = State::kFallback;
+        } else if (item->state == State::kWaiting) {
+          // All functions before it are committed.
+          item->state = State::kGenerating;
+          ml.NotifyAll();
+        }
+        if ((item->state == State::kCommitted) ||
+            (item->state == State::kFallback)) {
+          break;
+        }
+        ml.Wait();
+      }
+      committed = (item->state == State::kCommitted);
+    }
+    if (committed) {
+      // The helper waits in Commit until the results are taken.
+      TakeResults(item, item->graph_compiler, *item->pass_state);
+      SafepointMonitorLocker ml(&monitor_);
+      item->state = State::kDone;
+      ml.NotifyAll();
+    } else {
+      error = CompileOnPrecompilerThread(i);
+      if (!error.IsNull()) {
+        break;
+      }
+    }
+  }
+
+  // Helpers only have functions left if one failed to compile. Those waiting
+  // for their turn give up.
+  SafepointMonitorLocker ml(&monitor_);
+  cancelled_ = true;
+  ml.NotifyAll();
+  while (active_workers_ > 0) {
+    ml.Wait();
+  }
+  return error.ptr();
+}
+
+void PrecompilerBatch::WaitForTurn(intptr_t index) {
+  Thread* const thread = Thread::Current();
+  if (thread->IsMutatorThread()) {
+    // The precompiler's thread only compiles a function at its turn.
+    return;
+  }
+  bool cancelled = false;
+  {
+    SafepointMonitorLocker ml(&monitor_);
+    Item* const item = &items_[index];
+    // When retrying the compilation, the helper already has the turn.
+    if (item->state == State::kCompiling) {
+      item->state = State::kWaiting;
+      ml.NotifyAll();
+      while ((item->state == State::kWaiting) && !cancelled_) {
+        ml.Wait();
+      }
+    }
+    cancelled = (item->state != State::kGenerating);
+  }
+  if (cancelled) {
+    Compiler::AbortBackgroundCompilation(DeoptId::kNone,
+                                         "Precompiler batch cancelled");
+  }
+  if ((type_usage_info_ != nullptr) && (thread->type_usage_info() == nullptr)) {
+    thread->set_type_usage_info(type_usage_info_);
+  }
+}
+
+void PrecompilerBatch::Commit(intptr_t index,
+                              FlowGraphCompiler* graph_compiler,
+                              const CompilerPassState& pass_state) {
+  Thread* const thread = Thread::Current();
+  Item* const item = &items_[index];
+  if (thread->IsMutatorThread()) {
+    TakeResults(item, graph_compiler, pass_state);
+    SafepointMonitorLocker ml(&monitor_);
+    item->state = State::kDone;
+    return;
+  }
+  {
+    SafepointMonitorLocker ml(&monitor_);
+    ASSERT(item->state == State::kGenerating);
+    item->graph_compiler = graph_compiler;
+    item->pass_state = &pass_state;
+    item->state = State::kCommitted;
+    ml.NotifyAll();
+    while (item->state != State::kDone) {
+      ml.Wait();
+    }
+  }
+  if (type_usage_info_ != nullptr) {
+    thread->set_type_usage_info(nullptr);
+  }
+}
+
+void PrecompilerBatch::TakeResults(Item* item,
+                                   FlowGraphCompiler* graph_compiler,
+                                   const CompilerPassState& pass_state) {
+  // The compilation's handles go away with its zone.
+  Zone* const zone = precompiler_->zone();
+  const GrowableArray<const Field*>& fields =
+      graph_compiler->used_static_fields();
+  item->used_static_fields =
+      new (zone) ZoneGrowableArray<const Field*>(zone, fields.length());
+  for (intptr_t i = 0; i < fields.length(); i++) {
+    item->used_static_fields->Add(&Field::ZoneHandle(zone, fields[i]->ptr()));
+  }
+  const GrowableArray<const compiler::TableSelector*>& call_selectors =
+      graph_compiler->dispatch_table_call_targets();
+  item->call_selectors =
+      new (zone) ZoneGrowableArray<const compiler::TableSelector*>(
+          zone, call_selectors.length());
+  for (intptr_t i = 0; i < call_selectors.length(); i++) {
+    item->call_selectors->Add(call_selectors[i]);
+  }
+  item->instruction_count = pass_state.instruction_count;
+  item->call_site_count = pass_state.call_site_count;
+  item->inlining_depth = pass_state.inlining_depth;
+  item->gop_end = FLAG_use_bare_instructions
+                      ? precompiler_->global_object_pool_builder()
+                            ->CurrentLength()
+                      : 0;
+}
+
+void PrecompilerBatch::RunWorker() {
+  const bool result = Thread::EnterIsolateGroupAsHelper(
+      isolate_group_, Thread::kCompilerTask, /*bypass_safepoint=*/false);
+  ASSERT(result);
+  {
+    Thread* const thread = Thread::Current();
+    StackZone stack_zone(thread);
+    CompilerState compiler_state(thread, /*is_aot=*/true,
+                                 /*is_optimizing=*/true);
+    HierarchyInfo hierarchy_info(thread);
+    while (true) {
+      intptr_t index = -1;
+      {
+        SafepointMonitorLocker ml(&monitor_);
+        while ((next_pending_ < length()) &&
+               (items_[next_pending_].state != State::kPending)) {
+          next_pending_++;
+        }
+        if (!cancelled_ && (next_pending_ < length())) {
+          index = next_pending_++;
+          items_[index].state = State::kCompiling;
+        }
+      }
+      if (index < 0) {
+        break;
+      }
+      CompileOnWorker(index);
+    }
+  }
+  Thread::ExitIsolateGroupAsHelper(/*bypass_safepoint=*/false);
+
+  // Notify the precompiler's thread that this helper is done.
+  MonitorLocker ml(&monitor_);
+  active_workers_--;
+  ASSERT(active_workers_ >= 0);
+  ml.NotifyAll();
+}
+
+void PrecompilerBatch::CompileOnWorker(intptr_t index) {
+  Thread* const thread = Thread::Current();
+  StackZone stack_zone(thread);
+  Zone* const zone = stack_zone.GetZone();
+  HANDLESCOPE(thread);
+
+  // volatile because the variable may be clobbered by a longjmp.
+  volatile bool compiled = false;
+  {
+    LongJumpScope jump;
+    if (setjmp(*jump.Set()) == 0) {
+      ParsedFunction* parsed_function = new (zone) ParsedFunction(
+          thread, Function::ZoneHandle(zone, items_[index].function->ptr()));
+      DartCompilationPipeline pipeline;
+      {
+        HANDLESCOPE(thread);
+        pipeline.ParseFunction(parsed_function);
+      }
+      PrecompileParsedFunctionHelper helper(precompiler_, parsed_function,
+                                            /*optimized=*/true, this, index);
+      compiled = helper.Compile(&pipeline);
+    }
+  }
+  if (compiled) {
+    return;
+  }
+
+  // The precompiler's thread compiles the function again, and reports the
+  // error if there is one.
+  thread->ClearStickyError();
+  if (thread->type_usage_info() != nullptr) {
+    thread->set_type_usage_info(nullptr);
+  }
+  SafepointMonitorLocker ml(&monitor_);
+  items_[index].state = State::kFallback;
+  ml.NotifyAll();
+}
+
+ErrorPtr PrecompilerBatch::CompileOnPrecompilerThread(intptr_t index) {
+  Thread* const thread = Thread::Current();
+  const Function& function = *items_[index].function;
+  if (function.HasCode()) {
+    // Installed by a helper before it gave up.
+    SafepointWriteRwLocker ml(thread, isolate_group_->program_lock());
+    function.ClearCode();
+  }
+  return Precompiler::CompileFunction(precompiler_, thread,
+                                      precompiler_->zone(), function, this,
+                                      index);
 }
 
 Obfuscator::Obfuscator(Thread* thread, const String& private_key)
@@ -29,8 +29,10 @@ class GrowableObjectArray;
 class String;
 class Precompiler;
 class FlowGraph;
+class PrecompilerBatch;
 class PrecompilerTracer;
 class RetainedReasonsWriter;
+class TypeFeedback;
 
 class TableSelectorKeyValueTrait {
  public:
@@ -232,10 +234,14 @@ class Precompiler : public ValueObject {
  public:
   static ErrorPtr CompileAll();
 
+  // Compiles [function] on the precompiler's thread. If [batch] is given,
+  // [function] is its [batch_index]th function, see PrecompilerBatch.
   static ErrorPtr CompileFunction(Precompiler* precompiler,
                                   Thread* thread,
                                   Zone* zone,
-                                  const Function& function);
+                                  const Function& function,
+                                  PrecompilerBatch* batch = nullptr,
+                                  intptr_t batch_index = -1);
 
   // Returns true if get:runtimeType is not overloaded by any class.
   bool get_runtime_type_is_unique() const {
@@ -252,6 +258,9 @@ class Precompiler : public ValueObject {
     return dispatch_table_generator_->selector_map();
   }
 
+  // Receiver classes recorded by a JIT training run, if any.
+  TypeFeedback* type_feedback() const { return type_feedback_; }
+
   static Precompiler* Instance() { return singleton_; }
 
   void AddField(const Field& field);
@@ -307,7 +316,9 @@ class Precompiler : public ValueObject {
   void AddTypesOf(const Function& function);
   void AddTypeParameters(const TypeParameters& params);
   void AddTypeArguments(const TypeArguments& args);
-  void AddCalleesOf(const Function& function, intptr_t gop_offset);
+  void AddCalleesOf(const Function& function,
+                    intptr_t gop_offset,
+                    intptr_t gop_end);
   void AddCalleesOfHelper(const Object& entry,
                           String* temp_selector,
                           Class* temp_cls);
@@ -323,6 +334,8 @@ class Precompiler : public ValueObject {
   const char* MustRetainFunction(const Function& function);
 
   void ProcessFunction(const Function& function);
+  bool CanCompileInBatches();
+  void ProcessBatch();
   void CheckForNewDynamicFunctions();
   void CollectCallbackFields();
 
@@ -397,6 +410,7 @@ class Precompiler : public ValueObject {
   Phase phase_ = Phase::kPreparation;
   PrecompilerTracer* tracer_ = nullptr;
   RetainedReasonsWriter* retained_reasons_writer_ = nullptr;
+  TypeFeedback* type_feedback_ = nullptr;
   bool is_tracing_ = false;
 };
 
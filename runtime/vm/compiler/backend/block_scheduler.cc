@@ -234,8 +234,24 @@ void BlockScheduler::ReorderBlocksJIT(FlowGraph* flow_graph) {
   }
 }
 
-// Moves blocks ending in a throw/rethrow, as well as any block post-dominated
-// by such a throwing block, to the end.
+// Returns true if [block] calls a function which never returns normally, e.g.
+// a helper which throws an error.
+static bool CallsNeverReturningFunction(BlockEntryInstr* block) {
+  auto& result_type = AbstractType::Handle();
+  for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+    if (auto call = it.Current()->AsStaticCall()) {
+      result_type = call->function().result_type();
+      if (result_type.IsNeverType() && result_type.IsNonNullable()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Moves blocks ending in a throw/rethrow or calling a function which never
+// returns, as well as any block post-dominated by such a throwing block, to
+// the end.
 void BlockScheduler::ReorderBlocksAOT(FlowGraph* flow_graph) {
   if (!FLAG_reorder_basic_blocks) {
     return;
@@ -254,7 +270,8 @@ void BlockScheduler::ReorderBlocksAOT(FlowGraph* flow_graph) {
   for (intptr_t i = 0; i < block_count; ++i) {
     auto block = reverse_postorder[i];
     auto last = block->last_instruction();
-    if (last->IsThrow() || last->IsReThrow()) {
+    if (last->IsThrow() || last->IsReThrow() ||
+        (!block->IsFunctionEntry() && CallsNeverReturningFunction(block))) {
       const intptr_t preorder_nr = block->preorder_number();
       is_terminating[preorder_nr] = true;
       worklist.Add(block);
@@ -0,0 +1,75 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/block_scheduler.h"
+
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+#if defined(DART_PRECOMPILER)
+
+// Returns the position in the code generation order of the first block which
+// calls [name], or -1 if there is none.
+static intptr_t CodegenIndexOfCall(FlowGraph* flow_graph, const char* name) {
+  auto& codegen_order = *flow_graph->CodegenBlockOrder(true);
+  for (intptr_t i = 0; i < codegen_order.length(); i++) {
+    for (ForwardInstructionIterator it(codegen_order[i]); !it.Done();
+         it.Advance()) {
+      auto call = it.Current()->AsStaticCall();
+      if ((call != nullptr) &&
+          (strcmp(String::Handle(call->function().name()).ToCString(),
+                  name) == 0)) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+ISOLATE_UNIT_TEST_CASE(BlockScheduler_NeverReturningCallsAreCold) {
+  const char* kScript =
+      R"(
+      @pragma('vm:never-inline')
+      Never fail(int i) => throw 'Bad $i';
+
+      @pragma('vm:never-inline')
+      int log(int i) => i;
+
+      int foo(int i) {
+        if (i < 0) {
+          fail(i);
+        }
+        if (i > 100) {
+          i = log(i);
+        }
+        return i + 1;
+      }
+
+      main() {
+        foo(42);
+      }
+      )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // The block calling fail is moved to the end, after the one calling log
+  // which follows it in reverse postorder.
+  const intptr_t fail_index = CodegenIndexOfCall(flow_graph, "fail");
+  const intptr_t log_index = CodegenIndexOfCall(flow_graph, "log");
+  EXPECT(log_index >= 0);
+  EXPECT(fail_index > log_index);
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
@@ -56,6 +56,14 @@ DEFINE_FLAG(int,
             optimization_counter_scale,
             2000,
             "The scale of invocation count, by size of the function.");
+DEFINE_FLAG(int,
+            baseline_optimization_counter_threshold,
+            0,
+            "Invocation count at which a function is first compiled by the "
+            "cheaper baseline tier of the optimizing compiler. It is "
+            "recompiled by the full pipeline after "
+            "optimization_counter_threshold more invocations. 0 disables the "
+            "baseline tier.");
 DEFINE_FLAG(bool, source_lines, false, "Emit source line as assembly comment.");
 
 DECLARE_FLAG(charp, deoptimize_filter);
@@ -2026,9 +2034,15 @@ const ICData* FlowGraphCompiler::GetOrAddStaticCallICData(
   return &ic_data;
 }
 
+bool FlowGraphCompiler::is_baseline_tier() const {
+  return is_optimizing() && CompilerState::Current().is_baseline_tier();
+}
+
 intptr_t FlowGraphCompiler::GetOptimizationThreshold() const {
   intptr_t threshold;
-  if (is_optimizing()) {
+  if (is_baseline_tier()) {
+    threshold = FLAG_optimization_counter_threshold;
+  } else if (is_optimizing()) {
     threshold = FLAG_reoptimization_counter_threshold;
   } else if (parsed_function_.function().IsIrregexpFunction()) {
     threshold = FLAG_regexp_optimization_counter_threshold;
@@ -2043,6 +2057,10 @@ intptr_t FlowGraphCompiler::GetOptimizationThreshold() const {
     if (threshold > FLAG_optimization_counter_threshold) {
       threshold = FLAG_optimization_counter_threshold;
     }
+    if ((FLAG_baseline_optimization_counter_threshold > 0) &&
+        (threshold > FLAG_baseline_optimization_counter_threshold)) {
+      threshold = FLAG_baseline_optimization_counter_threshold;
+    }
   }
 
   // Threshold = 0 doesn't make sense because we increment the counter before
@@ -2149,7 +2167,23 @@ void FlowGraphCompiler::EmitPolymorphicInstanceCall(
     intptr_t total_ic_calls,
     bool receiver_can_be_smi) {
   ASSERT(call != nullptr);
-  if (FLAG_polymorphic_with_deopt) {
+  if (FLAG_polymorphic_with_deopt && !complete && targets.is_megamorphic()) {
+    // The call site is known to see more receiver classes than we check for,
+    // so use the megamorphic call for the others instead of deoptimizing.
+    compiler::Label megamorphic, ok;
+    EmitTestAndCall(targets, call->function_name(), args_info,
+                    &megamorphic,  // No cid match.
+                    &ok,           // Found cid.
+                    deopt_id, source, locs, complete, total_ic_calls,
+                    call->entry_kind());
+    assembler()->Jump(&ok);
+    assembler()->Bind(&megamorphic);
+    const Array& arguments_descriptor =
+        Array::ZoneHandle(zone(), args_info.ToArgumentsDescriptor());
+    EmitMegamorphicInstanceCall(call->function_name(), arguments_descriptor,
+                                deopt_id, source, locs, kInvalidTryIndex);
+    assembler()->Bind(&ok);
+  } else if (FLAG_polymorphic_with_deopt) {
     compiler::Label* deopt =
         AddDeoptStub(deopt_id, ICData::kDeoptPolymorphicInstanceCallTestFail);
     compiler::Label ok;
@@ -938,6 +938,10 @@ class FlowGraphCompiler : public ValueObject {
 
   bool may_reoptimize() const { return may_reoptimize_; }
 
+  // True if this is optimized code of the baseline tier, which gets
+  // recompiled with the full pipeline once it is hot.
+  bool is_baseline_tier() const;
+
   // Use in unoptimized compilation to preserve/reuse ICData.
   //
   // If [binary_smi_target] is non-null and we have to create the ICData, the
@@ -277,7 +277,7 @@ void FlowGraphCompiler::GenerateMethodExtractorIntrinsic(
 void FlowGraphCompiler::EmitFrameEntry() {
   const Function& function = parsed_function().function();
   if (CanOptimizeFunction() && function.IsOptimizable() &&
-      (!is_optimizing() || may_reoptimize())) {
+      (!is_optimizing() || may_reoptimize() || is_baseline_tier())) {
     __ Comment("Invocation Count Check");
     const Register function_reg = R6;
     __ ldr(function_reg,
@@ -286,8 +286,10 @@ void FlowGraphCompiler::EmitFrameEntry() {
     __ LoadFieldFromOffset(R7, function_reg, Function::usage_counter_offset(),
                            compiler::kFourBytes);
     // Reoptimization of an optimized function is triggered by counting in
-    // IC stubs, but not at the entry of the function.
-    if (!is_optimizing()) {
+    // IC stubs, but not at the entry of the function. Code of the baseline
+    // tier counts its invocations until it is recompiled by the full
+    // pipeline.
+    if (!is_optimizing() || is_baseline_tier()) {
       __ add(R7, R7, compiler::Operand(1));
       __ StoreFieldToOffset(R7, function_reg, Function::usage_counter_offset(),
                             compiler::kFourBytes);
@@ -298,15 +298,17 @@ void FlowGraphCompiler::EmitFrameEntry() {
   } else {
     const Function& function = parsed_function().function();
     if (CanOptimizeFunction() && function.IsOptimizable() &&
-        (!is_optimizing() || may_reoptimize())) {
+        (!is_optimizing() || may_reoptimize() || is_baseline_tier())) {
       __ Comment("Invocation Count Check");
       const Register function_reg = RDI;
       __ movq(function_reg,
               compiler::FieldAddress(CODE_REG, Code::owner_offset()));
 
       // Reoptimization of an optimized function is triggered by counting in
-      // IC stubs, but not at the entry of the function.
-      if (!is_optimizing()) {
+      // IC stubs, but not at the entry of the function. Code of the baseline
+      // tier counts its invocations until it is recompiled by the full
+      // pipeline.
+      if (!is_optimizing() || is_baseline_tier()) {
         __ incl(compiler::FieldAddress(function_reg,
                                        Function::usage_counter_offset()));
       }
@@ -815,6 +815,13 @@ void CallTargets::CreateHelper(Zone* zone, const ICData& ic_data) {
 
   if (ic_data.is_megamorphic()) {
     ASSERT(num_args_tested == 1);  // Only 1-arg ICData will turn megamorphic.
+    // The checks of the ICData count the calls made at this site, including
+    // for a while after it turned megamorphic (see
+    // --megamorphic_counted_checks). The megamorphic cache is shared by all
+    // call sites of the selector, so only estimate the counts of the classes
+    // which the ICData has not seen.
+    is_megamorphic_ = true;
+    const intptr_t num_ic_targets = cid_ranges_.length();
     const String& name = String::Handle(zone, ic_data.target_name());
     const Array& descriptor =
         Array::Handle(zone, ic_data.arguments_descriptor());
@@ -831,13 +838,25 @@ void CallTargets::CreateHelper(Zone* zone, const ICData& ic_data) {
         if (id == kIllegalCid) {
           continue;
         }
+        bool seen_by_ic = false;
+        for (intptr_t j = 0; j < num_ic_targets; j++) {
+          if (cid_ranges_[j]->cid_start == id) {
+            seen_by_ic = true;
+            break;
+          }
+        }
+        if (seen_by_ic) {
+          continue;
+        }
         Function& function = Function::ZoneHandle(zone);
         function ^= entries[i].Get<MegamorphicCache::kTargetFunctionIndex>();
         const intptr_t filled_entry_count = cache.filled_entry_count();
         ASSERT(filled_entry_count > 0);
-        cid_ranges_.Add(new (zone) TargetInfo(
+        auto info = new (zone) TargetInfo(
             id, id, &function, Usage(function) / filled_entry_count,
-            StaticTypeExactnessState::NotTracking()));
+            StaticTypeExactnessState::NotTracking());
+        info->count_is_estimated = true;
+        cid_ranges_.Add(info);
       }
     }
   }
@@ -3970,6 +3989,7 @@ void CallTargets::MergeIntoRanges() {
       TargetAt(dest)->cid_end = TargetAt(src)->cid_end;
       TargetAt(dest)->count += TargetAt(src)->count;
       TargetAt(dest)->exactness = StaticTypeExactnessState::NotTracking();
+      TargetAt(dest)->count_is_estimated |= TargetAt(src)->count_is_estimated;
     } else {
       dest++;
       if (src != dest) {
@@ -4899,6 +4919,28 @@ FunctionPtr InstanceCallBaseInstr::ResolveForReceiverClass(
                                                   args_desc, allow_add);
 }
 
+InstanceCallInstr* InstanceCallInstr::FromSpeculativeCall(
+    Zone* zone,
+    PolymorphicInstanceCallInstr* call) {
+  ASSERT(call->has_speculative_targets());
+  ASSERT(!call->HasPushArguments());
+  InputsArray* args = new (zone) InputsArray(zone, call->ArgumentCount());
+  for (intptr_t i = 0, n = call->ArgumentCount(); i < n; ++i) {
+    args->Add(call->ArgumentValueAt(i)->CopyWithType(zone));
+  }
+  auto new_call = new (zone) InstanceCallInstr(
+      call->source(), call->function_name(), call->token_kind(), args,
+      call->type_args_len(), call->argument_names(),
+      /*checked_argument_count=*/1, call->deopt_id(), call->interface_target(),
+      call->tearoff_interface_target());
+  new_call->set_ic_data(call->ic_data());
+  new_call->set_result_type(call->result_type());
+  new_call->set_entry_kind(call->entry_kind());
+  new_call->set_has_unique_selector(call->has_unique_selector());
+  new_call->is_speculation_fallback_ = true;
+  return new_call;
+}
+
 const CallTargets& InstanceCallInstr::Targets() {
   if (targets_ == nullptr) {
     Zone* zone = Thread::Current()->zone();
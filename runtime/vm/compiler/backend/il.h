@@ -580,6 +580,9 @@ struct TargetInfo : public CidRange {
   const Function* target;
   intptr_t count;
   StaticTypeExactnessState exactness;
+  // Whether [count] is estimated rather than counted at the call site, e.g.
+  // for classes only found in the megamorphic cache of the selector.
+  bool count_is_estimated = false;
 
   DISALLOW_COPY_AND_ASSIGN(TargetInfo);
 };
@@ -676,9 +679,16 @@ class CallTargets : public Cids {
     return true;
   }
 
+  // True if the call site went megamorphic: its receivers are not limited to
+  // the classes of the targets and the call counts are partly estimated.
+  bool is_megamorphic() const { return is_megamorphic_; }
+  void set_is_megamorphic(bool value) { is_megamorphic_ = value; }
+
  private:
   void CreateHelper(Zone* zone, const ICData& ic_data);
   void MergeIntoRanges();
+
+  bool is_megamorphic_ = false;
 };
 
 // Represents type feedback for the binary operators, and a few recognized
@@ -1143,6 +1153,7 @@ class Instruction : public ZoneAllocated {
  protected:
   // GetDeoptId and/or CopyDeoptIdFrom.
   friend class CallSiteInliner;
+  friend class CopyableLoop;
   friend class LICM;
   friend class ComparisonInstr;
   friend class Scheduler;
@@ -4192,10 +4203,20 @@ class InstanceCallInstr : public InstanceCallBaseInstr {
                               tearoff_interface_target),
         checked_argument_count_(checked_argument_count) {}
 
+  // Generate a generic instance call with the arguments of [call], for the
+  // receivers not covered by the speculative targets of [call].
+  static InstanceCallInstr* FromSpeculativeCall(
+      Zone* zone,
+      PolymorphicInstanceCallInstr* call);
+
   DECLARE_INSTRUCTION(InstanceCall)
 
   intptr_t checked_argument_count() const { return checked_argument_count_; }
 
+  // True if this call handles the receivers not covered by speculatively
+  // inlined targets. Type feedback is not applied to it again.
+  bool is_speculation_fallback() const { return is_speculation_fallback_; }
+
   virtual intptr_t CallCount() const {
     return ic_data() == nullptr ? 0 : ic_data()->AggregateCount();
   }
@@ -4224,6 +4245,7 @@ class InstanceCallInstr : public InstanceCallBaseInstr {
   const class BinaryFeedback* binary_ = nullptr;
   const intptr_t checked_argument_count_;
   const AbstractType* receivers_static_type_ = nullptr;
+  bool is_speculation_fallback_ = false;
 
   DISALLOW_COPY_AND_ASSIGN(InstanceCallInstr);
 };
@@ -4253,6 +4275,16 @@ class PolymorphicInstanceCallInstr : public InstanceCallBaseInstr {
 
   bool complete() const { return complete_; }
 
+  // True if the targets were speculated from the type feedback of a training
+  // run (see TypeFeedback). Such calls are never complete and the polymorphic
+  // inliner keeps a generic call for the receivers its class id checks do not
+  // cover instead of deoptimizing.
+  bool has_speculative_targets() const { return has_speculative_targets_; }
+  void set_has_speculative_targets(bool value) {
+    ASSERT(!complete_);
+    has_speculative_targets_ = value;
+  }
+
   virtual CompileType ComputeType() const;
 
   bool HasOnlyDispatcherOrImplicitAccessorTargets() const;
@@ -4314,6 +4346,7 @@ class PolymorphicInstanceCallInstr : public InstanceCallBaseInstr {
 
   const CallTargets& targets_;
   const bool complete_;
+  bool has_speculative_targets_ = false;
   intptr_t total_call_count_;
 
   friend class PolymorphicInliner;
@@ -5394,6 +5427,7 @@ class StoreInstanceFieldInstr : public TemplateInstruction<2, NoThrow> {
 
   virtual TokenPosition token_pos() const { return token_pos_; }
   bool is_initialization() const { return is_initialization_; }
+  StoreBarrierType emit_store_barrier() const { return emit_store_barrier_; }
 
   bool ShouldEmitStoreBarrier() const {
     if (RepresentationUtils::IsUnboxed(slot().representation())) {
@@ -5700,6 +5734,7 @@ class LoadIndexedInstr : public TemplateDefinition<2, NoThrow> {
   intptr_t index_scale() const { return index_scale_; }
   intptr_t class_id() const { return class_id_; }
   bool aligned() const { return alignment_ == kAlignedAccess; }
+  CompileType* result_type() const { return result_type_; }
 
   virtual intptr_t DeoptimizationTarget() const { return GetDeoptId(); }
   virtual bool ComputeCanDeoptimize() const {
@@ -5947,6 +5982,7 @@ class StoreIndexedInstr : public TemplateInstruction<3, NoThrow> {
   intptr_t index_scale() const { return index_scale_; }
   intptr_t class_id() const { return class_id_; }
   bool aligned() const { return alignment_ == kAlignedAccess; }
+  StoreBarrierType emit_store_barrier() const { return emit_store_barrier_; }
 
   bool ShouldEmitStoreBarrier() const {
     if (array()->definition() == value()->definition()) {
@@ -6335,6 +6371,8 @@ class MaterializeObjectInstr : public Definition {
     return slots_[i]->offset_in_bytes();
   }
 
+  const Slot& SlotAt(intptr_t i) const { return *slots_[i]; }
+
   const Location& LocationAt(intptr_t i) { return locations_[i]; }
 
   DECLARE_INSTRUCTION(MaterializeObject)
@@ -9256,6 +9294,11 @@ class SimdOpInstr : public Definition {
     return new SimdOpInstr(KindForMethod(kind), left, deopt_id);
   }
 
+  // Create a unary SimdOp instr.
+  static SimdOpInstr* Create(Kind kind, Value* left, intptr_t deopt_id) {
+    return new SimdOpInstr(kind, left, deopt_id);
+  }
+
   static Kind KindForOperator(MethodRecognizer::Kind kind);
 
   static Kind KindForMethod(MethodRecognizer::Kind method_kind);
@@ -519,6 +519,12 @@ void PolymorphicInstanceCallInstr::PrintOperandsTo(BaseTextBuffer* f) const {
   if (complete()) {
     f->AddString(" COMPLETE");
   }
+  if (has_speculative_targets()) {
+    f->AddString(" SPECULATIVE");
+  }
+  if (targets_.is_megamorphic()) {
+    f->AddString(" MEGAMORPHIC");
+  }
   if (entry_kind() == Code::EntryKind::kUnchecked) {
     f->AddString(" using unchecked entrypoint");
   }
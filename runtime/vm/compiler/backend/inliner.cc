@@ -42,6 +42,11 @@ DEFINE_FLAG(int,
             inlining_depth_threshold,
             6,
             "Inline function calls up to threshold nesting depth");
+DEFINE_FLAG(int,
+            baseline_inlining_depth_threshold,
+            1,
+            "Inline function calls up to threshold nesting depth in the "
+            "baseline tier of the JIT");
 DEFINE_FLAG(
     int,
     inlining_size_threshold,
@@ -77,6 +82,12 @@ DEFINE_FLAG(int,
             500,
             "Max. number of inlined calls per depth");
 DEFINE_FLAG(bool, print_inlining_tree, false, "Print inlining tree");
+DEFINE_FLAG(int,
+            megamorphic_inlining_coverage,
+            90,
+            "Inline the most frequent targets of calls with more than "
+            "max_polymorphic_checks targets if they account for at least this "
+            "percentage (0 .. 100) of the calls; 0 disables.");
 
 DECLARE_FLAG(int, max_deoptimization_counter_threshold);
 DECLARE_FLAG(bool, print_flow_graph);
@@ -605,6 +616,7 @@ class PolymorphicInliner : public ValueObject {
   bool CheckNonInlinedDuplicate(const Function& target);
 
   bool TryInliningPoly(const TargetInfo& target);
+  intptr_t CountDominantVariants(intptr_t total) const;
   bool TryInlineRecognizedMethod(intptr_t receiver_cid, const Function& target);
 
   TargetEntryInstr* BuildDecisionGraph();
@@ -1125,7 +1137,9 @@ class CallSiteInliner : public ValueObject {
           if (!AdjustForOptionalParameters(
                   *parsed_function, first_actual_param_index, argument_names,
                   arguments, param_stubs, callee_graph)) {
-            function.set_is_inlinable(false);
+            if (!CompilerState::Current().is_batch_compilation()) {
+              function.set_is_inlinable(false);
+            }
             TRACE_INLINING(THR_Print("     Bailout: optional arg mismatch\n"));
             PRINT_INLINING_TREE("Optional arg mismatch", &call_data->caller,
                                 &function, call_data->call);
@@ -1230,7 +1244,8 @@ class CallSiteInliner : public ValueObject {
           if (!decision.value) {
             // If size is larger than all thresholds, don't consider it again.
             if ((instruction_count > FLAG_inlining_size_threshold) &&
-                (call_site_count > FLAG_inlining_callee_call_sites_threshold)) {
+                (call_site_count > FLAG_inlining_callee_call_sites_threshold) &&
+                !CompilerState::Current().is_batch_compilation()) {
               function.set_is_inlinable(false);
             }
             TRACE_INLINING(
@@ -1556,8 +1571,10 @@ class CallSiteInliner : public ValueObject {
                              call_info.length()));
     for (intptr_t call_idx = 0; call_idx < call_info.length(); ++call_idx) {
       PolymorphicInstanceCallInstr* call = call_info[call_idx].call;
-      // PolymorphicInliner introduces deoptimization paths.
-      if (!call->complete() && !FLAG_polymorphic_with_deopt) {
+      // PolymorphicInliner introduces deoptimization paths, unless the
+      // targets are speculative.
+      if (!call->complete() && !FLAG_polymorphic_with_deopt &&
+          !call->has_speculative_targets()) {
         TRACE_INLINING(THR_Print("  => %s\n     Bailout: call with checks\n",
                                  call->function_name().ToCString()));
         continue;
@@ -1878,11 +1895,14 @@ bool PolymorphicInliner::TryInlineRecognizedMethod(intptr_t receiver_cid,
 // id of the receiver and make explicit comparisons for each inlined body,
 // in frequency order.  If all variants are inlined, the entry to the last
 // inlined body is guarded by a CheckClassId instruction which can deopt.
-// If not all variants are inlined, we add a PolymorphicInstanceCall
-// instruction to handle the non-inlined variants.
+// If not all variants are inlined, or if the variants are speculative, we
+// add a PolymorphicInstanceCall instruction to handle the remaining
+// receivers.
 TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
   COMPILER_TIMINGS_TIMER_SCOPE(owner_->thread(), BuildDecisionGraph);
   const intptr_t try_idx = call_->GetBlock()->try_index();
+  const bool needs_fallback_call =
+      !non_inlined_variants_->is_empty() || call_->has_speculative_targets();
 
   // Start with a fresh target entry.
   TargetEntryInstr* entry = new (Z) TargetEntryInstr(
@@ -1909,7 +1929,7 @@ TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
     // 1. Guard the body with a class id check.  We don't need any check if
     // it's the last test and global analysis has told us that the call is
     // complete.
-    if (is_last_test && non_inlined_variants_->is_empty()) {
+    if (is_last_test && !needs_fallback_call) {
       // If it is the last variant use a check class id instruction which can
       // deoptimize, followed unconditionally by the body. Omit the check if
       // we know that we have covered all possible classes.
@@ -2099,18 +2119,26 @@ TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
 
   ASSERT(!call_->HasPushArguments());
 
-  // Handle any non-inlined variants.
-  if (!non_inlined_variants_->is_empty()) {
-    PolymorphicInstanceCallInstr* fallback_call =
-        PolymorphicInstanceCallInstr::FromCall(Z, call_, *non_inlined_variants_,
-                                               call_->complete());
+  // Handle any non-inlined variants. If all speculative variants were
+  // inlined, the remaining receivers are handled by a generic call rather
+  // than by testing the same class ids again.
+  if (needs_fallback_call) {
+    InstanceCallBaseInstr* fallback_call;
+    if (non_inlined_variants_->is_empty()) {
+      fallback_call = InstanceCallInstr::FromSpeculativeCall(Z, call_);
+    } else {
+      PolymorphicInstanceCallInstr* polymorphic_call =
+          PolymorphicInstanceCallInstr::FromCall(
+              Z, call_, *non_inlined_variants_, call_->complete());
+      polymorphic_call->set_total_call_count(call_->CallCount());
+      fallback_call = polymorphic_call;
+    }
     fallback_call->set_ssa_temp_index(
         owner_->caller_graph()->alloc_ssa_temp_index());
     if (FlowGraph::NeedsPairLocation(fallback_call->representation())) {
       owner_->caller_graph()->alloc_ssa_temp_index();
     }
     fallback_call->InheritDeoptTarget(zone(), call_);
-    fallback_call->set_total_call_count(call_->CallCount());
     ReturnInstr* fallback_return = new ReturnInstr(
         call_->source(), new Value(fallback_call), DeoptId::kNone);
     fallback_return->InheritDeoptTargetAfter(owner_->caller_graph(), call_,
@@ -2139,13 +2167,48 @@ bool PolymorphicInliner::trace_inlining() const {
   return owner_->trace_inlining();
 }
 
+// Returns the number of variants, in frequency order, which are worth
+// guarding with class id checks. Calls with more than max_polymorphic_checks
+// variants (typically megamorphic ones) are usually left alone, unless a few
+// dominant variants account for most of the calls: the other receivers then
+// take the fallback call.
+intptr_t PolymorphicInliner::CountDominantVariants(intptr_t total) const {
+  if (variants_.length() <= FLAG_max_polymorphic_checks) {
+    return variants_.length();
+  }
+  if ((FLAG_megamorphic_inlining_coverage <= 0) || (total <= 0)) {
+    return 0;
+  }
+  intptr_t covered = 0;
+  for (intptr_t i = 0; i < FLAG_max_polymorphic_checks; i++) {
+    // Only targets whose calls were counted at this site can be dominant.
+    if (variants_.TargetAt(i)->count_is_estimated) {
+      return 0;
+    }
+    covered += variants_.TargetAt(i)->count;
+    if (covered * 100 >= total * FLAG_megamorphic_inlining_coverage) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
 bool PolymorphicInliner::Inline() {
   ASSERT(&variants_ == &call_->targets_);
 
   intptr_t total = call_->total_call_count();
+  non_inlined_variants_->set_is_megamorphic(variants_.is_megamorphic());
+  const intptr_t num_dominant_variants = CountDominantVariants(total);
+  if ((num_dominant_variants > 0) &&
+      (num_dominant_variants < variants_.length())) {
+    TRACE_INLINING(THR_Print("  %s: %" Pd " of %" Pd
+                             " targets are dominant\n",
+                             call_->function_name().ToCString(),
+                             num_dominant_variants, variants_.length()));
+  }
   for (intptr_t var_idx = 0; var_idx < variants_.length(); ++var_idx) {
     TargetInfo* info = variants_.TargetAt(var_idx);
-    if (variants_.length() > FLAG_max_polymorphic_checks) {
+    if (var_idx >= num_dominant_variants) {
       non_inlined_variants_->Add(info);
       continue;
     }
@@ -2156,7 +2219,8 @@ bool PolymorphicInliner::Inline() {
     // We we almost inlined all the cases then try a little harder to inline
     // the last two, because it's a big win if we inline all of them (compiler
     // can see all side effects).
-    const bool try_harder = (var_idx >= variants_.length() - 2) &&
+    const bool try_harder = (num_dominant_variants == variants_.length()) &&
+                            (var_idx >= variants_.length() - 2) &&
                             non_inlined_variants_->length() == 0;
 
     intptr_t size = target.optimized_instruction_count();
@@ -2263,6 +2327,14 @@ void FlowGraphInliner::CollectGraphInfo(FlowGraph* flow_graph,
   if (force || (function.optimized_instruction_count() == 0)) {
     GraphInfoCollector info;
     info.Collect(*flow_graph);
+    if (CompilerState::Current().is_batch_compilation()) {
+      // Computed but not cached, see CompilerPassState::instruction_count.
+      *instruction_count = Utils::Minimum(info.instruction_count(),
+                                          Function::kMaxInstructionCount);
+      *call_site_count = Utils::Minimum(info.call_site_count(),
+                                        Function::kMaxInstructionCount);
+      return;
+    }
     function.SetOptimizedInstructionCountClamped(info.instruction_count());
     function.SetOptimizedCallSiteCountClamped(info.call_site_count());
   }
@@ -2379,6 +2451,10 @@ int FlowGraphInliner::Inline() {
   }
 
   intptr_t inlining_depth_threshold = FLAG_inlining_depth_threshold;
+  if (CompilerState::Current().is_baseline_tier()) {
+    inlining_depth_threshold = Utils::Minimum<intptr_t>(
+        inlining_depth_threshold, FLAG_baseline_inlining_depth_threshold);
+  }
 
   CallSiteInliner inliner(this, inlining_depth_threshold);
   inliner.InlineCalls();
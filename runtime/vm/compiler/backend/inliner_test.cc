@@ -194,6 +194,181 @@ ISOLATE_UNIT_TEST_CASE(Inliner_TypedData_Regress7551) {
   RELEASE_ASSERT(unbox_instr->is_truncating());
 }
 
+// Test that the dominant target of a megamorphic call site is inlined behind
+// a class id check, and that the other targets are left to a fallback call.
+ISOLATE_UNIT_TEST_CASE(Inliner_MegamorphicDominantTarget) {
+  const char* kScript = R"(
+    abstract class A {
+      int foo();
+    }
+    class B extends A { int foo() => 1; }
+    class C extends A { int foo() => 2; }
+    class D extends A { int foo() => 3; }
+    class E extends A { int foo() => 4; }
+    class F extends A { int foo() => 5; }
+    class G extends A { int foo() => 6; }
+    class H extends A { int foo() => 7; }
+
+    testInlining(A arg) {
+      return arg.foo();
+    }
+
+    main() {
+      testInlining(C());
+      for (var i = 0; i < 1000; i++) {
+        testInlining(B());
+      }
+      testInlining(D());
+      testInlining(E());
+      testInlining(F());
+      testInlining(G());
+      testInlining(H());
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function =
+      Function::Handle(GetFunction(root_library, "testInlining"));
+
+  Invoke(root_library, "main");
+
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({
+      CompilerPass::kComputeSSA,
+      CompilerPass::kApplyICData,
+      CompilerPass::kTryOptimizePatterns,
+      CompilerPass::kSetOuterInliningId,
+      CompilerPass::kTypePropagation,
+      CompilerPass::kApplyClassIds,
+      CompilerPass::kInlining,
+  });
+
+  const Class& cls_B = Class::Handle(
+      root_library.LookupLocalClass(String::Handle(Symbols::New(thread, "B"))));
+  const Class& cls_C = Class::Handle(
+      root_library.LookupLocalClass(String::Handle(Symbols::New(thread, "C"))));
+
+  PolymorphicInstanceCallInstr* fallback = nullptr;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (auto call = it.Current()->AsPolymorphicInstanceCall()) {
+        EXPECT(fallback == nullptr);
+        fallback = call;
+      }
+    }
+  }
+
+  // The call for B has been inlined, the others remain.
+  EXPECT(fallback != nullptr);
+  EXPECT(fallback->targets().is_megamorphic());
+  bool has_B = false;
+  bool has_C = false;
+  for (intptr_t i = 0; i < fallback->targets().length(); i++) {
+    const CidRange& info = fallback->targets()[i];
+    has_B = has_B || ((info.cid_start <= cls_B.id()) &&
+                      (cls_B.id() <= info.cid_end));
+    has_C = has_C || ((info.cid_start <= cls_C.id()) &&
+                      (cls_C.id() <= info.cid_end));
+  }
+  EXPECT(!has_B);
+  EXPECT(has_C);
+}
+
+// Test that the receivers of a call site are still counted after it went
+// megamorphic, so that a class which only dominates the site afterwards is
+// inlined.
+ISOLATE_UNIT_TEST_CASE(Inliner_MegamorphicCountsAfterTransition) {
+  const char* kScript = R"(
+    abstract class A {
+      int foo();
+    }
+    class B extends A { int foo() => 1; }
+    class C extends A { int foo() => 2; }
+    class D extends A { int foo() => 3; }
+    class E extends A { int foo() => 4; }
+    class F extends A { int foo() => 5; }
+    class G extends A { int foo() => 6; }
+
+    testInlining(A arg) {
+      return arg.foo();
+    }
+
+    main() {
+      testInlining(C());
+      testInlining(D());
+      testInlining(E());
+      testInlining(F());
+      testInlining(G());
+      for (var i = 0; i < 1000; i++) {
+        testInlining(B());
+      }
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function =
+      Function::Handle(GetFunction(root_library, "testInlining"));
+
+  Invoke(root_library, "main");
+
+  const Class& cls_B = Class::Handle(
+      root_library.LookupLocalClass(String::Handle(Symbols::New(thread, "B"))));
+
+  // The calls of B, made after the site went megamorphic, are counted.
+  ZoneGrowableArray<const ICData*>* ic_data_array =
+      new (thread->zone()) ZoneGrowableArray<const ICData*>();
+  function.RestoreICDataMap(ic_data_array, /*clone_ic_data=*/false);
+  const ICData* ic_data = nullptr;
+  for (intptr_t i = 0; i < ic_data_array->length(); i++) {
+    const ICData* candidate = (*ic_data_array)[i];
+    if ((candidate != nullptr) &&
+        String::Handle(candidate->target_name()).Equals("foo")) {
+      EXPECT(ic_data == nullptr);
+      ic_data = candidate;
+    }
+  }
+  EXPECT(ic_data != nullptr);
+  intptr_t count_B = 0;
+  for (intptr_t i = 0; i < ic_data->NumberOfChecks(); i++) {
+    if (ic_data->GetReceiverClassIdAt(i) == cls_B.id()) {
+      count_B = ic_data->GetCountAt(i);
+    }
+  }
+  EXPECT_GE(count_B, 1000);
+
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({
+      CompilerPass::kComputeSSA,
+      CompilerPass::kApplyICData,
+      CompilerPass::kTryOptimizePatterns,
+      CompilerPass::kSetOuterInliningId,
+      CompilerPass::kTypePropagation,
+      CompilerPass::kApplyClassIds,
+      CompilerPass::kInlining,
+  });
+
+  // The call for B has been inlined, the others remain.
+  PolymorphicInstanceCallInstr* fallback = nullptr;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (auto call = it.Current()->AsPolymorphicInstanceCall()) {
+        EXPECT(fallback == nullptr);
+        fallback = call;
+      }
+    }
+  }
+  EXPECT(fallback != nullptr);
+  EXPECT(fallback->targets().is_megamorphic());
+  for (intptr_t i = 0; i < fallback->targets().length(); i++) {
+    const CidRange& info = fallback->targets()[i];
+    EXPECT((cls_B.id() < info.cid_start) || (info.cid_end < cls_B.id()));
+  }
+}
+
 #if defined(DART_PRECOMPILER)
 
 // Verifies that all calls are inlined in List.generate call
@@ -246,6 +421,115 @@ ISOLATE_UNIT_TEST_CASE(Inliner_List_generate) {
   }));
 }
 
+// Speculative targets recorded by a training run are inlined behind class id
+// checks. Once all of them are inlined, the other receivers go through a
+// generic instance call instead of a polymorphic call that tests the same
+// class ids again.
+ISOLATE_UNIT_TEST_CASE(Inliner_SpeculativePolymorphicCall) {
+  const char* kScript = R"(
+    class A { int foo() => 1; }
+    class B { int foo() => 2; }
+    class C { int foo() => 3; }
+
+    @pragma('vm:never-inline')
+    int test(dynamic x) => x.foo();
+
+    main() {
+      test(A());
+      test(B());
+      test(C());
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "test"));
+  Invoke(root_library, "main");
+
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({
+      CompilerPass::kComputeSSA,
+      CompilerPass::kApplyICData,
+      CompilerPass::kTryOptimizePatterns,
+      CompilerPass::kSetOuterInliningId,
+      CompilerPass::kTypePropagation,
+      CompilerPass::kApplyClassIds,
+  });
+
+  InstanceCallInstr* call = nullptr;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->IsInstanceCall()) {
+        call = it.Current()->AsInstanceCall();
+      }
+    }
+  }
+  RELEASE_ASSERT(call != nullptr);
+
+  // Speculate on the receivers A and B, as AotCallSpecializer does with the
+  // receivers recorded by --write_type_feedback_to.
+  const Class& class_a = Class::Handle(GetClass(root_library, "A"));
+  const Class& class_b = Class::Handle(GetClass(root_library, "B"));
+  const Array& args_desc_array =
+      Array::Handle(call->GetArgumentsDescriptor());
+  const ICData& ic_data = ICData::Handle(
+      ICData::New(function, call->function_name(), args_desc_array,
+                  DeoptId::kNone, /* args_tested = */ 1, ICData::kOptimized));
+  ic_data.AddReceiverCheck(
+      class_a.id(),
+      Function::Handle(call->ResolveForReceiverClass(class_a)), 100);
+  ic_data.AddReceiverCheck(
+      class_b.id(),
+      Function::Handle(call->ResolveForReceiverClass(class_b)), 100);
+  const CallTargets* targets = CallTargets::Create(thread->zone(), ic_data);
+  PolymorphicInstanceCallInstr* speculative_call =
+      PolymorphicInstanceCallInstr::FromCall(thread->zone(), call, *targets,
+                                             /* complete = */ false);
+  speculative_call->set_has_speculative_targets(true);
+  call->ReplaceWith(speculative_call, nullptr);
+
+  GrowableArray<const Function*> inline_id_to_function;
+  GrowableArray<TokenPosition> inline_id_to_token_pos;
+  GrowableArray<intptr_t> caller_inline_id;
+  inline_id_to_function.Add(&function);
+  caller_inline_id.Add(-1);
+  SpeculativeInliningPolicy speculative_policy(/*enable_suppression=*/false);
+  FlowGraphInliner inliner(flow_graph, &inline_id_to_function,
+                           &inline_id_to_token_pos, &caller_inline_id,
+                           &speculative_policy, /*precompiler=*/nullptr);
+  inliner.Inline();
+
+  intptr_t polymorphic_calls = 0;
+  intptr_t cid_checks = 0;
+  InstanceCallInstr* fallback_call = nullptr;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      Instruction* current = it.Current();
+      if (current->IsPolymorphicInstanceCall()) {
+        polymorphic_calls++;
+      } else if (current->IsInstanceCall()) {
+        EXPECT(fallback_call == nullptr);
+        fallback_call = current->AsInstanceCall();
+      } else if (current->IsBranch() &&
+                 current->AsBranch()
+                     ->comparison()
+                     ->left()
+                     ->definition()
+                     ->IsLoadClassId()) {
+        cid_checks++;
+      }
+    }
+  }
+  EXPECT_EQ(0, polymorphic_calls);
+  EXPECT_EQ(2, cid_checks);
+  EXPECT(fallback_call != nullptr);
+  EXPECT(fallback_call->is_speculation_fallback());
+  EXPECT_STREQ("foo", fallback_call->function_name().ToCString());
+}
+
 #endif  // defined(DART_PRECOMPILER)
 
 }  // namespace dart
@@ -16,6 +16,13 @@
 
 namespace dart {
 
+DEFINE_FLAG(bool,
+            coalescing_aot_allocator,
+            false,
+            "In AOT, use the coalescing register allocator, which unlike "
+            "linear scan prefers allocating phis to the register of one of "
+            "their inputs to remove phi resolution moves.");
+
 #if !defined(PRODUCT)
 #define INCLUDE_LINEAR_SCAN_TRACING_CODE
 #endif
@@ -882,6 +889,20 @@ void FlowGraphAllocator::ConnectIncomingPhiMoves(JoinEntryInstr* join) {
   const intptr_t pos = join->start_pos();
   const bool is_loop_header = join->IsLoopHeader();
 
+  // Compile time is less of a concern in AOT, so the coalescing allocator
+  // selected by --coalescing_aot_allocator tries to coalesce phis with their
+  // inputs: inputs flowing in along forward edges are allocated before the
+  // phi, so hinting the phi with the location of the first such input turns
+  // the corresponding phi resolution move into a no-op whenever that register
+  // is still free. Constants are rematerialized at their uses and never
+  // occupy a register, so they are not used as hints.
+  //
+  // This is only a first step towards a slower but better AOT allocator: it
+  // coalesces within linear scan and does not split or recolor ranges to
+  // remove the moves it cannot hint away.
+  const bool coalesce_phi_moves =
+      FLAG_coalescing_aot_allocator && CompilerState::Current().is_aot();
+
   intptr_t move_idx = 0;
   for (PhiIterator it(join); !it.Done(); it.Advance()) {
     PhiInstr* phi = it.Current();
@@ -905,6 +926,7 @@ void FlowGraphAllocator::ConnectIncomingPhiMoves(JoinEntryInstr* join) {
       if (is_loop_header) second_range->mark_loop_phi();
     }
 
+    bool is_hinted = is_pair_phi || !coalesce_phi_moves;
     for (intptr_t pred_idx = 0; pred_idx < phi->InputCount(); pred_idx++) {
       BlockEntryInstr* pred = join->PredecessorAt(pred_idx);
       GotoInstr* goto_instr = pred->last_instruction()->AsGoto();
@@ -912,7 +934,17 @@ void FlowGraphAllocator::ConnectIncomingPhiMoves(JoinEntryInstr* join) {
       MoveOperands* move =
           goto_instr->parallel_move()->MoveOperandsAt(move_idx);
       move->set_dest(Location::PrefersRegister());
-      range->AddUse(pos, move->dest_slot());
+      Definition* input = phi->InputAt(pred_idx)->definition();
+      if (!is_hinted && !input->IsConstant() &&
+          (input->ssa_temp_index() >= 0) &&
+          (pred->postorder_number() > join->postorder_number())) {
+        range->AddHintedUse(
+            pos, move->dest_slot(),
+            GetLiveRange(input->ssa_temp_index())->assigned_location_slot());
+        is_hinted = true;
+      } else {
+        range->AddUse(pos, move->dest_slot());
+      }
       if (is_pair_phi) {
         LiveRange* second_range = GetLiveRange(ToSecondPairVreg(vreg));
         MoveOperands* second_move =
@@ -0,0 +1,97 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/linearscan.h"
+
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+#if defined(DART_PRECOMPILER)
+
+DECLARE_FLAG(bool, coalescing_aot_allocator);
+
+// Counts the phi resolution moves on the edges into joins of [flow_graph]
+// that the register allocator could not turn into no-ops.
+static intptr_t CountPhiMoves(FlowGraph* flow_graph,
+                              intptr_t* redundant_moves) {
+  intptr_t moves = 0;
+  *redundant_moves = 0;
+  for (auto block : flow_graph->reverse_postorder()) {
+    JoinEntryInstr* join = block->AsJoinEntry();
+    if ((join == nullptr) || (join->phis() == nullptr) ||
+        join->phis()->is_empty()) {
+      continue;
+    }
+    for (intptr_t i = 0; i < join->PredecessorCount(); i++) {
+      GotoInstr* goto_instr =
+          join->PredecessorAt(i)->last_instruction()->AsGoto();
+      if ((goto_instr == nullptr) || !goto_instr->HasParallelMove()) {
+        continue;
+      }
+      ParallelMoveInstr* parallel_move = goto_instr->parallel_move();
+      for (intptr_t j = 0; j < parallel_move->NumMoves(); j++) {
+        if (parallel_move->MoveOperandsAt(j)->IsRedundant()) {
+          (*redundant_moves)++;
+        } else {
+          moves++;
+        }
+      }
+    }
+  }
+  return moves;
+}
+
+static intptr_t CompileAndCountPhiMoves(const Function& function,
+                                        bool coalesce_phi_moves,
+                                        intptr_t* redundant_moves) {
+  SetFlagScope<bool> sfs(&FLAG_coalescing_aot_allocator, coalesce_phi_moves);
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  return CountPhiMoves(flow_graph, redundant_moves);
+}
+
+// Phis hinted with the register of an input flowing in along a forward edge
+// get that register when it is free at the join, which removes the move.
+ISOLATE_UNIT_TEST_CASE(IRTest_LinearScan_CoalescePhiMoves) {
+  const char* kScript = R"(
+    @pragma('vm:never-inline')
+    int foo(int a, int b, bool c) {
+      int x, y;
+      if (c) {
+        x = a + b;
+        y = a * b;
+      } else {
+        x = a - b;
+        y = b - a;
+      }
+      return x * y + a;
+    }
+    main() {
+      foo(1, 2, true);
+      foo(3, 4, false);
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+
+  intptr_t redundant_moves = 0;
+  const intptr_t moves = CompileAndCountPhiMoves(
+      function, /*coalesce_phi_moves=*/true, &redundant_moves);
+
+  intptr_t uncoalesced_redundant_moves = 0;
+  const intptr_t uncoalesced_moves = CompileAndCountPhiMoves(
+      function, /*coalesce_phi_moves=*/false, &uncoalesced_redundant_moves);
+  EXPECT_LT(moves, uncoalesced_moves);
+  EXPECT_GT(redundant_moves, uncoalesced_redundant_moves);
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
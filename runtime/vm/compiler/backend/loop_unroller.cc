@@ -0,0 +1,838 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_unroller.h"
+
+#include "vm/bit_vector.h"
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/loops.h"
+#include "vm/compiler/backend/range_analysis.h"
+#include "vm/hash_map.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_peeling,
+            true,
+            "Peel the first iteration off loops with loop invariant checks.");
+DEFINE_FLAG(int,
+            loop_unroll_factor,
+            4,
+            "Number of iterations run by an unrolled loop body, 1 disables "
+            "loop unrolling.");
+DEFINE_FLAG(int,
+            loop_unroll_max_size,
+            64,
+            "Maximum number of instructions in a peeled iteration or in an "
+            "unrolled loop body.");
+
+typedef RawPointerKeyValueTrait<Definition, Definition*> DefinitionKV;
+typedef DirectChainedHashMap<DefinitionKV> DefinitionMap;
+
+// Returns the copy of [def] in [map], or [def] itself if it was not copied.
+static Definition* LookupCopy(const DefinitionMap& map, Definition* def) {
+  Definition* copy = map.LookupValue(def);
+  return (copy != nullptr) ? copy : def;
+}
+
+// An innermost loop of the form
+//
+//     preheader:
+//       goto header
+//     header:
+//       <phis>
+//       CheckStackOverflow
+//       if (<test of phis and invariants>) goto body else goto exit
+//     body:
+//       <instructions which can be copied>
+//       goto header
+//
+// whose iterations can be copied out of the loop (peeling) or into a longer
+// body (unrolling).
+class CopyableLoop : public ZoneAllocated {
+ public:
+  CopyableLoop(FlowGraph* flow_graph, LoopInfo* loop)
+      : flow_graph_(flow_graph),
+        zone_(flow_graph->zone()),
+        loop_(loop),
+        header_(nullptr),
+        body_(nullptr),
+        exit_(nullptr),
+        preheader_(nullptr),
+        preheader_goto_(nullptr),
+        branch_(nullptr),
+        phis_(),
+        entry_inputs_(),
+        back_edge_inputs_(),
+        instructions_(),
+        copy_block_(nullptr),
+        copied_values_(),
+        skip_block_(nullptr),
+        exit_join_(nullptr),
+        exit_phis_(),
+        index_(nullptr),
+        limit_(nullptr),
+        stride_(0),
+        factor_(0),
+        join_(nullptr) {}
+
+  // Returns true if the loop has the expected shape and all instructions of
+  // the body can be copied.
+  bool Analyze();
+
+  // Returns true if the body checks a loop invariant value.
+  bool HasInvariantCheck() const;
+
+  // Merges the phis which are used after the loop with their initial values
+  // at a new join of the exit. Has to be called for all loops before any of
+  // them is peeled, as it relies on the loop blocks of the original graph.
+  void PreparePeel();
+
+  // Rewrites the loop into
+  //
+  //     preheader:
+  //       if (<test of initial values>) goto peeled else goto skip
+  //     peeled:
+  //       <copy of the body for the initial values>
+  //       goto header
+  //     skip:
+  //       goto exit_join
+  //     header:
+  //       ...
+  //     exit:
+  //       goto exit_join
+  //     exit_join:
+  //       <code after the loop>
+  void Peel();
+
+  // Returns true if the loop counts up by a constant stride to a loop
+  // invariant limit and the body can be copied [FLAG_loop_unroll_factor] times
+  // (or at least twice) within the size budget. Has to be called after range
+  // analysis and induction variable analysis.
+  bool IsUnrollable();
+
+  // Rewrites the body of the loop into
+  //
+  //     body:
+  //       if (i + (factor - 1) * stride < limit)
+  //     unrolled:
+  //         <factor copies of the body>
+  //         goto join
+  //       else
+  //     remainder:
+  //         <original body>
+  //         goto join
+  //     join:
+  //       goto header
+  void Unroll();
+
+  // Reconnects the phis to the new blocks. Have to be called once the
+  // predecessors of all blocks are recomputed.
+  void FinalizePeel();
+  void FinalizeUnroll();
+
+  BlockEntryInstr* header() const { return header_; }
+  intptr_t size() const { return instructions_.length(); }
+  intptr_t factor() const { return factor_; }
+
+ private:
+  Zone* zone() const { return zone_; }
+
+  bool IsInvariant(Definition* def) const {
+    return !loop_->Contains(def->GetBlock());
+  }
+
+  static bool IsCopyable(Instruction* current);
+
+  Value* CopyOf(Value* value, const DefinitionMap& map) {
+    return new (zone()) Value(LookupCopy(map, value->definition()));
+  }
+  Instruction* CopyOf(Instruction* current, const DefinitionMap& map);
+  void CopyEnvironment(Instruction* copy, const DefinitionMap& map);
+  Instruction* AppendCopy(Instruction* cursor,
+                          Instruction* current,
+                          DefinitionMap* map);
+
+  // Appends a copy of the body for the given values of the phis and updates
+  // the values to the ones at the end of the copied iteration.
+  Instruction* AppendIteration(Instruction* cursor,
+                               GrowableArray<Definition*>* values);
+
+  Definition* UnboxedLimit();
+
+  TargetEntryInstr* NewTarget(BlockEntryInstr* block);
+  JoinEntryInstr* NewJoin(BlockEntryInstr* block);
+  GotoInstr* NewGoto(JoinEntryInstr* target);
+
+  FlowGraph* flow_graph_;
+  Zone* zone_;
+  LoopInfo* loop_;
+  JoinEntryInstr* header_;
+  TargetEntryInstr* body_;
+  TargetEntryInstr* exit_;
+  BlockEntryInstr* preheader_;
+  GotoInstr* preheader_goto_;
+  BranchInstr* branch_;
+  // The phis of the header and their inputs.
+  GrowableArray<PhiInstr*> phis_;
+  GrowableArray<Value*> entry_inputs_;
+  GrowableArray<Value*> back_edge_inputs_;
+  // The instructions of the body, in order, without the back edge.
+  GrowableArray<Instruction*> instructions_;
+  // The block with the copies, and the values of the phis at its end.
+  TargetEntryInstr* copy_block_;
+  GrowableArray<Definition*> copied_values_;
+
+  // Peeling.
+  TargetEntryInstr* skip_block_;
+  JoinEntryInstr* exit_join_;
+  GrowableArray<PhiInstr*> exit_phis_;
+
+  // Unrolling.
+  PhiInstr* index_;
+  Definition* limit_;
+  int64_t stride_;
+  intptr_t factor_;
+  JoinEntryInstr* join_;
+
+  DISALLOW_COPY_AND_ASSIGN(CopyableLoop);
+};
+
+bool CopyableLoop::IsCopyable(Instruction* current) {
+  if (current->IsLoadIndexed() || current->IsStoreIndexed() ||
+      current->IsStoreInstanceField() || current->IsBinaryDoubleOp() ||
+      current->IsCheckArrayBound() || current->IsGenericCheckBound() ||
+      current->IsCheckSmi() || current->IsCheckNull() ||
+      current->IsCheckClass() || current->IsCheckClassId() ||
+      current->IsBox() || current->IsIntConverter()) {
+    return true;
+  }
+  if (LoadFieldInstr* load = current->AsLoadField()) {
+    return !load->calls_initializer();
+  }
+  if (UnboxInstr* unbox = current->AsUnbox()) {
+    switch (unbox->representation()) {
+      case kUnboxedInt32:
+      case kUnboxedUint32:
+      case kUnboxedInt64:
+      case kUnboxedDouble:
+      case kUnboxedFloat:
+      case kUnboxedFloat32x4:
+      case kUnboxedFloat64x2:
+      case kUnboxedInt32x4:
+        return true;
+      default:
+        return false;
+    }
+  }
+  if (BinaryIntegerOpInstr* op = current->AsBinaryIntegerOp()) {
+    // Shifts and divisions are created with extra state by Make, and int32
+    // operations are only supported for some operands.
+    switch (op->op_kind()) {
+      case Token::kADD:
+      case Token::kSUB:
+      case Token::kMUL:
+      case Token::kBIT_AND:
+      case Token::kBIT_OR:
+      case Token::kBIT_XOR:
+        break;
+      default:
+        return false;
+    }
+    return (op->representation() == kTagged) ||
+           (op->representation() == kUnboxedInt64) ||
+           (op->representation() == kUnboxedUint32);
+  }
+  return false;
+}
+
+bool CopyableLoop::Analyze() {
+  // Only innermost loops made of the header and a single body block.
+  if ((loop_->inner() != nullptr) || (loop_->back_edges().length() != 1)) {
+    return false;
+  }
+  header_ = loop_->header()->AsJoinEntry();
+  if ((header_ == nullptr) || (header_->PredecessorCount() != 2)) {
+    return false;
+  }
+  body_ = loop_->back_edges()[0]->AsTargetEntry();
+  if ((body_ == nullptr) || (body_->PredecessorAt(0) != header_)) {
+    return false;
+  }
+  intptr_t num_blocks = 0;
+  for (BitVector::Iterator it(loop_->blocks()); !it.Done(); it.Advance()) {
+    num_blocks++;
+  }
+  if (num_blocks != 2) {
+    return false;
+  }
+  const intptr_t back_edge_index = header_->IndexOfPredecessor(body_);
+  preheader_ = header_->PredecessorAt(1 - back_edge_index);
+  preheader_goto_ = preheader_->last_instruction()->AsGoto();
+  if (preheader_goto_ == nullptr) {
+    return false;
+  }
+
+  // The header only checks for interrupts and tests the phis.
+  for (ForwardInstructionIterator it(header_); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if (!current->IsCheckStackOverflow() &&
+        (current != header_->last_instruction())) {
+      return false;
+    }
+  }
+  branch_ = header_->last_instruction()->AsBranch();
+  if (branch_ == nullptr) {
+    return false;
+  }
+  if (branch_->true_successor() == body_) {
+    exit_ = branch_->false_successor();
+  } else if (branch_->false_successor() == body_) {
+    exit_ = branch_->true_successor();
+  } else {
+    return false;
+  }
+  ComparisonInstr* compare = branch_->comparison();
+  if ((!compare->IsRelationalOp() && !compare->IsEqualityCompare() &&
+       !compare->IsStrictCompare()) ||
+      (compare->InputCount() != 2)) {
+    return false;
+  }
+
+  if (header_->phis() != nullptr) {
+    for (PhiIterator it(header_); !it.Done(); it.Advance()) {
+      PhiInstr* phi = it.Current();
+      phis_.Add(phi);
+      entry_inputs_.Add(phi->InputAt(1 - back_edge_index));
+      back_edge_inputs_.Add(phi->InputAt(back_edge_index));
+    }
+  }
+
+  for (ForwardInstructionIterator it(body_); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if (current == body_->last_instruction()) {
+      break;
+    }
+    if (!IsCopyable(current)) {
+      return false;
+    }
+    instructions_.Add(current);
+  }
+  return !instructions_.is_empty();
+}
+
+bool CopyableLoop::HasInvariantCheck() const {
+  for (intptr_t i = 0; i < instructions_.length(); i++) {
+    Instruction* current = instructions_[i];
+    Value* value = nullptr;
+    if (CheckClassInstr* check = current->AsCheckClass()) {
+      value = check->value();
+    } else if (CheckNullInstr* check = current->AsCheckNull()) {
+      value = check->value();
+    } else if (CheckSmiInstr* check = current->AsCheckSmi()) {
+      value = check->value();
+    } else if (CheckClassIdInstr* check = current->AsCheckClassId()) {
+      value = check->value();
+    }
+    if ((value != nullptr) && IsInvariant(value->definition())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Instruction* CopyableLoop::CopyOf(Instruction* current,
+                                  const DefinitionMap& map) {
+  const intptr_t deopt_id = current->GetDeoptId();
+  if (LoadIndexedInstr* load = current->AsLoadIndexed()) {
+    return new (zone()) LoadIndexedInstr(
+        CopyOf(load->array(), map), CopyOf(load->index(), map),
+        load->RequiredInputRepresentation(1) != kTagged, load->index_scale(),
+        load->class_id(), load->aligned() ? kAlignedAccess : kUnalignedAccess,
+        deopt_id, load->source(), load->result_type());
+  }
+  if (StoreIndexedInstr* store = current->AsStoreIndexed()) {
+    return new (zone()) StoreIndexedInstr(
+        CopyOf(store->array(), map), CopyOf(store->index(), map),
+        CopyOf(store->value(), map), store->emit_store_barrier(),
+        store->RequiredInputRepresentation(StoreIndexedInstr::kIndexPos) !=
+            kTagged,
+        store->index_scale(), store->class_id(),
+        store->aligned() ? kAlignedAccess : kUnalignedAccess, deopt_id,
+        store->source(), store->SpeculativeModeOfInputs());
+  }
+  if (LoadFieldInstr* load = current->AsLoadField()) {
+    return new (zone()) LoadFieldInstr(CopyOf(load->instance(), map),
+                                       load->slot(), load->source());
+  }
+  if (StoreInstanceFieldInstr* store = current->AsStoreInstanceField()) {
+    return new (zone()) StoreInstanceFieldInstr(
+        store->slot(), CopyOf(store->instance(), map),
+        CopyOf(store->value(), map), store->emit_store_barrier(),
+        store->source(),
+        store->is_initialization()
+            ? StoreInstanceFieldInstr::Kind::kInitializing
+            : StoreInstanceFieldInstr::Kind::kOther);
+  }
+  if (BinaryDoubleOpInstr* op = current->AsBinaryDoubleOp()) {
+    return new (zone()) BinaryDoubleOpInstr(
+        op->op_kind(), CopyOf(op->left(), map), CopyOf(op->right(), map),
+        deopt_id, op->source(), op->SpeculativeModeOfInputs());
+  }
+  if (BinaryIntegerOpInstr* op = current->AsBinaryIntegerOp()) {
+    return BinaryIntegerOpInstr::Make(
+        op->representation(), op->op_kind(), CopyOf(op->left(), map),
+        CopyOf(op->right(), map), deopt_id, op->can_overflow(),
+        op->is_truncating(), op->range(), op->SpeculativeModeOfInputs());
+  }
+  if (CheckArrayBoundInstr* check = current->AsCheckArrayBound()) {
+    return new (zone()) CheckArrayBoundInstr(
+        CopyOf(check->length(), map), CopyOf(check->index(), map), deopt_id);
+  }
+  if (GenericCheckBoundInstr* check = current->AsGenericCheckBound()) {
+    return new (zone()) GenericCheckBoundInstr(
+        CopyOf(check->length(), map), CopyOf(check->index(), map), deopt_id);
+  }
+  if (CheckSmiInstr* check = current->AsCheckSmi()) {
+    return new (zone())
+        CheckSmiInstr(CopyOf(check->value(), map), deopt_id, check->source());
+  }
+  if (CheckNullInstr* check = current->AsCheckNull()) {
+    return new (zone())
+        CheckNullInstr(CopyOf(check->value(), map), check->function_name(),
+                       deopt_id, check->source(), check->exception_type());
+  }
+  if (CheckClassInstr* check = current->AsCheckClass()) {
+    return new (zone()) CheckClassInstr(CopyOf(check->value(), map), deopt_id,
+                                        check->cids(), check->source());
+  }
+  if (CheckClassIdInstr* check = current->AsCheckClassId()) {
+    return new (zone()) CheckClassIdInstr(CopyOf(check->value(), map),
+                                          check->cids(), deopt_id);
+  }
+  if (BoxInstr* box = current->AsBox()) {
+    return BoxInstr::Create(box->from_representation(),
+                            CopyOf(box->value(), map));
+  }
+  if (UnboxInstr* unbox = current->AsUnbox()) {
+    UnboxInstr* copy =
+        UnboxInstr::Create(unbox->representation(), CopyOf(unbox->value(), map),
+                           deopt_id, unbox->SpeculativeModeOfInputs());
+    if ((unbox->AsUnboxInteger() != nullptr) &&
+        unbox->AsUnboxInteger()->is_truncating()) {
+      copy->AsUnboxInteger()->mark_truncating();
+    }
+    return copy;
+  }
+  IntConverterInstr* converter = current->AsIntConverter();
+  ASSERT(converter != nullptr);
+  IntConverterInstr* copy = new (zone())
+      IntConverterInstr(converter->from(), converter->to(),
+                        CopyOf(converter->value(), map), deopt_id);
+  if (converter->is_truncating()) {
+    copy->mark_truncating();
+  }
+  return copy;
+}
+
+void CopyableLoop::CopyEnvironment(Instruction* copy,
+                                   const DefinitionMap& map) {
+  if (copy->env() == nullptr) {
+    return;
+  }
+  for (Environment::DeepIterator it(copy->env()); !it.Done(); it.Advance()) {
+    Value* value = it.CurrentValue();
+    Definition* def = LookupCopy(map, value->definition());
+    if (def != value->definition()) {
+      value->BindToEnvironment(def);
+    }
+  }
+}
+
+Instruction* CopyableLoop::AppendCopy(Instruction* cursor,
+                                      Instruction* current,
+                                      DefinitionMap* map) {
+  Instruction* copy = CopyOf(current, *map);
+  Definition* def = current->AsDefinition();
+  const bool has_value = (def != nullptr) && def->HasSSATemp();
+  cursor = flow_graph_->AppendTo(
+      cursor, copy, current->env(),
+      has_value ? FlowGraph::kValue : FlowGraph::kEffect);
+  CopyEnvironment(copy, *map);
+  if (def != nullptr) {
+    // The copy computes a value of the original in some iteration.
+    Definition* copy_def = copy->AsDefinition();
+    if (def->range() != nullptr) {
+      copy_def->set_range(*def->range());
+    }
+    map->Insert({def, copy_def});
+  }
+  return cursor;
+}
+
+Instruction* CopyableLoop::AppendIteration(Instruction* cursor,
+                                           GrowableArray<Definition*>* values) {
+  DefinitionMap map;
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    map.Insert({phis_[i], (*values)[i]});
+  }
+  for (intptr_t i = 0; i < instructions_.length(); i++) {
+    cursor = AppendCopy(cursor, instructions_[i], &map);
+  }
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    (*values)[i] = LookupCopy(map, back_edge_inputs_[i]->definition());
+  }
+  return cursor;
+}
+
+TargetEntryInstr* CopyableLoop::NewTarget(BlockEntryInstr* block) {
+  return new (zone()) TargetEntryInstr(flow_graph_->allocate_block_id(),
+                                       block->try_index(), DeoptId::kNone);
+}
+
+JoinEntryInstr* CopyableLoop::NewJoin(BlockEntryInstr* block) {
+  return new (zone()) JoinEntryInstr(flow_graph_->allocate_block_id(),
+                                     block->try_index(), DeoptId::kNone);
+}
+
+GotoInstr* CopyableLoop::NewGoto(JoinEntryInstr* target) {
+  return new (zone()) GotoInstr(target, DeoptId::kNone);
+}
+
+void CopyableLoop::PreparePeel() {
+  exit_join_ = NewJoin(exit_);
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    PhiInstr* phi = phis_[i];
+    GrowableArray<Value*> uses;
+    GrowableArray<Value*> env_uses;
+    for (Value::Iterator it(phi->input_use_list()); !it.Done(); it.Advance()) {
+      if (!loop_->Contains(it.Current()->instruction()->GetBlock())) {
+        uses.Add(it.Current());
+      }
+    }
+    for (Value::Iterator it(phi->env_use_list()); !it.Done(); it.Advance()) {
+      if (!loop_->Contains(it.Current()->instruction()->GetBlock())) {
+        env_uses.Add(it.Current());
+      }
+    }
+    if (uses.is_empty() && env_uses.is_empty()) {
+      continue;
+    }
+    // Inputs are reordered in FinalizePeel: the first one is the initial
+    // value, for the path which skips the loop.
+    PhiInstr* exit_phi =
+        flow_graph_->AddPhi(exit_join_, entry_inputs_[i]->definition(), phi);
+    exit_phi->set_representation(phi->representation());
+    for (intptr_t j = 0; j < uses.length(); j++) {
+      uses[j]->BindTo(exit_phi);
+    }
+    for (intptr_t j = 0; j < env_uses.length(); j++) {
+      env_uses[j]->BindToEnvironment(exit_phi);
+    }
+    exit_phis_.Add(exit_phi);
+  }
+}
+
+void CopyableLoop::Peel() {
+  GrowableArray<Definition*> values(phis_.length());
+  DefinitionMap map;
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    values.Add(entry_inputs_[i]->definition());
+    map.Insert({phis_[i], values[i]});
+  }
+
+  // Test the loop condition on the initial values.
+  JoinEntryInstr* test_block = NewJoin(header_);
+  preheader_goto_->set_successor(test_block);
+  ComparisonInstr* compare = branch_->comparison();
+  ComparisonInstr* test = compare->CopyWithNewOperands(
+      CopyOf(compare->left(), map), CopyOf(compare->right(), map));
+  BranchInstr* test_branch =
+      new (zone()) BranchInstr(test, branch_->GetDeoptId());
+  flow_graph_->AppendTo(test_block, test_branch, branch_->env(),
+                        FlowGraph::kEffect);
+  CopyEnvironment(test_branch, map);
+  test_block->set_last_instruction(test_branch);
+
+  copy_block_ = NewTarget(header_);
+  skip_block_ = NewTarget(header_);
+  if (branch_->true_successor() == body_) {
+    *test_branch->true_successor_address() = copy_block_;
+    *test_branch->false_successor_address() = skip_block_;
+  } else {
+    *test_branch->true_successor_address() = skip_block_;
+    *test_branch->false_successor_address() = copy_block_;
+  }
+  GotoInstr* goto_exit_join = NewGoto(exit_join_);
+  skip_block_->AppendInstruction(goto_exit_join);
+  skip_block_->set_last_instruction(goto_exit_join);
+
+  // Move the code after the loop to the join of both exits.
+  exit_join_->LinkTo(exit_->next());
+  exit_join_->set_last_instruction(exit_->last_instruction());
+  GotoInstr* exit_goto = NewGoto(exit_join_);
+  exit_->LinkTo(exit_goto);
+  exit_->set_last_instruction(exit_goto);
+
+  // The peeled iteration enters the loop with the values of its end.
+  Instruction* cursor = AppendIteration(copy_block_, &values);
+  GotoInstr* goto_header = NewGoto(header_);
+  flow_graph_->AppendTo(cursor, goto_header, nullptr, FlowGraph::kEffect);
+  copy_block_->set_last_instruction(goto_header);
+  copied_values_.AddArray(values);
+}
+
+void CopyableLoop::FinalizePeel() {
+  // Phi inputs are ordered like the predecessors of their block.
+  const intptr_t back_edge_index = header_->IndexOfPredecessor(body_);
+  ASSERT(header_->IndexOfPredecessor(copy_block_) == 1 - back_edge_index);
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    entry_inputs_[i]->BindTo(copied_values_[i]);
+    phis_[i]->SetInputAt(1 - back_edge_index, entry_inputs_[i]);
+    phis_[i]->SetInputAt(back_edge_index, back_edge_inputs_[i]);
+  }
+  if (exit_join_->IndexOfPredecessor(skip_block_) != 0) {
+    for (intptr_t i = 0; i < exit_phis_.length(); i++) {
+      PhiInstr* phi = exit_phis_[i];
+      Value* initial = phi->InputAt(0);
+      Value* last = phi->InputAt(1);
+      phi->SetInputAt(0, last);
+      phi->SetInputAt(1, initial);
+    }
+  }
+}
+
+bool CopyableLoop::IsUnrollable() {
+  RelationalOpInstr* compare = branch_->comparison()->AsRelationalOp();
+  if ((compare == nullptr) || (branch_->true_successor() != body_)) {
+    return false;
+  }
+  Definition* index = nullptr;
+  if (compare->kind() == Token::kLT) {
+    index = compare->left()->definition();
+    limit_ = compare->right()->definition();
+  } else if (compare->kind() == Token::kGT) {
+    index = compare->right()->definition();
+    limit_ = compare->left()->definition();
+  } else {
+    return false;
+  }
+  index_ = index->AsPhi();
+  if ((index_ == nullptr) || (index_->block() != header_)) {
+    return false;
+  }
+  const intptr_t expected_cid =
+      (index_->representation() == kTagged) ? kSmiCid : kMintCid;
+  if (((index_->representation() != kTagged) &&
+       (index_->representation() != kUnboxedInt64)) ||
+      (compare->operation_cid() != expected_cid)) {
+    return false;
+  }
+  if (!IsInvariant(limit_) ||
+      ((limit_->representation() != kUnboxedInt64) &&
+       ((limit_->representation() != kTagged) || !limit_->Type()->IsInt()))) {
+    return false;
+  }
+  if (!InductionVar::IsLinear(loop_->LookupInduction(index_), &stride_) ||
+      (stride_ <= 0) || (stride_ > kMaxInt32)) {
+    return false;
+  }
+
+  factor_ = Utils::Minimum<intptr_t>(FLAG_loop_unroll_factor,
+                                     FLAG_loop_unroll_max_size / size());
+  if ((factor_ < 2) || !Smi::IsValid((factor_ - 1) * stride_)) {
+    return false;
+  }
+  // The guard computes the index of the last unrolled iteration.
+  return RangeUtils::IsWithin(index_->range(), kMinInt64,
+                              kMaxInt64 - (factor_ - 1) * stride_);
+}
+
+Definition* CopyableLoop::UnboxedLimit() {
+  if (limit_->representation() == kUnboxedInt64) {
+    return limit_;
+  }
+  ASSERT(limit_->representation() == kTagged);
+  Definition* unbox =
+      UnboxInstr::Create(kUnboxedInt64, new (zone()) Value(limit_),
+                         DeoptId::kNone, Instruction::kNotSpeculative);
+  flow_graph_->InsertBefore(preheader_goto_, unbox, nullptr,
+                            FlowGraph::kValue);
+  return unbox;
+}
+
+void CopyableLoop::Unroll() {
+  GotoInstr* back_edge = body_->last_instruction()->AsGoto();
+  ASSERT(back_edge != nullptr);
+
+  // Move the original body into its own block for the remaining iterations.
+  JoinEntryInstr* remainder_block = NewJoin(body_);
+  join_ = NewJoin(body_);
+  remainder_block->LinkTo(body_->next());
+  remainder_block->set_last_instruction(back_edge);
+  back_edge->set_successor(join_);
+
+  // Run the unrolled body if its last iteration passes the loop test. The
+  // iterations before it then pass the test as well.
+  Instruction* cursor = body_;
+  Definition* index64 = index_;
+  if (index_->representation() == kTagged) {
+    index64 = UnboxInstr::Create(kUnboxedInt64, new (zone()) Value(index_),
+                                 DeoptId::kNone, Instruction::kNotSpeculative);
+    cursor = flow_graph_->AppendTo(cursor, index64, nullptr, FlowGraph::kValue);
+  }
+  Definition* last_index = new (zone()) BinaryInt64OpInstr(
+      Token::kADD, new (zone()) Value(index64),
+      new (zone()) Value(flow_graph_->GetConstant(
+          Smi::Handle(zone(), Smi::New((factor_ - 1) * stride_)),
+          kUnboxedInt64)),
+      DeoptId::kNone);
+  cursor =
+      flow_graph_->AppendTo(cursor, last_index, nullptr, FlowGraph::kValue);
+  RelationalOpInstr* compare = new (zone()) RelationalOpInstr(
+      branch_->source(), Token::kLT, new (zone()) Value(last_index),
+      new (zone()) Value(UnboxedLimit()), kMintCid, DeoptId::kNone,
+      Instruction::kNotSpeculative);
+  BranchInstr* branch = new (zone()) BranchInstr(compare, DeoptId::kNone);
+  flow_graph_->AppendTo(cursor, branch, nullptr, FlowGraph::kEffect);
+  body_->set_last_instruction(branch);
+
+  copy_block_ = NewTarget(body_);
+  TargetEntryInstr* remainder_entry = NewTarget(body_);
+  *branch->true_successor_address() = copy_block_;
+  *branch->false_successor_address() = remainder_entry;
+  GotoInstr* goto_remainder = NewGoto(remainder_block);
+  remainder_entry->AppendInstruction(goto_remainder);
+  remainder_entry->set_last_instruction(goto_remainder);
+
+  // The copies neither test the loop condition nor check for interrupts.
+  GrowableArray<Definition*> values(phis_.length());
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    values.Add(phis_[i]);
+  }
+  cursor = copy_block_;
+  for (intptr_t i = 0; i < factor_; i++) {
+    cursor = AppendIteration(cursor, &values);
+  }
+  GotoInstr* goto_join = NewGoto(join_);
+  flow_graph_->AppendTo(cursor, goto_join, nullptr, FlowGraph::kEffect);
+  copy_block_->set_last_instruction(goto_join);
+  copied_values_.AddArray(values);
+
+  GotoInstr* goto_header = NewGoto(header_);
+  join_->AppendInstruction(goto_header);
+  join_->set_last_instruction(goto_header);
+}
+
+void CopyableLoop::FinalizeUnroll() {
+  // Phi inputs are ordered like the predecessors of their block.
+  const bool copies_first = (join_->IndexOfPredecessor(copy_block_) == 0);
+  const intptr_t back_edge_index = header_->IndexOfPredecessor(join_);
+  ASSERT(back_edge_index >= 0);
+  for (intptr_t i = 0; i < phis_.length(); i++) {
+    PhiInstr* phi = phis_[i];
+    Definition* next = back_edge_inputs_[i]->definition();
+    PhiInstr* join_phi =
+        copies_first ? flow_graph_->AddPhi(join_, copied_values_[i], next)
+                     : flow_graph_->AddPhi(join_, next, copied_values_[i]);
+    join_phi->set_representation(phi->representation());
+    if (phi->range() != nullptr) {
+      join_phi->set_range(*phi->range());
+    }
+    back_edge_inputs_[i]->BindTo(join_phi);
+    phi->SetInputAt(back_edge_index, back_edge_inputs_[i]);
+    phi->SetInputAt(1 - back_edge_index, entry_inputs_[i]);
+  }
+}
+
+bool LoopPeeler::Optimize(FlowGraph* flow_graph) {
+  if (!FLAG_loop_peeling) {
+    return false;
+  }
+
+  const LoopHierarchy& loop_hierarchy = flow_graph->GetLoopHierarchy();
+  const ZoneGrowableArray<BlockEntryInstr*>& headers =
+      loop_hierarchy.headers();
+  GrowableArray<CopyableLoop*> loops;
+  for (intptr_t i = 0; i < headers.length(); i++) {
+    CopyableLoop* loop = new (flow_graph->zone())
+        CopyableLoop(flow_graph, headers[i]->loop_info());
+    if (loop->Analyze() && (loop->size() <= FLAG_loop_unroll_max_size) &&
+        loop->HasInvariantCheck()) {
+      loops.Add(loop);
+    }
+  }
+  if (loops.is_empty()) {
+    return false;
+  }
+
+  // Innermost loops are disjoint, but the exit of one loop may lead to the
+  // next one, so all uses after the loops are updated before any code moves.
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->PreparePeel();
+  }
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->Peel();
+  }
+  flow_graph->DiscoverBlocks();
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->FinalizePeel();
+  }
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph->ComputeDominators(&dominance_frontier);
+
+  if (FLAG_trace_optimization) {
+    for (intptr_t i = 0; i < loops.length(); i++) {
+      THR_Print("Peeled loop B%" Pd " in %s\n", loops[i]->header()->block_id(),
+                flow_graph->function().ToFullyQualifiedCString());
+    }
+  }
+  return true;
+}
+
+bool LoopUnroller::Optimize(FlowGraph* flow_graph) {
+  if (FLAG_loop_unroll_factor < 2) {
+    return false;
+  }
+
+  const LoopHierarchy& loop_hierarchy = flow_graph->GetLoopHierarchy();
+  loop_hierarchy.ComputeInduction();
+  const ZoneGrowableArray<BlockEntryInstr*>& headers =
+      loop_hierarchy.headers();
+  GrowableArray<CopyableLoop*> loops;
+  for (intptr_t i = 0; i < headers.length(); i++) {
+    CopyableLoop* loop = new (flow_graph->zone())
+        CopyableLoop(flow_graph, headers[i]->loop_info());
+    if (loop->Analyze() && loop->IsUnrollable()) {
+      loops.Add(loop);
+    }
+  }
+  if (loops.is_empty()) {
+    return false;
+  }
+
+  // Innermost loops are disjoint and can be transformed independently.
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->Unroll();
+  }
+  flow_graph->DiscoverBlocks();
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->FinalizeUnroll();
+  }
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph->ComputeDominators(&dominance_frontier);
+
+  if (FLAG_trace_optimization) {
+    for (intptr_t i = 0; i < loops.length(); i++) {
+      THR_Print("Unrolled loop B%" Pd " in %s by %" Pd "\n",
+                loops[i]->header()->block_id(),
+                flow_graph->function().ToFullyQualifiedCString(),
+                loops[i]->factor());
+    }
+  }
+  return true;
+}
+
+}  // namespace dart
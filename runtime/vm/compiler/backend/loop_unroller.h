@@ -0,0 +1,46 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+
+namespace dart {
+
+class FlowGraph;
+
+// Peels the first iteration off innermost loops which repeat a check of loop
+// invariant values that LICM could not hoist, e.g. because the check may throw
+// and a store precedes it in the loop, or because the body is not always
+// entered. The checks of the peeled iteration dominate the loop, so CSE
+// removes the ones left in the loop.
+class LoopPeeler : public AllStatic {
+ public:
+  // Returns true if any loop was peeled.
+  static bool Optimize(FlowGraph* flow_graph);
+};
+
+// Unrolls innermost counted loops
+//
+//     for (int i = ...; i < n; i += stride) { body }
+//
+// by --loop_unroll_factor (k). The unrolled body is guarded by
+// i + (k - 1) * stride < n and runs k copies of the original body without
+// testing the loop condition or checking for interrupts in between. The
+// original body is kept for the remaining iterations. Has to run after range
+// analysis, which proves that the guard does not overflow.
+class LoopUnroller : public AllStatic {
+ public:
+  // Returns true if any loop was unrolled.
+  static bool Optimize(FlowGraph* flow_graph);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
@@ -0,0 +1,172 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_unroller.h"
+
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/backend/loops.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/dart_entry.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+DECLARE_FLAG(int, loop_unroll_factor);
+
+// Helper method to count the instructions with the given tag, either in all
+// blocks or only in loop blocks.
+static intptr_t CountInstructions(FlowGraph* flow_graph,
+                                  Instruction::Tag tag,
+                                  bool only_in_loops) {
+  flow_graph->ResetLoopHierarchy();
+  flow_graph->GetLoopHierarchy();
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    BlockEntryInstr* block = block_it.Current();
+    if (only_in_loops && (block->loop_info() == nullptr)) {
+      continue;
+    }
+    for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+      if (it.Current()->tag() == tag) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// Helper method to optimize "foo" with the full JIT pipeline, run "check"
+// with the optimized code attached for several trip counts, and return the
+// optimized graph.
+static FlowGraph* OptimizeAndCheck(const char* script_chars) {
+  const auto& root_library = Library::Handle(LoadTestScript(script_chars));
+  Invoke(root_library, "main");
+
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  pipeline.CompileGraphAndAttachFunction();
+
+  // Trip counts which are not multiples of the unroll factor exercise the
+  // remainder of the loop.
+  const auto& check = Function::Handle(GetFunction(root_library, "check"));
+  const auto& arguments = Array::Handle(Array::New(1));
+  auto& result = Object::Handle();
+  for (intptr_t n = 0; n < 14; n++) {
+    arguments.SetAt(0, Smi::Handle(Smi::New(n)));
+    result = DartEntry::InvokeFunction(check, arguments);
+    EXPECT(result.ptr() == Bool::True().ptr());
+  }
+  // Ensure we didn't deoptimize to unoptimized code.
+  EXPECT(function.HasOptimizedCode());
+  return flow_graph;
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_Reduction) {
+  const char* kScriptChars =
+      R"(
+      import 'dart:typed_data';
+      double foo(Float64List a) {
+        double sum = 0.0;
+        for (int i = 0; i < a.length; i++) {
+          sum += a[i];
+        }
+        return sum;
+      }
+      bool check(int n) {
+        final a = new Float64List(n);
+        double expected = 0.0;
+        for (int i = 0; i < n; i++) {
+          a[i] = i / 3.0;
+          expected += a[i];
+        }
+        return foo(a) == expected;
+      }
+      main() {
+        for (int i = 0; i < 100; i++) {
+          check(i % 7);
+        }
+      }
+      )";
+  FlowGraph* flow_graph = OptimizeAndCheck(kScriptChars);
+  // The original body is kept for the remaining iterations.
+  EXPECT_EQ(1 + FLAG_loop_unroll_factor,
+            CountInstructions(flow_graph, Instruction::kLoadIndexed,
+                              /*only_in_loops=*/true));
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_CannotUnroll) {
+  // The loop index is not linear.
+  const char* kScriptChars =
+      R"(
+      import 'dart:typed_data';
+      double foo(Float64List a) {
+        double sum = 0.0;
+        for (int i = 1; i < a.length; i *= 2) {
+          sum += a[i];
+        }
+        return sum;
+      }
+      bool check(int n) {
+        final a = new Float64List(n);
+        double expected = 0.0;
+        for (int i = 0; i < n; i++) {
+          a[i] = i / 3.0;
+        }
+        for (int i = 1; i < n; i *= 2) {
+          expected += a[i];
+        }
+        return foo(a) == expected;
+      }
+      main() {
+        for (int i = 0; i < 100; i++) {
+          check(i % 7);
+        }
+      }
+      )";
+  FlowGraph* flow_graph = OptimizeAndCheck(kScriptChars);
+  EXPECT_EQ(1, CountInstructions(flow_graph, Instruction::kLoadIndexed,
+                                 /*only_in_loops=*/true));
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopPeeler_InvariantNullCheck) {
+  // The null check may throw and the loop is not always entered, so LICM
+  // can not hoist it.
+  const char* kScriptChars =
+      R"(
+      import 'dart:typed_data';
+      class A {
+        double v;
+        A(this.v);
+      }
+      void foo(Float64List list, A? a, int n) {
+        for (int i = 0; i < n; i++) {
+          list[i] = a!.v;
+        }
+      }
+      bool check(int n) {
+        final list = new Float64List(n);
+        foo(list, new A(0.5), n);
+        for (int i = 0; i < n; i++) {
+          if (list[i] != 0.5) return false;
+        }
+        return true;
+      }
+      main() {
+        for (int i = 0; i < 100; i++) {
+          check(i % 7);
+        }
+      }
+      )";
+  FlowGraph* flow_graph = OptimizeAndCheck(kScriptChars);
+  EXPECT_EQ(1, CountInstructions(flow_graph, Instruction::kCheckNull,
+                                 /*only_in_loops=*/false));
+  EXPECT_EQ(0, CountInstructions(flow_graph, Instruction::kCheckNull,
+                                 /*only_in_loops=*/true));
+}
+
+}  // namespace dart
@@ -0,0 +1,629 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_vectorizer.h"
+
+#include "vm/bit_vector.h"
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/flow_graph_compiler.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/loops.h"
+#include "vm/compiler/backend/range_analysis.h"
+#include "vm/hash_map.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_vectorization,
+            true,
+            "Vectorize simple loops over Float32List and Float64List.");
+
+// The widest vector used, in elements.
+static const intptr_t kMaxVectorWidth = 4;
+
+// Returns the number of elements processed by one vector iteration over
+// typed data with the given cid, or 0 if such loops are not vectorized.
+//
+// Float32List elements are computed as doubles and rounded when stored, which
+// gives the same result as single precision arithmetic for a single
+// operation only, see [VectorizableLoop::IsVectorizableOperand].
+static intptr_t VectorWidthFor(intptr_t cid) {
+  switch (cid) {
+    case kTypedDataFloat32ArrayCid:
+      return 4;
+    case kTypedDataFloat64ArrayCid:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+static intptr_t VectorArrayCidFor(intptr_t cid) {
+  return (cid == kTypedDataFloat32ArrayCid) ? kTypedDataFloat32x4ArrayCid
+                                            : kTypedDataFloat64x2ArrayCid;
+}
+
+static intptr_t VectorCidFor(intptr_t cid) {
+  return (cid == kTypedDataFloat32ArrayCid) ? kFloat32x4Cid : kFloat64x2Cid;
+}
+
+static SimdOpInstr::Kind SplatKindFor(intptr_t cid) {
+  return (cid == kTypedDataFloat32ArrayCid) ? SimdOpInstr::kFloat32x4Splat
+                                            : SimdOpInstr::kFloat64x2Splat;
+}
+
+// An innermost loop of the form
+//
+//     header:
+//       i <- phi(init, i')
+//       if (i < n) goto body else goto exit
+//     body:
+//       <typed data loads, stores and double arithmetic indexed by i>
+//       i' <- i + 1
+//       goto header
+//
+// which can be vectorized.
+class VectorizableLoop : public ZoneAllocated {
+ public:
+  VectorizableLoop(FlowGraph* flow_graph, LoopInfo* loop)
+      : flow_graph_(flow_graph),
+        zone_(flow_graph->zone()),
+        loop_(loop),
+        header_(nullptr),
+        body_(nullptr),
+        preheader_(nullptr),
+        index_(nullptr),
+        increment_(nullptr),
+        limits_(),
+        instructions_(),
+        element_cid_(kIllegalCid),
+        vectors_(),
+        entry_input_(nullptr),
+        back_edge_input_(nullptr),
+        join_(nullptr),
+        vector_block_(nullptr),
+        vector_increment_(nullptr) {}
+
+  // Returns true if the loop has the expected shape and only contains
+  // instructions that can be vectorized.
+  bool Analyze();
+
+  // Rewrites the body of the loop into
+  //
+  //     body:
+  //       if (i + width - 1 < limit) for each limit ...
+  //     vector:
+  //         <vector loads, stores and arithmetic>
+  //         goto join(i + width)
+  //       else
+  //     scalar:
+  //         <original body>
+  //         goto join(i + 1)
+  //     join:
+  //       goto header
+  //
+  // where the limits are the loop bound and the lengths of the arrays
+  // with bounds checks left in the body. The original body is only executed
+  // for the remaining iterations at the end and keeps throwing the same errors.
+  void Transform();
+
+  // Connects the induction variable through the join. Has to be called once
+  // the predecessors of all blocks are recomputed.
+  void Finalize();
+
+  BlockEntryInstr* header() const { return header_; }
+  intptr_t width() const { return VectorWidthFor(element_cid_); }
+
+ private:
+  typedef RawPointerKeyValueTrait<Definition, Definition*> VectorKV;
+
+  Zone* zone() const { return zone_; }
+
+  bool IsInvariant(Definition* def) const {
+    return !loop_->Contains(def->GetBlock());
+  }
+
+  bool IsInBody(Definition* def) const { return def->GetBlock() == body_; }
+
+  bool IsLoopIndex(Value* value) const {
+    return value->definition()->OriginalDefinition() == index_;
+  }
+
+  bool HasOnlyUsesInBody(Definition* def) const;
+  bool AddLimit(Definition* limit);
+  bool IsVectorizableAccess(Instruction* access,
+                            Value* array,
+                            Value* index,
+                            intptr_t index_pos,
+                            intptr_t class_id);
+  bool IsVectorizableOperand(BinaryDoubleOpInstr* op, Value* operand) const;
+  bool IsVectorizableStoredValue(Value* value) const;
+
+  Definition* VectorFor(Value* value);
+  Definition* UnboxedLimit(Definition* limit);
+
+  TargetEntryInstr* NewTarget(Instruction* inherit);
+  JoinEntryInstr* NewJoin(Instruction* inherit);
+  GotoInstr* NewGoto(JoinEntryInstr* target, Instruction* inherit);
+
+  FlowGraph* flow_graph_;
+  Zone* zone_;
+  LoopInfo* loop_;
+  JoinEntryInstr* header_;
+  TargetEntryInstr* body_;
+  BlockEntryInstr* preheader_;
+  PhiInstr* index_;
+  BinaryIntegerOpInstr* increment_;
+  // Invariant upper bounds (exclusive) of the loop index.
+  GrowableArray<Definition*> limits_;
+  // Loads, stores and arithmetic of the body, in order.
+  GrowableArray<Instruction*> instructions_;
+  // Class id of all typed data accessed in the loop.
+  intptr_t element_cid_;
+  // Maps scalar definitions to their vector counterparts.
+  DirectChainedHashMap<VectorKV> vectors_;
+  Value* entry_input_;
+  Value* back_edge_input_;
+  JoinEntryInstr* join_;
+  TargetEntryInstr* vector_block_;
+  Definition* vector_increment_;
+
+  DISALLOW_COPY_AND_ASSIGN(VectorizableLoop);
+};
+
+bool VectorizableLoop::HasOnlyUsesInBody(Definition* def) const {
+  for (Value::Iterator it(def->input_use_list()); !it.Done(); it.Advance()) {
+    if (it.Current()->instruction()->GetBlock() != body_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool VectorizableLoop::AddLimit(Definition* limit) {
+  if (!IsInvariant(limit)) {
+    return false;
+  }
+  if ((limit->representation() != kUnboxedInt64) &&
+      ((limit->representation() != kTagged) || !limit->Type()->IsInt())) {
+    return false;
+  }
+  for (intptr_t i = 0; i < limits_.length(); i++) {
+    if (limits_[i] == limit) {
+      return true;
+    }
+  }
+  limits_.Add(limit);
+  return true;
+}
+
+bool VectorizableLoop::IsVectorizableAccess(Instruction* access,
+                                            Value* array,
+                                            Value* index,
+                                            intptr_t index_pos,
+                                            intptr_t class_id) {
+  if (VectorWidthFor(class_id) == 0) {
+    return false;
+  }
+  // Lanes of different widths can not be mixed.
+  if (element_cid_ == kIllegalCid) {
+    element_cid_ = class_id;
+  } else if (element_cid_ != class_id) {
+    return false;
+  }
+  // Only internal typed data is accessed: distinct arrays never overlap, so
+  // accesses at the same index of different arrays are independent.
+  if ((array->definition()->representation() != kTagged) ||
+      !IsInvariant(array->definition())) {
+    return false;
+  }
+  return IsLoopIndex(index) && (access->RequiredInputRepresentation(
+                                    index_pos) == index_->representation());
+}
+
+bool VectorizableLoop::IsVectorizableOperand(BinaryDoubleOpInstr* op,
+                                             Value* operand) const {
+  Definition* def = operand->definition();
+  if (element_cid_ == kTypedDataFloat32ArrayCid) {
+    // Rounding the double result of a single operation on floats is the
+    // same as the single precision operation, but this is not true for
+    // expressions or for doubles which are not floats.
+    if (!def->IsLoadIndexed() || !IsInBody(def)) {
+      return false;
+    }
+    for (Value::Iterator it(op->input_use_list()); !it.Done(); it.Advance()) {
+      if (!it.Current()->instruction()->IsStoreIndexed()) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (IsInBody(def)) {
+    return def->IsLoadIndexed() || def->IsBinaryDoubleOp();
+  }
+  return IsInvariant(def) && (def->representation() == kUnboxedDouble);
+}
+
+bool VectorizableLoop::IsVectorizableStoredValue(Value* value) const {
+  Definition* def = value->definition();
+  if (IsInBody(def)) {
+    return def->IsLoadIndexed() || def->IsBinaryDoubleOp();
+  }
+  return IsInvariant(def) && (def->representation() == kUnboxedDouble);
+}
+
+bool VectorizableLoop::Analyze() {
+  // Only innermost loops made of the header and a single body block.
+  if ((loop_->inner() != nullptr) || (loop_->back_edges().length() != 1)) {
+    return false;
+  }
+  header_ = loop_->header()->AsJoinEntry();
+  if ((header_ == nullptr) || (header_->PredecessorCount() != 2)) {
+    return false;
+  }
+  body_ = loop_->back_edges()[0]->AsTargetEntry();
+  if ((body_ == nullptr) || (body_->PredecessorAt(0) != header_)) {
+    return false;
+  }
+  intptr_t num_blocks = 0;
+  for (BitVector::Iterator it(loop_->blocks()); !it.Done(); it.Advance()) {
+    num_blocks++;
+  }
+  if (num_blocks != 2) {
+    return false;
+  }
+  const intptr_t back_edge_index = header_->IndexOfPredecessor(body_);
+  preheader_ = header_->PredecessorAt(1 - back_edge_index);
+
+  // The only phi is the loop index, counting up by one from a non-negative
+  // value. The vector path computes i + width - 1 in 64 bits.
+  if ((header_->phis() == nullptr) || (header_->phis()->length() != 1)) {
+    return false;
+  }
+  index_ = (*header_->phis())[0];
+  if ((index_->representation() != kTagged) &&
+      (index_->representation() != kUnboxedInt64)) {
+    return false;
+  }
+  int64_t stride = 0;
+  if (!InductionVar::IsLinear(loop_->LookupInduction(index_), &stride) ||
+      (stride != 1)) {
+    return false;
+  }
+  if ((index_->range() == nullptr) ||
+      !index_->range()->IsWithin(0, kMaxInt64 - kMaxVectorWidth)) {
+    return false;
+  }
+  entry_input_ = index_->InputAt(1 - back_edge_index);
+  back_edge_input_ = index_->InputAt(back_edge_index);
+  increment_ = back_edge_input_->definition()->AsBinaryIntegerOp();
+  if ((increment_ == nullptr) || !IsInBody(increment_) ||
+      (increment_->op_kind() != Token::kADD) ||
+      (increment_->left()->definition() != index_) ||
+      !increment_->right()->BindsToSmiConstant() ||
+      (increment_->right()->BoundSmiConstant() != 1) ||
+      increment_->CanDeoptimize() ||
+      (increment_->representation() != index_->representation())) {
+    return false;
+  }
+
+  // The header only checks for interrupts and tests i < n.
+  for (ForwardInstructionIterator it(header_); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if (!current->IsCheckStackOverflow() &&
+        (current != header_->last_instruction())) {
+      return false;
+    }
+  }
+  BranchInstr* branch = header_->last_instruction()->AsBranch();
+  if ((branch == nullptr) || (branch->true_successor() != body_)) {
+    return false;
+  }
+  RelationalOpInstr* compare = branch->comparison()->AsRelationalOp();
+  if (compare == nullptr) {
+    return false;
+  }
+  const intptr_t expected_cid =
+      (index_->representation() == kTagged) ? kSmiCid : kMintCid;
+  if (compare->operation_cid() != expected_cid) {
+    return false;
+  }
+  Definition* limit = nullptr;
+  if ((compare->kind() == Token::kLT) &&
+      (compare->left()->definition() == index_)) {
+    limit = compare->right()->definition();
+  } else if ((compare->kind() == Token::kGT) &&
+             (compare->right()->definition() == index_)) {
+    limit = compare->left()->definition();
+  } else {
+    return false;
+  }
+  if (!AddLimit(limit)) {
+    return false;
+  }
+
+  // The body only accesses elements at the loop index.
+  bool has_store = false;
+  for (ForwardInstructionIterator it(body_); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if ((current == increment_) || (current == body_->last_instruction())) {
+      continue;
+    }
+    if (CheckBoundBase* check = current->AsCheckBoundBase()) {
+      if (!IsLoopIndex(check->index()) ||
+          !AddLimit(check->length()->definition())) {
+        return false;
+      }
+    } else if (LoadIndexedInstr* load = current->AsLoadIndexed()) {
+      if (!IsVectorizableAccess(load, load->array(), load->index(),
+                                /*index_pos=*/1, load->class_id()) ||
+          !HasOnlyUsesInBody(load)) {
+        return false;
+      }
+      instructions_.Add(load);
+    } else if (StoreIndexedInstr* store = current->AsStoreIndexed()) {
+      if (!IsVectorizableAccess(store, store->array(), store->index(),
+                                StoreIndexedInstr::kIndexPos,
+                                store->class_id())) {
+        return false;
+      }
+      instructions_.Add(store);
+      has_store = true;
+    } else if (BinaryDoubleOpInstr* op = current->AsBinaryDoubleOp()) {
+      switch (op->op_kind()) {
+        case Token::kADD:
+        case Token::kSUB:
+        case Token::kMUL:
+        case Token::kDIV:
+          break;
+        default:
+          return false;
+      }
+      if (!HasOnlyUsesInBody(op)) {
+        return false;
+      }
+      instructions_.Add(op);
+    } else {
+      return false;
+    }
+  }
+  if (!has_store) {
+    return false;
+  }
+
+  // Now that the element type is known, check the operands.
+  for (intptr_t i = 0; i < instructions_.length(); i++) {
+    Instruction* current = instructions_[i];
+    if (BinaryDoubleOpInstr* op = current->AsBinaryDoubleOp()) {
+      if (!IsVectorizableOperand(op, op->left()) ||
+          !IsVectorizableOperand(op, op->right())) {
+        return false;
+      }
+    } else if (StoreIndexedInstr* store = current->AsStoreIndexed()) {
+      if (!IsVectorizableStoredValue(store->value())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+TargetEntryInstr* VectorizableLoop::NewTarget(Instruction* inherit) {
+  TargetEntryInstr* target = new (zone()) TargetEntryInstr(
+      flow_graph_->allocate_block_id(), body_->try_index(), DeoptId::kNone);
+  target->InheritDeoptTarget(zone(), inherit);
+  return target;
+}
+
+JoinEntryInstr* VectorizableLoop::NewJoin(Instruction* inherit) {
+  JoinEntryInstr* join = new (zone()) JoinEntryInstr(
+      flow_graph_->allocate_block_id(), body_->try_index(), DeoptId::kNone);
+  join->InheritDeoptTarget(zone(), inherit);
+  return join;
+}
+
+GotoInstr* VectorizableLoop::NewGoto(JoinEntryInstr* target,
+                                     Instruction* inherit) {
+  GotoInstr* got = new (zone()) GotoInstr(target, DeoptId::kNone);
+  got->InheritDeoptTarget(zone(), inherit);
+  return got;
+}
+
+Definition* VectorizableLoop::UnboxedLimit(Definition* limit) {
+  if (limit->representation() == kUnboxedInt64) {
+    return limit;
+  }
+  ASSERT(limit->representation() == kTagged);
+  Definition* unbox =
+      UnboxInstr::Create(kUnboxedInt64, new (zone()) Value(limit),
+                         DeoptId::kNone, Instruction::kNotSpeculative);
+  flow_graph_->InsertBefore(preheader_->last_instruction(), unbox, nullptr,
+                            FlowGraph::kValue);
+  return unbox;
+}
+
+Definition* VectorizableLoop::VectorFor(Value* value) {
+  Definition* def = value->definition();
+  Definition* vector = vectors_.LookupValue(def);
+  if (vector != nullptr) {
+    return vector;
+  }
+  // Loop invariant doubles are broadcast to all lanes before the loop.
+  ASSERT(IsInvariant(def));
+  vector = SimdOpInstr::Create(SplatKindFor(element_cid_),
+                               new (zone()) Value(def), DeoptId::kNone);
+  flow_graph_->InsertBefore(preheader_->last_instruction(), vector, nullptr,
+                            FlowGraph::kValue);
+  vectors_.Insert({def, vector});
+  return vector;
+}
+
+void VectorizableLoop::Transform() {
+  const intptr_t vector_array_cid = VectorArrayCidFor(element_cid_);
+  const intptr_t vector_cid = VectorCidFor(element_cid_);
+  GotoInstr* back_edge = body_->last_instruction()->AsGoto();
+  ASSERT(back_edge != nullptr);
+
+  // Move the original body into its own block.
+  JoinEntryInstr* scalar_block = NewJoin(body_);
+  join_ = NewJoin(body_);
+  scalar_block->LinkTo(body_->next());
+  scalar_block->set_last_instruction(back_edge);
+  back_edge->set_successor(join_);
+
+  // Compute i + width - 1 and compare it against all limits.
+  Instruction* cursor = body_;
+  Definition* index64 = index_;
+  if (index_->representation() == kTagged) {
+    index64 = UnboxInstr::Create(kUnboxedInt64, new (zone()) Value(index_),
+                                 DeoptId::kNone, Instruction::kNotSpeculative);
+    cursor = flow_graph_->AppendTo(cursor, index64, nullptr, FlowGraph::kValue);
+  }
+  Definition* last_index = new (zone()) BinaryInt64OpInstr(
+      Token::kADD, new (zone()) Value(index64),
+      new (zone()) Value(flow_graph_->GetConstant(
+          Smi::Handle(zone(), Smi::New(width() - 1)), kUnboxedInt64)),
+      DeoptId::kNone);
+  cursor =
+      flow_graph_->AppendTo(cursor, last_index, nullptr, FlowGraph::kValue);
+  BlockEntryInstr* block = body_;
+  for (intptr_t i = 0; i < limits_.length(); i++) {
+    Definition* limit = UnboxedLimit(limits_[i]);
+    RelationalOpInstr* compare = new (zone()) RelationalOpInstr(
+        back_edge->source(), Token::kLT, new (zone()) Value(last_index),
+        new (zone()) Value(limit), kMintCid, DeoptId::kNone,
+        Instruction::kNotSpeculative);
+    BranchInstr* branch = new (zone()) BranchInstr(compare, DeoptId::kNone);
+    branch->InheritDeoptTarget(zone(), body_);
+    cursor = flow_graph_->AppendTo(cursor, branch, nullptr, FlowGraph::kEffect);
+    block->set_last_instruction(branch);
+
+    TargetEntryInstr* in_bounds = NewTarget(body_);
+    TargetEntryInstr* out_of_bounds = NewTarget(body_);
+    *branch->true_successor_address() = in_bounds;
+    *branch->false_successor_address() = out_of_bounds;
+    GotoInstr* goto_scalar = NewGoto(scalar_block, body_);
+    out_of_bounds->AppendInstruction(goto_scalar);
+    out_of_bounds->set_last_instruction(goto_scalar);
+
+    block = in_bounds;
+    cursor = in_bounds;
+  }
+  vector_block_ = block->AsTargetEntry();
+
+  // Emit the vector body. None of these instructions can deoptimize.
+  for (intptr_t i = 0; i < instructions_.length(); i++) {
+    Instruction* current = instructions_[i];
+    if (LoadIndexedInstr* load = current->AsLoadIndexed()) {
+      LoadIndexedInstr* vector = new (zone()) LoadIndexedInstr(
+          new (zone()) Value(load->array()->definition()),
+          new (zone()) Value(index_),
+          load->RequiredInputRepresentation(1) != kTagged,
+          load->index_scale(), vector_array_cid, kAlignedAccess,
+          DeoptId::kNone, load->source());
+      cursor =
+          flow_graph_->AppendTo(cursor, vector, nullptr, FlowGraph::kValue);
+      vectors_.Insert({load, vector});
+    } else if (BinaryDoubleOpInstr* op = current->AsBinaryDoubleOp()) {
+      SimdOpInstr* vector = SimdOpInstr::Create(
+          SimdOpInstr::KindForOperator(vector_cid, op->op_kind()),
+          new (zone()) Value(VectorFor(op->left())),
+          new (zone()) Value(VectorFor(op->right())), DeoptId::kNone);
+      cursor =
+          flow_graph_->AppendTo(cursor, vector, nullptr, FlowGraph::kValue);
+      vectors_.Insert({op, vector});
+    } else {
+      StoreIndexedInstr* store = current->AsStoreIndexed();
+      ASSERT(store != nullptr);
+      StoreIndexedInstr* vector = new (zone()) StoreIndexedInstr(
+          new (zone()) Value(store->array()->definition()),
+          new (zone()) Value(index_),
+          new (zone()) Value(VectorFor(store->value())), kNoStoreBarrier,
+          store->RequiredInputRepresentation(StoreIndexedInstr::kIndexPos) !=
+              kTagged,
+          store->index_scale(), vector_array_cid, kAlignedAccess,
+          DeoptId::kNone, store->source(), Instruction::kNotSpeculative);
+      cursor =
+          flow_graph_->AppendTo(cursor, vector, nullptr, FlowGraph::kEffect);
+    }
+  }
+
+  // i + width does not overflow: it is at most the loop bound.
+  vector_increment_ = BinaryIntegerOpInstr::Make(
+      index_->representation(), Token::kADD, new (zone()) Value(index_),
+      new (zone()) Value(flow_graph_->GetConstant(
+          Smi::Handle(zone(), Smi::New(width())), index_->representation())),
+      DeoptId::kNone, /*can_overflow=*/false, /*is_truncating=*/false,
+      /*range=*/nullptr, Instruction::kNotSpeculative);
+  cursor = flow_graph_->AppendTo(cursor, vector_increment_, nullptr,
+                                 FlowGraph::kValue);
+  GotoInstr* goto_join = NewGoto(join_, body_);
+  cursor =
+      flow_graph_->AppendTo(cursor, goto_join, nullptr, FlowGraph::kEffect);
+  vector_block_->set_last_instruction(goto_join);
+
+  GotoInstr* goto_header = NewGoto(header_, body_);
+  join_->AppendInstruction(goto_header);
+  join_->set_last_instruction(goto_header);
+}
+
+void VectorizableLoop::Finalize() {
+  // Phi inputs are ordered like the predecessors of the join.
+  PhiInstr* next_index =
+      (join_->IndexOfPredecessor(vector_block_) == 0)
+          ? flow_graph_->AddPhi(join_, vector_increment_, increment_)
+          : flow_graph_->AddPhi(join_, increment_, vector_increment_);
+  next_index->set_representation(index_->representation());
+
+  const intptr_t back_edge_index = header_->IndexOfPredecessor(join_);
+  ASSERT(back_edge_index >= 0);
+  back_edge_input_->BindTo(next_index);
+  index_->SetInputAt(back_edge_index, back_edge_input_);
+  index_->SetInputAt(1 - back_edge_index, entry_input_);
+}
+
+void LoopVectorizer::Optimize(FlowGraph* flow_graph) {
+  if (!FLAG_loop_vectorization ||
+      !FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    return;
+  }
+
+  const LoopHierarchy& loop_hierarchy = flow_graph->GetLoopHierarchy();
+  loop_hierarchy.ComputeInduction();
+  const ZoneGrowableArray<BlockEntryInstr*>& headers =
+      loop_hierarchy.headers();
+  GrowableArray<VectorizableLoop*> loops;
+  for (intptr_t i = 0; i < headers.length(); i++) {
+    VectorizableLoop* loop = new (flow_graph->zone())
+        VectorizableLoop(flow_graph, headers[i]->loop_info());
+    if (loop->Analyze()) {
+      loops.Add(loop);
+    }
+  }
+  if (loops.is_empty()) {
+    return;
+  }
+
+  // Innermost loops are disjoint and can be transformed independently.
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->Transform();
+  }
+  flow_graph->DiscoverBlocks();
+  for (intptr_t i = 0; i < loops.length(); i++) {
+    loops[i]->Finalize();
+  }
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph->ComputeDominators(&dominance_frontier);
+
+  if (FLAG_trace_optimization) {
+    for (intptr_t i = 0; i < loops.length(); i++) {
+      THR_Print("Vectorized loop B%" Pd " in %s by %" Pd "\n",
+                loops[i]->header()->block_id(),
+                flow_graph->function().ToFullyQualifiedCString(),
+                loops[i]->width());
+    }
+  }
+}
+
+}  // namespace dart
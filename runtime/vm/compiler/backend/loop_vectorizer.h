@@ -0,0 +1,36 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+
+namespace dart {
+
+class FlowGraph;
+
+// Rewrites counted loops doing element-wise double arithmetic on
+// Float32List and Float64List, e.g.
+//
+//     for (int i = 0; i < a.length; i++) {
+//       c[i] = a[i] * b[i] + k;
+//     }
+//
+// to process a whole Float32x4 or Float64x2 vector per iteration using
+// SimdOp instructions. The original loop body is kept for the remaining
+// elements. Has to run after range analysis: bounds checks that could not be
+// eliminated are turned into a guard for the vector path.
+class LoopVectorizer : public AllStatic {
+ public:
+  static void Optimize(FlowGraph* flow_graph);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
@@ -0,0 +1,168 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_vectorizer.h"
+
+#include "vm/compiler/backend/flow_graph_compiler.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/dart_entry.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+// Helper method to count the number of vector stores.
+static intptr_t CountVectorStores(FlowGraph* flow_graph) {
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      StoreIndexedInstr* store = it.Current()->AsStoreIndexed();
+      if ((store != nullptr) &&
+          ((store->class_id() == kTypedDataFloat64x2ArrayCid) ||
+           (store->class_id() == kTypedDataFloat32x4ArrayCid))) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// Helper method to optimize "foo" with the full JIT pipeline, count the
+// vector stores in the resulting graph and run "check" with the optimized
+// code attached.
+static intptr_t VectorizeAndCheck(const char* script_chars) {
+  const auto& root_library = Library::Handle(LoadTestScript(script_chars));
+  Invoke(root_library, "main");
+
+  const auto& function = Function::Handle(GetFunction(root_library, "foo"));
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  const intptr_t num_vector_stores = CountVectorStores(flow_graph);
+  pipeline.CompileGraphAndAttachFunction();
+
+  // Odd lengths exercise both the vector and the scalar path.
+  const auto& check = Function::Handle(GetFunction(root_library, "check"));
+  const auto& arguments = Array::Handle(Array::New(1));
+  auto& result = Object::Handle();
+  for (intptr_t length = 0; length < 14; length++) {
+    arguments.SetAt(0, Smi::Handle(Smi::New(length)));
+    result = DartEntry::InvokeFunction(check, arguments);
+    EXPECT(result.ptr() == Bool::True().ptr());
+  }
+  // Ensure we didn't deoptimize to unoptimized code.
+  EXPECT(function.HasOptimizedCode());
+  return num_vector_stores;
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Float64List) {
+  const char* kScriptChars =
+      R"(
+      import 'dart:typed_data';
+      void foo(Float64List a, Float64List b, Float64List c) {
+        for (int i = 0; i < c.length; i++) {
+          c[i] = a[i] * b[i] + 0.5;
+        }
+      }
+      bool check(int n) {
+        final a = new Float64List(n), b = new Float64List(n);
+        final c = new Float64List(n);
+        for (int i = 0; i < n; i++) {
+          a[i] = i * 1.5;
+          b[i] = 3.0 - i;
+        }
+        foo(a, b, c);
+        for (int i = 0; i < n; i++) {
+          if (c[i] != a[i] * b[i] + 0.5) return false;
+        }
+        return true;
+      }
+      main() {
+        for (int i = 0; i < 100; i++) {
+          check(i % 7);
+        }
+      }
+      )";
+  const intptr_t num_vector_stores = VectorizeAndCheck(kScriptChars);
+  if (FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    EXPECT_EQ(1, num_vector_stores);
+  } else {
+    EXPECT_EQ(0, num_vector_stores);
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Float32List) {
+  const char* kScriptChars =
+      R"(
+      import 'dart:typed_data';
+      void foo(Float32List a, Float32List b, Float32List c) {
+        for (int i = 0; i < c.length; i++) {
+          c[i] = a[i] / b[i];
+        }
+      }
+      bool check(int n) {
+        final a = new Float32List(n), b = new Float32List(n);
+        final c = new Float32List(n);
+        for (int i = 0; i < n; i++) {
+          a[i] = i / 3.0;
+          b[i] = i + 0.7;
+        }
+        foo(a, b, c);
+        final expected = new Float32List(1);
+        for (int i = 0; i < n; i++) {
+          expected[0] = a[i] / b[i];
+          if (c[i] != expected[0]) return false;
+        }
+        return true;
+      }
+      main() {
+        for (int i = 0; i < 100; i++) {
+          check(i % 7);
+        }
+      }
+      )";
+  const intptr_t num_vector_stores = VectorizeAndCheck(kScriptChars);
+  if (FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    EXPECT_EQ(1, num_vector_stores);
+  } else {
+    EXPECT_EQ(0, num_vector_stores);
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_CannotVectorize) {
+  // Elements depend on the previous iteration.
+  const char* kScriptChars =
+      R"(
+      import 'dart:typed_data';
+      void foo(Float64List a, Float64List c) {
+        for (int i = 0; i < c.length - 1; i++) {
+          c[i + 1] = c[i] + a[i];
+        }
+      }
+      bool check(int n) {
+        final a = new Float64List(n), c = new Float64List(n);
+        for (int i = 0; i < n; i++) {
+          a[i] = i * 1.0;
+        }
+        foo(a, c);
+        double sum = 0.0;
+        for (int i = 0; i < n - 1; i++) {
+          sum += a[i];
+          if (c[i + 1] != sum) return false;
+        }
+        return true;
+      }
+      main() {
+        for (int i = 0; i < 100; i++) {
+          check(i % 7);
+        }
+      }
+      )";
+  EXPECT_EQ(0, VectorizeAndCheck(kScriptChars));
+}
+
+}  // namespace dart
@@ -21,6 +21,11 @@ DEFINE_FLAG(bool,
             optimize_lazy_initializer_calls,
             true,
             "Eliminate redundant lazy initializer calls.");
+DEFINE_FLAG(bool,
+            partial_escape_analysis,
+            true,
+            "Sink allocations which only escape at instructions after which "
+            "they are dead, allocating them only where they escape.");
 DEFINE_FLAG(bool,
             trace_load_optimization,
             false,
@@ -3084,8 +3089,6 @@ static bool IsSupportedAllocation(Instruction* instr) {
           IsValidLengthForAllocationSinking(instr->AsArrayAllocation()));
 }
 
-enum SafeUseCheck { kOptimisticCheck, kStrictCheck };
-
 // Check if the use is safe for allocation sinking. Allocation sinking
 // candidates can only be used as inputs to store and allocation instructions:
 //
@@ -3095,6 +3098,10 @@ enum SafeUseCheck { kOptimisticCheck, kStrictCheck };
 //       an allocation candidate.
 //     - use as input to another allocation is only safe if the other allocation
 //       is a candidate.
+//     - any other use is only safe if the candidate is partially escaping
+//       (see CollectPartiallyEscaping). Such candidates are materialized
+//       right before the instructions they escape at, so nothing can be stored
+//       into them which might need to be materialized as well.
 //
 // We use a simple fix-point algorithm to discover the set of valid candidates
 // (see CollectCandidates method), that's why this IsSafeUse can operate in two
@@ -3108,7 +3115,7 @@ enum SafeUseCheck { kOptimisticCheck, kStrictCheck };
 // Fix-point algorithm in CollectCandiates first collects a set of allocations
 // optimistically and then checks each collected candidate strictly and unmarks
 // invalid candidates transitively until only strictly valid ones remain.
-static bool IsSafeUse(Value* use, SafeUseCheck check_type) {
+bool AllocationSinking::IsSafeUse(Value* use, SafeUseCheck check_type) {
   ASSERT(IsSupportedAllocation(use->definition()));
 
   if (use->instruction()->IsMaterializeObject()) {
@@ -3116,7 +3123,7 @@ static bool IsSafeUse(Value* use, SafeUseCheck check_type) {
   }
 
   if (auto* const alloc = use->instruction()->AsAllocation()) {
-    return IsSupportedAllocation(alloc) &&
+    return IsSupportedAllocation(alloc) && !IsPartiallyEscaping(alloc) &&
            ((check_type == kOptimisticCheck) ||
             alloc->Identity().IsAllocationSinkingCandidate());
   }
@@ -3125,6 +3132,7 @@ static bool IsSafeUse(Value* use, SafeUseCheck check_type) {
     if (use == store->value()) {
       Definition* instance = store->instance()->definition();
       return IsSupportedAllocation(instance) &&
+             !IsPartiallyEscaping(instance) &&
              ((check_type == kOptimisticCheck) ||
               instance->Identity().IsAllocationSinkingCandidate());
     }
@@ -3157,20 +3165,22 @@ static bool IsSafeUse(Value* use, SafeUseCheck check_type) {
     if (use == store->value()) {
       Definition* instance = store->array()->definition();
       return IsSupportedAllocation(instance) &&
+             !IsPartiallyEscaping(instance) &&
              ((check_type == kOptimisticCheck) ||
               instance->Identity().IsAllocationSinkingCandidate());
     }
     return true;
   }
 
-  return false;
+  // The use was checked by CanMaterializeAtEscapes.
+  return IsPartiallyEscaping(use->definition());
 }
 
 // Right now we are attempting to sink allocation only into
 // deoptimization exit. So candidate should only be used in StoreInstanceField
 // instructions that write into fields of the allocated object.
-static bool IsAllocationSinkingCandidate(Definition* alloc,
-                                         SafeUseCheck check_type) {
+bool AllocationSinking::IsAllocationSinkingCandidate(Definition* alloc,
+                                                     SafeUseCheck check_type) {
   for (Value* use = alloc->input_use_list(); use != NULL;
        use = use->next_use()) {
     if (!IsSafeUse(use, check_type)) {
@@ -3265,10 +3275,137 @@ void AllocationSinking::EliminateAllocation(Definition* alloc) {
   alloc->RemoveFromGraph();
 }
 
+// Returns true if no use of the given allocation can be executed after the
+// given instruction which uses it, including the instruction itself when it
+// is in a loop.
+bool AllocationSinking::IsDeadAfter(Definition* alloc, Instruction* escape) {
+  BlockEntryInstr* escape_block = escape->GetBlock();
+  BitVector* use_blocks =
+      new (Z) BitVector(Z, flow_graph_->preorder().length());
+  for (Value::Iterator it(alloc->input_use_list()); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current()->instruction();
+    if (instr == escape) continue;
+    BlockEntryInstr* block = instr->GetBlock();
+    if ((block == escape_block) && !instr->IsPhi()) {
+      for (Instruction* next = escape->next(); next != nullptr;
+           next = next->next()) {
+        if (next == instr) return false;
+      }
+    }
+    use_blocks->Add(block->preorder_number());
+  }
+  for (Value::Iterator it(alloc->env_use_list()); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current()->instruction();
+    if (instr == escape) return false;
+    BlockEntryInstr* block = instr->GetBlock();
+    if (block == escape_block) {
+      for (Instruction* next = escape->next(); next != nullptr;
+           next = next->next()) {
+        if (next == instr) return false;
+      }
+    }
+    use_blocks->Add(block->preorder_number());
+  }
+
+  // Look for uses in all blocks reachable from the escaping instruction.
+  BitVector* visited = new (Z) BitVector(Z, flow_graph_->preorder().length());
+  GrowableArray<BlockEntryInstr*> worklist;
+  Instruction* last = escape_block->last_instruction();
+  for (intptr_t i = 0; i < last->SuccessorCount(); i++) {
+    worklist.Add(last->SuccessorAt(i));
+  }
+  while (!worklist.is_empty()) {
+    BlockEntryInstr* block = worklist.RemoveLast();
+    const intptr_t preorder_number = block->preorder_number();
+    if (visited->Contains(preorder_number)) continue;
+    visited->Add(preorder_number);
+    if ((block == escape_block) || use_blocks->Contains(preorder_number)) {
+      return false;
+    }
+    last = block->last_instruction();
+    for (intptr_t i = 0; i < last->SuccessorCount(); i++) {
+      worklist.Add(last->SuccessorAt(i));
+    }
+  }
+  return true;
+}
+
+// Returns true if the given allocation can be materialized right before each
+// instruction it escapes at. That is the case if the allocation is dead after
+// each of these instructions, and if it is neither stored into other objects
+// nor has to be materialized at deoptimization exits of these instructions.
+//
+// A fresh copy of the object then replaces the allocation as input of the
+// escaping instruction, so the allocation is only performed on the paths
+// where the object escapes. As materializations do not have a deoptimization
+// environment this is only done in AOT mode.
+bool AllocationSinking::CanMaterializeAtEscapes(Definition* alloc) {
+  const intptr_t kMaxEscapes = 4;
+  if (!alloc->IsAllocateObject() && !alloc->IsAllocateClosure()) {
+    return false;
+  }
+
+  GrowableArray<Instruction*> escapes;
+  for (Value::Iterator it(alloc->input_use_list()); !it.Done(); it.Advance()) {
+    Value* use = it.Current();
+    Definition* destination = StoreDestination(use);
+    if (destination == alloc) continue;
+    Instruction* instr = use->instruction();
+    if ((destination != nullptr) || instr->IsPhi() ||
+        instr->IsMaterializeObject()) {
+      return false;
+    }
+    if (!escapes.Contains(instr)) {
+      escapes.Add(instr);
+    }
+  }
+  if (escapes.is_empty() || (escapes.length() > kMaxEscapes)) {
+    return false;
+  }
+
+  for (auto escape : escapes) {
+    if (!IsDeadAfter(alloc, escape)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Find allocations which escape only at instructions after which they are
+// dead. See CanMaterializeAtEscapes.
+void AllocationSinking::CollectPartiallyEscaping() {
+  if (!FLAG_partial_escape_analysis || !CompilerState::Current().is_aot()) {
+    return;
+  }
+
+  for (BlockIterator block_it = flow_graph_->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    BlockEntryInstr* block = block_it.Current();
+    for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+      Definition* alloc = it.Current()->AsDefinition();
+      if ((alloc == nullptr) || !alloc->HasSSATemp() ||
+          !CanMaterializeAtEscapes(alloc)) {
+        continue;
+      }
+      if (FLAG_trace_optimization) {
+        THR_Print("allocation v%" Pd " is partially escaping\n",
+                  alloc->ssa_temp_index());
+      }
+      if (partially_escaping_ == nullptr) {
+        partially_escaping_ =
+            new (Z) BitVector(Z, flow_graph_->current_ssa_temp_index());
+      }
+      partially_escaping_->Add(alloc->ssa_temp_index());
+    }
+  }
+}
+
 // Find allocation instructions that can be potentially eliminated and
 // rematerialized at deoptimization exits if needed. See IsSafeUse
 // for the description of algorithm used below.
 void AllocationSinking::CollectCandidates() {
+  CollectPartiallyEscaping();
+
   // Optimistically collect all potential candidates.
   for (BlockIterator block_it = flow_graph_->reverse_postorder_iterator();
        !block_it.Done(); block_it.Advance()) {
@@ -3453,6 +3590,23 @@ void AllocationSinking::DiscoverFailedCandidates() {
       }
     }
     materializations_.TruncateTo(k);
+
+    // Likewise let the instructions a failed candidate escapes at use the
+    // allocation again.
+    k = 0;
+    for (intptr_t i = 0; i < escape_materializations_.length(); i++) {
+      MaterializeObjectInstr* mat = escape_materializations_[i];
+      if (!mat->allocation()->Identity().IsAllocationSinkingCandidate()) {
+        mat->ReplaceUsesWith(mat->allocation());
+        mat->RemoveFromGraph();
+      } else {
+        if (k != i) {
+          escape_materializations_[k] = mat;
+        }
+        k++;
+      }
+    }
+    escape_materializations_.TruncateTo(k);
   }
 
   candidates_.TruncateTo(j);
@@ -3487,6 +3641,11 @@ void AllocationSinking::Optimize() {
     InsertMaterializations(candidates_[i]);
   }
 
+  // From now on the uses of partially escaping candidates are restricted like
+  // those of other candidates: the loads inserted for their materializations
+  // have to be forwarded.
+  partially_escaping_ = nullptr;
+
   // Run load forwarding to eliminate LoadField/LoadIndexed instructions
   // inserted above.
   //
@@ -3513,6 +3672,8 @@ void AllocationSinking::Optimize() {
     EliminateAllocation(candidates_[i]);
   }
 
+  AllocateEscapeMaterializations();
+
   // Process materializations and unbox their arguments: materializations
   // are part of the environment and can materialize boxes for double/mint/simd
   // values when needed.
@@ -3583,7 +3744,7 @@ MaterializeObjectInstr* AllocationSinking::MaterializationFor(
 
 // Insert MaterializeObject instruction for the given allocation before
 // the given instruction that can deoptimize.
-void AllocationSinking::CreateMaterializationAt(
+MaterializeObjectInstr* AllocationSinking::CreateMaterializationAt(
     Instruction* exit,
     Definition* alloc,
     const ZoneGrowableArray<const Slot*>& slots) {
@@ -3668,8 +3829,7 @@ void AllocationSinking::CreateMaterializationAt(
   val->set_instruction(mat);
   alloc->AddEnvUse(val);
 
-  // Record inserted materialization.
-  materializations_.Add(mat);
+  return mat;
 }
 
 // Add given instruction to the list of the instructions if it is not yet
@@ -3769,13 +3929,108 @@ void AllocationSinking::InsertMaterializations(Definition* alloc) {
     }
   }
 
+  // Collect the instructions a partially escaping object escapes at before
+  // inserting loads from it.
+  GrowableArray<Instruction*> escapes;
+  if (IsPartiallyEscaping(alloc)) {
+    for (Value::Iterator it(alloc->input_use_list()); !it.Done();
+         it.Advance()) {
+      Instruction* instr = it.Current()->instruction();
+      if ((StoreDestination(it.Current()) != alloc) &&
+          !escapes.Contains(instr)) {
+        escapes.Add(instr);
+      }
+    }
+  }
+
   // Collect all instructions that mention this object in the environment.
   exits_collector_.CollectTransitively(alloc);
 
   // Insert materializations at environment uses.
   for (intptr_t i = 0; i < exits_collector_.exits().length(); i++) {
-    CreateMaterializationAt(exits_collector_.exits()[i], alloc, *slots);
+    materializations_.Add(
+        CreateMaterializationAt(exits_collector_.exits()[i], alloc, *slots));
+  }
+
+  InsertEscapeMaterializations(alloc, escapes, *slots);
+}
+
+// Replace the given partially escaping allocation by a materialization in the
+// inputs of each instruction it escapes at.
+void AllocationSinking::InsertEscapeMaterializations(
+    Definition* alloc,
+    const GrowableArray<Instruction*>& escapes,
+    const ZoneGrowableArray<const Slot*>& slots) {
+  for (auto escape : escapes) {
+    MaterializeObjectInstr* mat =
+        CreateMaterializationAt(escape, alloc, slots);
+    for (intptr_t i = 0; i < escape->InputCount(); i++) {
+      Value* input = escape->InputAt(i);
+      if (input->definition() == alloc) {
+        input->BindTo(mat);
+      }
+    }
+    escape_materializations_.Add(mat);
+  }
+}
+
+// Replace materializations of eliminated allocations at the instructions they
+// escape at by real allocations of the objects.
+void AllocationSinking::AllocateEscapeMaterializations() {
+  for (auto mat : escape_materializations_) {
+    AllocationInstr* alloc = mat->allocation();
+    Instruction* insert_before =
+        FirstMaterializationAt(ExitForMaterialization(mat));
+
+    // The inputs of the eliminated allocation are among the values of the
+    // materialization.
+    auto input_for_slot = [&](const Slot& slot) -> Value* {
+      for (intptr_t i = 0; i < mat->InputCount(); i++) {
+        if (mat->SlotAt(i).IsIdentical(slot)) {
+          return new (Z) Value(mat->InputAt(i)->definition());
+        }
+      }
+      UNREACHABLE();
+      return nullptr;
+    };
+    AllocationInstr* copy = nullptr;
+    if (auto instr = alloc->AsAllocateObject()) {
+      Value* type_arguments = nullptr;
+      if (instr->type_arguments() != nullptr) {
+        type_arguments = input_for_slot(
+            *instr->SlotForInput(AllocateObjectInstr::kTypeArgumentsPos));
+      }
+      copy = new (Z) AllocateObjectInstr(alloc->source(), instr->cls(),
+                                         DeoptId::kNone, type_arguments);
+    } else if (alloc->IsAllocateClosure()) {
+      copy = new (Z) AllocateClosureInstr(
+          alloc->source(), input_for_slot(Slot::Closure_function()),
+          input_for_slot(Slot::Closure_context()), DeoptId::kNone);
+    } else {
+      UNREACHABLE();
+    }
+    flow_graph_->InsertBefore(insert_before, copy, /*env=*/nullptr,
+                              FlowGraph::kValue);
+
+    for (intptr_t i = 0; i < mat->InputCount(); i++) {
+      const Slot& slot = mat->SlotAt(i);
+      if (copy->InputForSlot(slot) >= 0) continue;
+      auto store = new (Z) StoreInstanceFieldInstr(
+          slot, new (Z) Value(copy),
+          new (Z) Value(mat->InputAt(i)->definition()), kEmitStoreBarrier,
+          alloc->source(), StoreInstanceFieldInstr::Kind::kInitializing);
+      flow_graph_->InsertBefore(insert_before, store, /*env=*/nullptr,
+                                FlowGraph::kEffect);
+    }
+
+    if (FLAG_trace_optimization) {
+      THR_Print("allocating v%" Pd " as v%" Pd " where it escapes\n",
+                alloc->ssa_temp_index(), copy->ssa_temp_index());
+    }
+    mat->ReplaceUsesWith(copy);
+    mat->RemoveFromGraph();
   }
+  escape_materializations_.Clear();
 }
 
 // TryCatchAnalyzer tries to reduce the state that needs to be synchronized
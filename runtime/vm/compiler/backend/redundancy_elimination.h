@@ -19,7 +19,11 @@ class CSEInstructionMap;
 class AllocationSinking : public ZoneAllocated {
  public:
   explicit AllocationSinking(FlowGraph* flow_graph)
-      : flow_graph_(flow_graph), candidates_(5), materializations_(5) {}
+      : flow_graph_(flow_graph),
+        candidates_(5),
+        materializations_(5),
+        escape_materializations_(5),
+        partially_escaping_(nullptr) {}
 
   const GrowableArray<Definition*>& candidates() const { return candidates_; }
 
@@ -56,6 +60,26 @@ class AllocationSinking : public ZoneAllocated {
     GrowableArray<Definition*> worklist_;
   };
 
+  enum SafeUseCheck { kOptimisticCheck, kStrictCheck };
+
+  bool IsSafeUse(Value* use, SafeUseCheck check_type);
+
+  bool IsAllocationSinkingCandidate(Definition* alloc,
+                                    SafeUseCheck check_type);
+
+  // Returns true if the given allocation only escapes at instructions after
+  // which it is dead (see CollectPartiallyEscaping).
+  bool IsPartiallyEscaping(Definition* alloc) const {
+    return (partially_escaping_ != nullptr) && alloc->HasSSATemp() &&
+           partially_escaping_->Contains(alloc->ssa_temp_index());
+  }
+
+  void CollectPartiallyEscaping();
+
+  bool CanMaterializeAtEscapes(Definition* alloc);
+
+  bool IsDeadAfter(Definition* alloc, Instruction* escape);
+
   void CollectCandidates();
 
   void NormalizeMaterializations();
@@ -66,9 +90,17 @@ class AllocationSinking : public ZoneAllocated {
 
   void InsertMaterializations(Definition* alloc);
 
-  void CreateMaterializationAt(Instruction* exit,
-                               Definition* alloc,
-                               const ZoneGrowableArray<const Slot*>& fields);
+  MaterializeObjectInstr* CreateMaterializationAt(
+      Instruction* exit,
+      Definition* alloc,
+      const ZoneGrowableArray<const Slot*>& fields);
+
+  void InsertEscapeMaterializations(
+      Definition* alloc,
+      const GrowableArray<Instruction*>& escapes,
+      const ZoneGrowableArray<const Slot*>& slots);
+
+  void AllocateEscapeMaterializations();
 
   void EliminateAllocation(Definition* alloc);
 
@@ -79,6 +111,14 @@ class AllocationSinking : public ZoneAllocated {
   GrowableArray<Definition*> candidates_;
   GrowableArray<MaterializeObjectInstr*> materializations_;
 
+  // Materializations which replace partially escaping candidates as inputs of
+  // the instructions they escape at. They are turned into real allocations
+  // once the candidates are eliminated.
+  GrowableArray<MaterializeObjectInstr*> escape_materializations_;
+
+  // SSA temp indices of the partially escaping allocations.
+  BitVector* partially_escaping_;
+
   ExitsCollector exits_collector_;
 };
 
@@ -1333,6 +1333,104 @@ ISOLATE_UNIT_TEST_CASE(DelayAllocations_DontDelayIntoLoop) {
   EXPECT(call->Receiver()->definition() == allocate);
 }
 
+// Returns the allocations of objects of the class [name] in [flow_graph].
+static GrowableArray<AllocateObjectInstr*> FindAllocations(
+    FlowGraph* flow_graph,
+    const char* name) {
+  GrowableArray<AllocateObjectInstr*> allocations;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      auto allocate = it.Current()->AsAllocateObject();
+      if ((allocate != nullptr) &&
+          (strcmp(allocate->cls().ScrubbedNameCString(), name) == 0)) {
+        allocations.Add(allocate);
+      }
+    }
+  }
+  return allocations;
+}
+
+ISOLATE_UNIT_TEST_CASE(AllocationSinking_PartialEscape) {
+  const char* kScript = R"(
+    class Point {
+      int x, y;
+      Point(this.x, this.y);
+    }
+
+    @pragma('vm:never-inline')
+    void log(Object o) {}
+
+    int test(int a, int b) {
+      final p = new Point(a, b);
+      if (a > 100) {
+        p.x = b;
+        log(p);
+        return 0;
+      }
+      p.y = a;
+      return p.x + p.y;
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "test"));
+
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // The point is only allocated where it escapes.
+  auto allocations = FindAllocations(flow_graph, "Point");
+  EXPECT_EQ(1, allocations.length());
+  AllocateObjectInstr* allocate = allocations[0];
+  StaticCallInstr* call = nullptr;
+  for (Instruction* instr = allocate->next(); instr != nullptr;
+       instr = instr->next()) {
+    if (instr->IsStaticCall()) {
+      call = instr->AsStaticCall();
+      break;
+    }
+  }
+  RELEASE_ASSERT(call != nullptr);
+  EXPECT(strcmp(call->function().UserVisibleNameCString(), "log") == 0);
+  EXPECT(call->ArgumentAt(0) == allocate);
+}
+
+ISOLATE_UNIT_TEST_CASE(AllocationSinking_EscapeInLoop) {
+  const char* kScript = R"(
+    class Point {
+      int x, y;
+      Point(this.x, this.y);
+    }
+
+    @pragma('vm:never-inline')
+    void log(Object o) {}
+
+    int test(int a, int b) {
+      final p = new Point(a, b);
+      for (int i = 0; i < a; i++) {
+        if (i == b) {
+          log(p);
+        }
+      }
+      return p.x + p.y;
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "test"));
+
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+
+  // The same point may escape several times, so it can not be copied.
+  auto allocations = FindAllocations(flow_graph, "Point");
+  EXPECT_EQ(1, allocations.length());
+  flow_graph->GetLoopHierarchy();
+  EXPECT(allocations[0]->GetBlock()->loop_info() == nullptr);
+}
+
 ISOLATE_UNIT_TEST_CASE(CheckStackOverflowElimination_NoInterruptsPragma) {
   const char* kScript = R"(
     @pragma('vm:unsafe:no-interrupts')
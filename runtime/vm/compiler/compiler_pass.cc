@@ -11,10 +11,13 @@
 #include "vm/compiler/backend/il_printer.h"
 #include "vm/compiler/backend/inliner.h"
 #include "vm/compiler/backend/linearscan.h"
+#include "vm/compiler/backend/loop_unroller.h"
+#include "vm/compiler/backend/loop_vectorizer.h"
 #include "vm/compiler/backend/range_analysis.h"
 #include "vm/compiler/backend/redundancy_elimination.h"
 #include "vm/compiler/backend/type_propagator.h"
 #include "vm/compiler/call_specializer.h"
+#include "vm/compiler/compiler_state.h"
 #include "vm/compiler/compiler_timings.h"
 #include "vm/compiler/write_barrier_elimination.h"
 #if defined(DART_PRECOMPILER)
@@ -61,6 +64,8 @@ CompilerPassState::CompilerPassState(
       speculative_policy(speculative_policy),
       reorder_blocks(false),
       sticky_flags(0),
+      instruction_count(0),
+      call_site_count(0),
       flow_graph_(flow_graph) {
   // Top scope function is at inlining id 0.
   inline_id_to_function.Add(&flow_graph->parsed_function().function());
@@ -306,6 +311,40 @@ FlowGraph* CompilerPass::RunForceOptimizedPipeline(
   return pass_state->flow_graph();
 }
 
+FlowGraph* CompilerPass::RunBaselinePipeline(PipelineMode mode,
+                                             CompilerPassState* pass_state) {
+  INVOKE_PASS(ComputeSSA);
+  INVOKE_PASS(ApplyICData);
+  INVOKE_PASS(TryOptimizePatterns);
+  INVOKE_PASS(SetOuterInliningId);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(ApplyClassIds);
+  INVOKE_PASS(Inlining);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(ApplyClassIds);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(ApplyICData);
+  INVOKE_PASS(Canonicalize);
+  INVOKE_PASS(BranchSimplify);
+  INVOKE_PASS(ConstantPropagation);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(SelectRepresentations);
+  INVOKE_PASS(CSE);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(TryCatchOptimization);
+  INVOKE_PASS(EliminateEnvironments);
+  INVOKE_PASS(EliminateDeadPhis);
+  // Currently DCE assumes that EliminateEnvironments has already been run,
+  // so it should not be lifted earlier than that pass.
+  INVOKE_PASS(DCE);
+  INVOKE_PASS(Canonicalize);
+  INVOKE_PASS(EliminateWriteBarriers);
+  INVOKE_PASS(FinalizeGraph);
+  INVOKE_PASS(AllocateRegisters);
+  INVOKE_PASS(ReorderBlocks);
+  return pass_state->flow_graph();
+}
+
 FlowGraph* CompilerPass::RunPipeline(PipelineMode mode,
                                      CompilerPassState* pass_state) {
   INVOKE_PASS(ComputeSSA);
@@ -338,11 +377,14 @@ FlowGraph* CompilerPass::RunPipeline(PipelineMode mode,
   INVOKE_PASS(SelectRepresentations);
   INVOKE_PASS(CSE);
   INVOKE_PASS(LICM);
+  INVOKE_PASS(PeelLoops);
   INVOKE_PASS(TryOptimizePatterns);
   INVOKE_PASS(DSE);
   INVOKE_PASS(TypePropagation);
   INVOKE_PASS(RangeAnalysis);
   INVOKE_PASS(OptimizeBranches);
+  INVOKE_PASS(VectorizeLoops);
+  INVOKE_PASS(UnrollLoops);
   INVOKE_PASS(TypePropagation);
   INVOKE_PASS(TryCatchOptimization);
   INVOKE_PASS(EliminateEnvironments);
@@ -465,6 +507,14 @@ COMPILER_PASS(LICM, {
 
 COMPILER_PASS(DSE, { DeadStoreElimination::Optimize(flow_graph); });
 
+COMPILER_PASS(PeelLoops, {
+  // The checks of the peeled iterations dominate their loops, so CSE removes
+  // the copies left in the loops.
+  if (LoopPeeler::Optimize(flow_graph)) {
+    DominatorBasedCSE::Optimize(flow_graph);
+  }
+});
+
 COMPILER_PASS(RangeAnalysis, {
   // We have to perform range analysis after LICM because it
   // optimistically moves CheckSmi through phis into loop preheaders
@@ -480,6 +530,18 @@ COMPILER_PASS(OptimizeBranches, {
   ConstantPropagator::OptimizeBranches(flow_graph);
 });
 
+COMPILER_PASS(VectorizeLoops, {
+  // Has to run after range analysis, which eliminates the bounds checks the
+  // vectorized loop would otherwise have to guard against.
+  LoopVectorizer::Optimize(flow_graph);
+});
+
+COMPILER_PASS(UnrollLoops, {
+  // Has to run after range analysis, which proves that the unrolled loop
+  // guard does not overflow.
+  LoopUnroller::Optimize(flow_graph);
+});
+
 COMPILER_PASS(OptimizeTypedDataAccesses,
               { TypedDataSpecializer::Optimize(flow_graph); });
 
@@ -544,13 +606,13 @@ COMPILER_PASS(FinalizeGraph, {
   // At the end of the pipeline, force recomputing and caching graph
   // information (instruction and call site counts) for the (assumed)
   // non-specialized case with better values, for future inlining.
-  intptr_t instruction_count = 0;
-  intptr_t call_site_count = 0;
   FlowGraphInliner::CollectGraphInfo(flow_graph,
                                      /*constants_count*/ 0,
-                                     /*force*/ true, &instruction_count,
-                                     &call_site_count);
-  flow_graph->function().set_inlining_depth(state->inlining_depth);
+                                     /*force*/ true, &state->instruction_count,
+                                     &state->call_site_count);
+  if (!CompilerState::Current().is_batch_compilation()) {
+    flow_graph->function().set_inlining_depth(state->inlining_depth);
+  }
   // Remove redefinitions for the rest of the pipeline.
   flow_graph->RemoveRedefinitions();
 });
@@ -43,6 +43,7 @@ namespace dart {
   V(OptimisticallySpecializeSmiPhis)                                           \
   V(OptimizeBranches)                                                          \
   V(OptimizeTypedDataAccesses)                                                 \
+  V(PeelLoops)                                                                 \
   V(RangeAnalysis)                                                             \
   V(ReorderBlocks)                                                             \
   V(SelectRepresentations)                                                     \
@@ -50,7 +51,9 @@ namespace dart {
   V(TryCatchOptimization)                                                      \
   V(TryOptimizePatterns)                                                       \
   V(TypePropagation)                                                           \
+  V(UnrollLoops)                                                               \
   V(UseTableDispatch)                                                          \
+  V(VectorizeLoops)                                                            \
   V(WidenSmiToInt32)                                                           \
   V(EliminateWriteBarriers)
 
@@ -95,6 +98,12 @@ struct CompilerPassState {
 
   intptr_t sticky_flags;
 
+  // Graph information FinalizeGraph computed for the compiled function. Batch
+  // compilations (see CompilerState::is_batch_compilation) leave caching it on
+  // the function to the precompiler.
+  intptr_t instruction_count;
+  intptr_t call_site_count;
+
  private:
   FlowGraph* flow_graph_;
 };
@@ -162,6 +171,14 @@ class CompilerPass {
       CompilerPassState* state,
       std::initializer_list<CompilerPass::Id> passes);
 
+  // Cheaper pipeline which is used for the baseline tier of the JIT: warm
+  // functions are first compiled with SSA based type propagation, call
+  // specialization, shallow inlining, CSE and linear scan register allocation
+  // only, and get the full pipeline once they are hot.
+  DART_WARN_UNUSED_RESULT
+  static FlowGraph* RunBaselinePipeline(PipelineMode mode,
+                                        CompilerPassState* state);
+
   // Pipeline which is used for "force-optimized" functions.
   //
   // Must not include speculative or inter-procedural optimizations.
@@ -86,6 +86,25 @@ class CompilerState : public ThreadStackResource {
   bool is_aot() const { return is_aot_; }
 
   bool is_optimizing() const { return is_optimizing_; }
+
+  // True when compiling the baseline tier of an optimized JIT function, see
+  // CompilerPass::RunBaselinePipeline.
+  bool is_baseline_tier() const { return is_baseline_tier_; }
+  void set_is_baseline_tier(bool value) {
+    ASSERT(!value || (is_optimizing() && !is_aot()));
+    is_baseline_tier_ = value;
+  }
+
+  // True when this compilation is part of a batch the precompiler compiles on
+  // worker threads, see Precompiler::CompileBatch. Such compilations must not
+  // cache anything on the functions they look at: whether another compilation
+  // of the same batch sees it would depend on timing.
+  bool is_batch_compilation() const { return is_batch_compilation_; }
+  void set_is_batch_compilation(bool value) {
+    ASSERT(!value || is_aot());
+    is_batch_compilation_ = value;
+  }
+
   bool should_clone_fields() {
     return !is_aot() && (is_optimizing() || FLAG_force_clone_compiler_objects);
   }
@@ -118,6 +137,8 @@ class CompilerState : public ThreadStackResource {
 
   const bool is_aot_;
   const bool is_optimizing_;
+  bool is_baseline_tier_ = false;
+  bool is_batch_compilation_ = false;
 
   const CompilerTracing tracing_;
 
@@ -276,7 +276,9 @@ Fragment BaseFlowGraphBuilder::TailCall(const Code& code) {
 
 void BaseFlowGraphBuilder::InlineBailout(const char* reason) {
   if (IsInlining()) {
-    parsed_function_->function().set_is_inlinable(false);
+    if (!CompilerState::Current().is_batch_compilation()) {
+      parsed_function_->function().set_is_inlinable(false);
+    }
     parsed_function_->Bailout("kernel::BaseFlowGraphBuilder", reason);
   }
 }
@@ -5278,6 +5278,12 @@ Fragment StreamingFlowGraphBuilder::BuildFunctionNode(
   }
 
   if (function.IsNull()) {
+    if (Compiler::IsBackgroundCompilation()) {
+      // Closure functions are only created by the mutator, which keeps the
+      // order of the cache independent of compiler thread timing.
+      Compiler::AbortBackgroundCompilation(DeoptId::kNone,
+                                           "Closure function not created yet");
+    }
     SafepointWriteRwLocker ml(thread(),
                               thread()->isolate_group()->program_lock());
     // NOTE: This is not TokenPosition in the general sense!
@@ -5508,6 +5514,13 @@ Fragment StreamingFlowGraphBuilder::BuildFfiNativeCallbackFunction() {
       ReadListLength();  // Skip (empty) named arguments list.
   ASSERT(named_args_len == 0);
 
+  if (CompilerState::Current().is_aot() &&
+      Compiler::IsBackgroundCompilation()) {
+    // Callback ids are allocated, and callbacks listed, in the order the
+    // precompiler's mutator thread compiles their uses.
+    Compiler::AbortBackgroundCompilation(DeoptId::kNone,
+                                         "Ffi callback created on a helper");
+  }
   const Function& result =
       Function::ZoneHandle(Z, compiler::ffi::NativeCallbackFunction(
                                   native_sig, target, exceptional_return));
@@ -0,0 +1,207 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/function_order.h"
+
+#include "vm/dart.h"
+#include "vm/flags.h"
+#include "vm/hash_map.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/os.h"
+#include "vm/program_visitor.h"
+#include "vm/zone_text_buffer.h"
+
+namespace dart {
+
+DEFINE_FLAG(charp,
+            write_function_order_to,
+            nullptr,
+            "Write the functions executed by an isolate group, hottest first, "
+            "to the given file when the isolate group shuts down.");
+DEFINE_FLAG(charp,
+            read_function_order_from,
+            nullptr,
+            "Lay out the code of the functions recorded by "
+            "--write_function_order_to in the given file first, in the order "
+            "of the file, when writing an AOT snapshot.");
+
+// Returns the key identifying [function] across programs, or nullptr if it
+// has no script.
+static const char* FunctionKey(Zone* zone, const Function& function) {
+  const auto& script = Script::Handle(zone, function.script());
+  if (script.IsNull()) return nullptr;
+  const auto& url = String::Handle(zone, script.url());
+  const auto& name = String::Handle(zone, function.name());
+  return OS::SCreate(zone, "%s\t%" Pd32 "\t%s", url.ToCString(),
+                     function.token_pos().Serialize(),
+                     String::ScrubName(name));
+}
+
+class ExecutedFunctionsCollector : public FunctionVisitor {
+ public:
+  ExecutedFunctionsCollector(Zone* zone,
+                             GrowableArray<const Function*>* functions)
+      : zone_(zone), functions_(functions) {}
+
+  void VisitFunction(const Function& function) {
+    if (!function.HasCode() || !function.WasExecuted()) return;
+    functions_->Add(&Function::ZoneHandle(zone_, function.ptr()));
+  }
+
+ private:
+  Zone* const zone_;
+  GrowableArray<const Function*>* const functions_;
+};
+
+// Optimized functions come first. The usage counters of optimized functions
+// are reset when they are optimized, so they are only used to order the
+// other functions.
+static int CompareHotness(const Function* const* a, const Function* const* b) {
+  const bool a_is_optimized = (*a)->HasOptimizedCode();
+  const bool b_is_optimized = (*b)->HasOptimizedCode();
+  if (a_is_optimized != b_is_optimized) return a_is_optimized ? -1 : 1;
+  if (!a_is_optimized) {
+    const intptr_t a_count = (*a)->usage_counter();
+    const intptr_t b_count = (*b)->usage_counter();
+    if (a_count != b_count) return (a_count > b_count) ? -1 : 1;
+  }
+  // Keep the sort deterministic.
+  const intptr_t a_pos = (*a)->token_pos().Serialize();
+  const intptr_t b_pos = (*b)->token_pos().Serialize();
+  if (a_pos != b_pos) return (a_pos < b_pos) ? -1 : 1;
+  return 0;
+}
+
+void FunctionOrder::WriteIfRequested(Thread* thread) {
+  if (FLAG_write_function_order_to == nullptr) return;
+  if (IsolateGroup::IsSystemIsolateGroup(thread->isolate_group())) return;
+
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileWriteCallback file_write = Dart::file_write_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == nullptr) || (file_write == nullptr) ||
+      (file_close == nullptr)) {
+    return;
+  }
+
+  StackZone stack_zone(thread);
+  Zone* zone = stack_zone.GetZone();
+  HANDLESCOPE(thread);
+  GrowableArray<const Function*> functions;
+  ExecutedFunctionsCollector collector(zone, &functions);
+  ProgramVisitor::WalkProgram(zone, thread->isolate_group(), &collector);
+  functions.Sort(CompareHotness);
+
+  ZoneTextBuffer buffer(zone, 64 * KB);
+  for (intptr_t i = 0; i < functions.length(); i++) {
+    const char* key = FunctionKey(zone, *functions[i]);
+    if (key != nullptr) {
+      buffer.Printf("%s\n", key);
+    }
+  }
+
+  void* file = file_open(FLAG_write_function_order_to, /*write=*/true);
+  if (file == nullptr) {
+    OS::PrintErr("Failed to open file %s\n", FLAG_write_function_order_to);
+    return;
+  }
+  file_write(buffer.buffer(), buffer.length(), file);
+  file_close(file);
+}
+
+#if defined(DART_PRECOMPILER)
+
+struct CodeRank {
+  CodePtr code;
+  intptr_t rank;
+  intptr_t original_index;
+};
+
+static int CompareCodeRanks(CodeRank const* a, CodeRank const* b) {
+  if (a->rank != b->rank) return (a->rank < b->rank) ? -1 : 1;
+  if (a->original_index != b->original_index) {
+    return (a->original_index < b->original_index) ? -1 : 1;
+  }
+  return 0;
+}
+
+void FunctionOrder::SortIfRequested(Zone* zone,
+                                    GrowableArray<CodePtr>* codes) {
+  if (FLAG_read_function_order_from == nullptr) return;
+
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileReadCallback file_read = Dart::file_read_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == nullptr) || (file_read == nullptr) ||
+      (file_close == nullptr)) {
+    return;
+  }
+
+  void* file = file_open(FLAG_read_function_order_from, /*write=*/false);
+  if (file == nullptr) {
+    OS::PrintErr("Failed to open file %s\n", FLAG_read_function_order_from);
+    return;
+  }
+  uint8_t* data = nullptr;
+  intptr_t length = -1;
+  file_read(&data, &length, file);
+  file_close(file);
+  if (length < 0) {
+    OS::PrintErr("Failed to read file %s\n", FLAG_read_function_order_from);
+    return;
+  }
+
+  char* contents = zone->Alloc<char>(length + 1);
+  memmove(contents, data, length);
+  contents[length] = '\0';
+  free(data);
+
+  // Maps the key of each listed function to its position in the file.
+  CStringIntMap ranks(zone);
+  intptr_t rank = 0;
+  for (char* line = contents; *line != '\0';) {
+    char* next_line = strchr(line, '\n');
+    if (next_line != nullptr) {
+      *next_line++ = '\0';
+    } else {
+      next_line = line + strlen(line);
+    }
+    if ((*line != '\0') &&
+        (ranks.LookupValue(line) == CStringIntMapKeyValueTrait::kNoValue)) {
+      ranks.Insert({line, rank++});
+    }
+    line = next_line;
+  }
+
+  // Code of functions which are not listed keeps its original order after the
+  // listed ones.
+  const intptr_t kNotListed = rank;
+  GrowableArray<CodeRank> order(codes->length());
+  auto& function = Function::Handle(zone);
+  for (intptr_t i = 0; i < codes->length(); i++) {
+    CodePtr code = (*codes)[i];
+    intptr_t code_rank = kNotListed;
+    if (Code::OwnerClassIdOf(code) == kFunctionCid) {
+      function = Function::RawCast(
+          WeakSerializationReference::Unwrap(code->untag()->owner()));
+      const char* key = FunctionKey(zone, function);
+      if (key != nullptr) {
+        const intptr_t value = ranks.LookupValue(key);
+        if (value != CStringIntMapKeyValueTrait::kNoValue) {
+          code_rank = value;
+        }
+      }
+    }
+    order.Add({code, code_rank, i});
+  }
+  order.Sort(CompareCodeRanks);
+  for (intptr_t i = 0; i < order.length(); i++) {
+    (*codes)[i] = order[i].code;
+  }
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
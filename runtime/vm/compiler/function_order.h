@@ -0,0 +1,48 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_FUNCTION_ORDER_H_
+#define RUNTIME_VM_COMPILER_FUNCTION_ORDER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+#include "vm/tagged_pointer.h"
+
+namespace dart {
+
+class Thread;
+
+// Functions executed by a JIT training run, hottest first.
+//
+// The JIT writes the functions executed by an isolate group to the file given
+// by --write_function_order_to when the group shuts down: first the optimized
+// functions, then the others by decreasing usage count. When writing an AOT
+// snapshot, the code of the functions listed in the file given by
+// --read_function_order_from is laid out first, in the order of the file, so
+// that the code executed at startup and in hot loops shares as few pages as
+// possible.
+//
+// Functions are identified by the url of their script, their token position
+// and their name without private keys.
+class FunctionOrder : public AllStatic {
+ public:
+  // Writes the functions executed by the isolate group of [thread] to the file
+  // given by --write_function_order_to, if any.
+  static void WriteIfRequested(Thread* thread);
+
+#if defined(DART_PRECOMPILER)
+  // Moves the code of the functions listed in the file given by
+  // --read_function_order_from, if any, to the front of [codes] in the order
+  // of the file. The order of the other code objects is preserved.
+  static void SortIfRequested(Zone* zone, GrowableArray<CodePtr>* codes);
+#endif  // defined(DART_PRECOMPILER)
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_FUNCTION_ORDER_H_
@@ -48,6 +48,10 @@
 
 namespace dart {
 
+DEFINE_FLAG(int,
+            background_compiler_threads,
+            1,
+            "Number of threads optimizing functions in the background.");
 DEFINE_FLAG(
     int,
     max_deoptimization_counter_threshold,
@@ -83,6 +87,7 @@ DEFINE_FLAG(bool,
             "Trace only optimizing compiler operations.");
 DEFINE_FLAG(bool, trace_bailout, false, "Print bailout from ssa compiler.");
 
+DECLARE_FLAG(int, baseline_optimization_counter_threshold);
 DECLARE_FLAG(bool, huge_method_cutoff_in_code_size);
 DECLARE_FLAG(bool, trace_failed_optimization_attempts);
 
@@ -305,6 +310,16 @@ bool Compiler::IsBackgroundCompilation() {
   return !Thread::Current()->IsMutatorThread();
 }
 
+// Functions without optimized code are first compiled by the baseline tier
+// when it is enabled. Its code counts invocations and gets recompiled by the
+// full pipeline once hot. OSR compilations always use the full pipeline.
+static bool ShouldCompileBaselineTier(const Function& function,
+                                      intptr_t osr_id) {
+  return (FLAG_baseline_optimization_counter_threshold > 0) &&
+         (osr_id == Compiler::kNoOSRDeoptId) && !function.ForceOptimize() &&
+         !function.HasOptimizedCode();
+}
+
 class CompileParsedFunctionHelper : public ValueObject {
  public:
   CompileParsedFunctionHelper(ParsedFunction* parsed_function,
@@ -428,6 +443,8 @@ CodePtr CompileParsedFunctionHelper::FinalizeCompilation(
     if (code_is_valid && Compiler::CanOptimizeFunction(thread(), function)) {
       if (osr_id() == Compiler::kNoOSRDeoptId) {
         function.InstallOptimizedCode(code);
+        function.SetBaselineOptimized(
+            thread()->compiler_state().is_baseline_tier());
       } else {
         // OSR is not compiled in background.
         ASSERT(!Compiler::IsBackgroundCompilation());
@@ -512,6 +529,13 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
 
       CompilerState compiler_state(thread(), /*is_aot=*/false, optimized(),
                                    CompilerState::ShouldTrace(function));
+      if (optimized() && ShouldCompileBaselineTier(function, osr_id())) {
+        compiler_state.set_is_baseline_tier(true);
+        if (FLAG_trace_compiler || FLAG_trace_optimizing_compiler) {
+          THR_Print("--> baseline tier for '%s'\n",
+                    function.ToFullyQualifiedCString());
+        }
+      }
 
       {
         if (optimized()) {
@@ -581,7 +605,13 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         JitCallSpecializer call_specializer(flow_graph, &speculative_policy);
         pass_state.call_specializer = &call_specializer;
 
-        flow_graph = CompilerPass::RunPipeline(CompilerPass::kJIT, &pass_state);
+        if (compiler_state.is_baseline_tier()) {
+          flow_graph = CompilerPass::RunBaselinePipeline(CompilerPass::kJIT,
+                                                         &pass_state);
+        } else {
+          flow_graph =
+              CompilerPass::RunPipeline(CompilerPass::kJIT, &pass_state);
+        }
       }
 
       ASSERT(pass_state.inline_id_to_function.length() ==
@@ -995,113 +1025,6 @@ void Compiler::AbortBackgroundCompilation(intptr_t deopt_id, const char* msg) {
       deopt_id, Object::background_compilation_error());
 }
 
-// C-heap allocated background compilation queue element.
-class QueueElement {
- public:
-  explicit QueueElement(const Function& function)
-      : next_(NULL), function_(function.ptr()) {}
-
-  virtual ~QueueElement() {
-    next_ = NULL;
-    function_ = Function::null();
-  }
-
-  FunctionPtr Function() const { return function_; }
-
-  void set_next(QueueElement* elem) { next_ = elem; }
-  QueueElement* next() const { return next_; }
-
-  ObjectPtr function() const { return function_; }
-  ObjectPtr* function_untag() {
-    return reinterpret_cast<ObjectPtr*>(&function_);
-  }
-
- private:
-  QueueElement* next_;
-  FunctionPtr function_;
-
-  DISALLOW_COPY_AND_ASSIGN(QueueElement);
-};
-
-// Allocated in C-heap. Handles both input and output of background compilation.
-// It implements a FIFO queue, using Peek, Add, Remove operations.
-class BackgroundCompilationQueue {
- public:
-  BackgroundCompilationQueue() : first_(NULL), last_(NULL) {}
-  virtual ~BackgroundCompilationQueue() { Clear(); }
-
-  void VisitObjectPointers(ObjectPointerVisitor* visitor) {
-    ASSERT(visitor != NULL);
-    QueueElement* p = first_;
-    while (p != NULL) {
-      visitor->VisitPointer(p->function_untag());
-      p = p->next();
-    }
-  }
-
-  bool IsEmpty() const { return first_ == NULL; }
-
-  void Add(QueueElement* value) {
-    ASSERT(value != NULL);
-    ASSERT(value->next() == NULL);
-    if (first_ == NULL) {
-      first_ = value;
-      ASSERT(last_ == NULL);
-    } else {
-      ASSERT(last_ != NULL);
-      last_->set_next(value);
-    }
-    last_ = value;
-    ASSERT(first_ != NULL && last_ != NULL);
-  }
-
-  QueueElement* Peek() const { return first_; }
-
-  FunctionPtr PeekFunction() const {
-    QueueElement* e = Peek();
-    if (e == NULL) {
-      return Function::null();
-    } else {
-      return e->Function();
-    }
-  }
-
-  QueueElement* Remove() {
-    ASSERT(first_ != NULL);
-    QueueElement* result = first_;
-    first_ = first_->next();
-    if (first_ == NULL) {
-      last_ = NULL;
-    }
-    return result;
-  }
-
-  bool ContainsObj(const Object& obj) const {
-    QueueElement* p = first_;
-    while (p != NULL) {
-      if (p->function() == obj.ptr()) {
-        return true;
-      }
-      p = p->next();
-    }
-    return false;
-  }
-
-  void Clear() {
-    while (!IsEmpty()) {
-      QueueElement* e = Remove();
-      delete e;
-    }
-    ASSERT((first_ == NULL) && (last_ == NULL));
-  }
-
- private:
-  QueueElement* first_;
-  QueueElement* last_;
-
-  DISALLOW_COPY_AND_ASSIGN(BackgroundCompilationQueue);
-};
-
 class BackgroundCompilerTask : public ThreadPool::Task {
  public:
   explicit BackgroundCompilerTask(BackgroundCompiler* background_compiler)
@@ -1122,7 +1045,7 @@ BackgroundCompiler::BackgroundCompiler(IsolateGroup* isolate_group)
       function_queue_(new BackgroundCompilationQueue()),
       done_monitor_(),
       running_(false),
-      done_(true),
+      active_workers_(0),
       disabled_depth_(0) {}
 
 // Fields all deleted in ::Stop; here clear them.
@@ -1130,6 +1053,17 @@ BackgroundCompiler::~BackgroundCompiler() {
   delete function_queue_;
 }
 
+// A queued function is stale if it got optimized by the full pipeline in the
+// meantime (e.g. by the mutator) or can no longer be optimized. Functions
+// with baseline tier code are queued to be recompiled by the full pipeline.
+static bool IsStaleCompilation(const Function& function) {
+  if (FLAG_stress_test_background_compilation) {
+    return false;
+  }
+  return (function.HasOptimizedCode() && !function.BaselineOptimized()) ||
+         !function.IsOptimizable();
+}
+
 void BackgroundCompiler::Run() {
   while (true) {
     // Maybe something is already in the queue, check first before waiting
@@ -1143,40 +1077,54 @@ void BackgroundCompiler::Run() {
       Zone* zone = stack_zone.GetZone();
       HANDLESCOPE(thread);
       Function& function = Function::Handle(zone);
-      {
-        SafepointMonitorLocker ml(&queue_monitor_);
-        if (running_) {
-          function = function_queue()->PeekFunction();
-        }
-      }
-      while (!function.IsNull()) {
-        Compiler::CompileOptimizedFunction(thread, function,
-                                           Compiler::kNoOSRDeoptId);
-
+      while (true) {
         QueueElement* qelem = NULL;
         {
           SafepointMonitorLocker ml(&queue_monitor_);
-          if (!running_ || function_queue()->IsEmpty()) {
-            // We are shutting down, queue was cleared.
-            function = Function::null();
-          } else {
+          if (running_ && !function_queue()->IsEmpty()) {
             qelem = function_queue()->Remove();
-            const Function& old = Function::Handle(qelem->Function());
-            // If an optimizable method is not optimized, put it back on
-            // the background queue (unless it was passed to foreground).
-            if ((!old.HasOptimizedCode() && old.IsOptimizable()) ||
-                FLAG_stress_test_background_compilation) {
-              if (Compiler::CanOptimizeFunction(thread, old)) {
-                QueueElement* repeat_qelem = new QueueElement(old);
-                function_queue()->Add(repeat_qelem);
-              }
-            }
-            function = function_queue()->PeekFunction();
+            function = qelem->Function();
           }
         }
-        if (qelem != NULL) {
-          delete qelem;
+        if (qelem == NULL) {
+          break;
+        }
+
+        if (!IsStaleCompilation(function)) {
+#if !defined(PRODUCT)
+          TimelineStream* stream = Timeline::GetCompilerStream();
+          TimelineEvent* event = stream->StartEvent();
+          if (event != NULL) {
+            event->Duration("BackgroundCompilationQueued",
+                            qelem->enqueue_micros(),
+                            OS::GetCurrentMonotonicMicros());
+            event->SetNumArguments(2);
+            event->CopyArgument(0, "function",
+                                function.ToFullyQualifiedCString());
+            event->FormatArgument(1, "usageCounter", "%" Pd,
+                                  qelem->priority());
+            event->Complete();
+          }
+#endif  // !defined(PRODUCT)
+          Compiler::CompileOptimizedFunction(thread, function,
+                                             Compiler::kNoOSRDeoptId);
+        }
+
+        {
+          SafepointMonitorLocker ml(&queue_monitor_);
+          function_queue()->Done(qelem);
+          // If an optimizable method is not optimized, put it back on
+          // the background queue (unless it was passed to foreground).
+          // The queue was cleared if we are shutting down.
+          if (running_ &&
+              ((!function.HasOptimizedCode() && function.IsOptimizable()) ||
+               FLAG_stress_test_background_compilation)) {
+            if (Compiler::CanOptimizeFunction(thread, function)) {
+              function_queue()->Add(function, function.usage_counter());
+            }
+          }
         }
+        delete qelem;
       }
     }
     Thread::ExitIsolateGroupAsHelper(/*bypass_safepoint=*/false);
@@ -1195,7 +1143,8 @@ void BackgroundCompiler::Run() {
   {
     // Notify that the thread is done.
     MonitorLocker ml_done(&done_monitor_);
-    done_ = true;
+    active_workers_--;
+    ASSERT(active_workers_ >= 0);
     ml_done.NotifyAll();
   }
 }
@@ -1207,27 +1156,29 @@ bool BackgroundCompiler::EnqueueCompilation(const Function& function) {
 
   SafepointMonitorLocker ml_done(&done_monitor_);
   if (disabled_depth_ > 0) return false;
-  if (!running_ && done_) {
+  if (!running_ && (active_workers_ == 0)) {
     running_ = true;
-    done_ = false;
     // If we ever wanted to run the BG compiler on the
     // `IsolateGroup::mutator_pool()` we would need to ensure the BG compiler
     // stops when it's idle - otherwise the [MutatorThreadPool]-based idle
     // notification would not work anymore.
-    if (!Dart::thread_pool()->Run<BackgroundCompilerTask>(this)) {
+    const intptr_t num_workers =
+        Utils::Maximum(1, FLAG_background_compiler_threads);
+    for (intptr_t i = 0; i < num_workers; i++) {
+      if (!Dart::thread_pool()->Run<BackgroundCompilerTask>(this)) {
+        break;
+      }
+      active_workers_++;
+    }
+    if (active_workers_ == 0) {
       running_ = false;
-      done_ = true;
       return false;
     }
   }
 
   SafepointMonitorLocker ml(&queue_monitor_);
   ASSERT(running_);
-  if (function_queue()->ContainsObj(function)) {
-    return true;
-  }
-  QueueElement* elem = new QueueElement(function);
-  function_queue()->Add(elem);
+  function_queue()->Add(function, function.usage_counter());
   ml.NotifyAll();
   return true;
 }
@@ -1254,7 +1205,7 @@ void BackgroundCompiler::StopLocked(Thread* thread,
     ml.NotifyAll();  // Stop waiting for the queue.
   }
 
-  while (!done_) {
+  while (active_workers_ > 0) {
     done_locker->Wait();
   }
 }
@@ -1278,7 +1229,7 @@ void BackgroundCompiler::Disable() {
 
   SafepointMonitorLocker ml_done(&done_monitor_);
   disabled_depth_++;
-  if (done_) return;
+  if (active_workers_ == 0) return;
   StopLocked(thread, &ml_done);
 }
 
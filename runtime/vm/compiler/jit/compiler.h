@@ -8,13 +8,13 @@
 #include "vm/allocation.h"
 #include "vm/compiler/api/deopt_id.h"
 #include "vm/growable_array.h"
+#include "vm/object.h"
 #include "vm/runtime_entry.h"
 #include "vm/thread_pool.h"
 
 namespace dart {
 
 // Forward declarations.
-class BackgroundCompilationQueue;
 class Class;
 class Code;
 class CompilationWorkQueue;
@@ -23,7 +23,6 @@ class Function;
 class IndirectGotoInstr;
 class Library;
 class ParsedFunction;
-class QueueElement;
 class Script;
 class SequenceNode;
 
@@ -113,10 +112,189 @@ class Compiler : public AllStatic {
   static void AbortBackgroundCompilation(intptr_t deopt_id, const char* msg);
 };
 
-// Class to run optimizing compilation in a background thread.
-// Current implementation: one task per isolate, it dies with the owning
-// isolate.
+// Class to run optimizing compilation in background threads.
+// Current implementation: up to --background_compiler_threads tasks per
+// isolate group compiling the hottest queued functions first, they die with
+// the owning isolate group.
 // No OSR compilation in the background compiler.
+// C-heap allocated background compilation queue element.
+class QueueElement {
+ public:
+  QueueElement(const Function& function, intptr_t priority, intptr_t sequence)
+      : function_(function.ptr()),
+        priority_(priority),
+        sequence_(sequence),
+        enqueue_micros_(OS::GetCurrentMonotonicMicros()) {}
+
+  virtual ~QueueElement() { function_ = Function::null(); }
+
+  FunctionPtr Function() const { return function_; }
+
+  ObjectPtr function() const { return function_; }
+  ObjectPtr* function_untag() {
+    return reinterpret_cast<ObjectPtr*>(&function_);
+  }
+
+  intptr_t priority() const { return priority_; }
+  void set_priority(intptr_t value) { priority_ = value; }
+  intptr_t sequence() const { return sequence_; }
+  int64_t enqueue_micros() const { return enqueue_micros_; }
+
+  // Whether this element should be compiled before [other]: hotter functions
+  // first, FIFO among functions of equal hotness.
+  bool IsBefore(const QueueElement* other) const {
+    if (priority_ != other->priority_) {
+      return priority_ > other->priority_;
+    }
+    return sequence_ < other->sequence_;
+  }
+
+ private:
+  FunctionPtr function_;
+  intptr_t priority_;
+  intptr_t sequence_;
+  int64_t enqueue_micros_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueueElement);
+};
+
+// Allocated in C-heap. Handles both input and output of background compilation.
+// It implements a priority queue ordered by the usage counter of the functions
+// at the time they were enqueued, using Add, Remove operations. Elements
+// handed out by Remove are tracked as in flight until passed to Done, so that
+// a function is never queued or compiled twice at the same time.
+class BackgroundCompilationQueue {
+ public:
+  BackgroundCompilationQueue() : heap_(), in_flight_(), next_sequence_(0) {}
+  virtual ~BackgroundCompilationQueue() { Clear(); }
+
+  void VisitObjectPointers(ObjectPointerVisitor* visitor) {
+    ASSERT(visitor != NULL);
+    for (intptr_t i = 0; i < heap_.length(); i++) {
+      visitor->VisitPointer(heap_[i]->function_untag());
+    }
+    for (intptr_t i = 0; i < in_flight_.length(); i++) {
+      visitor->VisitPointer(in_flight_[i]->function_untag());
+    }
+  }
+
+  bool IsEmpty() const { return heap_.is_empty(); }
+
+  // Adds [function] unless it is already queued or being compiled. A queued
+  // function that got hotter since it was added is moved ahead accordingly.
+  void Add(const Function& function, intptr_t priority) {
+    for (intptr_t i = 0; i < in_flight_.length(); i++) {
+      if (in_flight_[i]->function() == function.ptr()) {
+        return;
+      }
+    }
+    for (intptr_t i = 0; i < heap_.length(); i++) {
+      if (heap_[i]->function() == function.ptr()) {
+        if (priority > heap_[i]->priority()) {
+          heap_[i]->set_priority(priority);
+          SiftUp(i);
+        }
+        return;
+      }
+    }
+    heap_.Add(new QueueElement(function, priority, next_sequence_++));
+    SiftUp(heap_.length() - 1);
+  }
+
+  // Removes the hottest function from the queue and marks it as in flight.
+  QueueElement* Remove() {
+    ASSERT(!IsEmpty());
+    QueueElement* result = heap_[0];
+    QueueElement* last = heap_.RemoveLast();
+    if (!heap_.is_empty()) {
+      heap_[0] = last;
+      SiftDown(0);
+    }
+    in_flight_.Add(result);
+    return result;
+  }
+
+  // Called once the compilation of an element returned by Remove is over.
+  // The caller owns [element] afterwards.
+  void Done(QueueElement* element) {
+    for (intptr_t i = 0; i < in_flight_.length(); i++) {
+      if (in_flight_[i] == element) {
+        in_flight_[i] = in_flight_.Last();
+        in_flight_.RemoveLast();
+        return;
+      }
+    }
+    UNREACHABLE();
+  }
+
+  bool ContainsObj(const Object& obj) const {
+    for (intptr_t i = 0; i < heap_.length(); i++) {
+      if (heap_[i]->function() == obj.ptr()) {
+        return true;
+      }
+    }
+    for (intptr_t i = 0; i < in_flight_.length(); i++) {
+      if (in_flight_[i]->function() == obj.ptr()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Drops all queued functions. Elements in flight are still owned by the
+  // compiler threads.
+  void Clear() {
+    for (intptr_t i = 0; i < heap_.length(); i++) {
+      delete heap_[i];
+    }
+    heap_.Clear();
+  }
+
+ private:
+  void SiftUp(intptr_t index) {
+    while (index > 0) {
+      const intptr_t parent = (index - 1) / 2;
+      if (!heap_[index]->IsBefore(heap_[parent])) {
+        break;
+      }
+      Swap(index, parent);
+      index = parent;
+    }
+  }
+
+  void SiftDown(intptr_t index) {
+    const intptr_t length = heap_.length();
+    while (true) {
+      intptr_t first = index;
+      const intptr_t left = 2 * index + 1;
+      const intptr_t right = left + 1;
+      if ((left < length) && heap_[left]->IsBefore(heap_[first])) {
+        first = left;
+      }
+      if ((right < length) && heap_[right]->IsBefore(heap_[first])) {
+        first = right;
+      }
+      if (first == index) {
+        break;
+      }
+      Swap(index, first);
+      index = first;
+    }
+  }
+
+  void Swap(intptr_t i, intptr_t j) {
+    QueueElement* tmp = heap_[i];
+    heap_[i] = heap_[j];
+    heap_[j] = tmp;
+  }
+
+  MallocGrowableArray<QueueElement*> heap_;
+  MallocGrowableArray<QueueElement*> in_flight_;
+  intptr_t next_sequence_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackgroundCompilationQueue);
+};
+
 class BackgroundCompiler {
  public:
   explicit BackgroundCompiler(IsolateGroup* isolate_group);
@@ -145,16 +323,16 @@ class BackgroundCompiler {
   void StopLocked(Thread* thread, SafepointMonitorLocker* done_locker);
   void Enable();
   void Disable();
-  bool IsRunning() { return !done_; }
+  bool IsRunning() { return active_workers_ > 0; }
 
   IsolateGroup* isolate_group_;
 
   Monitor queue_monitor_;  // Controls access to the queue.
   BackgroundCompilationQueue* function_queue_;
 
-  Monitor done_monitor_;    // Notify/wait that the thread is done.
-  bool running_;            // While true, will try to read queue and compile.
-  bool done_;               // True if the thread is done.
+  Monitor done_monitor_;     // Notify/wait that the threads are done.
+  bool running_;             // While true, will try to read queue and compile.
+  intptr_t active_workers_;  // Number of threads that are not done.
 
   int16_t disabled_depth_;
 
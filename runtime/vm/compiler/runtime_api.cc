@@ -471,6 +471,11 @@ bool Class::TraceAllocation(const dart::Class& klass) {
   return klass.TraceAllocation(dart::IsolateGroup::Current());
 }
 
+bool Class::ShouldPretenure(const dart::Class& klass) {
+  return dart::IsolateGroup::Current()->heap()->new_space()->ShouldPretenure(
+      klass.id());
+}
+
 word Instance::first_field_offset() {
   return TranslateOffsetInWords(dart::Instance::NextFieldOffset());
 }
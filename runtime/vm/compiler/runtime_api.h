@@ -503,6 +503,10 @@ class Class : public AllStatic {
 
   // Whether to trace allocation for this klass.
   static bool TraceAllocation(const dart::Class& klass);
+
+  // Whether instances of this klass should be allocated in old space
+  // (--pretenure).
+  static bool ShouldPretenure(const dart::Class& klass);
 };
 
 class Instance : public AllStatic {
@@ -2048,6 +2048,7 @@ void StubCodeCompiler::GenerateAllocationStubForClass(
 
   if (!FLAG_use_slow_path && FLAG_inline_alloc &&
       !target::Class::TraceAllocation(cls) &&
+      !target::Class::ShouldPretenure(cls) &&
       target::SizeFitsInSizeTag(instance_size)) {
     if (is_cls_parameterized) {
       // TODO(41974): Assign all allocation stubs to the root loading unit?
@@ -0,0 +1,345 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/type_feedback.h"
+
+#include "vm/class_table.h"
+#include "vm/dart.h"
+#include "vm/flags.h"
+#include "vm/isolate.h"
+#include "vm/lockers.h"
+#include "vm/object.h"
+#include "vm/os.h"
+#include "vm/program_visitor.h"
+#include "vm/symbols.h"
+#include "vm/zone_text_buffer.h"
+
+namespace dart {
+
+DEFINE_FLAG(charp,
+            write_type_feedback_to,
+            nullptr,
+            "Write the receiver classes seen by instance calls to the given "
+            "file when an isolate group shuts down.");
+DEFINE_FLAG(charp,
+            read_type_feedback_from,
+            nullptr,
+            "Speculate on the receiver classes recorded by "
+            "--write_type_feedback_to in the given file when precompiling.");
+
+// Returns a copy of [name] without the private keys of its identifiers, which
+// depend on the order in which libraries were loaded.
+static const char* RemovePrivateKeys(Zone* zone, const char* name) {
+  const intptr_t length = strlen(name);
+  char* result = zone->Alloc<char>(length + 1);
+  intptr_t j = 0;
+  for (intptr_t i = 0; i < length; i++) {
+    if (name[i] == '@') {
+      while ((i + 1 < length) && (name[i + 1] >= '0') && (name[i + 1] <= '9')) {
+        i++;
+      }
+    } else {
+      result[j++] = name[i];
+    }
+  }
+  result[j] = '\0';
+  return result;
+}
+
+static const char* CallSiteKey(Zone* zone,
+                               const char* script_url,
+                               int32_t token_pos,
+                               const char* selector) {
+  return OS::SCreate(zone, "%s\t%" Pd32 "\t%s", script_url, token_pos,
+                     RemovePrivateKeys(zone, selector));
+}
+
+// Appends a line
+//
+//     <script url> <token pos> <selector> (<library url> <class> <count>)*
+//
+// with tab separated fields for every instance call with receiver classes in
+// the ICData of the visited functions.
+class TypeFeedbackCollector : public FunctionVisitor {
+ public:
+  TypeFeedbackCollector(Zone* zone, BaseTextBuffer* buffer)
+      : zone_(zone),
+        buffer_(buffer),
+        class_table_(IsolateGroup::Current()->class_table()),
+        code_(Code::Handle(zone)),
+        descriptors_(PcDescriptors::Handle(zone)),
+        script_(Script::Handle(zone)),
+        url_(String::Handle(zone)),
+        library_url_(String::Handle(zone)),
+        selector_(String::Handle(zone)),
+        cls_(Class::Handle(zone)),
+        library_(Library::Handle(zone)) {}
+
+  void VisitFunction(const Function& function) {
+    code_ = function.unoptimized_code();
+    if (code_.IsNull()) return;
+    ZoneGrowableArray<const ICData*> deopt_id_to_ic_data(zone_, 0);
+    function.RestoreICDataMap(&deopt_id_to_ic_data, /*clone_ic_data=*/false);
+    if (deopt_id_to_ic_data.is_empty()) return;
+
+    script_ = function.script();
+    url_ = script_.url();
+    descriptors_ = code_.pc_descriptors();
+    PcDescriptors::Iterator iter(descriptors_, UntaggedPcDescriptors::kIcCall);
+    while (iter.MoveNext()) {
+      const intptr_t deopt_id = iter.DeoptId();
+      if ((deopt_id < 0) || (deopt_id >= deopt_id_to_ic_data.length()) ||
+          !iter.TokenPos().IsReal()) {
+        continue;
+      }
+      const ICData* ic_data = deopt_id_to_ic_data[deopt_id];
+      if ((ic_data == nullptr) ||
+          (ic_data->rebind_rule() != ICData::kInstance)) {
+        continue;
+      }
+      WriteCallSite(iter.TokenPos(), *ic_data);
+    }
+  }
+
+ private:
+  void WriteCallSite(TokenPosition token_pos, const ICData& ic_data) {
+    // ICData testing several arguments may have several entries for the same
+    // receiver class.
+    GrowableArray<intptr_t> cids;
+    GrowableArray<intptr_t> counts;
+    for (intptr_t i = 0, n = ic_data.NumberOfChecks(); i < n; i++) {
+      const intptr_t count = ic_data.GetCountAt(i);
+      if (count <= 0) continue;
+      const intptr_t cid = ic_data.GetReceiverClassIdAt(i);
+      intptr_t j = 0;
+      while ((j < cids.length()) && (cids[j] != cid)) {
+        j++;
+      }
+      if (j == cids.length()) {
+        cids.Add(cid);
+        counts.Add(count);
+      } else {
+        counts[j] += count;
+      }
+    }
+    if (cids.is_empty()) return;
+
+    selector_ = ic_data.target_name();
+    buffer_->Printf("%s", CallSiteKey(zone_, url_.ToCString(),
+                                      token_pos.Serialize(),
+                                      selector_.ToCString()));
+    for (intptr_t i = 0; i < cids.length(); i++) {
+      cls_ = class_table_->At(cids[i]);
+      library_ = cls_.library();
+      library_url_ = library_.url();
+      buffer_->Printf("\t%s\t%s\t%" Pd "", library_url_.ToCString(),
+                      cls_.ScrubbedNameCString(), counts[i]);
+    }
+    buffer_->AddChar('\n');
+  }
+
+  Zone* const zone_;
+  BaseTextBuffer* const buffer_;
+  ClassTable* const class_table_;
+  Code& code_;
+  PcDescriptors& descriptors_;
+  Script& script_;
+  String& url_;
+  String& library_url_;
+  String& selector_;
+  Class& cls_;
+  Library& library_;
+};
+
+// The feedback of the isolate groups that shut down so far. Every write
+// contains all of it, so that isolate groups do not overwrite each other's
+// feedback. Call sites recorded by several groups are merged when reading.
+static Mutex* written_feedback_mutex = nullptr;
+static char* written_feedback = nullptr;
+static intptr_t written_feedback_length = 0;
+
+void TypeFeedback::Init() {
+  ASSERT(written_feedback_mutex == nullptr);
+  written_feedback_mutex = new Mutex();
+}
+
+void TypeFeedback::Cleanup() {
+  delete written_feedback_mutex;
+  written_feedback_mutex = nullptr;
+  free(written_feedback);
+  written_feedback = nullptr;
+  written_feedback_length = 0;
+}
+
+void TypeFeedback::WriteIfRequested(Thread* thread) {
+  if (FLAG_write_type_feedback_to == nullptr) return;
+  if (IsolateGroup::IsSystemIsolateGroup(thread->isolate_group())) return;
+
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileWriteCallback file_write = Dart::file_write_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == nullptr) || (file_write == nullptr) ||
+      (file_close == nullptr)) {
+    return;
+  }
+
+  StackZone stack_zone(thread);
+  Zone* zone = stack_zone.GetZone();
+  HANDLESCOPE(thread);
+  ZoneTextBuffer buffer(zone, 64 * KB);
+  TypeFeedbackCollector collector(zone, &buffer);
+  ProgramVisitor::WalkProgram(zone, thread->isolate_group(), &collector);
+
+  MutexLocker ml(written_feedback_mutex);
+  written_feedback = reinterpret_cast<char*>(
+      realloc(written_feedback, written_feedback_length + buffer.length()));
+  memmove(written_feedback + written_feedback_length, buffer.buffer(),
+          buffer.length());
+  written_feedback_length += buffer.length();
+
+  void* file = file_open(FLAG_write_type_feedback_to, /*write=*/true);
+  if (file == nullptr) {
+    OS::PrintErr("Failed to open file %s\n", FLAG_write_type_feedback_to);
+    return;
+  }
+  file_write(written_feedback, written_feedback_length, file);
+  file_close(file);
+}
+
+#if defined(DART_PRECOMPILER)
+
+static constexpr intptr_t kUnresolvedCid = -1;
+
+TypeFeedback* TypeFeedback::ReadIfRequested(Zone* zone) {
+  if (FLAG_read_type_feedback_from == nullptr) return nullptr;
+
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileReadCallback file_read = Dart::file_read_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == nullptr) || (file_read == nullptr) ||
+      (file_close == nullptr)) {
+    return nullptr;
+  }
+
+  void* file = file_open(FLAG_read_type_feedback_from, /*write=*/false);
+  if (file == nullptr) {
+    OS::PrintErr("Failed to open file %s\n", FLAG_read_type_feedback_from);
+    return nullptr;
+  }
+  uint8_t* data = nullptr;
+  intptr_t length = -1;
+  file_read(&data, &length, file);
+  file_close(file);
+  if (length < 0) {
+    OS::PrintErr("Failed to read file %s\n", FLAG_read_type_feedback_from);
+    return nullptr;
+  }
+
+  char* contents = zone->Alloc<char>(length + 1);
+  memmove(contents, data, length);
+  contents[length] = '\0';
+  free(data);
+
+  TypeFeedback* feedback = new (zone) TypeFeedback(zone);
+  if (!feedback->Parse(contents)) {
+    OS::PrintErr("Malformed type feedback in %s\n",
+                 FLAG_read_type_feedback_from);
+    return nullptr;
+  }
+  return feedback;
+}
+
+bool TypeFeedback::Parse(char* contents) {
+  GrowableArray<char*> fields;
+  char* line = contents;
+  while (*line != '\0') {
+    char* next_line = strchr(line, '\n');
+    if (next_line != nullptr) {
+      *next_line++ = '\0';
+    } else {
+      next_line = line + strlen(line);
+    }
+
+    fields.Clear();
+    for (char* field = line; field != nullptr;) {
+      fields.Add(field);
+      field = strchr(field, '\t');
+      if (field != nullptr) *field++ = '\0';
+    }
+    if ((fields.length() < 6) || ((fields.length() % 3) != 0)) {
+      return false;
+    }
+
+    char* end = nullptr;
+    const int32_t token_pos = strtol(fields[1], &end, 10);
+    if (*end != '\0') return false;
+    const char* key = CallSiteKey(zone_, fields[0], token_pos, fields[2]);
+    intptr_t index = call_site_index_.LookupValue(key);
+    if (index == CStringIntMapKeyValueTrait::kNoValue) {
+      index = call_sites_.length();
+      call_sites_.Add(new (zone_) ZoneGrowableArray<Receiver>(zone_, 1));
+      call_site_index_.Insert({key, index});
+    }
+    ZoneGrowableArray<Receiver>* receivers = call_sites_[index];
+    for (intptr_t i = 3; i < fields.length(); i += 3) {
+      const intptr_t count = strtol(fields[i + 2], &end, 10);
+      if (*end != '\0') return false;
+      // Call sites recorded by several isolate groups have their counts
+      // summed up.
+      intptr_t j = 0;
+      while ((j < receivers->length()) &&
+             ((strcmp((*receivers)[j].library_url, fields[i]) != 0) ||
+              (strcmp((*receivers)[j].class_name, fields[i + 1]) != 0))) {
+        j++;
+      }
+      if (j == receivers->length()) {
+        receivers->Add({fields[i], fields[i + 1], count, kUnresolvedCid});
+      } else {
+        (*receivers)[j].count += count;
+      }
+    }
+
+    line = next_line;
+  }
+  return true;
+}
+
+const ZoneGrowableArray<TypeFeedback::Receiver>* TypeFeedback::LookupReceivers(
+    const Script& script,
+    TokenPosition token_pos,
+    const String& selector) {
+  if (!token_pos.IsReal()) return nullptr;
+  Thread* thread = Thread::Current();
+  Zone* zone = thread->zone();
+  const auto& url = String::Handle(zone, script.url());
+  const char* key = CallSiteKey(zone, url.ToCString(), token_pos.Serialize(),
+                                selector.ToCString());
+  const intptr_t index = call_site_index_.LookupValue(key);
+  if (index == CStringIntMapKeyValueTrait::kNoValue) return nullptr;
+
+  ZoneGrowableArray<Receiver>* receivers = call_sites_[index];
+  SafepointMutexLocker ml(&resolve_mutex_);
+  auto& library = Library::Handle(zone);
+  auto& cls = Class::Handle(zone);
+  auto& name = String::Handle(zone);
+  for (intptr_t i = 0; i < receivers->length(); i++) {
+    Receiver& receiver = (*receivers)[i];
+    if (receiver.cid != kUnresolvedCid) continue;
+    receiver.cid = kIllegalCid;
+    name = String::New(receiver.library_url);
+    library = Library::LookupLibrary(thread, name);
+    if (!library.IsNull()) {
+      name = Symbols::New(thread, receiver.class_name);
+      cls = library.LookupClassAllowPrivate(name);
+      if (!cls.IsNull() && cls.is_finalized() && !cls.is_abstract()) {
+        receiver.cid = cls.id();
+      }
+    }
+  }
+  return receivers;
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
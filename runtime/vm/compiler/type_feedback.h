@@ -0,0 +1,86 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_TYPE_FEEDBACK_H_
+#define RUNTIME_VM_COMPILER_TYPE_FEEDBACK_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+#include "vm/hash_map.h"
+#include "vm/os_thread.h"
+#include "vm/token_position.h"
+
+namespace dart {
+
+class Script;
+class String;
+class Thread;
+
+// Receiver classes seen by the instance calls of a JIT training run.
+//
+// The JIT writes the receiver classes and call counts collected in the
+// ICData of all instance calls to the file given by --write_type_feedback_to
+// when an isolate group shuts down, together with those of the isolate groups
+// that shut down before it. The precompiler reads them back from the file
+// given by --read_type_feedback_from and uses them to speculatively inline
+// the hottest targets of calls that it cannot devirtualize otherwise.
+//
+// Call sites are identified by the url of their script, their token position
+// and their selector, and classes by the url of their library and their
+// name, so that the feedback does not depend on the class ids or the private
+// keys of the training run.
+class TypeFeedback : public ZoneAllocated {
+ public:
+  struct Receiver {
+    const char* library_url;
+    const char* class_name;
+    intptr_t count;
+    // Class id in the program being compiled, resolved on first lookup.
+    intptr_t cid;
+  };
+
+  static void Init();
+  static void Cleanup();
+
+  // Writes the feedback collected by the isolate group of [thread] to the
+  // file given by --write_type_feedback_to, if any. Called once when the
+  // isolate group shuts down.
+  static void WriteIfRequested(Thread* thread);
+
+#if defined(DART_PRECOMPILER)
+  // Reads the file given by --read_type_feedback_from, if any.
+  static TypeFeedback* ReadIfRequested(Zone* zone);
+
+  // Returns the receivers recorded for the call of [selector] at [token_pos]
+  // in [script], or nullptr if there are none. Receivers whose class does not
+  // exist in the program being compiled have the cid kIllegalCid.
+  const ZoneGrowableArray<Receiver>* LookupReceivers(const Script& script,
+                                                     TokenPosition token_pos,
+                                                     const String& selector);
+
+ private:
+  explicit TypeFeedback(Zone* zone)
+      : zone_(zone), call_site_index_(zone), call_sites_(zone, 0) {}
+
+  bool Parse(char* contents);
+
+  Zone* const zone_;
+  // Maps the key of a call site to its index in [call_sites_].
+  CStringIntMap call_site_index_;
+  GrowableArray<ZoneGrowableArray<Receiver>*> call_sites_;
+  // Guards the resolution of receiver cids, the precompiler looks up
+  // receivers from several threads when it compiles functions in batches.
+  Mutex resolve_mutex_;
+#endif  // defined(DART_PRECOMPILER)
+
+  DISALLOW_COPY_AND_ASSIGN(TypeFeedback);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_TYPE_FEEDBACK_H_
@@ -0,0 +1,138 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/type_feedback.h"
+
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/dart.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+#if defined(DART_PRECOMPILER)
+
+DECLARE_FLAG(charp, write_type_feedback_to);
+DECLARE_FLAG(charp, read_type_feedback_from);
+
+// The contents of the last type feedback file written.
+static char* type_feedback_file = nullptr;
+static intptr_t type_feedback_file_length = 0;
+
+static void* TypeFeedbackOpen(const char* name, bool write) {
+  if (write) {
+    free(type_feedback_file);
+    type_feedback_file = nullptr;
+    type_feedback_file_length = 0;
+  }
+  return &type_feedback_file;
+}
+
+static void TypeFeedbackRead(uint8_t** data, intptr_t* length, void* file) {
+  *data = reinterpret_cast<uint8_t*>(malloc(type_feedback_file_length));
+  memmove(*data, type_feedback_file, type_feedback_file_length);
+  *length = type_feedback_file_length;
+}
+
+static void TypeFeedbackWrite(const void* data, intptr_t length, void* file) {
+  type_feedback_file = reinterpret_cast<char*>(
+      realloc(type_feedback_file, type_feedback_file_length + length + 1));
+  memmove(type_feedback_file + type_feedback_file_length, data, length);
+  type_feedback_file_length += length;
+  type_feedback_file[type_feedback_file_length] = '\0';
+}
+
+static void TypeFeedbackClose(void* file) {}
+
+// Returns the count recorded for the receiver class [cid], or -1.
+static intptr_t ReceiverCount(
+    const ZoneGrowableArray<TypeFeedback::Receiver>* receivers,
+    intptr_t cid) {
+  for (intptr_t i = 0; i < receivers->length(); i++) {
+    if (receivers->At(i).cid == cid) return receivers->At(i).count;
+  }
+  return -1;
+}
+
+// The receivers recorded by a JIT run are read back for the same call site,
+// and the feedback of several isolate groups is merged.
+ISOLATE_UNIT_TEST_CASE(TypeFeedback_RoundTrip) {
+  const char* kScript = R"(
+    class A { int foo() => 1; }
+    class B { int foo() => 2; }
+
+    int test(dynamic x) => x.foo();
+
+    main() {
+      for (int i = 0; i < 10; i++) {
+        test(A());
+        test(B());
+        test(B());
+      }
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "test"));
+  Invoke(root_library, "main");
+  const Class& class_a = Class::Handle(GetClass(root_library, "A"));
+  const Class& class_b = Class::Handle(GetClass(root_library, "B"));
+
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileReadCallback file_read = Dart::file_read_callback();
+  Dart_FileWriteCallback file_write = Dart::file_write_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  Dart::SetFileCallbacks(TypeFeedbackOpen, TypeFeedbackRead, TypeFeedbackWrite,
+                         TypeFeedbackClose);
+  SetFlagScope<charp> sfs_write(&FLAG_write_type_feedback_to, "feedback.txt");
+  SetFlagScope<charp> sfs_read(&FLAG_read_type_feedback_from, "feedback.txt");
+
+  TypeFeedback::WriteIfRequested(thread);
+  RELEASE_ASSERT(type_feedback_file != nullptr);
+  EXPECT_SUBSTRING("\tfoo\t", type_feedback_file);
+  EXPECT_SUBSTRING("\tA\t", type_feedback_file);
+  EXPECT_SUBSTRING("\tB\t", type_feedback_file);
+
+  // The call site is identified by its token position in the script.
+  const char* line = strstr(type_feedback_file, "\tfoo\t");
+  while ((line > type_feedback_file) && (line[-1] != '\n')) {
+    line--;
+  }
+  const char* token_pos_field = strchr(line, '\t') + 1;
+  const TokenPosition token_pos =
+      TokenPosition::Deserialize(strtol(token_pos_field, nullptr, 10));
+  const Script& script = Script::Handle(function.script());
+  const String& selector = String::Handle(String::New("foo"));
+
+  TypeFeedback* feedback = TypeFeedback::ReadIfRequested(thread->zone());
+  RELEASE_ASSERT(feedback != nullptr);
+  const ZoneGrowableArray<TypeFeedback::Receiver>* receivers =
+      feedback->LookupReceivers(script, token_pos, selector);
+  RELEASE_ASSERT(receivers != nullptr);
+  EXPECT_EQ(2, receivers->length());
+  const intptr_t count_a = ReceiverCount(receivers, class_a.id());
+  const intptr_t count_b = ReceiverCount(receivers, class_b.id());
+  EXPECT(count_a > 0);
+  EXPECT(count_b > count_a);
+
+  // Another isolate group shutting down rewrites the file with the feedback
+  // of both, and the counts of the call site are summed up.
+  TypeFeedback::WriteIfRequested(thread);
+  feedback = TypeFeedback::ReadIfRequested(thread->zone());
+  RELEASE_ASSERT(feedback != nullptr);
+  receivers = feedback->LookupReceivers(script, token_pos, selector);
+  RELEASE_ASSERT(receivers != nullptr);
+  EXPECT_EQ(2, receivers->length());
+  EXPECT_EQ(2 * count_a, ReceiverCount(receivers, class_a.id()));
+  EXPECT_EQ(2 * count_b, ReceiverCount(receivers, class_b.id()));
+
+  Dart::SetFileCallbacks(file_open, file_read, file_write, file_close);
+  free(type_feedback_file);
+  type_feedback_file = nullptr;
+  type_feedback_file_length = 0;
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
@@ -16,6 +16,9 @@
 
 namespace dart {
 
+DECLARE_FLAG(int, background_compiler_threads);
+DECLARE_FLAG(int, baseline_optimization_counter_threshold);
+
 ISOLATE_UNIT_TEST_CASE(CompileFunction) {
   const char* kScriptChars =
       "class A {\n"
@@ -100,6 +103,152 @@ ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionOnHelperThread) {
   delete m;
 }
 
+ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionWithBaselineTier) {
+  SetFlagScope<int> sfs(&FLAG_baseline_optimization_counter_threshold, 100);
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo() { return 42; }\n"
+      "}\n";
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const auto& error = cls.EnsureIsFinalized(thread);
+  EXPECT(error == Error::null());
+  Function& func = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("foo"))));
+  CompilerTest::TestCompileFunction(func);
+  EXPECT(func.HasCode());
+  EXPECT(!func.HasOptimizedCode());
+
+  // The first optimized compilation uses the baseline tier.
+  Object& result = Object::Handle(Compiler::CompileOptimizedFunction(
+      thread, func, Compiler::kNoOSRDeoptId));
+  EXPECT(!result.IsError());
+  EXPECT(func.HasOptimizedCode());
+  EXPECT(func.BaselineOptimized());
+
+  // Once the baseline tier code is hot, the full pipeline recompiles it.
+  result =
+      Compiler::CompileOptimizedFunction(thread, func, Compiler::kNoOSRDeoptId);
+  EXPECT(!result.IsError());
+  EXPECT(func.HasOptimizedCode());
+  EXPECT(!func.BaselineOptimized());
+}
+
+ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionsOnHelperThreads) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo() { return 42; }\n"
+      "  static bar() { return 43; }\n"
+      "}\n";
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const auto& error = cls.EnsureIsFinalized(thread);
+  EXPECT(error == Error::null());
+  Function& foo = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("foo"))));
+  Function& bar = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("bar"))));
+  CompilerTest::TestCompileFunction(foo);
+  CompilerTest::TestCompileFunction(bar);
+  EXPECT(!foo.HasOptimizedCode());
+  EXPECT(!bar.HasOptimizedCode());
+  foo.SetUsageCounter(10);
+  bar.SetUsageCounter(1000);
+#if !defined(PRODUCT)
+  // Constant in product mode.
+  FLAG_background_compilation = true;
+#endif
+  SetFlagScope<int> sfs(&FLAG_background_compiler_threads, 2);
+  auto isolate_group = thread->isolate_group();
+  isolate_group->background_compiler()->EnqueueCompilation(foo);
+  isolate_group->background_compiler()->EnqueueCompilation(bar);
+  // Enqueuing a function twice is a no-op.
+  isolate_group->background_compiler()->EnqueueCompilation(foo);
+  Monitor* m = new Monitor();
+  {
+    SafepointMonitorLocker ml(m);
+    while (!foo.HasOptimizedCode() || !bar.HasOptimizedCode()) {
+      ml.Wait(1);
+    }
+  }
+  delete m;
+}
+
+ISOLATE_UNIT_TEST_CASE(BackgroundCompilationQueueOrder) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo() { return 42; }\n"
+      "  static bar() { return 43; }\n"
+      "  static baz() { return 44; }\n"
+      "}\n";
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const auto& error = cls.EnsureIsFinalized(thread);
+  EXPECT(error == Error::null());
+  Function& foo = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("foo"))));
+  Function& bar = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("bar"))));
+  Function& baz = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("baz"))));
+
+  // Functions are handed out in order of hotness, FIFO among functions of
+  // equal hotness.
+  BackgroundCompilationQueue queue;
+  queue.Add(foo, 10);
+  queue.Add(bar, 1000);
+  queue.Add(baz, 10);
+  // Adding a queued function again only raises its priority.
+  queue.Add(baz, 100);
+  queue.Add(bar, 1);
+
+  QueueElement* first = queue.Remove();
+  EXPECT(first->Function() == bar.ptr());
+  EXPECT_EQ(1000, first->priority());
+  // A function in flight is not queued again.
+  queue.Add(bar, 2000);
+  QueueElement* second = queue.Remove();
+  EXPECT(second->Function() == baz.ptr());
+  EXPECT_EQ(100, second->priority());
+  QueueElement* third = queue.Remove();
+  EXPECT(third->Function() == foo.ptr());
+  EXPECT(queue.IsEmpty());
+
+  queue.Done(first);
+  queue.Done(second);
+  queue.Done(third);
+  delete first;
+  delete second;
+  delete third;
+}
+
 ISOLATE_UNIT_TEST_CASE(CompileFunctionOnHelperThread) {
   // Create a simple function and compile it without optimization.
   const char* kScriptChars =
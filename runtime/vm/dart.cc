@@ -11,6 +11,9 @@
 #include "vm/code_observers.h"
 #include "vm/compiler/runtime_offsets_extracted.h"
 #include "vm/compiler/runtime_offsets_list.h"
+#if !defined(DART_PRECOMPILED_RUNTIME)
+#include "vm/compiler/type_feedback.h"
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
 #include "vm/cpu.h"
 #include "vm/dart_api_state.h"
 #include "vm/dart_entry.h"
@@ -252,6 +255,9 @@ char* Dart::Init(const uint8_t* vm_isolate_snapshot,
   NOT_IN_PRODUCT(Metric::Init());
   StoreBuffer::Init();
   MarkingStack::Init();
+#if !defined(DART_PRECOMPILED_RUNTIME)
+  TypeFeedback::Init();
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
 
 #if defined(USING_SIMULATOR)
   Simulator::Init();
@@ -632,6 +638,9 @@ char* Dart::Cleanup() {
   ASSERT(Isolate::IsolateListLength() == 0);
   PortMap::Cleanup();
   IsolateGroup::Cleanup();
+#if !defined(DART_PRECOMPILED_RUNTIME)
+  TypeFeedback::Cleanup();
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
   ICData::Cleanup();
   SubtypeTestCache::Cleanup();
   ArgumentsDescriptor::Cleanup();
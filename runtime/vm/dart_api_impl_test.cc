@@ -3604,6 +3604,64 @@ TEST_CASE(DartAPI_FinalizableHandleCallback) {
   }
 }
 
+static void CountingFinalizer(void* isolate_callback_data, void* peer) {
+  (*static_cast<intptr_t*>(peer))++;
+}
+
+// Enough weak handles to span many handle blocks, so that both collectors
+// split them into several chunks and process those from different tasks.
+TEST_CASE(DartAPI_WeakPersistentHandleParallelMourning) {
+  SetFlagScope<int> sfs_scavenger(&FLAG_scavenger_tasks, 4);
+  SetFlagScope<int> sfs_marker(&FLAG_marker_tasks, 4);
+  const intptr_t kNumHandles = 5000;
+  Dart_WeakPersistentHandle* weak_refs =
+      new Dart_WeakPersistentHandle[kNumHandles];
+  intptr_t finalized = 0;
+  Dart_PersistentHandle live;
+  {
+    Dart_EnterScope();
+    Dart_Handle list = Dart_NewList(kNumHandles / 2);
+    EXPECT_VALID(list);
+    live = Dart_NewPersistentHandle(list);
+    for (intptr_t i = 0; i < kNumHandles; i++) {
+      Dart_Handle obj = Dart_NewDouble(i);
+      EXPECT_VALID(obj);
+      if ((i % 2) == 0) {
+        EXPECT_VALID(Dart_ListSetAt(list, i / 2, obj));
+      }
+      weak_refs[i] = Dart_NewWeakPersistentHandle(obj, &finalized, 0,
+                                                  CountingFinalizer);
+    }
+    Dart_ExitScope();
+  }
+  {
+    TransitionNativeToVM transition(thread);
+    GCTestHelper::CollectNewSpace();
+    EXPECT_EQ(kNumHandles / 2, finalized);
+  }
+  {
+    // The surviving handles were relocated along with their referents.
+    Dart_EnterScope();
+    for (intptr_t i = 0; i < kNumHandles; i += 2) {
+      double value = 0.0;
+      Dart_Handle obj = Dart_HandleFromWeakPersistent(weak_refs[i]);
+      EXPECT_VALID(Dart_DoubleValue(obj, &value));
+      EXPECT_EQ(i, static_cast<intptr_t>(value));
+    }
+    Dart_ExitScope();
+  }
+  Dart_DeletePersistentHandle(live);
+  {
+    TransitionNativeToVM transition(thread);
+    GCTestHelper::CollectAllGarbage();
+    EXPECT_EQ(kNumHandles, finalized);
+  }
+  for (intptr_t i = 0; i < kNumHandles; i++) {
+    Dart_DeleteWeakPersistentHandle(weak_refs[i]);
+  }
+  delete[] weak_refs;
+}
+
 TEST_CASE(DartAPI_WeakPersistentHandleNoCallback) {
   Dart_WeakPersistentHandle weak_ref = NULL;
   int peer = 0;
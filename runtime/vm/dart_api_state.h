@@ -545,6 +545,16 @@ class FinalizablePersistentHandles
             kOffsetOfRawPtrInFinalizablePersistentHandle>::Visit(visitor);
   }
 
+  // Visit the handles of one of 'num_chunks' disjoint sets of handle blocks.
+  void VisitHandlesChunk(HandleVisitor* visitor,
+                         intptr_t chunk,
+                         intptr_t num_chunks) {
+    Handles<kFinalizablePersistentHandleSizeInWords,
+            kFinalizablePersistentHandlesPerChunk,
+            kOffsetOfRawPtrInFinalizablePersistentHandle>::
+        VisitChunk(visitor, chunk, num_chunks);
+  }
+
   // Visit all object pointers stored in the various handles.
   void VisitObjectPointers(ObjectPointerVisitor* visitor) {
     visitor->set_gc_root_type("weak persistent handle");
@@ -760,6 +770,11 @@ class ApiState {
   void VisitWeakHandlesUnlocked(HandleVisitor* visitor) {
     weak_persistent_handles_.VisitHandles(visitor);
   }
+  void VisitWeakHandlesChunkUnlocked(HandleVisitor* visitor,
+                                     intptr_t chunk,
+                                     intptr_t num_chunks) {
+    weak_persistent_handles_.VisitHandlesChunk(visitor, chunk, num_chunks);
+  }
 
   PersistentHandle* AllocatePersistentHandle() {
     MutexLocker ml(&mutex_);
@@ -126,6 +126,9 @@ constexpr bool FLAG_support_il_printer = false;
     "Don't optimize away static field initialization")                         \
   P(force_clone_compiler_objects, bool, false,                                 \
     "Force cloning of objects needed in compiler (ICData and Field).")         \
+  P(gc_work_stealing, bool, false,                                             \
+    "Balance parallel scavenging and marking with per-task work-stealing "     \
+    "deques instead of only sharing whole blocks through a global stack.")     \
   P(getter_setter_ratio, int, 13,                                              \
     "Ratio of getter/setter usage used for double field unboxing heuristics")  \
   P(guess_icdata_cid, bool, true,                                              \
@@ -164,6 +167,8 @@ constexpr bool FLAG_support_il_printer = false;
   P(old_gen_heap_size, int, kDefaultMaxOldGenHeapSize,                         \
     "Max size of old gen heap size in MB, or 0 for unlimited,"                 \
     "e.g: --old_gen_heap_size=1024 allows up to 1024MB old gen heap")          \
+  P(old_gen_tlab, bool, false,                                                 \
+    "Bump allocate small old gen objects from thread-local buffers.")          \
   R(pause_isolates_on_start, false, bool, false,                               \
     "Pause isolates before starting.")                                         \
   R(pause_isolates_on_exit, false, bool, false, "Pause isolates exiting.")     \
@@ -172,6 +177,9 @@ constexpr bool FLAG_support_il_printer = false;
   P(polymorphic_with_deopt, bool, true,                                        \
     "Polymorphic calls with deoptimization / megamorphic call")                \
   P(precompiled_mode, bool, false, "Precompilation compiler mode")             \
+  P(pretenure, bool, false,                                                    \
+    "Allocate instances of classes that mostly survive scavenges directly "    \
+    "in old space.")                                                           \
   P(print_snapshot_sizes, bool, false, "Print sizes of generated snapshots.")  \
   P(print_snapshot_sizes_verbose, bool, false,                                 \
     "Print cluster sizes of generated snapshots.")                             \
@@ -200,6 +208,9 @@ constexpr bool FLAG_support_il_printer = false;
     "As an experimental feature enable isolate group support in JIT"           \
     "(goes into effect only when enable_isolate_groups is turned on as "       \
     "well).")                                                                  \
+  P(enable_fast_object_copy, bool, true,                                       \
+    "Copy messages between isolates of the same isolate group directly on "    \
+    "the heap instead of going through a message snapshot.")                   \
   P(show_invisible_frames, bool, false,                                        \
     "Show invisible frames in stack traces.")                                  \
   D(trace_cha, bool, false, "Trace CHA operations")                            \
@@ -230,6 +241,8 @@ constexpr bool FLAG_support_il_printer = false;
   P(truncating_left_shift, bool, true,                                         \
     "Optimize left shift to truncate if possible")                             \
   P(use_compactor, bool, false, "Compact the heap during old-space GC.")       \
+  P(use_incremental_compactor, bool, false,                                    \
+    "Compact by evacuating only the sparsest pages during old-space GC.")      \
   P(use_cha_deopt, bool, true,                                                 \
     "Use class hierarchy analysis even if it can cause deoptimization.")       \
   P(use_field_guards, bool, true, "Use field guards and track field types")    \
@@ -77,6 +77,11 @@ class Handles {
   // Visit all of the various handles.
   void Visit(HandleVisitor* visitor);
 
+  // Visit the handles of every num_chunks-th handle block, starting with block
+  // number 'chunk'. Lets several GC workers visit disjoint parts of the
+  // handles; no handles may be allocated or freed in the meantime.
+  void VisitChunk(HandleVisitor* visitor, intptr_t chunk, intptr_t num_chunks);
+
   // Reset the handles so that we can reuse.
   void Reset();
 
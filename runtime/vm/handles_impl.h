@@ -57,6 +57,33 @@ void Handles<kHandleSizeInWords, kHandlesPerChunk, kOffsetOfRawPtr>::Visit(
   } while (block != NULL);
 }
 
+template <int kHandleSizeInWords, int kHandlesPerChunk, int kOffsetOfRawPtr>
+void Handles<kHandleSizeInWords, kHandlesPerChunk, kOffsetOfRawPtr>::VisitChunk(
+    HandleVisitor* visitor,
+    intptr_t chunk,
+    intptr_t num_chunks) {
+  ASSERT((chunk >= 0) && (chunk < num_chunks));
+  intptr_t index = 0;
+
+  // Visit zone handles.
+  HandlesBlock* block = zone_blocks_;
+  while (block != NULL) {
+    if ((index++ % num_chunks) == chunk) {
+      block->Visit(visitor);
+    }
+    block = block->next_block();
+  }
+
+  // Visit scoped handles.
+  block = &first_scoped_block_;
+  do {
+    if ((index++ % num_chunks) == chunk) {
+      block->Visit(visitor);
+    }
+    block = block->next_block();
+  } while (block != NULL);
+}
+
 template <int kHandleSizeInWords, int kHandlesPerChunk, int kOffsetOfRawPtr>
 void Handles<kHandleSizeInWords, kHandlesPerChunk, kOffsetOfRawPtr>::Reset() {
   // Delete all the extra zone handle blocks allocated and reinit the first
@@ -18,6 +18,16 @@ DEFINE_FLAG(bool,
             force_evacuation,
             false,
             "Force compaction to move every movable object");
+DEFINE_FLAG(int,
+            incremental_compactor_budget,
+            8,
+            "Maximum number of live MB the incremental compactor evacuates "
+            "in one GC.");
+DEFINE_FLAG(int,
+            incremental_compactor_threshold,
+            50,
+            "Pages with at most this percentage of live bytes are evacuated "
+            "by the incremental compactor.");
 
 // Each OldPage is divided into blocks of size kBlockSize. Each object belongs
 // to the block containing its header word (so up to kBlockSize +
@@ -728,4 +738,392 @@ void GCCompactor::ForwardStackPointers() {
                                        ValidationPolicy::kDontValidateFrames);
 }
 
+static int CompareLiveBytes(OldPage* const* a, OldPage* const* b) {
+  const intptr_t a_live = (*a)->live_bytes();
+  const intptr_t b_live = (*b)->live_bytes();
+  if (a_live < b_live) {
+    return -1;
+  } else if (a_live == b_live) {
+    return 0;
+  } else {
+    return 1;
+  }
+}
+
+static bool IsSparse(OldPage* page) {
+  const intptr_t usable = page->object_end() - page->object_start();
+  return (page->live_bytes() * 100) <=
+         (usable * FLAG_incremental_compactor_threshold);
+}
+
+static intptr_t EvacuationBudget() {
+  return static_cast<intptr_t>(FLAG_incremental_compactor_budget) * MB;
+}
+
+void GCEvacuator::SelectCandidates(OldPage* pages) {
+  ASSERT(candidates_.IsEmpty());
+  MallocGrowableArray<OldPage*> sparse;
+  for (OldPage* page = pages; page != nullptr; page = page->next()) {
+    ASSERT(page->type() == OldPage::kData);
+    if ((page->forwarding_page() != nullptr) && IsSparse(page)) {
+      sparse.Add(page);
+    }
+  }
+  sparse.Sort(CompareLiveBytes);
+
+  // The live bytes are left over from the previous marking, so this is only
+  // an estimate. Evacuate checks the budget again with the current numbers.
+  intptr_t selected_bytes = 0;
+  for (intptr_t i = 0; i < sparse.length(); i++) {
+    OldPage* page = sparse[i];
+    if ((selected_bytes + page->live_bytes()) > EvacuationBudget()) {
+      break;
+    }
+    selected_bytes += page->live_bytes();
+    candidates_.Add(page);
+  }
+  candidates_.Sort();
+}
+
+void GCEvacuator::AddRecordedSlots(
+    const MallocGrowableArray<uword>& slots,
+    const MallocGrowableArray<TypedDataViewPtr>& views) {
+  MutexLocker ml(&slots_mutex_);
+  for (intptr_t i = 0; i < slots.length(); i++) {
+    slots_.Add(slots[i]);
+  }
+  for (intptr_t i = 0; i < views.length(); i++) {
+    typed_data_views_.Add(views[i]);
+  }
+}
+
+// Copies the live objects of the candidates that are still sparse to fresh
+// pages, forwards the recorded slots and the roots, and releases the evacuated
+// pages. Unlike GCCompactor::Compact, the other pages are neither walked nor
+// moved. If no more destination pages can be allocated, the remaining
+// candidates simply stay where they are.
+void GCEvacuator::Evacuate() {
+  {
+    TIMELINE_FUNCTION_GC_DURATION(thread(), "EvacuatePages");
+    for (intptr_t i = 0; i < candidates_.length(); i++) {
+      OldPage* page = candidates_.At(i);
+      if (!IsSparse(page) ||
+          ((evacuated_bytes_ + page->live_bytes()) > EvacuationBudget())) {
+        continue;
+      }
+      if (!TryEvacuatePage(page)) {
+        break;  // Out of memory.
+      }
+      evacuated_.Add(page);
+      evacuated_bytes_ += page->live_bytes();
+    }
+    evacuated_.Sort();
+
+    // Make the rest of the last destination page walkable.
+    if (!to_pages_.is_empty()) {
+      OldPage* to_page = to_pages_.Last();
+      if (free_current_ < free_end_) {
+        FreeListElement::AsElement(free_current_, free_end_ - free_current_);
+      }
+      to_page->set_live_bytes(free_current_ - to_page->object_start());
+    }
+  }
+
+  if (!evacuated_.IsEmpty()) {
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardEvacuatedObjects");
+      ForwardCopiedObjects();
+    }
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardRecordedSlots");
+      ForwardRecordedSlots();
+    }
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardNewSpace");
+      heap_->new_space()->VisitObjectPointers(this);
+    }
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardRememberedSet");
+      isolate_group()->store_buffer()->VisitObjectPointers(this);
+    }
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardWeakTables");
+      heap_->ForwardWeakTables(this);
+    }
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardWeakHandles");
+      isolate_group()->VisitWeakPersistentHandles(this);
+    }
+#ifndef PRODUCT
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardObjectIdRing");
+      isolate_group()->ForEachIsolate(
+          [&](Isolate* isolate) {
+            ObjectIdRing* ring = isolate->object_id_ring();
+            if (ring != nullptr) {
+              ring->VisitPointers(this);
+            }
+          },
+          /*at_safepoint=*/true);
+    }
+#endif  // !PRODUCT
+    {
+      TIMELINE_FUNCTION_GC_DURATION(thread(),
+                                    "ForwardTypedDataViewInternalPointers");
+      ForwardTypedDataViews();
+    }
+    {
+      // N.B.: As in GCCompactor, the heap is forwarded before the stack.
+      TIMELINE_FUNCTION_GC_DURATION(thread(), "ForwardStackPointers");
+      isolate_group()->VisitObjectPointers(
+          this, ValidationPolicy::kDontValidateFrames);
+    }
+    heap_->old_space()->VisitRoots(this);
+  }
+
+  PageSpace* old_space = heap_->old_space();
+  MutexLocker ml(&old_space->pages_lock_);
+
+  // Free evacuated pages.
+  OldPage* prev_page = nullptr;
+  OldPage* page = old_space->pages_;
+  while (page != nullptr) {
+    OldPage* next_page = page->next();
+    if (evacuated_.Contains(reinterpret_cast<uword>(page))) {
+      old_space->RemovePageLocked(page, prev_page);
+      old_space->IncreaseCapacityInWordsLocked(
+          -(page->memory_->size() >> kWordSizeLog2));
+      page->Deallocate();
+    } else {
+      prev_page = page;
+    }
+    page = next_page;
+  }
+
+  // The destination pages are swept with the rest of the heap.
+  for (intptr_t i = 0; i < to_pages_.length(); i++) {
+    old_space->AddPageLocked(to_pages_[i]);
+  }
+}
+
+bool GCEvacuator::TryEvacuatePage(OldPage* page) {
+  const intptr_t saved_to_pages = to_pages_.length();
+  const uword saved_current = free_current_;
+  const uword saved_end = free_end_;
+
+  ForwardingPage* forwarding_page = page->forwarding_page();
+  ASSERT(forwarding_page != nullptr);
+  forwarding_page->Clear();
+  uword current = page->object_start();
+  const uword end = page->object_end();
+  while (current < end) {
+    current = TryEvacuateBlock(current, forwarding_page);
+    if (current == 0) {
+      // Drop the partial copy. The page stays a regular page and the
+      // forwarding page is ignored because it is not in evacuated_.
+      ReleaseToPagesAfter(saved_to_pages);
+      free_current_ = saved_current;
+      free_end_ = saved_end;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Like CompactorTask::PlanBlock followed by CompactorTask::SlideBlock, but
+// copies to a fresh page instead of sliding within the heap. Returns the first
+// object in the next block, or 0 if no destination space could be allocated.
+uword GCEvacuator::TryEvacuateBlock(uword first_object,
+                                    ForwardingPage* forwarding_page) {
+  uword block_start = first_object & kBlockMask;
+  uword block_end = block_start + kBlockSize;
+  ForwardingBlock* forwarding_block = forwarding_page->BlockFor(first_object);
+
+  intptr_t block_live_size = 0;
+  uword current = first_object;
+  while (current < block_end) {
+    ObjectPtr obj = UntaggedObject::FromAddr(current);
+    intptr_t size = obj->untag()->HeapSize();
+    if (obj->untag()->IsMarked()) {
+      forwarding_block->RecordLive(current, size);
+      ASSERT(static_cast<intptr_t>(forwarding_block->Lookup(current)) ==
+             block_live_size);
+      block_live_size += size;
+    }
+    current += size;
+  }
+
+  if (!TryMoveToContiguousSize(block_live_size)) {
+    return 0;
+  }
+  forwarding_block->set_new_address(free_current_);
+
+  uword old_addr = first_object;
+  while (old_addr < current) {
+    ObjectPtr old_obj = UntaggedObject::FromAddr(old_addr);
+    intptr_t size = old_obj->untag()->HeapSize();
+    if (old_obj->untag()->IsMarked()) {
+      uword new_addr = forwarding_block->Lookup(old_addr);
+      ASSERT(new_addr == free_current_);
+      // The original stays intact until the page is released, so pointers
+      // into it can still be followed while forwarding.
+      memcpy(reinterpret_cast<void*>(new_addr),
+             reinterpret_cast<void*>(old_addr), size);
+      ObjectPtr new_obj = UntaggedObject::FromAddr(new_addr);
+      if (IsTypedDataClassId(new_obj->GetClassId())) {
+        static_cast<TypedDataPtr>(new_obj)->untag()->RecomputeDataField();
+      }
+      free_current_ += size;
+    }
+    old_addr += size;
+  }
+
+  return current;
+}
+
+bool GCEvacuator::TryMoveToContiguousSize(intptr_t size) {
+  ASSERT(size <= kOldPageSize);
+  intptr_t free_remaining = free_end_ - free_current_;
+  if (free_remaining >= size) {
+    return true;
+  }
+
+  OldPage* page =
+      heap_->old_space()->AllocatePage(OldPage::kData, /* link */ false);
+  if (page == nullptr) {
+    return false;
+  }
+  if (!to_pages_.is_empty()) {
+    // Make the rest of the previous destination page walkable.
+    OldPage* last = to_pages_.Last();
+    if (free_remaining > 0) {
+      FreeListElement::AsElement(free_current_, free_remaining);
+    }
+    last->set_live_bytes(free_current_ - last->object_start());
+  }
+  to_pages_.Add(page);
+  free_current_ = page->object_start();
+  free_end_ = page->object_end();
+  ASSERT((free_end_ - free_current_) >= size);
+  return true;
+}
+
+void GCEvacuator::ReleaseToPagesAfter(intptr_t length) {
+  PageSpace* old_space = heap_->old_space();
+  while (to_pages_.length() > length) {
+    OldPage* page = to_pages_.RemoveLast();
+    old_space->IncreaseCapacityInWords(
+        -(page->memory_->size() >> kWordSizeLog2));
+    page->Deallocate();
+  }
+}
+
+void GCEvacuator::ForwardCopiedObjects() {
+  for (intptr_t i = 0; i < to_pages_.length(); i++) {
+    to_pages_[i]->VisitObjectPointers(this);
+  }
+}
+
+void GCEvacuator::ForwardRecordedSlots() {
+  const intptr_t length = slots_.length();
+  for (intptr_t i = 0; i < length; i++) {
+    const uword slot = slots_[i] & ~kCompressedSlotBit;
+    if (evacuated_.Contains(slot)) {
+      continue;  // Forwarded in the copy of its object.
+    }
+    if ((slots_[i] & kCompressedSlotBit) != 0) {
+      ForwardCompressedPointer(slot & kHeapBaseMask,
+                               reinterpret_cast<CompressedObjectPtr*>(slot));
+    } else {
+      ForwardPointer(reinterpret_cast<ObjectPtr*>(slot));
+    }
+  }
+}
+
+void GCEvacuator::ForwardTypedDataViews() {
+  const intptr_t length = typed_data_views_.length();
+  for (intptr_t i = 0; i < length; ++i) {
+    TypedDataViewPtr view = typed_data_views_[i];
+    uword addr = UntaggedObject::ToAddr(view);
+    if (evacuated_.Contains(addr)) {
+      // Recorded by the marker before the view itself moved.
+      view = static_cast<TypedDataViewPtr>(UntaggedObject::FromAddr(
+          OldPage::Of(addr)->forwarding_page()->Lookup(addr)));
+    }
+    const classid_t cid = view->untag()->typed_data()->GetClassIdMayBeSmi();
+    if (IsTypedDataClassId(cid)) {
+      view->untag()->RecomputeDataFieldForInternalTypedData();
+    }
+  }
+}
+
+DART_FORCE_INLINE
+void GCEvacuator::ForwardPointer(ObjectPtr* ptr) {
+  ObjectPtr old_target = *ptr;
+  if (old_target->IsSmiOrNewObject()) {
+    return;  // Not moved.
+  }
+  uword old_addr = UntaggedObject::ToAddr(old_target);
+  if (!evacuated_.Contains(old_addr)) {
+    return;  // Not moved.
+  }
+  ObjectPtr new_target = UntaggedObject::FromAddr(
+      OldPage::Of(old_addr)->forwarding_page()->Lookup(old_addr));
+  ASSERT(!new_target->IsSmiOrNewObject());
+  *ptr = new_target;
+}
+
+DART_FORCE_INLINE
+void GCEvacuator::ForwardCompressedPointer(uword heap_base,
+                                           CompressedObjectPtr* ptr) {
+  ObjectPtr old_target = ptr->Decompress(heap_base);
+  if (old_target->IsSmiOrNewObject()) {
+    return;  // Not moved.
+  }
+  uword old_addr = UntaggedObject::ToAddr(old_target);
+  if (!evacuated_.Contains(old_addr)) {
+    return;  // Not moved.
+  }
+  ObjectPtr new_target = UntaggedObject::FromAddr(
+      OldPage::Of(old_addr)->forwarding_page()->Lookup(old_addr));
+  ASSERT(!new_target->IsSmiOrNewObject());
+  *ptr = new_target;
+}
+
+void GCEvacuator::VisitTypedDataViewPointers(TypedDataViewPtr view,
+                                             CompressedObjectPtr* first,
+                                             CompressedObjectPtr* last) {
+  ObjectPtr old_backing = view->untag()->typed_data();
+  VisitCompressedPointers(view->heap_base(), first, last);
+  ObjectPtr new_backing = view->untag()->typed_data();
+  if (old_backing != new_backing) {
+    // Evacuation is single threaded, so the backing store has already been
+    // copied and the inner pointer could be updated here. It is deferred only
+    // to share the code with the views recorded by the marker.
+    typed_data_views_.Add(view);
+  }
+}
+
+// Unlike GCCompactor, forwarding is idempotent: destination pages are never
+// candidates, so visiting a pointer twice is harmless.
+void GCEvacuator::VisitPointers(ObjectPtr* first, ObjectPtr* last) {
+  for (ObjectPtr* ptr = first; ptr <= last; ptr++) {
+    ForwardPointer(ptr);
+  }
+}
+
+void GCEvacuator::VisitCompressedPointers(uword heap_base,
+                                          CompressedObjectPtr* first,
+                                          CompressedObjectPtr* last) {
+  for (CompressedObjectPtr* ptr = first; ptr <= last; ptr++) {
+    ForwardCompressedPointer(heap_base, ptr);
+  }
+}
+
+void GCEvacuator::VisitHandle(uword addr) {
+  FinalizablePersistentHandle* handle =
+      reinterpret_cast<FinalizablePersistentHandle*>(addr);
+  ForwardPointer(handle->ptr_addr());
+}
+
 }  // namespace dart
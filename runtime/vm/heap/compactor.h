@@ -10,6 +10,7 @@
 #include "vm/allocation.h"
 #include "vm/dart_api_state.h"
 #include "vm/globals.h"
+#include "vm/heap/pages.h"
 #include "vm/visitor.h"
 
 namespace dart {
@@ -73,6 +74,132 @@ class GCCompactor : public ValueObject,
   MallocGrowableArray<TypedDataViewPtr> typed_data_views_;
 };
 
+// The pages chosen by GCEvacuator. Membership only depends on the page-aligned
+// part of an address, so it is safe to query with pointers into image pages,
+// large pages or other heaps.
+class EvacuationCandidateSet {
+ public:
+  EvacuationCandidateSet() : pages_() {}
+
+  intptr_t length() const { return pages_.length(); }
+  bool IsEmpty() const { return pages_.is_empty(); }
+  OldPage* At(intptr_t i) const {
+    return reinterpret_cast<OldPage*>(pages_[i]);
+  }
+
+  void Add(OldPage* page) { pages_.Add(reinterpret_cast<uword>(page)); }
+  void Clear() { pages_.Clear(); }
+  // Must be called after adding pages and before calling Contains.
+  void Sort() { pages_.Sort(CompareAddresses); }
+
+  bool Contains(uword addr) const {
+    const uword page = addr & kOldPageMask;
+    intptr_t lo = 0;
+    intptr_t hi = pages_.length() - 1;
+    while (lo <= hi) {
+      const intptr_t mid = lo + (hi - lo) / 2;
+      if (page < pages_[mid]) {
+        hi = mid - 1;
+      } else if (page > pages_[mid]) {
+        lo = mid + 1;
+      } else {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static int CompareAddresses(const uword* a, const uword* b) {
+    if (*a < *b) {
+      return -1;
+    } else if (*a == *b) {
+      return 0;
+    } else {
+      return 1;
+    }
+  }
+
+  MallocGrowableArray<uword> pages_;
+
+  DISALLOW_COPY_AND_ASSIGN(EvacuationCandidateSet);
+};
+
+// Implements an evacuating compactor for a bounded number of sparsely
+// populated pages. Candidates are chosen before a stop-the-world marking from
+// the live bytes recorded by the previous marking, and the marker records the
+// slots that point into them. After marking, the live objects of the
+// candidates are copied to fresh pages and only the recorded slots, the weak
+// roots and the remembered set are forwarded, so the pause is proportional to
+// the number of evacuated bytes instead of the size of the heap.
+class GCEvacuator : public ValueObject,
+                    public HandleVisitor,
+                    public ObjectPointerVisitor {
+ public:
+  // Recorded slots of compressed pointers have this bit set.
+  static constexpr uword kCompressedSlotBit = 1;
+
+  GCEvacuator(Thread* thread, Heap* heap)
+      : HandleVisitor(thread),
+        ObjectPointerVisitor(thread->isolate_group()),
+        heap_(heap) {}
+
+  // Chooses the pages whose live bytes are below the evacuation threshold,
+  // sparsest first, within the evacuation budget.
+  void SelectCandidates(OldPage* pages);
+  const EvacuationCandidateSet* candidates() const { return &candidates_; }
+
+  // Called by the marker (possibly from several tasks) with the slots and
+  // typed data views it found pointing into the candidates.
+  void AddRecordedSlots(const MallocGrowableArray<uword>& slots,
+                        const MallocGrowableArray<TypedDataViewPtr>& views);
+
+  // Moves the live objects out of the candidates that are still sparse after
+  // marking, forwards all pointers to them and releases their pages. Must be
+  // called after marking and before sweeping.
+  void Evacuate();
+
+  intptr_t evacuated_pages() const { return evacuated_.length(); }
+  intptr_t evacuated_bytes() const { return evacuated_bytes_; }
+
+ private:
+  bool TryEvacuatePage(OldPage* page);
+  uword TryEvacuateBlock(uword first_object, ForwardingPage* forwarding_page);
+  bool TryMoveToContiguousSize(intptr_t size);
+  void ReleaseToPagesAfter(intptr_t length);
+  void ForwardCopiedObjects();
+  void ForwardRecordedSlots();
+  void ForwardTypedDataViews();
+  void ForwardPointer(ObjectPtr* ptr);
+  void ForwardCompressedPointer(uword heap_base, CompressedObjectPtr* ptr);
+  void VisitTypedDataViewPointers(TypedDataViewPtr view,
+                                  CompressedObjectPtr* first,
+                                  CompressedObjectPtr* last);
+  void VisitPointers(ObjectPtr* first, ObjectPtr* last);
+  void VisitCompressedPointers(uword heap_base,
+                               CompressedObjectPtr* first,
+                               CompressedObjectPtr* last);
+  void VisitHandle(uword addr);
+
+  Heap* heap_;
+
+  EvacuationCandidateSet candidates_;
+  // The candidates whose objects were moved; a subset of candidates_.
+  EvacuationCandidateSet evacuated_;
+  intptr_t evacuated_bytes_ = 0;
+
+  // Destination pages, and the bump region in the last of them.
+  MallocGrowableArray<OldPage*> to_pages_;
+  uword free_current_ = 0;
+  uword free_end_ = 0;
+
+  Mutex slots_mutex_;
+  MallocGrowableArray<uword> slots_;
+  MallocGrowableArray<TypedDataViewPtr> typed_data_views_;
+
+  DISALLOW_COPY_AND_ASSIGN(GCEvacuator);
+};
+
 }  // namespace dart
 
 #endif  // RUNTIME_VM_HEAP_COMPACTOR_H_
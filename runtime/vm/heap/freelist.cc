@@ -296,6 +296,23 @@ void FreeList::Print() const {
   PrintLarge();
 }
 
+void FreeList::CollectSizeClassStats(intptr_t* counts, intptr_t* bytes) const {
+  MutexLocker ml(&mutex_);
+  for (int i = 0; i < kNumLists; ++i) {
+    if (free_lists_[i] == NULL) {
+      continue;
+    }
+    intptr_t list_length = LengthLocked(i);
+    counts[i] += list_length;
+    bytes[i] += list_length * i * kObjectAlignment;
+  }
+  for (FreeListElement* node = free_lists_[kNumLists]; node != NULL;
+       node = node->next()) {
+    counts[kNumLists] += 1;
+    bytes[kNumLists] += node->HeapSize();
+  }
+}
+
 void FreeList::SplitElementAfterAndEnqueue(FreeListElement* element,
                                            intptr_t size,
                                            bool is_protected) {
@@ -74,6 +74,10 @@ class FreeListElement {
 
 class FreeList {
  public:
+  // Elements smaller than kNumLists * kObjectAlignment are kept in exact-size
+  // lists, one per size class. Larger elements share a single list.
+  static const int kNumLists = 128;
+
   FreeList();
   ~FreeList();
 
@@ -84,6 +88,11 @@ class FreeList {
 
   void Print() const;
 
+  // Adds the number and total size of the free elements in each size class to
+  // 'counts' and 'bytes', which have kNumLists + 1 entries. The last entry
+  // accumulates the large elements.
+  void CollectSizeClassStats(intptr_t* counts, intptr_t* bytes) const;
+
   Mutex* mutex() { return &mutex_; }
   uword TryAllocateLocked(intptr_t size, bool is_protected);
   void FreeLocked(uword addr, intptr_t size);
@@ -155,7 +164,6 @@ class FreeList {
   void AddUnaccountedSize(intptr_t size) { unaccounted_size_ += size; }
 
  private:
-  static const int kNumLists = 128;
   static const intptr_t kInitialFreeListSearchBudget = 1000;
 
   static intptr_t IndexForSize(intptr_t size) {
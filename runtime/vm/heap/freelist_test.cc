@@ -232,4 +232,33 @@ TEST_CASE(Regress38528) {
   }
 }
 
+TEST_CASE(FreeListSizeClassStats) {
+  FreeList* free_list = new FreeList();
+  const intptr_t kBlobSize = 1 * MB;
+  VirtualMemory* region =
+      VirtualMemory::Allocate(kBlobSize, /* is_executable */ false, "test");
+  const uword blob = region->start();
+  const intptr_t kSmallSize = 4 * kObjectAlignment;
+  const intptr_t kLargeSize = FreeList::kNumLists * kObjectAlignment;
+  free_list->Free(blob, kSmallSize);
+  free_list->Free(blob + kSmallSize, kLargeSize);
+  free_list->Free(blob + kSmallSize + kLargeSize, kSmallSize);
+
+  intptr_t counts[FreeList::kNumLists + 1] = {0};
+  intptr_t bytes[FreeList::kNumLists + 1] = {0};
+  free_list->CollectSizeClassStats(counts, bytes);
+  EXPECT_EQ(2, counts[4]);
+  EXPECT_EQ(2 * kSmallSize, bytes[4]);
+  EXPECT_EQ(1, counts[FreeList::kNumLists]);
+  EXPECT_EQ(kLargeSize, bytes[FreeList::kNumLists]);
+  intptr_t total = 0;
+  for (intptr_t i = 0; i <= FreeList::kNumLists; i++) {
+    total += counts[i];
+  }
+  EXPECT_EQ(3, total);
+
+  delete region;
+  delete free_list;
+}
+
 }  // namespace dart
@@ -931,7 +931,7 @@ void Heap::ForwardWeakEntries(ObjectPtr before_object, ObjectPtr after_object) {
 }
 
 void Heap::ForwardWeakTables(ObjectPointerVisitor* visitor) {
-  // NOTE: This method is only used by the compactor, so there is no need to
+  // NOTE: This method is only used by the compactors, so there is no need to
   // process the `Heap::kNew` tables.
   for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
     WeakSelector selector = static_cast<Heap::WeakSelector>(sel);
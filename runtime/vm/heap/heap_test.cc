@@ -19,6 +19,7 @@
 #include "vm/object_graph.h"
 #include "vm/port.h"
 #include "vm/symbols.h"
+#include "vm/thread_pool.h"
 #include "vm/unit_test.h"
 
 namespace dart {
@@ -729,4 +730,223 @@ ISOLATE_UNIT_TEST_CASE(ArrayTruncationRaces) {
   }
 }
 
+ISOLATE_UNIT_TEST_CASE(OldGenTLAB) {
+  SetFlagScope<bool> sfs(&FLAG_old_gen_tlab, true);
+  PageSpace* old_space = thread->heap()->old_space();
+  const intptr_t refills_before = old_space->tlab_refills();
+
+  const intptr_t kLength = 1000;
+  const Array& arrays = Array::Handle(Array::New(kLength, Heap::kOld));
+  Array& element = Array::Handle();
+  for (intptr_t i = 0; i < kLength; i++) {
+    element = Array::New(2, Heap::kOld);
+    element.SetAt(0, Smi::Handle(Smi::New(i)));
+    arrays.SetAt(i, element);
+  }
+  EXPECT(old_space->tlab_refills() > refills_before);
+
+  // The most recent allocation came from this thread's TLAB.
+  const uword last = UntaggedObject::ToAddr(element.ptr());
+  EXPECT(thread->old_space_end() != 0);
+  EXPECT(last < thread->old_space_top());
+  EXPECT(last >= thread->old_space_end() - PageSpace::kMaxTLABSize);
+
+  // Heap iteration must be able to step over the unused part of the TLAB.
+  EXPECT(thread->heap()->Verify());
+
+  // The TLAB is given back before sweeping.
+  GCTestHelper::CollectOldSpace();
+  EXPECT(thread->old_space_end() == 0);
+  for (intptr_t i = 0; i < kLength; i++) {
+    element ^= arrays.At(i);
+    EXPECT_EQ(i, Smi::Value(Smi::RawCast(element.At(0))));
+  }
+}
+
+TEST_CASE(Pretenuring) {
+  SetFlagScope<bool> sfs(&FLAG_pretenure, true);
+  const char* kScriptChars =
+      "class A {\n"
+      "  var a;\n"
+      "  var b;\n"
+      "}\n"
+      "var retained;\n"
+      "fill() {\n"
+      "  var list = [];\n"
+      "  for (var i = 0; i < 20000; i++) {\n"
+      "    list.add(new A());\n"
+      "  }\n"
+      "  retained = list;\n"
+      "}\n"
+      "allocate() => new A();\n";
+  Dart_Handle h_lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  Dart_Handle result = Dart_Invoke(h_lib, NewString("fill"), 0, NULL);
+  EXPECT_VALID(result);
+
+  Scavenger* new_space = IsolateGroup::Current()->heap()->new_space();
+  intptr_t cid;
+  {
+    TransitionNativeToVM transition(thread);
+    Library& lib = Library::Handle();
+    lib ^= Api::UnwrapHandle(h_lib);
+    const Class& cls = Class::Handle(GetClass(lib, "A"));
+    cid = cls.id();
+
+    // Every instance of A allocated so far is still reachable.
+    GCTestHelper::CollectNewSpace();
+    EXPECT(new_space->ShouldPretenure(cid));
+    EXPECT_LE(1, new_space->NumPretenuredClasses());
+    new_space->ApplyPretenuringDecisions(thread);
+  }
+
+  result = Dart_Invoke(h_lib, NewString("allocate"), 0, NULL);
+  EXPECT_VALID(result);
+  {
+    TransitionNativeToVM transition(thread);
+    const Instance& instance =
+        Api::UnwrapInstanceHandle(thread->zone(), result);
+    EXPECT_EQ(cid, instance.GetClassId());
+    EXPECT(instance.ptr()->IsOldObject());
+  }
+}
+
+class PretenuringScavengeTask : public ThreadPool::Task {
+ public:
+  PretenuringScavengeTask(Isolate* isolate, Monitor* monitor, bool* done)
+      : isolate_(isolate), monitor_(monitor), done_(done) {}
+  virtual void Run() {
+    Thread::EnterIsolateAsHelper(isolate_, Thread::kUnknownTask);
+    GCTestHelper::CollectNewSpace();
+    Thread::ExitIsolateAsHelper();
+    {
+      MonitorLocker ml(monitor_);
+      *done_ = true;
+      ml.Notify();
+    }
+  }
+
+ private:
+  Isolate* isolate_;
+  Monitor* monitor_;
+  bool* done_;
+};
+
+// A decision made by a scavenge on a helper thread is applied by the mutator.
+TEST_CASE(Pretenuring_ScavengeOnHelperThread) {
+  SetFlagScope<bool> sfs(&FLAG_pretenure, true);
+  const char* kScriptChars =
+      "class A {\n"
+      "  var a;\n"
+      "  var b;\n"
+      "}\n"
+      "var retained;\n"
+      "fill() {\n"
+      "  var list = [];\n"
+      "  for (var i = 0; i < 20000; i++) {\n"
+      "    list.add(new A());\n"
+      "  }\n"
+      "  retained = list;\n"
+      "}\n"
+      "allocate() => new A();\n";
+  Dart_Handle h_lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  Dart_Handle result = Dart_Invoke(h_lib, NewString("fill"), 0, NULL);
+  EXPECT_VALID(result);
+
+  Monitor monitor;
+  bool done = false;
+  Dart::thread_pool()->Run<PretenuringScavengeTask>(Isolate::Current(),
+                                                    &monitor, &done);
+  {
+    MonitorLocker ml(&monitor);
+    while (!done) {
+      ml.Wait();
+    }
+  }
+
+  Scavenger* new_space = IsolateGroup::Current()->heap()->new_space();
+  intptr_t cid;
+  {
+    TransitionNativeToVM transition(thread);
+    Library& lib = Library::Handle();
+    lib ^= Api::UnwrapHandle(h_lib);
+    const Class& cls = Class::Handle(GetClass(lib, "A"));
+    cid = cls.id();
+    EXPECT(new_space->ShouldPretenure(cid));
+    EXPECT(new_space->HasPendingPretenuringDecisions());
+    EXPECT(thread->HasScheduledInterrupts());
+  }
+
+  // The first call handles the interrupt, the second one uses the
+  // regenerated allocation stub.
+  result = Dart_Invoke(h_lib, NewString("allocate"), 0, NULL);
+  EXPECT_VALID(result);
+  EXPECT(!new_space->HasPendingPretenuringDecisions());
+  result = Dart_Invoke(h_lib, NewString("allocate"), 0, NULL);
+  EXPECT_VALID(result);
+  {
+    TransitionNativeToVM transition(thread);
+    const Instance& instance =
+        Api::UnwrapInstanceHandle(thread->zone(), result);
+    EXPECT_EQ(cid, instance.GetClassId());
+    EXPECT(instance.ptr()->IsOldObject());
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(IncrementalCompactor) {
+  Heap* heap = thread->heap();
+  PageSpace* old_space = heap->old_space();
+
+  // Leave every sixteenth object alive, so all pages become sparse.
+  const intptr_t kNumObjects = 64 * KB;
+  const intptr_t kKeepEvery = 16;
+  const Array& survivors =
+      Array::Handle(Array::New(kNumObjects / kKeepEvery, Heap::kOld));
+  Array& element = Array::Handle();
+  TypedData& data = TypedData::Handle();
+  TypedDataView& view = TypedDataView::Handle();
+  for (intptr_t i = 0; i < kNumObjects; i++) {
+    element = Array::New(2, Heap::kOld);
+    element.SetAt(0, Smi::Handle(Smi::New(i)));
+    if ((i % kKeepEvery) == 0) {
+      survivors.SetAt(i / kKeepEvery, element);
+    }
+    if (i == (kNumObjects / 2)) {
+      // The inner pointer of the view must follow its backing store.
+      data = TypedData::New(kTypedDataUint8ArrayCid, 16, Heap::kOld);
+      for (intptr_t j = 0; j < 16; j++) {
+        data.SetUint8(j, j);
+      }
+      view = TypedDataView::New(kTypedDataUint8ArrayViewCid, data, 4, 8,
+                                Heap::kOld);
+      element.SetAt(1, view);
+      data = TypedData::null();
+      view = TypedDataView::null();
+    }
+  }
+  element = Array::null();
+
+  // Records the live bytes of each page.
+  GCTestHelper::CollectOldSpace();
+
+  {
+    SetFlagScope<bool> sfs(&FLAG_use_incremental_compactor, true);
+    const intptr_t evacuated_before = old_space->evacuated_bytes();
+    heap->CollectGarbage(Heap::kMarkCompact, Heap::kDebugging);
+    GCTestHelper::WaitForGCTasks();
+    EXPECT(old_space->evacuated_bytes() > evacuated_before);
+  }
+
+  for (intptr_t i = 0; i < kNumObjects; i += kKeepEvery) {
+    element ^= survivors.At(i / kKeepEvery);
+    EXPECT_EQ(i, Smi::Value(Smi::RawCast(element.At(0))));
+  }
+  element ^= survivors.At(kNumObjects / 2 / kKeepEvery);
+  view ^= element.At(1);
+  EXPECT_EQ(8, view.LengthInBytes());
+  for (intptr_t j = 0; j < 8; j++) {
+    EXPECT_EQ(j + 4, view.GetUint8(j));
+  }
+  EXPECT(heap->Verify());
+}
+
 }  // namespace dart
@@ -4,11 +4,17 @@
 
 #include "vm/heap/marker.h"
 
+#include <memory>
+
 #include "platform/atomic.h"
 #include "vm/allocation.h"
 #include "vm/dart_api_state.h"
+#include "vm/growable_array.h"
+#include "vm/heap/compactor.h"
 #include "vm/heap/pages.h"
 #include "vm/heap/pointer_block.h"
+#include "vm/heap/weak_table.h"
+#include "vm/heap/work_stealing.h"
 #include "vm/isolate.h"
 #include "vm/log.h"
 #include "vm/object_id_ring.h"
@@ -36,7 +42,10 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
         deferred_work_list_(deferred_marking_stack),
         delayed_weak_properties_(WeakProperty::null()),
         marked_bytes_(0),
-        marked_micros_(0) {
+        marked_micros_(0),
+        live_page_(nullptr),
+        live_page_bytes_(0),
+        candidates_(nullptr) {
     ASSERT(thread_->isolate_group() == isolate_group);
   }
   ~MarkingVisitorBase() {}
@@ -45,6 +54,20 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
   int64_t marked_micros() const { return marked_micros_; }
   void AddMicros(int64_t micros) { marked_micros_ += micros; }
 
+  // Once set, slots of visited heap objects that point into 'candidates' are
+  // recorded for GCEvacuator. Roots are not recorded: they may be visited
+  // through temporary copies and the evacuator visits them again anyway.
+  void set_evacuation_candidates(const EvacuationCandidateSet* candidates) {
+    candidates_ = candidates;
+  }
+  const MallocGrowableArray<uword>& recorded_slots() const {
+    return recorded_slots_;
+  }
+  const MallocGrowableArray<TypedDataViewPtr>& recorded_typed_data_views()
+      const {
+    return recorded_typed_data_views_;
+  }
+
   bool ProcessPendingWeakProperties() {
     bool marked = false;
     WeakPropertyPtr cur_weak = delayed_weak_properties_;
@@ -96,6 +119,9 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
           size = ProcessWeakProperty(raw_weak, /* did_mark */ true);
         }
         marked_bytes_ += size;
+        if (class_id != kInstructionsCid) {
+          AddLiveBytes(raw_obj, size);
+        }
 
         raw_obj = work_list_.Pop();
       } while (raw_obj != nullptr);
@@ -130,7 +156,11 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
 
   void VisitPointers(ObjectPtr* first, ObjectPtr* last) {
     for (ObjectPtr* current = first; current <= last; current++) {
-      MarkObject(LoadPointerIgnoreRace(current));
+      ObjectPtr raw_obj = LoadPointerIgnoreRace(current);
+      if (UNLIKELY(candidates_ != nullptr)) {
+        RecordSlot(reinterpret_cast<uword>(current), raw_obj);
+      }
+      MarkObject(raw_obj);
     }
   }
 
@@ -138,9 +168,29 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
                                CompressedObjectPtr* first,
                                CompressedObjectPtr* last) {
     for (CompressedObjectPtr* current = first; current <= last; current++) {
-      MarkObject(
-          LoadCompressedPointerIgnoreRace(current).Decompress(heap_base));
+      ObjectPtr raw_obj =
+          LoadCompressedPointerIgnoreRace(current).Decompress(heap_base);
+      if (UNLIKELY(candidates_ != nullptr)) {
+        RecordSlot(reinterpret_cast<uword>(current) |
+                       GCEvacuator::kCompressedSlotBit,
+                   raw_obj);
+      }
+      MarkObject(raw_obj);
+    }
+  }
+
+  void VisitTypedDataViewPointers(TypedDataViewPtr view,
+                                  CompressedObjectPtr* first,
+                                  CompressedObjectPtr* last) {
+    if (UNLIKELY(candidates_ != nullptr)) {
+      // The inner pointer must follow the backing store if it is evacuated.
+      ObjectPtr backing = view->untag()->typed_data();
+      if (backing->IsHeapObject() && backing->IsOldObject() &&
+          candidates_->Contains(UntaggedObject::ToAddr(backing))) {
+        recorded_typed_data_views_.Add(view);
+      }
     }
+    VisitCompressedPointers(view->heap_base(), first, last);
   }
 
   void EnqueueWeakProperty(WeakPropertyPtr raw_weak) {
@@ -189,6 +239,9 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
       // double-counting.
       if (did_mark) {
         marked_bytes_ += size;
+        if (class_id != kInstructionsCid) {
+          AddLiveBytes(raw_obj, size);
+        }
       }
     }
   }
@@ -201,6 +254,7 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
   // Called when all marking is complete.
   void Finalize() {
     work_list_.Finalize();
+    FlushLiveBytes();
     // Clear pending weak properties.
     WeakPropertyPtr cur_weak = delayed_weak_properties_;
     delayed_weak_properties_ = WeakProperty::null();
@@ -221,12 +275,44 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
     return work_list_.WaitForWork(num_busy);
   }
 
+  void AttachToStealingGroup(WorkStealingGroup* group, intptr_t index) {
+    work_list_.AttachToStealingGroup(group, index);
+  }
+
   void AbandonWork() {
     work_list_.AbandonWork();
     deferred_work_list_.AbandonWork();
   }
 
  private:
+  // Live bytes are accumulated per page in OldPage::live_bytes for choosing
+  // evacuation candidates. Consecutive objects tend to be on the same page, so
+  // the atomic update is only done when the page changes. Instructions are
+  // skipped because their pages may be write-protected.
+  void AddLiveBytes(ObjectPtr raw_obj, intptr_t size) {
+    OldPage* page = OldPage::Of(raw_obj);
+    if (page != live_page_) {
+      FlushLiveBytes();
+      live_page_ = page;
+    }
+    live_page_bytes_ += size;
+  }
+
+  void FlushLiveBytes() {
+    if (live_page_ != nullptr) {
+      live_page_->AddLiveBytes(live_page_bytes_);
+      live_page_ = nullptr;
+      live_page_bytes_ = 0;
+    }
+  }
+
+  void RecordSlot(uword slot, ObjectPtr target) {
+    if (target->IsHeapObject() && target->IsOldObject() &&
+        candidates_->Contains(UntaggedObject::ToAddr(target))) {
+      recorded_slots_.Add(slot);
+    }
+  }
+
   void PushMarked(ObjectPtr raw_obj) {
     ASSERT(raw_obj->IsHeapObject());
     ASSERT(raw_obj->IsOldObject());
@@ -296,6 +382,11 @@ class MarkingVisitorBase : public ObjectPointerVisitor {
   WeakPropertyPtr delayed_weak_properties_;
   uintptr_t marked_bytes_;
   int64_t marked_micros_;
+  OldPage* live_page_;
+  intptr_t live_page_bytes_;
+  const EvacuationCandidateSet* candidates_;
+  MallocGrowableArray<uword> recorded_slots_;
+  MallocGrowableArray<TypedDataViewPtr> recorded_typed_data_views_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(MarkingVisitorBase);
 };
@@ -318,21 +409,26 @@ static bool IsUnreachable(const ObjectPtr raw_obj) {
 
 class MarkingWeakVisitor : public HandleVisitor {
  public:
-  explicit MarkingWeakVisitor(Thread* thread)
+  MarkingWeakVisitor(Thread* thread,
+                     MallocGrowableArray<FinalizablePersistentHandle*>* dead)
       : HandleVisitor(thread),
-        class_table_(thread->isolate_group()->shared_class_table()) {}
+        class_table_(thread->isolate_group()->shared_class_table()),
+        dead_(dead) {}
 
   void VisitHandle(uword addr) {
     FinalizablePersistentHandle* handle =
         reinterpret_cast<FinalizablePersistentHandle*>(addr);
     ObjectPtr raw_obj = handle->ptr();
     if (IsUnreachable(raw_obj)) {
-      handle->UpdateUnreachable(thread()->isolate_group());
+      // Finalizers may free other handles, so they cannot run while other
+      // markers are visiting handles.
+      dead_->Add(handle);
     }
   }
 
  private:
   SharedClassTable* class_table_;
+  MallocGrowableArray<FinalizablePersistentHandle*>* dead_;
 
   DISALLOW_COPY_AND_ASSIGN(MarkingWeakVisitor);
 };
@@ -348,6 +444,18 @@ enum RootSlices {
   kNumFixedRootSlices = 1,
 };
 
+// Weak handles are visited in this many chunks per marker, so that markers
+// which finish their other weak slices early can help.
+static constexpr intptr_t kWeakHandleChunksPerTask = 4;
+
+// Number of weak table entries pruned by one weak slice.
+static constexpr intptr_t kWeakTableChunkSize = 16 * KB;
+
+static intptr_t NumWeakTableChunks(WeakTable* table) {
+  return Utils::RoundUp(table->size(), kWeakTableChunkSize) /
+         kWeakTableChunkSize;
+}
+
 void GCMarker::ResetSlices() {
   ASSERT(Thread::Current()->IsAtSafepoint());
 
@@ -360,6 +468,16 @@ void GCMarker::ResetSlices() {
   }
 
   weak_slices_started_ = 0;
+  num_weak_handle_chunks_ =
+      Utils::Maximum(FLAG_marker_tasks, 1) * kWeakHandleChunksPerTask;
+  num_weak_table_chunks_ = 0;
+  for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
+    num_weak_table_chunks_ += NumWeakTableChunks(
+        heap_->GetWeakTable(Heap::kOld, static_cast<Heap::WeakSelector>(sel)));
+  }
+  typedef MallocGrowableArray<FinalizablePersistentHandle*> HandleList;
+  delete[] unreachable_handles_;
+  unreachable_handles_ = new HandleList[num_weak_handle_chunks_];
 }
 
 void GCMarker::IterateRoots(ObjectPointerVisitor* visitor) {
@@ -399,27 +517,31 @@ void GCMarker::IterateRoots(ObjectPointerVisitor* visitor) {
 }
 
 enum WeakSlices {
-  kWeakHandles = 0,
-  kWeakTables,
-  kObjectIdRing,
+  kObjectIdRing = 0,
   kRememberedSet,
-  kNumWeakSlices,
+  kNumFixedWeakSlices,
 };
 
+// The weak handle chunks come first, then the weak table chunks, then the
+// fixed slices.
 void GCMarker::IterateWeakRoots(Thread* thread) {
   for (;;) {
     intptr_t slice = weak_slices_started_.fetch_add(1);
-    if (slice >= kNumWeakSlices) {
+    if (slice < num_weak_handle_chunks_) {
+      ProcessWeakHandles(thread, slice);
+      continue;
+    }
+    slice -= num_weak_handle_chunks_;
+    if (slice < num_weak_table_chunks_) {
+      ProcessWeakTables(thread, slice);
+      continue;
+    }
+    slice -= num_weak_table_chunks_;
+    if (slice >= kNumFixedWeakSlices) {
       return;  // No more slices.
     }
 
     switch (slice) {
-      case kWeakHandles:
-        ProcessWeakHandles(thread);
-        break;
-      case kWeakTables:
-        ProcessWeakTables(thread);
-        break;
       case kObjectIdRing:
         ProcessObjectIdTable(thread);
         break;
@@ -432,29 +554,57 @@ void GCMarker::IterateWeakRoots(Thread* thread) {
   }
 }
 
-void GCMarker::ProcessWeakHandles(Thread* thread) {
+void GCMarker::ProcessWeakHandles(Thread* thread, intptr_t chunk) {
   TIMELINE_FUNCTION_GC_DURATION(thread, "ProcessWeakHandles");
-  MarkingWeakVisitor visitor(thread);
+  MarkingWeakVisitor visitor(thread, &unreachable_handles_[chunk]);
   ApiState* state = isolate_group_->api_state();
   ASSERT(state != NULL);
-  isolate_group_->VisitWeakPersistentHandles(&visitor);
+  isolate_group_->VisitWeakPersistentHandlesChunk(&visitor, chunk,
+                                                  num_weak_handle_chunks_);
+}
+
+void GCMarker::FinalizeWeakHandles(Thread* thread) {
+  TIMELINE_FUNCTION_GC_DURATION(thread, "FinalizeWeakHandles");
+  for (intptr_t i = 0; i < num_weak_handle_chunks_; i++) {
+    MallocGrowableArray<FinalizablePersistentHandle*>* dead =
+        &unreachable_handles_[i];
+    for (intptr_t j = 0; j < dead->length(); j++) {
+      (*dead)[j]->UpdateUnreachable(isolate_group_);
+    }
+  }
+  delete[] unreachable_handles_;
+  unreachable_handles_ = nullptr;
 }
 
-void GCMarker::ProcessWeakTables(Thread* thread) {
+void GCMarker::ProcessWeakTables(Thread* thread, intptr_t chunk) {
   TIMELINE_FUNCTION_GC_DURATION(thread, "ProcessWeakTables");
   for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
     WeakTable* table =
         heap_->GetWeakTable(Heap::kOld, static_cast<Heap::WeakSelector>(sel));
-    intptr_t size = table->size();
-    for (intptr_t i = 0; i < size; i++) {
+    const intptr_t num_chunks = NumWeakTableChunks(table);
+    if (chunk >= num_chunks) {
+      chunk -= num_chunks;
+      continue;
+    }
+    const intptr_t start = chunk * kWeakTableChunkSize;
+    const intptr_t end =
+        Utils::Minimum(start + kWeakTableChunkSize, table->size());
+    intptr_t removed = 0;
+    for (intptr_t i = start; i < end; i++) {
       if (table->IsValidEntryAtExclusive(i)) {
         ObjectPtr raw_obj = table->ObjectAtExclusive(i);
         if (raw_obj->IsHeapObject() && !raw_obj->untag()->IsMarked()) {
-          table->InvalidateAtExclusive(i);
+          table->InvalidateAtParallel(i);
+          removed++;
         }
       }
     }
+    if (removed > 0) {
+      table->RemovedEntries(removed);
+    }
+    return;
   }
+  UNREACHABLE();
 }
 
 void GCMarker::ProcessRememberedSet(Thread* thread) {
@@ -554,6 +704,7 @@ class ParallelMarkTask : public ThreadPool::Task {
 
       // Phase 1: Iterate over roots and drain marking stack in tasks.
       marker_->IterateRoots(visitor_);
+      visitor_->set_evacuation_candidates(marker_->evacuation_candidates());
 
       visitor_->ProcessDeferredMarking();
 
@@ -692,6 +843,10 @@ void GCMarker::FinalizeResultsFrom(MarkingVisitorType* visitor) {
     marked_bytes_ += visitor->marked_bytes();
     marked_micros_ += visitor->marked_micros();
   }
+  if (evacuator_ != nullptr) {
+    evacuator_->AddRecordedSlots(visitor->recorded_slots(),
+                                 visitor->recorded_typed_data_views());
+  }
   visitor->Finalize();
 }
 
@@ -717,8 +872,12 @@ GCMarker::GCMarker(IsolateGroup* isolate_group, Heap* heap)
       heap_(heap),
       marking_stack_(),
       visitors_(),
+      num_weak_handle_chunks_(0),
+      num_weak_table_chunks_(0),
+      unreachable_handles_(nullptr),
       marked_bytes_(0),
-      marked_micros_(0) {
+      marked_micros_(0),
+      evacuator_(nullptr) {
   visitors_ = new SyncMarkingVisitor*[FLAG_marker_tasks];
   for (intptr_t i = 0; i < FLAG_marker_tasks; i++) {
     visitors_[i] = NULL;
@@ -736,6 +895,11 @@ GCMarker::~GCMarker() {
     }
   }
   delete[] visitors_;
+  delete[] unreachable_handles_;
+}
+
+const EvacuationCandidateSet* GCMarker::evacuation_candidates() const {
+  return evacuator_ == nullptr ? nullptr : evacuator_->candidates();
 }
 
 void GCMarker::StartConcurrentMark(PageSpace* page_space) {
@@ -794,43 +958,64 @@ void GCMarker::MarkObjects(PageSpace* page_space) {
                                 &deferred_marking_stack_);
       ResetSlices();
       IterateRoots(&mark);
+      mark.set_evacuation_candidates(evacuation_candidates());
       mark.ProcessDeferredMarking();
       mark.DrainMarkingStack();
       mark.FinalizeDeferredMarking();
       IterateWeakRoots(thread);
+      FinalizeWeakHandles(thread);
       // All marking done; detach code, etc.
       int64_t stop = OS::GetCurrentMonotonicMicros();
       mark.AddMicros(stop - start);
       FinalizeResultsFrom(&mark);
     } else {
-      ThreadBarrier barrier(num_tasks, heap_->barrier(), heap_->barrier_done());
-      ResetSlices();
-      // Used to coordinate draining among tasks; all start out as 'busy'.
-      RelaxedAtomic<uintptr_t> num_busy(num_tasks);
-      // Phase 1: Iterate over roots and drain marking stack in tasks.
-      for (intptr_t i = 0; i < num_tasks; ++i) {
-        SyncMarkingVisitor* visitor;
-        if (visitors_[i] != NULL) {
-          visitor = visitors_[i];
-          visitors_[i] = NULL;
-        } else {
-          visitor =
-              new SyncMarkingVisitor(isolate_group_, page_space,
-                                     &marking_stack_, &deferred_marking_stack_);
-        }
-        if (i < (num_tasks - 1)) {
-          // Begin marking on a helper thread.
-          bool result = Dart::thread_pool()->Run<ParallelMarkTask>(
-              this, isolate_group_, &marking_stack_, &barrier, visitor,
-              &num_busy);
-          ASSERT(result);
-        } else {
-          // Last worker is the main thread.
-          ParallelMarkTask task(this, isolate_group_, &marking_stack_, &barrier,
-                                visitor, &num_busy);
-          task.RunEnteredIsolateGroup();
-          barrier.Exit();
+      std::unique_ptr<WorkStealingGroup> stealing_group;
+      if (FLAG_gc_work_stealing) {
+        stealing_group.reset(new WorkStealingGroup(num_tasks));
+      }
+      {
+        ThreadBarrier barrier(num_tasks, heap_->barrier(),
+                              heap_->barrier_done());
+        ResetSlices();
+        // Used to coordinate draining among tasks; all start out as 'busy'.
+        RelaxedAtomic<uintptr_t> num_busy(num_tasks);
+        // Phase 1: Iterate over roots and drain marking stack in tasks.
+        for (intptr_t i = 0; i < num_tasks; ++i) {
+          SyncMarkingVisitor* visitor;
+          if (visitors_[i] != NULL) {
+            visitor = visitors_[i];
+            visitors_[i] = NULL;
+          } else {
+            visitor = new SyncMarkingVisitor(isolate_group_, page_space,
+                                             &marking_stack_,
+                                             &deferred_marking_stack_);
+          }
+          if (stealing_group != nullptr) {
+            visitor->AttachToStealingGroup(stealing_group.get(), i);
+          }
+          if (i < (num_tasks - 1)) {
+            // Begin marking on a helper thread.
+            bool result = Dart::thread_pool()->Run<ParallelMarkTask>(
+                this, isolate_group_, &marking_stack_, &barrier, visitor,
+                &num_busy);
+            ASSERT(result);
+          } else {
+            // Last worker is the main thread.
+            ParallelMarkTask task(this, isolate_group_, &marking_stack_,
+                                  &barrier, visitor, &num_busy);
+            task.RunEnteredIsolateGroup();
+            barrier.Exit();
+          }
         }
+        // Leaving this scope waits for all tasks to exit the barrier.
+      }
+      FinalizeWeakHandles(thread);
+      if (FLAG_log_marker_tasks && (stealing_group != nullptr)) {
+        THR_Print("Marker tasks stole %" Pd " objects (%" Pd
+                  " failed attempts), idle for %" Pd64 " micros.\n",
+                  stealing_group->TotalSteals(),
+                  stealing_group->TotalFailedSteals(),
+                  stealing_group->TotalIdleMicros());
       }
     }
   }
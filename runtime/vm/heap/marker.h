@@ -12,9 +12,14 @@
 namespace dart {
 
 // Forward declarations.
+class EvacuationCandidateSet;
+class FinalizablePersistentHandle;
+class GCEvacuator;
 class HandleVisitor;
 class Heap;
 class IsolateGroup;
+template <typename T>
+class MallocGrowableArray;
 class ObjectPointerVisitor;
 class PageSpace;
 template <bool sync>
@@ -45,16 +50,23 @@ class GCMarker {
   intptr_t marked_words() const { return marked_bytes_ >> kWordSizeLog2; }
   intptr_t MarkedWordsPerMicro() const;
 
+  // Makes MarkObjects record the slots pointing into the candidates of
+  // 'evacuator'. Only valid if marking happens entirely within MarkObjects,
+  // because the incremental barrier does not record slots.
+  void set_evacuator(GCEvacuator* evacuator) { evacuator_ = evacuator; }
+
  private:
   void Prologue();
   void Epilogue();
   void ResetSlices();
   void IterateRoots(ObjectPointerVisitor* visitor);
   void IterateWeakRoots(Thread* thread);
-  void ProcessWeakHandles(Thread* thread);
-  void ProcessWeakTables(Thread* thread);
+  void ProcessWeakHandles(Thread* thread, intptr_t chunk);
+  void ProcessWeakTables(Thread* thread, intptr_t chunk);
+  void FinalizeWeakHandles(Thread* thread);
   void ProcessRememberedSet(Thread* thread);
   void ProcessObjectIdTable(Thread* thread);
+  const EvacuationCandidateSet* evacuation_candidates() const;
 
   // Called by anyone: finalize and accumulate stats from 'visitor'.
   template <class MarkingVisitorType>
@@ -72,11 +84,18 @@ class GCMarker {
   intptr_t root_slices_finished_;
   intptr_t root_slices_count_;
   RelaxedAtomic<intptr_t> weak_slices_started_;
+  intptr_t num_weak_handle_chunks_;
+  intptr_t num_weak_table_chunks_;
+  // Handles whose referent died, per weak handle chunk. Their finalizers run
+  // on the main thread once all weak slices are done.
+  MallocGrowableArray<FinalizablePersistentHandle*>* unreachable_handles_;
 
   Mutex stats_mutex_;
   uintptr_t marked_bytes_;
   int64_t marked_micros_;
 
+  GCEvacuator* evacuator_;
+
   friend class ConcurrentMarkTask;
   friend class ParallelMarkTask;
   DISALLOW_IMPLICIT_CONSTRUCTORS(GCMarker);
@@ -59,6 +59,7 @@ OldPage* OldPage::Allocate(intptr_t size_in_words,
   result->memory_ = memory;
   result->next_ = NULL;
   result->used_in_bytes_ = 0;
+  result->live_bytes_ = 0;
   result->forwarding_page_ = NULL;
   result->card_table_ = NULL;
   result->type_ = type;
@@ -227,6 +228,9 @@ PageSpace::PageSpace(Heap* heap, intptr_t max_capacity_in_words)
     : heap_(heap),
       num_freelists_(Utils::Maximum(FLAG_scavenger_tasks, 1) + 1),
       freelists_(new FreeList[num_freelists_]),
+      tlab_owners_(),
+      tlab_refills_(0),
+      tlab_waste_in_words_(0),
       pages_lock_(),
       max_capacity_in_words_(max_capacity_in_words),
       usage_(),
@@ -376,6 +380,7 @@ OldPage* PageSpace::AllocatePage(OldPage::PageType type, bool link) {
       (!heap_->is_vm_isolate())) {
     page->AllocateForwardingPage();
   }
+  page->set_live_bytes(page->object_end() - page->object_start());
   return page;
 }
 
@@ -572,6 +577,98 @@ uword PageSpace::TryAllocateInternal(intptr_t size,
   return result;
 }
 
+uword PageSpace::TryAllocateInTLAB(intptr_t size) {
+  ASSERT(Utils::IsAligned(size, kObjectAlignment));
+  ASSERT(size <= kMaxTLABAllocationSize);
+  if (heap_ == NULL) {  // Some unit tests.
+    return 0;
+  }
+  Thread* thread = Thread::Current();
+  // Threads that bypass safepoints cannot be made to give back their TLAB
+  // before a GC.
+  if ((thread->heap() != heap_) || thread->BypassSafepoints()) {
+    return 0;
+  }
+  uword result = thread->old_space_top();
+  if (static_cast<intptr_t>(thread->old_space_end() - result) < size) {
+    FreeList* freelist = &freelists_[OldPage::kData];
+    MutexLocker ml(freelist->mutex());
+    if (!TryRefillTLABLocked(thread, freelist)) {
+      return 0;
+    }
+    result = thread->old_space_top();
+  }
+  ASSERT(static_cast<intptr_t>(thread->old_space_end() - result) >= size);
+  thread->set_old_space_top(result + size);
+  return result;
+}
+
+bool PageSpace::TryRefillTLABLocked(Thread* thread, FreeList* freelist) {
+  ASSERT(freelist->mutex()->IsOwnedByCurrentThread());
+  // Only carve TLABs out of large elements. Small requests that do not fit
+  // keep being served by the exact size-class lists, so the TLABs do not eat
+  // into the elements that would otherwise be reused.
+  FreeListElement* block = freelist->TryAllocateLargeLocked(kMinTLABSize);
+  if (block == NULL) {
+    return false;
+  }
+  AbandonTLABLocked(thread, freelist);
+  uword start = reinterpret_cast<uword>(block);
+  intptr_t block_size = block->HeapSize();
+  if (block_size > kMaxTLABSize) {
+    freelist->FreeLocked(start + kMaxTLABSize, block_size - kMaxTLABSize);
+    block_size = kMaxTLABSize;
+  }
+  // The whole buffer is accounted as used up front; AbandonTLABLocked gives
+  // back whatever is left.
+  usage_.used_in_words += (block_size >> kWordSizeLog2);
+  thread->set_old_space_top(start);
+  thread->set_old_space_end(start + block_size);
+  tlab_owners_.Add(thread);
+  tlab_refills_.fetch_add(1);
+  return true;
+}
+
+void PageSpace::AbandonTLABLocked(Thread* thread, FreeList* freelist) {
+  ASSERT(freelist->mutex()->IsOwnedByCurrentThread());
+  uword top = thread->old_space_top();
+  uword end = thread->old_space_end();
+  if (end == 0) {
+    return;
+  }
+  for (intptr_t i = 0; i < tlab_owners_.length(); i++) {
+    if (tlab_owners_[i] == thread) {
+      tlab_owners_.RemoveAt(i);
+      break;
+    }
+  }
+  if (top < end) {
+    const intptr_t remaining = end - top;
+    freelist->FreeLocked(top, remaining);
+    usage_.used_in_words -= (remaining >> kWordSizeLog2);
+    tlab_waste_in_words_.fetch_add(remaining >> kWordSizeLog2);
+  }
+  thread->set_old_space_top(0);
+  thread->set_old_space_end(0);
+}
+
+void PageSpace::AbandonTLAB(Thread* thread) {
+  if (thread->old_space_end() == 0) {
+    return;
+  }
+  FreeList* freelist = &freelists_[OldPage::kData];
+  MutexLocker ml(freelist->mutex());
+  AbandonTLABLocked(thread, freelist);
+}
+
+void PageSpace::AbandonTLABs() {
+  FreeList* freelist = &freelists_[OldPage::kData];
+  MutexLocker ml(freelist->mutex());
+  while (!tlab_owners_.is_empty()) {
+    AbandonTLABLocked(tlab_owners_.Last(), freelist);
+  }
+}
+
 void PageSpace::AcquireLock(FreeList* freelist) {
   freelist->mutex()->Lock();
 }
@@ -686,9 +783,18 @@ void PageSpace::MakeIterable() const {
   for (intptr_t i = 0; i < num_freelists_; i++) {
     freelists_[i].MakeIterable();
   }
+  for (intptr_t i = 0; i < tlab_owners_.length(); i++) {
+    Thread* thread = tlab_owners_[i];
+    uword top = thread->old_space_top();
+    uword end = thread->old_space_end();
+    if (top < end) {
+      FreeListElement::AsElement(top, end - top);
+    }
+  }
 }
 
 void PageSpace::AbandonBumpAllocation() {
+  AbandonTLABs();
   for (intptr_t i = 0; i < num_freelists_; i++) {
     freelists_[i].AbandonBumpAllocation();
   }
@@ -893,6 +999,29 @@ void PageSpace::PrintToJSONObject(JSONObject* object) const {
   } else {
     space.AddProperty("avgCollectionPeriodMillis", 0.0);
   }
+  space.AddProperty("_tlabRefills", tlab_refills());
+  space.AddProperty64("_evacuatedBytes", evacuated_bytes());
+  space.AddProperty64("_tlabWaste", tlab_waste_in_words() * kWordSize);
+  {
+    // Free space per size class of the data freelists, to measure
+    // fragmentation. The last entry covers all large elements.
+    intptr_t counts[FreeList::kNumLists + 1] = {0};
+    intptr_t bytes[FreeList::kNumLists + 1] = {0};
+    for (intptr_t i = OldPage::kData; i < num_freelists_; i++) {
+      freelists_[i].CollectSizeClassStats(counts, bytes);
+    }
+    JSONArray size_classes(&space, "_freeListSizeClasses");
+    for (intptr_t i = 0; i <= FreeList::kNumLists; i++) {
+      if (counts[i] == 0) {
+        continue;
+      }
+      JSONObject size_class(&size_classes);
+      size_class.AddProperty("size", i * kObjectAlignment);
+      size_class.AddProperty("large", i == FreeList::kNumLists);
+      size_class.AddProperty("count", counts[i]);
+      size_class.AddProperty("bytes", bytes[i]);
+    }
+  }
 }
 
 class HeapMapAsJSONVisitor : public ObjectVisitor {
@@ -1177,10 +1306,30 @@ void PageSpace::CollectGarbageHelper(bool compact,
   // Save old value before GCMarker visits the weak persistent handles.
   SpaceUsage usage_before = GetCurrentUsage();
 
+  // The incremental compactor needs the marker to record every slot pointing
+  // into its candidates. The incremental barrier does not record slots, so it
+  // is only used when the whole marking happens within this safepoint.
+  const bool evacuate =
+      compact && finalize && FLAG_use_incremental_compactor && (marker_ == NULL);
+  GCEvacuator evacuator(thread, heap_);
+
   // Mark all reachable old-gen objects.
   if (marker_ == NULL) {
     ASSERT(phase() == kDone);
+    if (evacuate) {
+      // Uses the live bytes from the previous marking.
+      evacuator.SelectCandidates(pages_);
+    }
+    for (OldPage* page = pages_; page != nullptr; page = page->next()) {
+      page->set_live_bytes(0);
+    }
+    for (OldPage* page = large_pages_; page != nullptr; page = page->next()) {
+      page->set_live_bytes(0);
+    }
     marker_ = new GCMarker(isolate_group, heap_);
+    if (evacuate && !evacuator.candidates()->IsEmpty()) {
+      marker_->set_evacuator(&evacuator);
+    }
   } else {
     ASSERT(phase() == kAwaitingFinalization);
   }
@@ -1191,6 +1340,10 @@ void PageSpace::CollectGarbageHelper(bool compact,
     return;
   }
 
+  // Return the TLABs before the used size is recomputed from the marking
+  // results, so their unused remainders are not subtracted twice.
+  AbandonTLABs();
+
   marker_->MarkObjects(this);
   usage_.used_in_words = marker_->marked_words() + allocated_black_in_words_;
   allocated_black_in_words_ = 0;
@@ -1243,7 +1396,13 @@ void PageSpace::CollectGarbageHelper(bool compact,
 
   bool has_reservation = MarkReservation();
 
-  if (compact) {
+  if (evacuate) {
+    // Moves the live objects off the sparse candidates; the result is swept
+    // as usual below.
+    Evacuate(thread, &evacuator);
+  }
+
+  if (compact && !evacuate) {
     SweepLarge();
     Compact(thread);
     set_phase(kDone);
@@ -1364,6 +1523,19 @@ void PageSpace::Compact(Thread* thread) {
   }
 }
 
+void PageSpace::Evacuate(Thread* thread, GCEvacuator* evacuator) {
+  thread->isolate_group()->set_compaction_in_progress(true);
+  evacuator->Evacuate();
+  thread->isolate_group()->set_compaction_in_progress(false);
+  evacuated_bytes_ += evacuator->evacuated_bytes();
+
+  if (FLAG_verbose_gc) {
+    THR_Print("Evacuated %" Pd " of %" Pd " candidate pages (%" Pd "kB).\n",
+              evacuator->evacuated_pages(), evacuator->candidates()->length(),
+              evacuator->evacuated_bytes() / KB);
+  }
+}
+
 uword PageSpace::TryAllocateDataBumpLocked(FreeList* freelist, intptr_t size) {
   ASSERT(size >= kObjectAlignment);
   ASSERT(Utils::IsAligned(size, kObjectAlignment));
@@ -7,6 +7,7 @@
 
 #include "platform/atomic.h"
 #include "vm/globals.h"
+#include "vm/growable_array.h"
 #include "vm/heap/freelist.h"
 #include "vm/heap/spaces.h"
 #include "vm/lockers.h"
@@ -24,6 +25,7 @@ class JSONObject;
 class ObjectPointerVisitor;
 class ObjectSet;
 class ForwardingPage;
+class GCEvacuator;
 class GCMarker;
 
 static constexpr intptr_t kOldPageSize = 512 * KB;
@@ -55,6 +57,12 @@ class OldPage {
     used_in_bytes_ = value;
   }
 
+  // Bytes of the objects found live by the most recent marking. Pages that
+  // have not been marked yet pessimistically report the whole page as live.
+  intptr_t live_bytes() const { return live_bytes_; }
+  void set_live_bytes(intptr_t value) { live_bytes_ = value; }
+  void AddLiveBytes(intptr_t value) { live_bytes_.fetch_add(value); }
+
   ForwardingPage* forwarding_page() const { return forwarding_page_; }
   void AllocateForwardingPage();
 
@@ -203,12 +211,14 @@ class OldPage {
   OldPage* next_;
   uword object_end_;
   uword used_in_bytes_;
+  RelaxedAtomic<intptr_t> live_bytes_;
   ForwardingPage* forwarding_page_;
   uint8_t* card_table_;  // Remembered set, not marking.
   PageType type_;
 
   friend class PageSpace;
   friend class GCCompactor;
+  friend class GCEvacuator;
 
   DISALLOW_ALLOCATION();
   DISALLOW_IMPLICIT_CONSTRUCTORS(OldPage);
@@ -335,6 +345,13 @@ class PageSpace {
   uword TryAllocate(intptr_t size,
                     OldPage::PageType type = OldPage::kData,
                     GrowthPolicy growth_policy = kControlGrowth) {
+    if (FLAG_old_gen_tlab && (type == OldPage::kData) &&
+        (size <= kMaxTLABAllocationSize)) {
+      uword result = TryAllocateInTLAB(size);
+      if (result != 0) {
+        return result;
+      }
+    }
     bool is_protected =
         (type == OldPage::kExecutable) && FLAG_write_protect_code;
     bool is_locked = false;
@@ -342,6 +359,24 @@ class PageSpace {
                                is_protected, is_locked);
   }
 
+  // Small data objects can be bump allocated from a thread-local allocation
+  // buffer (TLAB) carved out of the data freelist, which avoids taking the
+  // freelist lock in the common case. TLABs are returned to the freelist when
+  // their thread is unscheduled, and at safepoints before the heap is swept,
+  // compacted or write protected.
+  static constexpr intptr_t kMinTLABSize = 4 * KB;
+  static constexpr intptr_t kMaxTLABSize = 32 * KB;
+  static constexpr intptr_t kMaxTLABAllocationSize = 1 * KB;
+
+  // Returns the unused part of 'thread's TLAB to the freelist.
+  void AbandonTLAB(Thread* thread);
+
+  intptr_t tlab_refills() const { return tlab_refills_; }
+  intptr_t tlab_waste_in_words() const { return tlab_waste_in_words_; }
+
+  // Total bytes moved by the incremental compactor.
+  intptr_t evacuated_bytes() const { return evacuated_bytes_; }
+
   void TryReleaseReservation();
   bool MarkReservation();
   void TryReserveForOOM();
@@ -514,7 +549,7 @@ class PageSpace {
 
   void SetupImagePage(void* pointer, uword size, bool is_executable);
 
-  // Return any bump allocation block to the freelist.
+  // Return any bump allocation block, including all TLABs, to the freelist.
   void AbandonBumpAllocation();
   // Have threads release marking stack blocks, etc.
   void AbandonMarkingForShutdown();
@@ -560,6 +595,11 @@ class PageSpace {
 
   void EvaluateConcurrentMarking(GrowthPolicy growth_policy);
 
+  uword TryAllocateInTLAB(intptr_t size);
+  bool TryRefillTLABLocked(Thread* thread, FreeList* freelist);
+  void AbandonTLABLocked(Thread* thread, FreeList* freelist);
+  void AbandonTLABs();
+
   // Makes bump block walkable; do not call concurrently with mutator.
   void MakeIterable() const;
 
@@ -586,6 +626,7 @@ class PageSpace {
   void Sweep();
   void ConcurrentSweep(IsolateGroup* isolate_group);
   void Compact(Thread* thread);
+  void Evacuate(Thread* thread, GCEvacuator* evacuator);
 
   static intptr_t LargePageSizeInWordsFor(intptr_t size);
 
@@ -609,6 +650,14 @@ class PageSpace {
   // page freelists without locking.
   const intptr_t num_freelists_;
   FreeList* freelists_;
+
+  // Threads currently owning a TLAB. Guarded by the data freelist's mutex.
+  MallocGrowableArray<Thread*> tlab_owners_;
+  RelaxedAtomic<intptr_t> tlab_refills_;
+  RelaxedAtomic<intptr_t> tlab_waste_in_words_;
+
+  intptr_t evacuated_bytes_ = 0;
+
   static constexpr intptr_t kOOMReservationSize = 32 * KB;
   FreeListElement* oom_reservation_ = nullptr;
 
@@ -657,6 +706,7 @@ class PageSpace {
   friend class PageSpaceController;
   friend class ConcurrentSweeperTask;
   friend class GCCompactor;
+  friend class GCEvacuator;
   friend class CompactorTask;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(PageSpace);
@@ -7,6 +7,8 @@
 
 #include "platform/assert.h"
 #include "vm/globals.h"
+#include "vm/heap/work_stealing.h"
+#include "vm/os.h"
 #include "vm/os_thread.h"
 #include "vm/tagged_pointer.h"
 
@@ -163,11 +165,31 @@ class BlockWorkList : public ValueObject {
     ASSERT(local_output_ == nullptr);
     ASSERT(local_input_ == nullptr);
     ASSERT(stack_ == nullptr);
+    ASSERT(group_ == nullptr);
+  }
+
+  // Makes this work list the 'index'th member of 'group'. Pushed objects go to
+  // this worker's deque first and only spill into blocks of the shared stack
+  // when it overflows. When a worker runs out of local work it steals single
+  // objects from the deques of its peers instead of waiting for another
+  // worker to publish a whole block.
+  void AttachToStealingGroup(WorkStealingGroup* group, intptr_t index) {
+    ASSERT(group_ == nullptr);
+    group_ = group;
+    index_ = index;
+    deque_ = group->DequeAt(index);
+    ASSERT(deque_->IsEmpty());
   }
 
   // Returns nullptr if no more work was found.
   ObjectPtr Pop() {
     ASSERT(local_input_ != nullptr);
+    if (deque_ != nullptr) {
+      ObjectPtr raw_obj;
+      if (deque_->Pop(&raw_obj)) {
+        return raw_obj;
+      }
+    }
     if (UNLIKELY(local_input_->IsEmpty())) {
       if (!local_output_->IsEmpty()) {
         auto temp = local_output_;
@@ -176,7 +198,11 @@ class BlockWorkList : public ValueObject {
       } else {
         Block* new_work = stack_->PopNonEmptyBlock();
         if (new_work == nullptr) {
-          return nullptr;
+          ObjectPtr raw_obj = nullptr;
+          if (group_ != nullptr) {
+            group_->TrySteal(index_, &raw_obj);
+          }
+          return raw_obj;
         }
         stack_->PushBlock(local_input_);
         local_input_ = new_work;
@@ -188,6 +214,9 @@ class BlockWorkList : public ValueObject {
   }
 
   void Push(ObjectPtr raw_obj) {
+    if (deque_ != nullptr && deque_->Push(raw_obj)) {
+      return;
+    }
     if (UNLIKELY(local_output_->IsFull())) {
       stack_->PushBlock(local_output_);
       local_output_ = stack_->PopEmptyBlock();
@@ -197,6 +226,9 @@ class BlockWorkList : public ValueObject {
 
   bool WaitForWork(RelaxedAtomic<uintptr_t>* num_busy) {
     ASSERT(local_input_->IsEmpty());
+    if (group_ != nullptr) {
+      return WaitForStealableWork(num_busy);
+    }
     Block* new_work = stack_->WaitForWork(num_busy);
     if (new_work == NULL) {
       return false;
@@ -207,6 +239,8 @@ class BlockWorkList : public ValueObject {
   }
 
   void Finalize() {
+    ASSERT(deque_ == nullptr || deque_->IsEmpty());
+    DetachFromStealingGroup();
     ASSERT(local_output_->IsEmpty());
     stack_->PushBlock(local_output_);
     local_output_ = nullptr;
@@ -218,6 +252,19 @@ class BlockWorkList : public ValueObject {
   }
 
   void AbandonWork() {
+    // Move any objects still in the deque into blocks so they are discarded
+    // together with the rest of the stack.
+    if (deque_ != nullptr) {
+      ObjectPtr raw_obj;
+      while (deque_->Pop(&raw_obj)) {
+        if (local_output_->IsFull()) {
+          stack_->PushBlock(local_output_);
+          local_output_ = stack_->PopEmptyBlock();
+        }
+        local_output_->Push(raw_obj);
+      }
+    }
+    DetachFromStealingGroup();
     stack_->PushBlock(local_output_);
     local_output_ = nullptr;
     stack_->PushBlock(local_input_);
@@ -226,6 +273,9 @@ class BlockWorkList : public ValueObject {
   }
 
   bool IsEmpty() {
+    if (deque_ != nullptr && !deque_->IsEmpty()) {
+      return false;
+    }
     if (!local_input_->IsEmpty()) {
       return false;
     }
@@ -236,9 +286,68 @@ class BlockWorkList : public ValueObject {
   }
 
  private:
+  void DetachFromStealingGroup() {
+    group_ = nullptr;
+    deque_ = nullptr;
+    index_ = -1;
+  }
+
+  // Termination protocol for work-stealing mode. Peers never notify the
+  // stack's monitor when they push into their deques, so instead of blocking
+  // an idle worker polls the shared stack and its peers' deques.
+  //
+  // A worker only leaves the busy count once its deque and blocks are empty
+  // and only idle workers poll, so once 'num_busy' reaches zero no deque can
+  // be refilled and all workers may stop. A worker that sees apparent work
+  // rejoins the busy count *before* trying to take it, so a successful steal
+  // always happens while at least one other worker is counted as busy.
+  bool WaitForStealableWork(RelaxedAtomic<uintptr_t>* num_busy) {
+    const int64_t start = OS::GetCurrentMonotonicMicros();
+    num_busy->fetch_sub(1u, std::memory_order_seq_cst);
+    bool found = false;
+    for (intptr_t round = 0;; round++) {
+      if (!stack_->IsEmpty() || group_->HasStealableWork(index_)) {
+        num_busy->fetch_add(1u, std::memory_order_seq_cst);
+        Block* new_work = stack_->PopNonEmptyBlock();
+        if (new_work != nullptr) {
+          stack_->PushBlock(local_input_);
+          local_input_ = new_work;
+          found = true;
+          break;
+        }
+        ObjectPtr raw_obj;
+        if (group_->TrySteal(index_, &raw_obj)) {
+          // Our deque is empty, so this cannot overflow.
+          const bool pushed = deque_->Push(raw_obj);
+          ASSERT(pushed);
+          USE(pushed);
+          found = true;
+          break;
+        }
+        num_busy->fetch_sub(1u, std::memory_order_seq_cst);
+      }
+      if (num_busy->load(std::memory_order_seq_cst) == 0) {
+        break;
+      }
+      if (round >= kIdleSpinRounds) {
+        OS::SleepMicros(1);
+      }
+    }
+    group_->AddIdleMicros(index_, OS::GetCurrentMonotonicMicros() - start);
+    return found;
+  }
+
+  // Number of polling rounds before an idle worker starts sleeping.
+  static constexpr intptr_t kIdleSpinRounds = 64;
+
   Block* local_output_;
   Block* local_input_;
   Stack* stack_;
+
+  // Only set in work-stealing mode.
+  WorkStealingGroup* group_ = nullptr;
+  ObjectStealingDeque* deque_ = nullptr;
+  intptr_t index_ = -1;
 };
 
 static const int kStoreBufferBlockSize = 1024;
@@ -4,6 +4,8 @@
 
 #include "vm/heap/scavenger.h"
 
+#include <memory>
+
 #include "platform/leak_sanitizer.h"
 #include "vm/dart.h"
 #include "vm/dart_api_state.h"
@@ -14,6 +16,7 @@
 #include "vm/heap/safepoint.h"
 #include "vm/heap/verifier.h"
 #include "vm/heap/weak_table.h"
+#include "vm/heap/work_stealing.h"
 #include "vm/isolate.h"
 #include "vm/lockers.h"
 #include "vm/longjump.h"
@@ -38,6 +41,11 @@ DEFINE_FLAG(int,
             90,
             "Grow new gen when less than this percentage is garbage.");
 DEFINE_FLAG(int, new_gen_growth_factor, 2, "Grow new gen by this factor.");
+DEFINE_FLAG(int,
+            pretenure_threshold,
+            90,
+            "With --pretenure, allocate a class in old space when more than "
+            "this percentage of its new-space instances survive a scavenge.");
 
 // Scavenger uses the kCardRememberedBit to distinguish forwarded and
 // non-forwarded objects. We must choose a bit that is clear for all new-space
@@ -210,6 +218,10 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
 
   intptr_t bytes_promoted() const { return bytes_promoted_; }
 
+  void AttachToStealingGroup(WorkStealingGroup* group, intptr_t index) {
+    promoted_list_.AttachToStealingGroup(group, index);
+  }
+
   void ProcessRoots() {
     thread_ = Thread::Current();
     page_space_->AcquireLock(freelist_);
@@ -252,6 +264,8 @@ class ScavengerVisitorBase : public ObjectPointerVisitor {
 
   inline void ProcessWeakProperties();
 
+  bool aborted() const { return scavenger_->abort_; }
+
   bool HasWork() {
     if (scavenger_->abort_) return false;
     return (scan_ != tail_) || (scan_ != nullptr && !scan_->IsResolved()) ||
@@ -506,10 +520,13 @@ typedef ScavengerVisitorBase<true> ParallelScavengerVisitor;
 
 class ScavengerWeakVisitor : public HandleVisitor {
  public:
-  ScavengerWeakVisitor(Thread* thread, Scavenger* scavenger)
+  ScavengerWeakVisitor(Thread* thread,
+                       Scavenger* scavenger,
+                       MallocGrowableArray<FinalizablePersistentHandle*>* dead)
       : HandleVisitor(thread),
         scavenger_(scavenger),
-        class_table_(thread->isolate_group()->shared_class_table()) {
+        class_table_(thread->isolate_group()->shared_class_table()),
+        dead_(dead) {
     ASSERT(scavenger->heap_->isolate_group() == thread->isolate_group());
   }
 
@@ -518,7 +535,9 @@ class ScavengerWeakVisitor : public HandleVisitor {
         reinterpret_cast<FinalizablePersistentHandle*>(addr);
     ObjectPtr* p = handle->ptr_addr();
     if (scavenger_->IsUnreachable(p)) {
-      handle->UpdateUnreachable(thread()->isolate_group());
+      // Finalizers may free other handles, so they cannot run while other
+      // tasks are visiting handles.
+      dead_->Add(handle);
     } else {
       handle->UpdateRelocated(thread()->isolate_group());
     }
@@ -527,19 +546,216 @@ class ScavengerWeakVisitor : public HandleVisitor {
  private:
   Scavenger* scavenger_;
   SharedClassTable* class_table_;
+  MallocGrowableArray<FinalizablePersistentHandle*>* dead_;
 
   DISALLOW_COPY_AND_ASSIGN(ScavengerWeakVisitor);
 };
 
+// Mourns the weak persistent handles and rehashes the new-space weak tables
+// once the survivors of a scavenge are known. The work is split into slices
+// that the scavenger tasks claim in two phases:
+//  1. Chunks of the weak handles, and chunks of the weak tables whose
+//     surviving entries are forwarded into per-chunk buffers.
+//  2. One slice per weak table, which builds its replacement from the
+//     buffered survivors.
+// Finalize then runs the finalizers of the unreachable handles and installs
+// the replacement tables on the main thread.
+class ScavengerWeakMourner {
+ public:
+  ScavengerWeakMourner(Scavenger* scavenger, intptr_t num_tasks)
+      : scavenger_(scavenger),
+        num_handle_chunks_(Utils::Maximum<intptr_t>(num_tasks, 1) *
+                           kHandleChunksPerTask),
+        unreachable_handles_(new HandleList[num_handle_chunks_]) {
+    Heap* heap = scavenger->heap_;
+    intptr_t num_table_chunks = 0;
+    for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
+      const auto selector = static_cast<Heap::WeakSelector>(sel);
+      AddTable(heap->GetWeakTable(Heap::kNew, selector),
+               heap->GetWeakTable(Heap::kOld, selector), nullptr, selector,
+               &num_table_chunks);
+    }
+    // Each isolate might have a weak table used for fast snapshot writing
+    // (i.e. isolate communication). Rehash those tables if need be.
+    heap->isolate_group()->ForEachIsolate(
+        [&](Isolate* isolate) {
+          if (isolate->forward_table_new() != nullptr) {
+            AddTable(isolate->forward_table_new(),
+                     isolate->forward_table_old(), isolate,
+                     Heap::kNumWeakSelectors, &num_table_chunks);
+          }
+        },
+        /*at_safepoint=*/true);
+    num_table_chunks_ = num_table_chunks;
+    survivors_ = new SurvivorList[num_table_chunks_];
+  }
+
+  ~ScavengerWeakMourner() {
+    delete[] unreachable_handles_;
+    delete[] survivors_;
+  }
+
+  // Phase 1.
+  void ProcessChunks(Thread* thread) {
+    const intptr_t num_slices = num_handle_chunks_ + num_table_chunks_;
+    for (;;) {
+      const intptr_t slice = chunks_started_.fetch_add(1);
+      if (slice >= num_slices) {
+        return;  // No more slices.
+      }
+      if (slice < num_handle_chunks_) {
+        MournHandleChunk(thread, slice);
+      } else {
+        ForwardTableChunk(thread, slice - num_handle_chunks_);
+      }
+    }
+  }
+
+  // Phase 2.
+  void RehashTables(Thread* thread) {
+    for (;;) {
+      const intptr_t slice = tables_started_.fetch_add(1);
+      if (slice >= tables_.length()) {
+        return;  // No more slices.
+      }
+      RehashTable(thread, &tables_[slice]);
+    }
+  }
+
+  void Finalize(Thread* thread) {
+    TIMELINE_FUNCTION_GC_DURATION(thread, "FinalizeWeakHandles");
+    IsolateGroup* isolate_group = scavenger_->heap_->isolate_group();
+    for (intptr_t i = 0; i < num_handle_chunks_; i++) {
+      HandleList* dead = &unreachable_handles_[i];
+      for (intptr_t j = 0; j < dead->length(); j++) {
+        (*dead)[j]->UpdateUnreachable(isolate_group);
+      }
+    }
+
+    for (intptr_t i = 0; i < tables_.length(); i++) {
+      const Table& table = tables_[i];
+      ASSERT(table.replacement != nullptr);
+      if (table.isolate != nullptr) {
+        table.isolate->set_forward_table_new(table.replacement);
+      } else {
+        scavenger_->heap_->SetWeakTable(Heap::kNew, table.selector,
+                                        table.replacement);
+        // Remove the old table as it has been replaced with the newly
+        // allocated table above.
+        delete table.table;
+      }
+    }
+  }
+
+ private:
+  // Weak handles are visited in this many chunks per task, so that tasks
+  // which finish their weak table chunks early can help.
+  static constexpr intptr_t kHandleChunksPerTask = 4;
+
+  // Number of weak table entries forwarded by one slice.
+  static constexpr intptr_t kTableChunkSize = 16 * KB;
+
+  typedef MallocGrowableArray<FinalizablePersistentHandle*> HandleList;
+
+  struct Survivor {
+    ObjectPtr key;
+    intptr_t value;
+  };
+  typedef MallocGrowableArray<Survivor> SurvivorList;
+
+  struct Table {
+    WeakTable* table;      // The new-space table being replaced.
+    WeakTable* old_table;  // Receives the entries of promoted keys.
+    Isolate* isolate;      // Owner of a forward table, or nullptr.
+    Heap::WeakSelector selector;
+    intptr_t first_chunk;
+    intptr_t num_chunks;
+    WeakTable* replacement;
+  };
+
+  void AddTable(WeakTable* table,
+                WeakTable* old_table,
+                Isolate* isolate,
+                Heap::WeakSelector selector,
+                intptr_t* num_table_chunks) {
+    const intptr_t num_chunks =
+        Utils::RoundUp(table->size(), kTableChunkSize) / kTableChunkSize;
+    tables_.Add({table, old_table, isolate, selector, *num_table_chunks,
+                 num_chunks, nullptr});
+    *num_table_chunks += num_chunks;
+  }
+
+  void MournHandleChunk(Thread* thread, intptr_t chunk) {
+    TIMELINE_FUNCTION_GC_DURATION(thread, "MournWeakHandles");
+    ScavengerWeakVisitor visitor(thread, scavenger_,
+                                 &unreachable_handles_[chunk]);
+    thread->isolate_group()->VisitWeakPersistentHandlesChunk(
+        &visitor, chunk, num_handle_chunks_);
+  }
+
+  void ForwardTableChunk(Thread* thread, intptr_t chunk) {
+    TIMELINE_FUNCTION_GC_DURATION(thread, "ForwardWeakTable");
+    intptr_t index = 0;
+    while (chunk >= tables_[index].first_chunk + tables_[index].num_chunks) {
+      index++;
+    }
+    WeakTable* table = tables_[index].table;
+    SurvivorList* survivors = &survivors_[chunk];
+    const intptr_t start =
+        (chunk - tables_[index].first_chunk) * kTableChunkSize;
+    const intptr_t end = Utils::Minimum(start + kTableChunkSize, table->size());
+    for (intptr_t i = start; i < end; i++) {
+      if (table->IsValidEntryAtExclusive(i)) {
+        ObjectPtr raw_obj = table->ObjectAtExclusive(i);
+        ASSERT(raw_obj->IsHeapObject());
+        uword raw_addr = UntaggedObject::ToAddr(raw_obj);
+        uword header = *reinterpret_cast<uword*>(raw_addr);
+        if (IsForwarding(header)) {
+          // The object has survived.  Preserve its record.
+          survivors->Add({ForwardedObj(header), table->ValueAtExclusive(i)});
+        }
+      }
+    }
+  }
+
+  void RehashTable(Thread* thread, Table* table) {
+    TIMELINE_FUNCTION_GC_DURATION(thread, "RehashWeakTable");
+    WeakTable* replacement = WeakTable::NewFrom(table->table);
+    for (intptr_t c = 0; c < table->num_chunks; c++) {
+      const SurvivorList& survivors = survivors_[table->first_chunk + c];
+      for (intptr_t i = 0; i < survivors.length(); i++) {
+        ObjectPtr raw_obj = survivors[i].key;
+        WeakTable* target =
+            raw_obj->IsNewObject() ? replacement : table->old_table;
+        target->SetValueExclusive(raw_obj, survivors[i].value);
+      }
+    }
+    table->replacement = replacement;
+  }
+
+  Scavenger* const scavenger_;
+  const intptr_t num_handle_chunks_;
+  HandleList* const unreachable_handles_;
+  MallocGrowableArray<Table> tables_;
+  intptr_t num_table_chunks_ = 0;
+  SurvivorList* survivors_ = nullptr;
+  RelaxedAtomic<intptr_t> chunks_started_ = {0};
+  RelaxedAtomic<intptr_t> tables_started_ = {0};
+
+  DISALLOW_COPY_AND_ASSIGN(ScavengerWeakMourner);
+};
+
 class ParallelScavengerTask : public ThreadPool::Task {
  public:
   ParallelScavengerTask(IsolateGroup* isolate_group,
                         ThreadBarrier* barrier,
                         ParallelScavengerVisitor* visitor,
+                        ScavengerWeakMourner* mourner,
                         RelaxedAtomic<uintptr_t>* num_busy)
       : isolate_group_(isolate_group),
         barrier_(barrier),
         visitor_(visitor),
+        mourner_(mourner),
         num_busy_(num_busy) {}
 
   virtual void Run() {
@@ -601,12 +817,22 @@ class ParallelScavengerTask : public ThreadPool::Task {
     // Phase 2: Weak processing, statistics.
     visitor_->Finalize();
     barrier_->Sync();
+
+    // Phase 3: Weak handles and weak tables. A failed scavenge must be
+    // reversed first, after which they are mourned on the main thread.
+    if (!visitor_->aborted()) {
+      mourner_->ProcessChunks(Thread::Current());
+      barrier_->Sync();
+      mourner_->RehashTables(Thread::Current());
+      barrier_->Sync();
+    }
   }
 
  private:
   IsolateGroup* isolate_group_;
   ThreadBarrier* barrier_;
   ParallelScavengerVisitor* visitor_;
+  ScavengerWeakMourner* mourner_;
   RelaxedAtomic<uintptr_t>* num_busy_;
 
   DISALLOW_COPY_AND_ASSIGN(ParallelScavengerTask);
@@ -691,6 +917,7 @@ NewPage* NewPage::Allocate() {
   result->top_ = top;
   result->end_ = memory->end() - kNewObjectAlignmentOffset;
   result->survivor_end_ = top;
+  result->allocation_start_ = top;
   result->resolved_top_ = top;
 
   LSAN_REGISTER_ROOT_REGION(result, sizeof(*result));
@@ -1146,8 +1373,6 @@ void Scavenger::IterateStoreBuffers(ScavengerVisitorBase<parallel>* visitor) {
   visitor->VisitingOldObject(nullptr);
 
   heap_->RecordData(kStoreBufferEntries, total_count);
-  heap_->RecordData(kDataUnused1, 0);
-  heap_->RecordData(kDataUnused2, 0);
 }
 
 template <bool parallel>
@@ -1220,13 +1445,6 @@ bool Scavenger::IsUnreachable(ObjectPtr* p) {
   return true;
 }
 
-void Scavenger::MournWeakHandles() {
-  Thread* thread = Thread::Current();
-  TIMELINE_FUNCTION_GC_DURATION(thread, "MournWeakHandles");
-  ScavengerWeakVisitor weak_visitor(thread, this);
-  heap_->isolate_group()->VisitWeakPersistentHandles(&weak_visitor);
-}
-
 template <bool parallel>
 void ScavengerVisitorBase<parallel>::ProcessToSpace() {
   while (scan_ != nullptr) {
@@ -1367,59 +1585,6 @@ intptr_t ScavengerVisitorBase<parallel>::ProcessCopied(ObjectPtr raw_obj) {
   return raw_obj->untag()->VisitPointersNonvirtual(this);
 }
 
-void Scavenger::MournWeakTables() {
-  TIMELINE_FUNCTION_GC_DURATION(Thread::Current(), "MournWeakTables");
-
-  auto rehash_weak_table = [](WeakTable* table, WeakTable* replacement_new,
-                              WeakTable* replacement_old) {
-    intptr_t size = table->size();
-    for (intptr_t i = 0; i < size; i++) {
-      if (table->IsValidEntryAtExclusive(i)) {
-        ObjectPtr raw_obj = table->ObjectAtExclusive(i);
-        ASSERT(raw_obj->IsHeapObject());
-        uword raw_addr = UntaggedObject::ToAddr(raw_obj);
-        uword header = *reinterpret_cast<uword*>(raw_addr);
-        if (IsForwarding(header)) {
-          // The object has survived.  Preserve its record.
-          raw_obj = ForwardedObj(header);
-          auto replacement =
-              raw_obj->IsNewObject() ? replacement_new : replacement_old;
-          replacement->SetValueExclusive(raw_obj, table->ValueAtExclusive(i));
-        }
-      }
-    }
-  };
-
-  // Rehash the weak tables now that we know which objects survive this cycle.
-  for (int sel = 0; sel < Heap::kNumWeakSelectors; sel++) {
-    const auto selector = static_cast<Heap::WeakSelector>(sel);
-    auto table = heap_->GetWeakTable(Heap::kNew, selector);
-    auto table_old = heap_->GetWeakTable(Heap::kOld, selector);
-
-    // Create a new weak table for the new-space.
-    auto table_new = WeakTable::NewFrom(table);
-    rehash_weak_table(table, table_new, table_old);
-    heap_->SetWeakTable(Heap::kNew, selector, table_new);
-
-    // Remove the old table as it has been replaced with the newly allocated
-    // table above.
-    delete table;
-  }
-
-  // Each isolate might have a weak table used for fast snapshot writing (i.e.
-  // isolate communication). Rehash those tables if need be.
-  heap_->isolate_group()->ForEachIsolate(
-      [&](Isolate* isolate) {
-        auto table = isolate->forward_table_new();
-        if (table != nullptr) {
-          auto replacement = WeakTable::NewFrom(table);
-          rehash_weak_table(table, replacement, isolate->forward_table_old());
-          isolate->set_forward_table_new(replacement);
-        }
-      },
-      /*at_safepoint=*/true);
-}
-
 template <bool parallel>
 void ScavengerVisitorBase<parallel>::MournWeakProperties() {
   ASSERT(!scavenger_->abort_);
@@ -1560,6 +1725,134 @@ uword ScavengerVisitorBase<parallel>::TryAllocateCopySlow(intptr_t size) {
   return tail_->TryAllocateGC(size);
 }
 
+// Minimum number of words of a class that must have been sampled before it is
+// considered for pretenuring.
+static constexpr intptr_t kPretenureMinSampleInWords = 64 * KBInWords;
+// Counters are halved once this many words have been sampled, so decisions
+// follow the recent allocation behavior of the class.
+static constexpr intptr_t kPretenureSampleWindowInWords = 1 * MBInWords;
+
+// Walks the objects allocated by the mutator since the last scavenge. Those
+// that were copied have a forwarding header, the rest are garbage.
+void Scavenger::UpdatePretenuringFeedback(SemiSpace* from) {
+  Thread* thread = Thread::Current();
+  TIMELINE_FUNCTION_GC_DURATION(thread, "UpdatePretenuringFeedback");
+
+  const intptr_t num_cids =
+      heap_->isolate_group()->shared_class_table()->NumCids();
+  while (survival_stats_.length() < num_cids) {
+    survival_stats_.Add({0, 0, false});
+  }
+
+  for (NewPage* page = from->head(); page != nullptr; page = page->next()) {
+    uword addr = page->allocation_start();
+    const uword end = page->object_end();
+    while (addr < end) {
+      const uword header = *reinterpret_cast<uword*>(addr);
+      ObjectPtr obj;
+      bool survived;
+      if (IsForwarding(header)) {
+        obj = ForwardedObj(header);
+        survived = true;
+      } else {
+        obj = UntaggedObject::FromAddr(addr);
+        survived = false;
+      }
+      const intptr_t cid = obj->GetClassId();
+      const intptr_t size = obj->untag()->HeapSize();
+      // Predefined classes are not allocated through class allocation stubs.
+      if (cid >= kNumPredefinedCids) {
+        SurvivalStats& stats = survival_stats_[cid];
+        stats.allocated_in_words += size >> kWordSizeLog2;
+        if (survived) {
+          stats.survived_in_words += size >> kWordSizeLog2;
+        }
+      }
+      addr += size;
+    }
+  }
+
+  bool decided = false;
+  for (intptr_t cid = kNumPredefinedCids; cid < num_cids; cid++) {
+    SurvivalStats& stats = survival_stats_[cid];
+    if (stats.pretenured) {
+      continue;
+    }
+    if ((stats.allocated_in_words >= kPretenureMinSampleInWords) &&
+        (stats.survived_in_words * 100 >=
+         stats.allocated_in_words * FLAG_pretenure_threshold)) {
+      stats.pretenured = true;
+      MutexLocker ml(&pretenure_lock_);
+      pending_pretenured_cids_.Add(cid);
+      decided = true;
+      if (FLAG_verbose_gc) {
+        OS::PrintErr(
+            "Pretenuring cid %" Pd " (%" Pd "%% of %" Pd "kB survived).\n", cid,
+            stats.survived_in_words * 100 / stats.allocated_in_words,
+            stats.allocated_in_words / KBInWords);
+      }
+    } else if (stats.allocated_in_words >= kPretenureSampleWindowInWords) {
+      stats.allocated_in_words >>= 1;
+      stats.survived_in_words >>= 1;
+    }
+  }
+
+  // Allocation stubs can only be replaced by a mutator outside of a
+  // safepoint. The scavenge may run on any thread, so every scheduled mutator
+  // of the group is interrupted and the first one to handle it applies the
+  // decisions. Isolates without a scheduled mutator pick them up when they
+  // are entered.
+  if (decided) {
+    heap_->isolate_group()->ForEachIsolate(
+        [&](Isolate* isolate) {
+          Thread* mutator = isolate->scheduled_mutator_thread();
+          if (mutator != nullptr) {
+            mutator->ScheduleInterrupts(Thread::kVMInterrupt);
+          }
+        },
+        /*at_safepoint=*/true);
+  }
+}
+
+bool Scavenger::HasPendingPretenuringDecisions() {
+  MutexLocker ml(&pretenure_lock_);
+  return !pending_pretenured_cids_.is_empty();
+}
+
+intptr_t Scavenger::NumPretenuredClasses() const {
+  intptr_t count = 0;
+  for (intptr_t cid = 0; cid < survival_stats_.length(); cid++) {
+    if (survival_stats_[cid].pretenured) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void Scavenger::ApplyPretenuringDecisions(Thread* thread) {
+  MallocGrowableArray<intptr_t> cids;
+  {
+    MutexLocker ml(&pretenure_lock_);
+    while (!pending_pretenured_cids_.is_empty()) {
+      cids.Add(pending_pretenured_cids_.RemoveLast());
+    }
+  }
+#if !defined(DART_PRECOMPILED_RUNTIME)
+  // Precompiled allocation stubs cannot be replaced; there only the runtime
+  // fallback honors the decisions.
+  ClassTable* class_table = thread->isolate_group()->class_table();
+  Class& cls = Class::Handle(thread->zone());
+  for (intptr_t i = 0; i < cids.length(); i++) {
+    const intptr_t cid = cids[i];
+    if (!class_table->HasValidClassAt(cid)) {
+      continue;
+    }
+    cls = class_table->At(cid);
+    cls.DisableAllocationStub();
+  }
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+}
+
 void Scavenger::Scavenge() {
   int64_t start = OS::GetCurrentMonotonicMicros();
 
@@ -1602,11 +1895,17 @@ void Scavenger::Scavenge() {
   SemiSpace* from = Prologue();
 
   intptr_t bytes_promoted;
+  stolen_objects_ = 0;
+  idle_micros_ = 0;
+  ScavengerWeakMourner mourner(this, FLAG_scavenger_tasks);
   if (FLAG_scavenger_tasks == 0) {
     bytes_promoted = SerialScavenge(from);
   } else {
-    bytes_promoted = ParallelScavenge(from);
+    bytes_promoted = ParallelScavenge(from, &mourner);
   }
+  // Parallel scavenges have already mourned the weak handles and tables,
+  // unless they were aborted.
+  const bool mourn_weak = (FLAG_scavenger_tasks == 0) || abort_;
   if (abort_) {
     ReverseScavenge(&from);
     bytes_promoted = 0;
@@ -1616,17 +1915,26 @@ void Scavenger::Scavenge() {
     heap_->assume_scavenge_will_fail_ = true;
   }
   ASSERT(promotion_stack_.IsEmpty());
-  MournWeakHandles();
-  MournWeakTables();
+  if (mourn_weak) {
+    mourner.ProcessChunks(thread);
+    mourner.RehashTables(thread);
+  }
+  mourner.Finalize(thread);
+  if (FLAG_pretenure && !abort_) {
+    UpdatePretenuringFeedback(from);
+  }
 
   // Restore write-barrier assumptions.
   heap_->isolate_group()->RememberLiveTemporaries();
 
   // Scavenge finished. Run accounting.
   int64_t end = OS::GetCurrentMonotonicMicros();
+  heap_->RecordData(kStolenObjects, stolen_objects_);
+  heap_->RecordData(kIdleMicros, static_cast<intptr_t>(idle_micros_));
   stats_history_.Add(ScavengeStats(
       start, end, usage_before, GetCurrentUsage(), promo_candidate_words,
-      bytes_promoted >> kWordSizeLog2, abandoned_bytes >> kWordSizeLog2));
+      bytes_promoted >> kWordSizeLog2, abandoned_bytes >> kWordSizeLog2,
+      stolen_objects_, idle_micros_));
   Epilogue(from);
 
   if (FLAG_verify_after_gc) {
@@ -1656,11 +1964,18 @@ intptr_t Scavenger::SerialScavenge(SemiSpace* from) {
   return visitor.bytes_promoted();
 }
 
-intptr_t Scavenger::ParallelScavenge(SemiSpace* from) {
+intptr_t Scavenger::ParallelScavenge(SemiSpace* from,
+                                     ScavengerWeakMourner* mourner) {
   intptr_t bytes_promoted = 0;
   const intptr_t num_tasks = FLAG_scavenger_tasks;
   ASSERT(num_tasks > 0);
 
+  // Declared before the barrier so that it outlives all scavenger tasks.
+  std::unique_ptr<WorkStealingGroup> stealing_group;
+  if (FLAG_gc_work_stealing) {
+    stealing_group.reset(new WorkStealingGroup(num_tasks));
+  }
+
   ThreadBarrier barrier(num_tasks, heap_->barrier(), heap_->barrier_done());
   RelaxedAtomic<uintptr_t> num_busy = num_tasks;
 
@@ -1670,15 +1985,18 @@ intptr_t Scavenger::ParallelScavenge(SemiSpace* from) {
     FreeList* freelist = heap_->old_space()->DataFreeList(i);
     visitors[i] = new ParallelScavengerVisitor(
         heap_->isolate_group(), this, from, freelist, &promotion_stack_);
+    if (stealing_group != nullptr) {
+      visitors[i]->AttachToStealingGroup(stealing_group.get(), i);
+    }
     if (i < (num_tasks - 1)) {
       // Begin scavenging on a helper thread.
       bool result = Dart::thread_pool()->Run<ParallelScavengerTask>(
-          heap_->isolate_group(), &barrier, visitors[i], &num_busy);
+          heap_->isolate_group(), &barrier, visitors[i], mourner, &num_busy);
       ASSERT(result);
     } else {
       // Last worker is the main thread.
       ParallelScavengerTask task(heap_->isolate_group(), &barrier, visitors[i],
-                                 &num_busy);
+                                 mourner, &num_busy);
       task.RunEnteredIsolateGroup();
       barrier.Exit();
     }
@@ -1691,6 +2009,12 @@ intptr_t Scavenger::ParallelScavenge(SemiSpace* from) {
   }
 
   delete[] visitors;
+
+  // All tasks have passed their final barrier, so the counters are stable.
+  if (stealing_group != nullptr) {
+    stolen_objects_ = stealing_group->TotalSteals();
+    idle_micros_ = stealing_group->TotalIdleMicros();
+  }
   return bytes_promoted;
 }
 
@@ -1800,6 +2124,22 @@ void Scavenger::PrintToJSONObject(JSONObject* object) const {
   space.AddProperty64("capacity", CapacityInWords() * kWordSize);
   space.AddProperty64("external", ExternalInWords() * kWordSize);
   space.AddProperty("time", MicrosecondsToSeconds(gc_time_micros()));
+  if (FLAG_pretenure) {
+    ClassTable* class_table = isolate_group->class_table();
+    JSONArray pretenured(&space, "_pretenuredClasses");
+    for (intptr_t cid = 0; cid < survival_stats_.length(); cid++) {
+      const SurvivalStats& stats = survival_stats_[cid];
+      if (!stats.pretenured || !class_table->HasValidClassAt(cid)) {
+        continue;
+      }
+      JSONObject entry(&pretenured);
+      entry.AddProperty("class", Class::Handle(class_table->At(cid)));
+      entry.AddProperty64("_sampledBytes",
+                          stats.allocated_in_words * kWordSize);
+      entry.AddProperty64("_survivedBytes",
+                          stats.survived_in_words * kWordSize);
+    }
+  }
 }
 #endif  // !PRODUCT
 
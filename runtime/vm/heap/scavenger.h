@@ -11,6 +11,7 @@
 #include "vm/dart.h"
 #include "vm/flags.h"
 #include "vm/globals.h"
+#include "vm/growable_array.h"
 #include "vm/heap/spaces.h"
 #include "vm/lockers.h"
 #include "vm/raw_object.h"
@@ -27,6 +28,7 @@ class JSONObject;
 class ObjectSet;
 template <bool parallel>
 class ScavengerVisitorBase;
+class ScavengerWeakMourner;
 
 static constexpr intptr_t kNewPageSize = 512 * KB;
 static constexpr intptr_t kNewPageSizeInWords = kNewPageSize / kWordSize;
@@ -87,7 +89,7 @@ class NewPage {
   }
 
   // Remember the limit to which objects have been copied.
-  void RecordSurvivors() { survivor_end_ = object_end(); }
+  void RecordSurvivors() { survivor_end_ = allocation_start_ = object_end(); }
 
   // Move survivor end to the end of the to_ space, making all surviving
   // objects candidates for promotion next time.
@@ -135,6 +137,10 @@ class NewPage {
   bool IsSurvivor(uword raw_addr) const { return raw_addr < survivor_end_; }
   bool IsResolved() const { return top_ == resolved_top_; }
 
+  // Objects at or above this address were allocated by the mutator since the
+  // last scavenge. Unlike survivor_end_, not affected by early tenuring.
+  uword allocation_start() const { return allocation_start_; }
+
  private:
   VirtualMemory* memory_;
   NewPage* next_;
@@ -153,6 +159,9 @@ class NewPage {
   // Objects below this address have survived a scavenge.
   uword survivor_end_;
 
+  // Objects below this address were copied here by the last scavenge.
+  uword allocation_start_;
+
   // A pointer to the first unprocessed object. Resolution completes when this
   // value meets the allocation top. Called "SCAN" in the original Cheney paper.
   uword resolved_top_;
@@ -206,14 +215,18 @@ class ScavengeStats {
                 SpaceUsage after,
                 intptr_t promo_candidates_in_words,
                 intptr_t promoted_in_words,
-                intptr_t abandoned_in_words)
+                intptr_t abandoned_in_words,
+                intptr_t stolen_objects,
+                int64_t idle_micros)
       : start_micros_(start_micros),
         end_micros_(end_micros),
         before_(before),
         after_(after),
         promo_candidates_in_words_(promo_candidates_in_words),
         promoted_in_words_(promoted_in_words),
-        abandoned_in_words_(abandoned_in_words) {}
+        abandoned_in_words_(abandoned_in_words),
+        stolen_objects_(stolen_objects),
+        idle_micros_(idle_micros) {}
 
   // Of all data before scavenge, what fraction was found to be garbage?
   // If this scavenge included growth, assume the extra capacity would become
@@ -237,6 +250,11 @@ class ScavengeStats {
 
   int64_t DurationMicros() const { return end_micros_ - start_micros_; }
 
+  // Number of objects parallel workers stole from each other's deques
+  // (--gc_work_stealing), and the total time workers spent waiting for work.
+  intptr_t StolenObjects() const { return stolen_objects_; }
+  int64_t IdleMicros() const { return idle_micros_; }
+
  private:
   int64_t start_micros_;
   int64_t end_micros_;
@@ -245,6 +263,8 @@ class ScavengeStats {
   intptr_t promo_candidates_in_words_;
   intptr_t promoted_in_words_;
   intptr_t abandoned_in_words_;
+  intptr_t stolen_objects_;
+  int64_t idle_micros_;
 };
 
 class Scavenger {
@@ -354,6 +374,21 @@ class Scavenger {
 
   NewPage* head() const { return to_->head(); }
 
+  // Whether new instances of the class should be allocated directly in old
+  // space because most of them survive their first scavenge (--pretenure).
+  // Decisions only change during a scavenge, so reading them outside of a
+  // safepoint is fine.
+  bool ShouldPretenure(intptr_t cid) const {
+    return (cid < survival_stats_.length()) && survival_stats_[cid].pretenured;
+  }
+  intptr_t NumPretenuredClasses() const;
+
+  // Disables the allocation stubs of classes selected for pretenuring since
+  // the last call, so that they are regenerated without the inline new-space
+  // path. Must not be called at a safepoint.
+  void ApplyPretenuringDecisions(Thread* thread);
+  bool HasPendingPretenuringDecisions();
+
  private:
   // Ids for time and data records in Heap::GCStats.
   enum {
@@ -366,8 +401,8 @@ class Scavenger {
     kIterateWeaks = 5,
     // Data
     kStoreBufferEntries = 0,
-    kDataUnused1 = 1,
-    kDataUnused2 = 2,
+    kStolenObjects = 1,
+    kIdleMicros = 2,
     kToKBAfterStoreBuffer = 3
   };
 
@@ -389,7 +424,7 @@ class Scavenger {
   void TryAllocateNewTLAB(Thread* thread, intptr_t size);
 
   SemiSpace* Prologue();
-  intptr_t ParallelScavenge(SemiSpace* from);
+  intptr_t ParallelScavenge(SemiSpace* from, ScavengerWeakMourner* mourner);
   intptr_t SerialScavenge(SemiSpace* from);
   void ReverseScavenge(SemiSpace** from);
   void IterateIsolateRoots(ObjectPointerVisitor* visitor);
@@ -400,7 +435,6 @@ class Scavenger {
   void IterateObjectIdTable(ObjectPointerVisitor* visitor);
   template <bool parallel>
   void IterateRoots(ScavengerVisitorBase<parallel>* visitor);
-  void MournWeakHandles();
   void Epilogue(SemiSpace* from);
 
   bool IsUnreachable(ObjectPtr* p);
@@ -410,7 +444,7 @@ class Scavenger {
   void UpdateMaxHeapCapacity();
   void UpdateMaxHeapUsage();
 
-  void MournWeakTables();
+  void UpdatePretenuringFeedback(SemiSpace* from);
 
   intptr_t NewSizeInWords(intptr_t old_size_in_words) const;
 
@@ -439,9 +473,28 @@ class Scavenger {
   // The total size of external data associated with objects in this scavenger.
   RelaxedAtomic<intptr_t> external_size_;
 
+  // Work-stealing statistics of the current scavenge.
+  intptr_t stolen_objects_ = 0;
+  int64_t idle_micros_ = 0;
+
   RelaxedAtomic<bool> failed_to_promote_;
   RelaxedAtomic<bool> abort_;
 
+  // Per-class pretenuring feedback, indexed by cid. Counts the words
+  // allocated in new space and how many of them survived their first
+  // scavenge.
+  struct SurvivalStats {
+    intptr_t allocated_in_words;
+    intptr_t survived_in_words;
+    bool pretenured;
+  };
+  MallocGrowableArray<SurvivalStats> survival_stats_;
+
+  // Classes selected for pretenuring whose allocation stubs have not been
+  // disabled yet.
+  MallocGrowableArray<intptr_t> pending_pretenured_cids_;
+  Mutex pretenure_lock_;
+
   bool growth_control_;
 
   // Protects new space during the allocation of new TLABs
@@ -450,6 +503,7 @@ class Scavenger {
   template <bool>
   friend class ScavengerVisitorBase;
   friend class ScavengerWeakVisitor;
+  friend class ScavengerWeakMourner;
 
   DISALLOW_COPY_AND_ASSIGN(Scavenger);
 };
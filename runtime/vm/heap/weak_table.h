@@ -91,6 +91,21 @@ class WeakTable {
     SetValueAt(i, 0);
   }
 
+  // Like InvalidateAtExclusive, but leaves count() to be corrected with
+  // RemovedEntries. Lets several GC workers prune disjoint ranges of the same
+  // table in parallel.
+  void InvalidateAtParallel(intptr_t i) {
+    ASSERT(IsValidEntryAtExclusive(i));
+    data_[ObjectIndex(i)] = kDeletedEntry;
+    data_[ValueIndex(i)] = 0;
+  }
+
+  // Thread-safe.
+  void RemovedEntries(intptr_t n) {
+    MutexLocker ml(&mutex_);
+    set_count(count() - n);
+  }
+
   ObjectPtr ObjectAtExclusive(intptr_t i) const {
     ASSERT(i >= 0);
     ASSERT(i < size());
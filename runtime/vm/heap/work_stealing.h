@@ -0,0 +1,212 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_HEAP_WORK_STEALING_H_
+#define RUNTIME_VM_HEAP_WORK_STEALING_H_
+
+#include <atomic>
+
+#include "platform/assert.h"
+#include "platform/utils.h"
+#include "vm/allocation.h"
+#include "vm/globals.h"
+#include "vm/tagged_pointer.h"
+
+namespace dart {
+
+// A bounded Chase-Lev work-stealing deque.
+//
+// The owning worker pushes and pops at the bottom end, which only needs a CAS
+// when racing a thief for the last element. Any other worker may steal from
+// the top end. Memory orderings follow Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP'13).
+//
+// Unlike the original algorithm the backing array does not grow: Push fails
+// when the deque is full and the caller is expected to spill the element into
+// a shared overflow structure instead.
+template <typename T, intptr_t Capacity>
+class WorkStealingDeque {
+ public:
+  COMPILE_ASSERT(Utils::IsPowerOfTwo(Capacity));
+
+  WorkStealingDeque() : top_(0), bottom_(0) {}
+
+  // Owner only. Returns false if the deque is full.
+  bool Push(T value) {
+    const intptr_t b = bottom_.load(std::memory_order_relaxed);
+    const intptr_t t = top_.load(std::memory_order_acquire);
+    if ((b - t) >= Capacity) {
+      return false;
+    }
+    buffer_[b & kMask].store(value, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only. Returns false if the deque is empty.
+  bool Pop(T* value) {
+    const intptr_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    intptr_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      // Empty.
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    *value = buffer_[b & kMask].load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last element: race against thieves for it.
+      const bool won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Returns false if the deque is empty or another thread won the
+  // race for the top element.
+  bool Steal(T* value) {
+    intptr_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const intptr_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    *value = buffer_[t & kMask].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+  // Racy unless called by the owner while no thief is active.
+  intptr_t Size() const {
+    const intptr_t b = bottom_.load(std::memory_order_acquire);
+    const intptr_t t = top_.load(std::memory_order_acquire);
+    return b > t ? b - t : 0;
+  }
+  bool IsEmpty() const { return Size() == 0; }
+
+ private:
+  static constexpr intptr_t kMask = Capacity - 1;
+
+  // Thieves hammer top_ while the owner mostly touches bottom_; keep them on
+  // different cache lines.
+  alignas(64) std::atomic<intptr_t> top_;
+  alignas(64) std::atomic<intptr_t> bottom_;
+  std::atomic<T> buffer_[Capacity];
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+static constexpr intptr_t kWorkStealingDequeCapacity = 1024;
+typedef WorkStealingDeque<ObjectPtr, kWorkStealingDequeCapacity>
+    ObjectStealingDeque;
+
+// The deques of all workers of one parallel GC phase (scavenge or mark), plus
+// per-worker statistics. Each worker owns the deque at its index and steals
+// from the others when it runs dry.
+class WorkStealingGroup {
+ public:
+  explicit WorkStealingGroup(intptr_t num_workers)
+      : num_workers_(num_workers), workers_(new Worker[num_workers]) {
+    ASSERT(num_workers > 0);
+    for (intptr_t i = 0; i < num_workers; i++) {
+      workers_[i].next_victim = (i + 1) % num_workers;
+    }
+  }
+  ~WorkStealingGroup() {
+#if defined(DEBUG)
+    for (intptr_t i = 0; i < num_workers_; i++) {
+      ASSERT(workers_[i].deque.IsEmpty());
+    }
+#endif
+    delete[] workers_;
+  }
+
+  intptr_t num_workers() const { return num_workers_; }
+
+  ObjectStealingDeque* DequeAt(intptr_t worker) {
+    ASSERT((worker >= 0) && (worker < num_workers_));
+    return &workers_[worker].deque;
+  }
+
+  // Attempts to steal one object from any worker other than 'thief'. Victims
+  // are probed round-robin, starting with the last successful victim.
+  bool TrySteal(intptr_t thief, ObjectPtr* result) {
+    Worker* self = &workers_[thief];
+    intptr_t victim = self->next_victim;
+    for (intptr_t i = 0; i < num_workers_; i++) {
+      if (victim != thief && workers_[victim].deque.Steal(result)) {
+        self->next_victim = victim;
+        self->steals++;
+        return true;
+      }
+      victim = (victim + 1) % num_workers_;
+    }
+    self->failed_steals++;
+    return false;
+  }
+
+  // Whether any worker other than 'thief' appears to have stealable work.
+  bool HasStealableWork(intptr_t thief) const {
+    for (intptr_t i = 0; i < num_workers_; i++) {
+      if (i != thief && !workers_[i].deque.IsEmpty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void AddIdleMicros(intptr_t worker, int64_t micros) {
+    workers_[worker].idle_micros += micros;
+  }
+
+  // Only meaningful once all workers have finished.
+  intptr_t TotalSteals() const {
+    intptr_t result = 0;
+    for (intptr_t i = 0; i < num_workers_; i++) {
+      result += workers_[i].steals;
+    }
+    return result;
+  }
+  intptr_t TotalFailedSteals() const {
+    intptr_t result = 0;
+    for (intptr_t i = 0; i < num_workers_; i++) {
+      result += workers_[i].failed_steals;
+    }
+    return result;
+  }
+  int64_t TotalIdleMicros() const {
+    int64_t result = 0;
+    for (intptr_t i = 0; i < num_workers_; i++) {
+      result += workers_[i].idle_micros;
+    }
+    return result;
+  }
+  intptr_t StealsOf(intptr_t worker) const { return workers_[worker].steals; }
+  int64_t IdleMicrosOf(intptr_t worker) const {
+    return workers_[worker].idle_micros;
+  }
+
+ private:
+  struct alignas(64) Worker {
+    ObjectStealingDeque deque;
+    // Only written by the owning worker.
+    intptr_t next_victim = 0;
+    intptr_t steals = 0;
+    intptr_t failed_steals = 0;
+    int64_t idle_micros = 0;
+  };
+
+  const intptr_t num_workers_;
+  Worker* const workers_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingGroup);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_HEAP_WORK_STEALING_H_
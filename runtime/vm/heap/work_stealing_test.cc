@@ -0,0 +1,204 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <atomic>
+
+#include "platform/assert.h"
+#include "vm/heap/heap.h"
+#include "vm/heap/work_stealing.h"
+#include "vm/lockers.h"
+#include "vm/object.h"
+#include "vm/thread_pool.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+static ObjectPtr Item(intptr_t i) {
+  return Smi::New(i);
+}
+
+static intptr_t ValueOf(ObjectPtr obj) {
+  return Smi::Value(static_cast<SmiPtr>(obj));
+}
+
+VM_UNIT_TEST_CASE(WorkStealingDeque_OwnerIsLifoThiefIsFifo) {
+  WorkStealingDeque<ObjectPtr, 8> deque;
+  ObjectPtr obj;
+  EXPECT(deque.IsEmpty());
+  EXPECT(!deque.Pop(&obj));
+  EXPECT(!deque.Steal(&obj));
+
+  for (intptr_t i = 0; i < 8; i++) {
+    EXPECT(deque.Push(Item(i)));
+  }
+  // Bounded: the ninth push is rejected.
+  EXPECT(!deque.Push(Item(8)));
+  EXPECT_EQ(8, deque.Size());
+
+  EXPECT(deque.Pop(&obj));
+  EXPECT_EQ(7, ValueOf(obj));
+  EXPECT(deque.Steal(&obj));
+  EXPECT_EQ(0, ValueOf(obj));
+  EXPECT(deque.Steal(&obj));
+  EXPECT_EQ(1, ValueOf(obj));
+
+  // The freed slots can be reused after wrapping around.
+  EXPECT(deque.Push(Item(100)));
+  EXPECT(deque.Push(Item(101)));
+  EXPECT(deque.Push(Item(102)));
+  EXPECT(!deque.Push(Item(103)));
+
+  intptr_t popped = 0;
+  while (deque.Pop(&obj)) {
+    popped++;
+  }
+  EXPECT_EQ(8, popped);
+  EXPECT(deque.IsEmpty());
+}
+
+class StealingTask : public ThreadPool::Task {
+ public:
+  StealingTask(ObjectStealingDeque* deque,
+               std::atomic<bool>* owner_done,
+               std::atomic<intptr_t>* sum,
+               std::atomic<intptr_t>* count,
+               Monitor* monitor,
+               intptr_t* exited)
+      : deque_(deque),
+        owner_done_(owner_done),
+        sum_(sum),
+        count_(count),
+        monitor_(monitor),
+        exited_(exited) {}
+
+  virtual void Run() {
+    ObjectPtr obj;
+    for (;;) {
+      const bool done = owner_done_->load();
+      if (deque_->Steal(&obj)) {
+        sum_->fetch_add(ValueOf(obj));
+        count_->fetch_add(1);
+      } else if (done && deque_->IsEmpty()) {
+        break;
+      }
+    }
+    MonitorLocker ml(monitor_);
+    ++*exited_;
+    ml.Notify();
+  }
+
+ private:
+  ObjectStealingDeque* deque_;
+  std::atomic<bool>* owner_done_;
+  std::atomic<intptr_t>* sum_;
+  std::atomic<intptr_t>* count_;
+  Monitor* monitor_;
+  intptr_t* exited_;
+};
+
+// Every pushed element is consumed exactly once, either by the owner or by
+// one of the thieves.
+VM_UNIT_TEST_CASE(WorkStealingDeque_ConcurrentSteal) {
+  const intptr_t kThieves = 3;
+  const intptr_t kItems = 200000;
+  ObjectStealingDeque* deque = new ObjectStealingDeque();
+  std::atomic<bool> owner_done(false);
+  std::atomic<intptr_t> sum(0);
+  std::atomic<intptr_t> count(0);
+  Monitor monitor;
+  intptr_t exited = 0;
+
+  for (intptr_t i = 0; i < kThieves; i++) {
+    Dart::thread_pool()->Run<StealingTask>(deque, &owner_done, &sum, &count,
+                                           &monitor, &exited);
+  }
+
+  ObjectPtr obj;
+  intptr_t next = 1;
+  while (next <= kItems) {
+    // Push a burst, then consume part of it ourselves.
+    for (intptr_t i = 0; i < 16 && next <= kItems; i++) {
+      if (!deque->Push(Item(next))) break;
+      next++;
+    }
+    for (intptr_t i = 0; i < 8; i++) {
+      if (!deque->Pop(&obj)) break;
+      sum.fetch_add(ValueOf(obj));
+      count.fetch_add(1);
+    }
+  }
+  while (deque->Pop(&obj)) {
+    sum.fetch_add(ValueOf(obj));
+    count.fetch_add(1);
+  }
+  owner_done.store(true);
+
+  {
+    MonitorLocker ml(&monitor);
+    while (exited < kThieves) {
+      ml.Wait();
+    }
+  }
+  EXPECT_EQ(kItems, count.load());
+  EXPECT_EQ(kItems * (kItems + 1) / 2, sum.load());
+  delete deque;
+}
+
+VM_UNIT_TEST_CASE(WorkStealingGroup_StealsFromPeers) {
+  WorkStealingGroup group(3);
+  ObjectPtr obj;
+  EXPECT(!group.HasStealableWork(0));
+  EXPECT(!group.TrySteal(0, &obj));
+
+  group.DequeAt(2)->Push(Item(42));
+  // A worker never steals from itself.
+  EXPECT(!group.HasStealableWork(2));
+  EXPECT(!group.TrySteal(2, &obj));
+  EXPECT(group.HasStealableWork(0));
+  EXPECT(group.TrySteal(0, &obj));
+  EXPECT_EQ(42, ValueOf(obj));
+
+  EXPECT_EQ(1, group.TotalSteals());
+  EXPECT_EQ(1, group.StealsOf(0));
+  EXPECT_EQ(2, group.TotalFailedSteals());
+}
+
+static void BuildAndCollectDeepGraph(Thread* thread) {
+  // A long chain of arrays is the worst case for block-granular sharing: it
+  // only ever exposes one object at a time.
+  const intptr_t kLength = 100000;
+  Array& head = Array::Handle(Array::New(2));
+  Array& current = Array::Handle();
+  Array& next = Array::Handle();
+  current = head.ptr();
+  for (intptr_t i = 0; i < kLength; i++) {
+    next = Array::New(2);
+    next.SetAt(0, Smi::Handle(Smi::New(i)));
+    current.SetAt(1, next);
+    current = next.ptr();
+  }
+
+  GCTestHelper::CollectNewSpace();
+  GCTestHelper::CollectNewSpace();
+  GCTestHelper::CollectAllGarbage();
+
+  intptr_t length = 0;
+  current = head.ptr();
+  Object& link = Object::Handle();
+  for (;;) {
+    link = current.At(1);
+    if (link.IsNull()) break;
+    current ^= link.ptr();
+    EXPECT_EQ(length, Smi::Value(Smi::RawCast(current.At(0))));
+    length++;
+  }
+  EXPECT_EQ(kLength, length);
+}
+
+ISOLATE_UNIT_TEST_CASE(WorkStealingGC_PreservesDeepGraph) {
+  SetFlagScope<bool> sfs(&FLAG_gc_work_stealing, true);
+  BuildAndCollectDeepGraph(thread);
+}
+
+}  // namespace dart
@@ -37,6 +37,7 @@
 #include "vm/os_thread.h"
 #include "vm/port.h"
 #include "vm/profiler.h"
+#include "vm/profiler_service.h"
 #include "vm/reusable_handles.h"
 #include "vm/reverse_pc_lookup_cache.h"
 #include "vm/service.h"
@@ -54,7 +55,9 @@
 
 #if !defined(DART_PRECOMPILED_RUNTIME)
 #include "vm/compiler/assembler/assembler.h"
+#include "vm/compiler/function_order.h"
 #include "vm/compiler/stub_code_compiler.h"
+#include "vm/compiler/type_feedback.h"
 #endif
 
 namespace dart {
@@ -610,6 +613,7 @@ void IsolateGroup::UnscheduleThreadLocked(MonitorLocker* ml,
                                           bool is_mutator,
                                           bool bypass_safepoint) {
   thread->heap()->new_space()->AbandonRemainingTLAB(thread);
+  thread->heap()->old_space()->AbandonTLAB(thread);
 
   // Clear since GC will not visit the thread once it is unscheduled. Do this
   // under the thread lock to prevent races with the GC visiting thread roots.
@@ -1322,6 +1326,9 @@ MessageHandler::MessageStatus IsolateMessageHandler::HandleMessage(
   tbes.SetNumArguments(1);
   tbes.CopyArgument(0, "isolateName", I->name());
 #endif
+#if !defined(PRODUCT)
+  ProfilerService::WriteProfileIfDue(thread, /*force=*/false);
+#endif
 
   // If the message is in band we lookup the handler to dispatch to.  If the
   // receive port was closed, we drop the message without deserializing it.
@@ -2496,6 +2503,7 @@ void Isolate::Shutdown() {
     ServiceIsolate::SendIsolateShutdownMessage();
 #if !defined(PRODUCT)
     debugger()->Shutdown();
+    ProfilerService::WriteProfileIfDue(thread, /*force=*/true);
 #endif
   }
 
@@ -2574,6 +2582,8 @@ void Isolate::LowLevelCleanup(Isolate* isolate) {
       Thread::EnterIsolateGroupAsHelper(isolate_group, Thread::kUnknownTask,
                                         /*bypass_safepoint=*/false);
       BackgroundCompiler::Stop(isolate_group);
+      FunctionOrder::WriteIfRequested(Thread::Current());
+      TypeFeedback::WriteIfRequested(Thread::Current());
       Thread::ExitIsolateGroupAsHelper(/*bypass_safepoint=*/false);
     }
 #endif  // !defined(DART_PRECOMPILED_RUNTIME)
@@ -2882,6 +2892,12 @@ void IsolateGroup::VisitWeakPersistentHandles(HandleVisitor* visitor) {
   api_state()->VisitWeakHandlesUnlocked(visitor);
 }
 
+void IsolateGroup::VisitWeakPersistentHandlesChunk(HandleVisitor* visitor,
+                                                   intptr_t chunk,
+                                                   intptr_t num_chunks) {
+  api_state()->VisitWeakHandlesChunkUnlocked(visitor, chunk, num_chunks);
+}
+
 void IsolateGroup::DeferredMarkLiveTemporaries() {
   ForEachIsolate(
       [&](Isolate* isolate) { isolate->DeferredMarkLiveTemporaries(); },
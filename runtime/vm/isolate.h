@@ -743,6 +743,9 @@ class IsolateGroup : public IntrusiveDListEntry<IsolateGroup> {
                           ValidationPolicy validate_frames);
   void VisitObjectIdRingPointers(ObjectPointerVisitor* visitor);
   void VisitWeakPersistentHandles(HandleVisitor* visitor);
+  void VisitWeakPersistentHandlesChunk(HandleVisitor* visitor,
+                                       intptr_t chunk,
+                                       intptr_t num_chunks);
 
   bool compaction_in_progress() const {
     return CompactionInProgressBit::decode(isolate_group_flags_);
@@ -1145,6 +1148,17 @@ class Isolate : public BaseIsolate, public IntrusiveDListEntry<Isolate> {
 
   int64_t last_resume_timestamp() const { return last_resume_timestamp_; }
 
+  // The end of the time range covered by the last profile written for
+  // --profile_output, and the number of profiles written so far.
+  int64_t last_profile_output_micros() const {
+    return last_profile_output_micros_;
+  }
+  void set_last_profile_output_micros(int64_t micros) {
+    last_profile_output_micros_ = micros;
+  }
+  intptr_t profile_output_count() const { return profile_output_count_; }
+  void increment_profile_output_count() { profile_output_count_++; }
+
   // Returns whether the vm service has requested that the debugger
   // resume execution.
   bool GetAndClearResumeRequest() {
@@ -1571,6 +1585,8 @@ class Isolate : public BaseIsolate, public IntrusiveDListEntry<Isolate> {
 #if !defined(PRODUCT)
   Debugger* debugger_ = nullptr;
   int64_t last_resume_timestamp_;
+  int64_t last_profile_output_micros_ = 0;
+  intptr_t profile_output_count_ = 0;
 
   VMTagCounters vm_tag_counters_;
 
@@ -186,6 +186,40 @@ void MessageQueue::Clear() {
   }
 }
 
+bool MessageInbox::Push(std::unique_ptr<Message> msg0) {
+  Message* msg = msg0.release();
+  // Make sure messages are not reused.
+  ASSERT(msg->next_ == nullptr);
+  Message* head = head_.load(std::memory_order_relaxed);
+  do {
+    msg->next_ = head;
+  } while (!head_.compare_exchange_weak(head, msg, std::memory_order_release,
+                                        std::memory_order_relaxed));
+  return head == nullptr;
+}
+
+void MessageInbox::DrainTo(MessageQueue* queue) {
+  if (IsEmpty()) {
+    return;
+  }
+  // The stack holds the newest message first.
+  Message* newest_first = head_.exchange(nullptr);
+  Message* oldest_first = nullptr;
+  while (newest_first != nullptr) {
+    Message* next = newest_first->next_;
+    newest_first->next_ = oldest_first;
+    oldest_first = newest_first;
+    newest_first = next;
+  }
+  while (oldest_first != nullptr) {
+    Message* next = oldest_first->next_;
+    oldest_first->next_ = nullptr;
+    queue->Enqueue(std::unique_ptr<Message>(oldest_first),
+                   /*before_events=*/false);
+    oldest_first = next;
+  }
+}
+
 MessageQueue::Iterator::Iterator(const MessageQueue* queue) : next_(NULL) {
   Reset(queue);
 }
@@ -9,6 +9,7 @@
 #include <utility>
 
 #include "platform/assert.h"
+#include "platform/atomic.h"
 #include "vm/allocation.h"
 #include "vm/finalizable_data.h"
 #include "vm/globals.h"
@@ -135,6 +136,7 @@ class Message {
   static intptr_t const kPersistentHandleSnapshotLen = -1;
 
   friend class MessageQueue;
+  friend class MessageInbox;
 
   Message* next_ = nullptr;
   Dart_Port dest_port_;
@@ -205,6 +207,33 @@ class MessageQueue {
   DISALLOW_COPY_AND_ASSIGN(MessageQueue);
 };
 
+// A lock-free multi-producer single-consumer inbox of messages.
+//
+// Producers push onto an intrusive stack linked through [Message::next_].
+// The consumer takes the whole stack at once and appends it to a
+// [MessageQueue], oldest message first, so messages from any one producer
+// keep their order.
+class MessageInbox {
+ public:
+  MessageInbox() : head_(nullptr) {}
+  ~MessageInbox() { ASSERT(IsEmpty()); }
+
+  // Can be called from any thread. Returns true if the inbox was empty, in
+  // which case the caller is responsible for waking up the consumer.
+  bool Push(std::unique_ptr<Message> msg);
+
+  // Moves all messages pushed so far to the tail of [queue]. Must only be
+  // called by the consumer.
+  void DrainTo(MessageQueue* queue);
+
+  bool IsEmpty() const { return head_.load() == nullptr; }
+
+ private:
+  AcqRelAtomic<Message*> head_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageInbox);
+};
+
 }  // namespace dart
 
 #endif  // RUNTIME_VM_MESSAGE_H_
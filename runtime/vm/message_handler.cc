@@ -79,6 +79,7 @@ MessageHandler::MessageHandler()
 }
 
 MessageHandler::~MessageHandler() {
+  DrainInboxLocked();
   delete queue_;
   delete oob_queue_;
   queue_ = NULL;
@@ -124,6 +125,19 @@ void MessageHandler::Run(ThreadPool* pool,
 
 void MessageHandler::PostMessage(std::unique_ptr<Message> message,
                                  bool before_events) {
+  if (!message->IsOOB() && !before_events && !FLAG_trace_isolates) {
+    // Fast path for normal messages. Only the poster that finds the inbox
+    // empty has to take the monitor to wake up the handler; everybody else
+    // piggybacks on that wakeup, so a busy handler drains many messages per
+    // task without contending with its posters.
+    if (inbox_.Push(std::move(message))) {
+      MonitorLocker ml(&monitor_);
+      WakeUpLocked(&ml);
+    }
+    MessageNotify(Message::kNormalPriority);
+    return;
+  }
+
   Message::Priority saved_priority;
 
   {
@@ -153,30 +167,40 @@ void MessageHandler::PostMessage(std::unique_ptr<Message> message,
     if (message->IsOOB()) {
       oob_queue_->Enqueue(std::move(message), before_events);
     } else {
+      // Keep the order with respect to messages posted through the inbox.
+      DrainInboxLocked();
       queue_->Enqueue(std::move(message), before_events);
     }
-    if (paused_for_messages_) {
-      ml.Notify();
-    }
-
-    if (pool_ != nullptr && !task_running_) {
-      ASSERT(!delete_me_);
-      task_running_ = true;
-      const bool launched_successfully = pool_->Run<MessageHandlerTask>(this);
-      ASSERT(launched_successfully);
-    }
+    WakeUpLocked(&ml);
   }
 
   // Invoke any custom message notification.
   MessageNotify(saved_priority);
 }
 
+void MessageHandler::WakeUpLocked(MonitorLocker* ml) {
+  if (paused_for_messages_) {
+    ml->Notify();
+  }
+
+  if (pool_ != nullptr && !task_running_) {
+    ASSERT(!delete_me_);
+    task_running_ = true;
+    const bool launched_successfully = pool_->Run<MessageHandlerTask>(this);
+    ASSERT(launched_successfully);
+  }
+}
+
 std::unique_ptr<Message> MessageHandler::DequeueMessage(
     Message::Priority min_priority) {
   // TODO(turnidge): Add assert that monitor_ is held here.
   std::unique_ptr<Message> message = oob_queue_->Dequeue();
   if ((message == nullptr) && (min_priority < Message::kOOBPriority)) {
     message = queue_->Dequeue();
+    if (message == nullptr) {
+      DrainInboxLocked();
+      message = queue_->Dequeue();
+    }
   }
   return message;
 }
@@ -303,7 +327,7 @@ MessageHandler::MessageStatus MessageHandler::PauseAndHandleAllMessages(
   CheckAccess();
 #endif
   paused_for_messages_ = true;
-  while (queue_->IsEmpty() && oob_queue_->IsEmpty()) {
+  while (queue_->IsEmpty() && inbox_.IsEmpty() && oob_queue_->IsEmpty()) {
     Monitor::WaitResult wr;
     {
       // Ensure this thread is at a safepoint while we wait for new messages to
@@ -316,7 +340,7 @@ MessageHandler::MessageStatus MessageHandler::PauseAndHandleAllMessages(
     if (wr == Monitor::kTimedOut) {
       break;
     }
-    if (queue_->IsEmpty()) {
+    if (queue_->IsEmpty() && inbox_.IsEmpty()) {
       // There are only OOB messages. Handle them and then continue waiting for
       // normal messages unless there is an error.
       MessageStatus status = HandleMessages(&ml, false, false);
@@ -373,7 +397,7 @@ bool MessageHandler::HasOOBMessages() {
 
 bool MessageHandler::HasMessages() {
   MonitorLocker ml(&monitor_);
-  return !queue_->IsEmpty();
+  return !queue_->IsEmpty() || !inbox_.IsEmpty();
 }
 
 void MessageHandler::TaskCallback() {
@@ -534,6 +558,7 @@ void MessageHandler::CloseAllPorts() {
         "\thandler:    %s\n",
         name());
   }
+  DrainInboxLocked();
   queue_->Clear();
   oob_queue_->Clear();
 }
@@ -640,6 +665,7 @@ void MessageHandler::PausedOnExitLocked(MonitorLocker* ml, bool paused) {
 MessageHandler::AcquiredQueues::AcquiredQueues(MessageHandler* handler)
     : handler_(handler), ml_(&handler->monitor_) {
   ASSERT(handler != NULL);
+  handler_->DrainInboxLocked();
   handler_->oob_message_handling_allowed_ = false;
 }
 
@@ -239,22 +239,36 @@ class MessageHandler {
 
   void ClearOOBQueue();
 
+  // Moves the messages posted through [inbox_] to [queue_].
+  void DrainInboxLocked() { inbox_.DrainTo(queue_); }
+
+  // Makes sure the posted messages get handled, either by the paused handler
+  // or by a (new) task on the thread pool.
+  void WakeUpLocked(MonitorLocker* ml);
+
   // Handles any pending messages.
   MessageStatus HandleMessages(MonitorLocker* ml,
                                bool allow_normal_messages,
                                bool allow_multiple_normal_messages);
 
-  Monitor monitor_;  // Protects all fields in MessageHandler.
+  Monitor monitor_;  // Protects all fields in MessageHandler but [inbox_].
   MessageQueue* queue_;
   MessageQueue* oob_queue_;
+  // Normal priority messages are posted here without taking [monitor_]. They
+  // are moved to [queue_] by whichever thread holds [monitor_] next and looks
+  // for messages.
+  MessageInbox inbox_;
   // This flag is not thread safe and can only reliably be accessed on a single
   // thread.
   bool oob_message_handling_allowed_;
   bool paused_for_messages_;
-  PortSet<PortSetEntry>
-      ports_;  // Only accessed by [PortMap], protected by [PortMap]s lock.
-  intptr_t live_ports_;  // The number of open ports, including control ports.
-  intptr_t paused_;      // The number of pause messages received.
+  // Only accessed by [PortMap], protected by [ports_mutex_].
+  PortSet<PortSetEntry> ports_;
+  Mutex ports_mutex_;
+  // The number of open ports, including control ports. Changed by [PortMap]
+  // under [ports_mutex_].
+  intptr_t live_ports_;
+  intptr_t paused_;  // The number of pause messages received.
 #if !defined(PRODUCT)
   bool should_pause_on_start_;
   bool should_pause_on_exit_;
@@ -24,7 +24,10 @@ class MessageHandlerTestPeer {
   void increment_live_ports() { handler_->increment_live_ports(); }
   void decrement_live_ports() { handler_->decrement_live_ports(); }
 
-  MessageQueue* queue() const { return handler_->queue_; }
+  MessageQueue* queue() const {
+    handler_->DrainInboxLocked();
+    return handler_->queue_;
+  }
   MessageQueue* oob_queue() const { return handler_->oob_queue_; }
 
  private:
@@ -409,4 +412,59 @@ VM_UNIT_TEST_CASE(MessageHandler_Run) {
   OSThread::Join(info.join_id);
 }
 
+// Several threads posting to the same handler concurrently. Every message is
+// handled exactly once and the messages of each sender in the order they
+// were sent.
+VM_UNIT_TEST_CASE(MessageHandler_ConcurrentPosters) {
+  const int kSenders = 4;
+  const int kMessagesPerSender = 100;
+  TestMessageHandler handler;
+  ThreadPool pool;
+  MessageHandlerTestPeer handler_peer(&handler);
+  handler_peer.increment_live_ports();
+  handler.Run(&pool, TestStartFunction, TestEndFunction,
+              reinterpret_cast<uword>(&handler));
+
+  Dart_Port ports[kSenders][kMessagesPerSender];
+  ThreadStartInfo infos[kSenders];
+  for (int i = 0; i < kSenders; i++) {
+    for (int j = 0; j < kMessagesPerSender; j++) {
+      ports[i][j] = PortMap::CreatePort(&handler);
+    }
+    infos[i].handler = &handler;
+    infos[i].ports = ports[i];
+    infos[i].count = kMessagesPerSender;
+    infos[i].join_id = OSThread::kInvalidThreadJoinId;
+    OSThread::Start("SendMessages", SendMessages,
+                    reinterpret_cast<uword>(&infos[i]));
+  }
+
+  {
+    MonitorLocker ml(handler.monitor());
+    while (handler.message_count() < kSenders * kMessagesPerSender) {
+      ml.Wait();
+    }
+    EXPECT_EQ(kSenders * kMessagesPerSender, handler.message_count());
+    int next[kSenders] = {0};
+    Dart_Port* handled = handler.port_buffer();
+    for (int k = 0; k < kSenders * kMessagesPerSender; k++) {
+      bool found = false;
+      for (int i = 0; i < kSenders && !found; i++) {
+        if ((next[i] < kMessagesPerSender) &&
+            (handled[k] == ports[i][next[i]])) {
+          next[i]++;
+          found = true;
+        }
+      }
+      EXPECT(found);
+    }
+    handler_peer.decrement_live_ports();
+  }
+
+  for (int i = 0; i < kSenders; i++) {
+    ASSERT(infos[i].join_id != OSThread::kInvalidThreadJoinId);
+    OSThread::Join(infos[i].join_id);
+  }
+}
+
 }  // namespace dart
@@ -3769,6 +3769,11 @@ FunctionPtr Function::GetMethodExtractor(const String& getter_name) const {
   Function& result = Function::Handle(
       Resolver::ResolveDynamicFunction(thread->zone(), owner, getter_name));
   if (result.IsNull()) {
+    if (Compiler::IsBackgroundCompilation()) {
+      // Only the mutator adds functions to classes, see Class::AddFunction.
+      Compiler::AbortBackgroundCompilation(DeoptId::kNone,
+                                           "Method extractor not created yet");
+    }
     SafepointWriteRwLocker ml(thread, group->program_lock());
     result = owner.LookupDynamicFunctionUnsafe(getter_name);
     if (result.IsNull()) {
@@ -3942,6 +3947,12 @@ FunctionPtr Function::GetDynamicInvocationForwarder(
   if (!allow_add) {
     return needs_dyn_forwarder ? Function::null() : ptr();
   }
+  if (Compiler::IsBackgroundCompilation()) {
+    // Leave growing the dispatcher cache to the mutator, so the order of its
+    // entries doesn't depend on compiler thread timing.
+    Compiler::AbortBackgroundCompilation(DeoptId::kNone,
+                                         "Dynamic forwarder not created yet");
+  }
 
   // If we failed to find it and possibly need to create it, use a write lock.
   SafepointWriteRwLocker ml(thread, thread->isolate_group()->program_lock());
@@ -3628,11 +3628,14 @@ class Function : public Object {
 // a hoisted check class instruction.
 // 'ProhibitsBoundsCheckGeneralization' is true if this function deoptimized
 // before on a generalized bounds check.
+// 'BaselineOptimized' is true if the last optimized code installed for this
+// function was compiled by the baseline tier of the JIT.
 #define STATE_BITS_LIST(V)                                                     \
   V(WasCompiled)                                                               \
   V(WasExecutedBit)                                                            \
   V(ProhibitsHoistingCheckClass)                                               \
-  V(ProhibitsBoundsCheckGeneralization)
+  V(ProhibitsBoundsCheckGeneralization)                                        \
+  V(BaselineOptimized)
 
   enum StateBits {
 #define DECLARE_FLAG_POS(Name) k##Name##Pos,
@@ -7517,6 +7520,7 @@ class Instance : public Object {
   friend class ClassDeserializationCluster;  // vtable
   friend class InstanceMorpher;
   friend class Obfuscator;  // RawGetFieldAtOffset, RawSetFieldAtOffset
+  friend class ObjectGraphCopier;  // RawGetFieldAtOffset, RawSetFieldAtOffset
 };
 
 class LibraryPrefix : public Instance {
@@ -11050,6 +11054,7 @@ class LinkedHashMap : public Instance {
 
   friend class Class;
   friend class LinkedHashMapDeserializationCluster;
+  friend class ObjectGraphCopier;  // NewUninitialized
 };
 
 class Closure : public Instance {
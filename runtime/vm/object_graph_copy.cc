@@ -0,0 +1,377 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/object_graph_copy.h"
+
+#include "vm/dart_api_state.h"
+#include "vm/handles.h"
+#include "vm/heap/weak_table.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/object_store.h"
+#include "vm/timeline.h"
+
+namespace dart {
+
+// This function's name can appear in Observatory.
+static void CopiedTypedDataFinalizer(void* isolate_callback_data,
+                                     void* buffer) {
+  free(buffer);
+}
+
+// Objects which can be referenced from both the sending and the receiving
+// isolate, because neither of them can observe a difference to a copy.
+static bool CanShareObject(ObjectPtr obj) {
+  if (!obj->IsHeapObject() || obj->untag()->IsCanonical() ||
+      obj->untag()->InVMIsolateHeap()) {
+    return true;
+  }
+  const intptr_t cid = obj->GetClassId();
+  if (IsStringClassId(cid)) {
+    return true;
+  }
+  switch (cid) {
+    case kMintCid:
+    case kDoubleCid:
+    case kFloat32x4Cid:
+    case kInt32x4Cid:
+    case kFloat64x2Cid:
+    case kBoolCid:
+    case kSendPortCid:
+    case kCapabilityCid:
+    case kTypeArgumentsCid:
+    case kTypeCid:
+    case kFunctionTypeCid:
+    case kTypeRefCid:
+    case kTypeParameterCid:
+      return true;
+    case kClosureCid:
+      // Only closures of static functions can be sent and those do not
+      // capture any state.
+      return Function::IsImplicitStaticClosureFunction(
+          Closure::RawCast(obj)->untag()->function());
+    default:
+      return false;
+  }
+}
+
+// Copies a message object graph from one isolate's point of view to
+// another's within a single heap.
+//
+// Copies are allocated with the ordinary (GC-safe) allocation functions. The
+// mapping from original to copy is kept in the isolate's forward tables,
+// which the GC keeps up to date when it moves the originals, with the copies
+// themselves kept alive by [from_to_].
+class ObjectGraphCopier : public ValueObject {
+ public:
+  explicit ObjectGraphCopier(Thread* thread)
+      : thread_(thread),
+        zone_(thread->zone()),
+        isolate_(thread->isolate()),
+        set_cid_(Class::Handle(thread->zone(), thread->isolate_group()
+                                                   ->object_store()
+                                                   ->linked_hash_set_class())
+                     .id()),
+        from_to_(GrowableObjectArray::Handle(zone_,
+                                             GrowableObjectArray::New())),
+        objects_to_rehash_(GrowableObjectArray::Handle(zone_)),
+        transferables_(GrowableObjectArray::Handle(zone_)),
+        failed_(false) {
+    ASSERT(isolate_->forward_table_new() == nullptr);
+    ASSERT(isolate_->forward_table_old() == nullptr);
+    isolate_->set_forward_table_new(new WeakTable());
+    isolate_->set_forward_table_old(new WeakTable());
+  }
+
+  ~ObjectGraphCopier() {
+    isolate_->set_forward_table_new(nullptr);
+    isolate_->set_forward_table_old(nullptr);
+  }
+
+  ArrayPtr Copy(const Object& root) {
+    const Object& copy = Object::Handle(zone_, Forward(root));
+    Object& from = Object::Handle(zone_);
+    Object& to = Object::Handle(zone_);
+    for (intptr_t i = 0; !failed_ && (i < from_to_.Length()); i += 2) {
+      HANDLESCOPE(thread_);
+      from = from_to_.At(i);
+      to = from_to_.At(i + 1);
+      CopyContents(from, to);
+    }
+    if (failed_) {
+      ReleaseTransferables(/*from_copies=*/true);
+      return Array::null();
+    }
+    ReleaseTransferables(/*from_copies=*/false);
+
+    const Array& result = Array::Handle(zone_, Array::New(2));
+    result.SetAt(0, copy);
+    result.SetAt(1, objects_to_rehash_);
+    return result.ptr();
+  }
+
+ private:
+  WeakTable* ForwardTableFor(ObjectPtr obj) const {
+    return obj->IsNewObject() ? isolate_->forward_table_new()
+                              : isolate_->forward_table_old();
+  }
+
+  // Returns the object the receiver should see in place of [from], copying it
+  // if it has not been copied before. The contents of new copies are filled in
+  // later by [CopyContents].
+  ObjectPtr Forward(const Object& from) {
+    if (failed_) {
+      return Object::null();
+    }
+    if (CanShareObject(from.ptr())) {
+      return from.ptr();
+    }
+    const intptr_t index = ForwardTableFor(from.ptr())->GetValueExclusive(
+        from.ptr());
+    if (index != 0) {
+      return from_to_.At(index);
+    }
+
+    const Object& to = Object::Handle(zone_, AllocateCopy(from));
+    if (failed_) {
+      return Object::null();
+    }
+    from_to_.Add(from);
+    from_to_.Add(to);
+    // The allocations above may have moved [from].
+    ForwardTableFor(from.ptr())->SetValueExclusive(from.ptr(),
+                                                   from_to_.Length() - 1);
+    return to.ptr();
+  }
+
+  ObjectPtr AllocateCopy(const Object& from) {
+    const intptr_t cid = from.GetClassId();
+    if (IsTypedDataClassId(cid)) {
+      return TypedData::New(cid, TypedData::Cast(from).Length());
+    }
+    if (IsExternalTypedDataClassId(cid)) {
+      const auto& src = ExternalTypedData::Cast(from);
+      const intptr_t length_in_bytes = src.LengthInBytes();
+      uint8_t* data = reinterpret_cast<uint8_t*>(malloc(length_in_bytes));
+      memmove(data, src.DataAddr(0), length_in_bytes);
+      const auto& dst = ExternalTypedData::Handle(
+          zone_, ExternalTypedData::New(cid, data, src.Length()));
+      dst.AddFinalizer(data, &CopiedTypedDataFinalizer, length_in_bytes);
+      return dst.ptr();
+    }
+    if (IsTypedDataViewClassId(cid)) {
+      return TypedDataView::New(cid);
+    }
+    switch (cid) {
+      case kArrayCid:
+        return Array::New(Array::Cast(from).Length());
+      case kImmutableArrayCid:
+        return ImmutableArray::New(Array::Cast(from).Length());
+      case kGrowableObjectArrayCid:
+        return GrowableObjectArray::New(Object::empty_array());
+      case kLinkedHashMapCid:
+        return LinkedHashMap::NewUninitialized();
+      case kTransferableTypedDataCid:
+        return TransferTypedData(from);
+      default:
+        break;
+    }
+    if ((cid == kInstanceCid) || (cid >= kNumPredefinedCids)) {
+      const Class& cls =
+          Class::Handle(zone_, isolate_->group()->class_table()->At(cid));
+      if (cls.num_native_fields() == 0) {
+        return Instance::New(cls);
+      }
+    }
+    // Closures of non-static functions, native wrappers, receive ports, ...
+    failed_ = true;
+    return Object::null();
+  }
+
+  // The receiver takes over the external data of [from]. The sender only
+  // loses it once the whole graph has been copied, see
+  // [ReleaseTransferables].
+  ObjectPtr TransferTypedData(const Object& from) {
+    auto tpeer = reinterpret_cast<TransferableTypedDataPeer*>(
+        thread_->heap()->GetPeer(from.ptr()));
+    ASSERT(tpeer != nullptr);
+    if (tpeer->data() == nullptr) {
+      // Already transferred: let the message writer report the error.
+      failed_ = true;
+      return Object::null();
+    }
+    const auto& to = TransferableTypedData::Handle(
+        zone_, TransferableTypedData::New(tpeer->data(), tpeer->length()));
+    if (transferables_.IsNull()) {
+      transferables_ = GrowableObjectArray::New();
+    }
+    transferables_.Add(from);
+    transferables_.Add(to);
+    return to.ptr();
+  }
+
+  // Both the original and the copy of a transferable refer to the same
+  // external data at this point. Detach it from the sender if the copy
+  // succeeded and from the copy otherwise.
+  void ReleaseTransferables(bool from_copies) {
+    if (transferables_.IsNull()) {
+      return;
+    }
+    Object& obj = Object::Handle(zone_);
+    const intptr_t length = transferables_.Length();
+    for (intptr_t i = from_copies ? 1 : 0; i < length; i += 2) {
+      obj = transferables_.At(i);
+      auto tpeer = reinterpret_cast<TransferableTypedDataPeer*>(
+          thread_->heap()->GetPeer(obj.ptr()));
+      tpeer->handle()->EnsureFreedExternal(isolate_->group());
+      tpeer->ClearData();
+    }
+  }
+
+  void CopyContents(const Object& from, const Object& to) {
+    const intptr_t cid = from.GetClassId();
+    if (IsTypedDataClassId(cid)) {
+      const auto& src = TypedData::Cast(from);
+      TypedData::Copy(TypedData::Cast(to), 0, src, 0, src.LengthInBytes());
+      return;
+    }
+    if (IsTypedDataViewClassId(cid)) {
+      const auto& src = TypedDataView::Cast(from);
+      auto& backing = Instance::Handle(zone_, src.typed_data());
+      backing ^= Forward(backing);
+      if (failed_) return;
+      auto& view =
+          TypedDataView::Handle(zone_, TypedDataView::RawCast(to.ptr()));
+      view.InitializeWith(TypedDataBase::Cast(backing),
+                          Smi::Value(TypedDataView::OffsetInBytes(src)),
+                          src.Length());
+      return;
+    }
+    switch (cid) {
+      case kArrayCid:
+      case kImmutableArrayCid:
+        CopyArray(Array::Cast(from), Array::Cast(to));
+        return;
+      case kGrowableObjectArrayCid:
+        CopyGrowableObjectArray(GrowableObjectArray::Cast(from),
+                                GrowableObjectArray::Cast(to));
+        return;
+      case kLinkedHashMapCid:
+        CopyLinkedHashMap(LinkedHashMap::Cast(from), LinkedHashMap::Cast(to));
+        return;
+      default:
+        break;
+    }
+    if (IsExternalTypedDataClassId(cid) || (cid == kTransferableTypedDataCid)) {
+      // Fully initialized by [AllocateCopy].
+      return;
+    }
+    CopyInstance(Instance::Cast(from), Instance::Cast(to));
+  }
+
+  void CopyArray(const Array& from, const Array& to) {
+    const auto& type_args =
+        TypeArguments::Handle(zone_, from.GetTypeArguments());
+    to.SetTypeArguments(type_args);
+    Object& value = Object::Handle(zone_);
+    const intptr_t length = from.Length();
+    for (intptr_t i = 0; i < length; i++) {
+      value = from.At(i);
+      value = Forward(value);
+      if (failed_) return;
+      to.SetAt(i, value);
+    }
+  }
+
+  void CopyGrowableObjectArray(const GrowableObjectArray& from,
+                               const GrowableObjectArray& to) {
+    const auto& type_args =
+        TypeArguments::Handle(zone_, from.GetTypeArguments());
+    to.SetTypeArguments(type_args);
+    auto& data = Array::Handle(zone_, from.data());
+    data ^= Forward(data);
+    if (failed_) return;
+    to.SetData(data);
+    to.SetLength(from.Length());
+  }
+
+  void CopyLinkedHashMap(const LinkedHashMap& from, const LinkedHashMap& to) {
+    const auto& type_args =
+        TypeArguments::Handle(zone_, from.GetTypeArguments());
+    to.SetTypeArguments(type_args);
+    auto& data = Array::Handle(zone_, from.data());
+    data ^= Forward(data);
+    if (failed_) return;
+    to.SetData(data);
+    to.SetUsedData(Smi::Value(from.used_data()));
+    // The index is keyed by hash codes which may not survive the copy, so it
+    // is regenerated by the receiver, just like for deserialized maps. This
+    // also drops the deleted entries.
+    to.SetDeletedKeys(0);
+    to.SetHashMask(0);
+    EnqueueRehashing(to);
+  }
+
+  void CopyInstance(const Instance& from, const Instance& to) {
+    const intptr_t cid = from.GetClassId();
+    const Class& cls =
+        Class::Handle(zone_, isolate_->group()->class_table()->At(cid));
+    const auto unboxed_fields =
+        isolate_->group()->shared_class_table()->GetUnboxedFieldsMapAt(cid);
+    const intptr_t next_field_offset = cls.host_next_field_offset();
+    // Copies have the same class as the originals and share all immutable
+    // field values, so guarded field state stays valid and does not need
+    // updating like it does when reading a message snapshot.
+    Object& value = Object::Handle(zone_);
+    for (intptr_t offset = Instance::NextFieldOffset();
+         offset < next_field_offset; offset += kCompressedWordSize) {
+      if (unboxed_fields.Get(offset / kCompressedWordSize)) {
+        NoSafepointScope no_safepoint;
+        memmove(reinterpret_cast<void*>(UntaggedObject::ToAddr(to.ptr()) +
+                                        offset),
+                reinterpret_cast<void*>(UntaggedObject::ToAddr(from.ptr()) +
+                                        offset),
+                kCompressedWordSize);
+        continue;
+      }
+      value = from.RawGetFieldAtOffset(offset);
+      value = Forward(value);
+      if (failed_) return;
+      to.RawSetFieldAtOffset(offset, value);
+    }
+    if (cid == set_cid_) {
+      EnqueueRehashing(to);
+    }
+  }
+
+  void EnqueueRehashing(const Object& obj) {
+    if (objects_to_rehash_.IsNull()) {
+      objects_to_rehash_ = GrowableObjectArray::New();
+    }
+    objects_to_rehash_.Add(obj);
+  }
+
+  Thread* thread_;
+  Zone* zone_;
+  Isolate* isolate_;
+  const intptr_t set_cid_;
+  // Pairs of (original, copy), in the order the copies were allocated. The
+  // forward tables map each original to the index of its copy.
+  const GrowableObjectArray& from_to_;
+  GrowableObjectArray& objects_to_rehash_;
+  // Pairs of (original, copy) of transferable typed data.
+  GrowableObjectArray& transferables_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObjectGraphCopier);
+};
+
+ArrayPtr CopyMutableObjectGraph(const Object& root) {
+  Thread* thread = Thread::Current();
+  TIMELINE_DURATION(thread, Isolate, "CopyMutableObjectGraph");
+  ObjectGraphCopier copier(thread);
+  return copier.Copy(root);
+}
+
+}  // namespace dart
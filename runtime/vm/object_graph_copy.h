@@ -0,0 +1,31 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_OBJECT_GRAPH_COPY_H_
+#define RUNTIME_VM_OBJECT_GRAPH_COPY_H_
+
+#include "vm/tagged_pointer.h"
+
+namespace dart {
+
+class Object;
+
+// Copies the object graph reachable from [root] so it can be handed to
+// another isolate of the same isolate group without going through a message
+// snapshot.
+//
+// Deeply immutable objects (strings, numbers, types, canonical objects,
+// send ports, ...) are shared rather than copied and the contents of
+// [TransferableTypedData] objects are moved into the copy.
+//
+// Returns an array of the form [<copy>, <objects-to-rehash>] as expected by
+// persistent handle messages (see [IsolateMessageHandler::HandleMessage]), or
+// null if the graph contains an object this copier does not handle. In the
+// latter case the caller should fall back to the [MessageWriter], which also
+// takes care of reporting illegal message objects.
+ArrayPtr CopyMutableObjectGraph(const Object& root);
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_OBJECT_GRAPH_COPY_H_
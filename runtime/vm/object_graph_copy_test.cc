@@ -0,0 +1,96 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/object_graph_copy.h"
+
+#include "platform/assert.h"
+#include "vm/dart_api_state.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+ISOLATE_UNIT_TEST_CASE(ObjectGraphCopy_CopiesMutableAndSharesImmutable) {
+  const String& str = String::Handle(String::New("shared"));
+  const TypedData& bytes =
+      TypedData::Handle(TypedData::New(kTypedDataUint8ArrayCid, 16));
+  for (intptr_t i = 0; i < 16; i++) {
+    bytes.SetUint8(i, i);
+  }
+  const Array& root = Array::Handle(Array::New(4));
+  root.SetAt(0, str);
+  root.SetAt(1, bytes);
+  root.SetAt(2, bytes);
+  root.SetAt(3, root);
+
+  const Array& msg = Array::Handle(CopyMutableObjectGraph(root));
+  EXPECT(!msg.IsNull());
+  EXPECT(msg.At(1) == Object::null());
+
+  const Array& copy = Array::Handle(Array::RawCast(msg.At(0)));
+  EXPECT(copy.ptr() != root.ptr());
+  EXPECT_EQ(4, copy.Length());
+  // Strings are immutable and shared.
+  EXPECT(copy.At(0) == str.ptr());
+  // Mutable objects are copied once, preserving sharing and cycles.
+  EXPECT(copy.At(1) != bytes.ptr());
+  EXPECT(copy.At(1) == copy.At(2));
+  EXPECT(copy.At(3) == copy.ptr());
+  const TypedData& bytes_copy =
+      TypedData::Handle(TypedData::RawCast(copy.At(1)));
+  EXPECT_EQ(16, bytes_copy.Length());
+  for (intptr_t i = 0; i < 16; i++) {
+    EXPECT_EQ(i, bytes_copy.GetUint8(i));
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(ObjectGraphCopy_MapsAreRehashed) {
+  const LinkedHashMap& map = LinkedHashMap::Handle(LinkedHashMap::NewDefault());
+  const Array& root = Array::Handle(Array::New(1));
+  root.SetAt(0, map);
+
+  const Array& msg = Array::Handle(CopyMutableObjectGraph(root));
+  EXPECT(!msg.IsNull());
+  const Array& copy = Array::Handle(Array::RawCast(msg.At(0)));
+  EXPECT(copy.At(0) != map.ptr());
+  EXPECT(copy.At(0)->GetClassId() == kLinkedHashMapCid);
+
+  const GrowableObjectArray& to_rehash =
+      GrowableObjectArray::Handle(GrowableObjectArray::RawCast(msg.At(1)));
+  EXPECT(!to_rehash.IsNull());
+  EXPECT_EQ(1, to_rehash.Length());
+  EXPECT(to_rehash.At(0) == copy.At(0));
+}
+
+ISOLATE_UNIT_TEST_CASE(ObjectGraphCopy_UnsupportedObject) {
+  const Array& root = Array::Handle(Array::New(2));
+  root.SetAt(0, WeakProperty::Handle(WeakProperty::New()));
+  EXPECT(CopyMutableObjectGraph(root) == Array::null());
+}
+
+ISOLATE_UNIT_TEST_CASE(ObjectGraphCopy_TransfersTypedData) {
+  const intptr_t kLength = 32;
+  uint8_t* data = reinterpret_cast<uint8_t*>(malloc(kLength));
+  const TransferableTypedData& ttd = TransferableTypedData::Handle(
+      TransferableTypedData::New(data, kLength));
+
+  const Array& msg = Array::Handle(CopyMutableObjectGraph(ttd));
+  EXPECT(!msg.IsNull());
+  const Object& copy = Object::Handle(msg.At(0));
+  EXPECT(copy.ptr() != ttd.ptr());
+
+  Heap* heap = thread->heap();
+  auto sender_peer =
+      reinterpret_cast<TransferableTypedDataPeer*>(heap->GetPeer(ttd.ptr()));
+  auto receiver_peer =
+      reinterpret_cast<TransferableTypedDataPeer*>(heap->GetPeer(copy.ptr()));
+  EXPECT(sender_peer->data() == nullptr);
+  EXPECT(receiver_peer->data() == data);
+  EXPECT_EQ(kLength, receiver_peer->length());
+
+  // Once transferred, the sender's object can not be sent again.
+  EXPECT(CopyMutableObjectGraph(ttd) == Array::null());
+}
+
+}  // namespace dart
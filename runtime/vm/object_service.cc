@@ -845,6 +845,12 @@ void ICData::PrintToJSONArray(const JSONArray& jsarray,
   JSONObject jsobj(&jsarray);
   jsobj.AddProperty("name", String::Handle(target_name()).ToCString());
   jsobj.AddProperty("tokenPos", static_cast<intptr_t>(token_pos.Serialize()));
+  if (!is_static_call()) {
+    // The entries of a megamorphic call site keep counting the calls of
+    // their receiver classes until it switches to the megamorphic cache (see
+    // --megamorphic_counted_checks).
+    jsobj.AddProperty("_megamorphic", is_megamorphic());
+  }
   // TODO(rmacnak): Figure out how to stringify DeoptReasons().
   // jsobj.AddProperty("deoptReasons", ...);
 
@@ -16,8 +16,7 @@
 
 namespace dart {
 
-Mutex* PortMap::mutex_ = NULL;
-PortSet<PortMap::Entry>* PortMap::ports_ = NULL;
+PortMap::Shard PortMap::shards_[PortMap::kNumShards];
 MessageHandler* PortMap::deleted_entry_ = reinterpret_cast<MessageHandler*>(1);
 Random* PortMap::prng_ = NULL;
 
@@ -38,18 +37,15 @@ const char* PortMap::PortStateString(PortState kind) {
 }
 
 Dart_Port PortMap::AllocatePort() {
-  Dart_Port result;
-
-  // Keep getting new values while we have an illegal port number or the port
-  // number is already in use.
-  do {
+  // Keep getting new values while we have an illegal port number.
+  for (;;) {
     // Ensure port ids are representable in JavaScript for the benefit of
     // vm-service clients such as Observatory.
     const Dart_Port kMask1 = 0xFFFFFFFFFFFFF;
     // Ensure port ids are never valid object pointers so that reinterpreting
     // an object pointer as a port id never produces a used port id.
     const Dart_Port kMask2 = 0x3;
-    result = (prng_->NextUInt64() & kMask1) | kMask2;
+    const Dart_Port result = (prng_->NextUInt64() & kMask1) | kMask2;
 
     // The two special marker ports are used for the hashset implementation and
     // cannot be used as actual ports.
@@ -59,18 +55,30 @@ Dart_Port PortMap::AllocatePort() {
     }
 
     ASSERT(!static_cast<ObjectPtr>(static_cast<uword>(result))->IsWellFormed());
-  } while (ports_->Contains(result));
-
-  ASSERT(result != 0);
-  ASSERT(!ports_->Contains(result));
-  return result;
+    ASSERT(result != 0);
+    return result;
+  }
 }
 
 void PortMap::SetPortState(Dart_Port port, PortState state) {
-  MutexLocker ml(mutex_);
+  Shard* shard = ShardFor(port);
+  MessageHandler* handler = NULL;
+  {
+    MutexLocker ml(shard->mutex);
+    auto it = shard->ports->TryLookup(port);
+    ASSERT(it != shard->ports->end());
+    handler = (*it).handler;
+    ASSERT(handler != nullptr);
+  }
+  // The live port count of the handler is shared by ports in other shards,
+  // which are closed under the handler's port set lock. Respect the lock
+  // order: the handler's port set before the shard.
+  MutexLocker hl(&handler->ports_mutex_);
+  MutexLocker ml(shard->mutex);
 
-  auto it = ports_->TryLookup(port);
-  ASSERT(it != ports_->end());
+  auto it = shard->ports->TryLookup(port);
+  ASSERT(it != shard->ports->end());
+  ASSERT((*it).handler == handler);
 
   Entry& entry = *it;
   PortState old_state = entry.state;
@@ -92,25 +100,31 @@ void PortMap::SetPortState(Dart_Port port, PortState state) {
 
 Dart_Port PortMap::CreatePort(MessageHandler* handler) {
   ASSERT(handler != NULL);
-  MutexLocker ml(mutex_);
+  MutexLocker ml(&handler->ports_mutex_);
 #if defined(DEBUG)
   handler->CheckAccess();
 #endif
 
-  const Dart_Port port = AllocatePort();
+  Entry entry;
+  entry.handler = handler;
+  entry.state = kNewPort;
+  // Keep getting new values while the port number is already in use.
+  for (;;) {
+    entry.port = AllocatePort();
+    Shard* shard = ShardFor(entry.port);
+    MutexLocker sl(shard->mutex);
+    if (!shard->ports->Contains(entry.port)) {
+      shard->ports->Insert(entry);
+      break;
+    }
+  }
 
   // The MessageHandler::ports_ is only accessed by [PortMap], it is guarded
-  // by the [PortMap::mutex_] we already hold.
+  // by the [MessageHandler::ports_mutex_] we already hold.
   MessageHandler::PortSetEntry isolate_entry;
-  isolate_entry.port = port;
+  isolate_entry.port = entry.port;
   handler->ports_.Insert(isolate_entry);
 
-  Entry entry;
-  entry.port = port;
-  entry.handler = handler;
-  entry.state = kNewPort;
-  ports_->Insert(entry);
-
   if (FLAG_trace_isolates) {
     OS::PrintErr(
         "[+] Opening port: \n"
@@ -123,16 +137,28 @@ Dart_Port PortMap::CreatePort(MessageHandler* handler) {
 }
 
 bool PortMap::ClosePort(Dart_Port port) {
+  Shard* shard = ShardFor(port);
   MessageHandler* handler = NULL;
   {
-    MutexLocker ml(mutex_);
-    auto it = ports_->TryLookup(port);
-    if (it == ports_->end()) {
+    MutexLocker ml(shard->mutex);
+    auto it = shard->ports->TryLookup(port);
+    if (it == shard->ports->end()) {
       return false;
     }
-    Entry entry = *it;
-    handler = entry.handler;
+    handler = (*it).handler;
     ASSERT(handler != nullptr);
+  }
+  {
+    // Respect the lock order: the handler's port set before the shard.
+    MutexLocker ml(&handler->ports_mutex_);
+    MutexLocker sl(shard->mutex);
+    auto it = shard->ports->TryLookup(port);
+    if (it == shard->ports->end()) {
+      // Closed concurrently.
+      return false;
+    }
+    Entry entry = *it;
+    ASSERT(entry.handler == handler);
 
 #if defined(DEBUG)
     handler->CheckAccess();
@@ -145,10 +171,10 @@ bool PortMap::ClosePort(Dart_Port port) {
     // Delete the port entry before releasing the lock to avoid holding the lock
     // while flushing the messages below.
     it.Delete();
-    ports_->Rebalance();
+    shard->ports->Rebalance();
 
     // The MessageHandler::ports_ is only accessed by [PortMap], it is guarded
-    // by the [PortMap::mutex_] we already hold.
+    // by the [MessageHandler::ports_mutex_] we already hold.
     auto isolate_it = handler->ports_.TryLookup(port);
     ASSERT(isolate_it != handler->ports_.end());
     isolate_it.Delete();
@@ -164,13 +190,15 @@ bool PortMap::ClosePort(Dart_Port port) {
 
 void PortMap::ClosePorts(MessageHandler* handler) {
   {
-    MutexLocker ml(mutex_);
+    MutexLocker ml(&handler->ports_mutex_);
     // The MessageHandler::ports_ is only accessed by [PortMap], it is guarded
-    // by the [PortMap::mutex_] we already hold.
+    // by the [MessageHandler::ports_mutex_] we already hold.
     for (auto isolate_it = handler->ports_.begin();
          isolate_it != handler->ports_.end(); ++isolate_it) {
-      auto it = ports_->TryLookup((*isolate_it).port);
-      ASSERT(it != ports_->end());
+      Shard* shard = ShardFor((*isolate_it).port);
+      MutexLocker sl(shard->mutex);
+      auto it = shard->ports->TryLookup((*isolate_it).port);
+      ASSERT(it != shard->ports->end());
       Entry entry = *it;
       ASSERT(entry.port == (*isolate_it).port);
       ASSERT(entry.handler == handler);
@@ -178,19 +206,21 @@ void PortMap::ClosePorts(MessageHandler* handler) {
         handler->decrement_live_ports();
       }
       it.Delete();
+      shard->ports->Rebalance();
       isolate_it.Delete();
     }
     ASSERT(handler->ports_.IsEmpty());
-    ports_->Rebalance();
   }
   handler->CloseAllPorts();
 }
 
 bool PortMap::PostMessage(std::unique_ptr<Message> message,
                           bool before_events) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(message->dest_port());
-  if (it == ports_->end()) {
+  // The shard lock keeps the handler from being deleted while we post to it.
+  Shard* shard = ShardFor(message->dest_port());
+  MutexLocker ml(shard->mutex);
+  auto it = shard->ports->TryLookup(message->dest_port());
+  if (it == shard->ports->end()) {
     // Ownership of external data remains with the poster.
     message->DropFinalizers();
     return false;
@@ -202,9 +232,10 @@ bool PortMap::PostMessage(std::unique_ptr<Message> message,
 }
 
 bool PortMap::IsLocalPort(Dart_Port id) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(id);
-  if (it == ports_->end()) {
+  Shard* shard = ShardFor(id);
+  MutexLocker ml(shard->mutex);
+  auto it = shard->ports->TryLookup(id);
+  if (it == shard->ports->end()) {
     // Port does not exist.
     return false;
   }
@@ -215,9 +246,10 @@ bool PortMap::IsLocalPort(Dart_Port id) {
 }
 
 bool PortMap::IsLivePort(Dart_Port id) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(id);
-  if (it == ports_->end()) {
+  Shard* shard = ShardFor(id);
+  MutexLocker ml(shard->mutex);
+  auto it = shard->ports->TryLookup(id);
+  if (it == shard->ports->end()) {
     // Port does not exist.
     return false;
   }
@@ -227,9 +259,10 @@ bool PortMap::IsLivePort(Dart_Port id) {
 }
 
 Isolate* PortMap::GetIsolate(Dart_Port id) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(id);
-  if (it == ports_->end()) {
+  Shard* shard = ShardFor(id);
+  MutexLocker ml(shard->mutex);
+  auto it = shard->ports->TryLookup(id);
+  if (it == shard->ports->end()) {
     // Port does not exist.
     return nullptr;
   }
@@ -240,39 +273,45 @@ Isolate* PortMap::GetIsolate(Dart_Port id) {
 
 bool PortMap::IsReceiverInThisIsolateGroup(Dart_Port receiver,
                                            IsolateGroup* group) {
-  MutexLocker ml(mutex_);
-  auto it = ports_->TryLookup(receiver);
-  if (it == ports_->end()) return false;
+  Shard* shard = ShardFor(receiver);
+  MutexLocker ml(shard->mutex);
+  auto it = shard->ports->TryLookup(receiver);
+  if (it == shard->ports->end()) return false;
   return (*it).handler->isolate()->group() == group;
 }
 
 void PortMap::Init() {
   // TODO(bkonyi): don't keep ports_ after Dart_Cleanup.
-  if (mutex_ == NULL) {
-    mutex_ = new Mutex();
+  for (intptr_t i = 0; i < kNumShards; i++) {
+    Shard* shard = &shards_[i];
+    if (shard->mutex == nullptr) {
+      shard->mutex = new Mutex();
+    }
+    if (shard->ports == nullptr) {
+      shard->ports = new PortSet<Entry>();
+    }
   }
-  ASSERT(mutex_ != NULL);
   if (prng_ == nullptr) {
     prng_ = new Random();
   }
-  if (ports_ == nullptr) {
-    ports_ = new PortSet<Entry>();
-  }
 }
 
 void PortMap::Cleanup() {
-  ASSERT(ports_ != nullptr);
   ASSERT(prng_ != NULL);
-  for (auto it = ports_->begin(); it != ports_->end(); ++it) {
-    const auto& entry = *it;
-    ASSERT(entry.handler != nullptr);
-    if (entry.state == kLivePort) {
-      entry.handler->decrement_live_ports();
+  for (intptr_t i = 0; i < kNumShards; i++) {
+    PortSet<Entry>* ports = shards_[i].ports;
+    ASSERT(ports != nullptr);
+    for (auto it = ports->begin(); it != ports->end(); ++it) {
+      const auto& entry = *it;
+      ASSERT(entry.handler != nullptr);
+      if (entry.state == kLivePort) {
+        entry.handler->decrement_live_ports();
+      }
+      delete entry.handler;
+      it.Delete();
     }
-    delete entry.handler;
-    it.Delete();
+    ports->Rebalance();
   }
-  ports_->Rebalance();
 
   delete prng_;
   prng_ = NULL;
@@ -289,15 +328,17 @@ void PortMap::PrintPortsForMessageHandler(MessageHandler* handler,
   Object& msg_handler = Object::Handle();
   {
     JSONArray ports(&jsobj, "ports");
-    SafepointMutexLocker ml(mutex_);
-    for (auto& entry : *ports_) {
-      if (entry.handler == handler) {
-        if (entry.state == kLivePort) {
-          JSONObject port(&ports);
-          port.AddProperty("type", "_Port");
-          port.AddPropertyF("name", "Isolate Port (%" Pd64 ")", entry.port);
-          msg_handler = DartLibraryCalls::LookupHandler(entry.port);
-          port.AddProperty("handler", msg_handler);
+    for (intptr_t i = 0; i < kNumShards; i++) {
+      SafepointMutexLocker ml(shards_[i].mutex);
+      for (auto& entry : *shards_[i].ports) {
+        if (entry.handler == handler) {
+          if (entry.state == kLivePort) {
+            JSONObject port(&ports);
+            port.AddProperty("type", "_Port");
+            port.AddPropertyF("name", "Isolate Port (%" Pd64 ")", entry.port);
+            msg_handler = DartLibraryCalls::LookupHandler(entry.port);
+            port.AddProperty("handler", msg_handler);
+          }
         }
       }
     }
@@ -306,14 +347,16 @@ void PortMap::PrintPortsForMessageHandler(MessageHandler* handler,
 }
 
 void PortMap::DebugDumpForMessageHandler(MessageHandler* handler) {
-  SafepointMutexLocker ml(mutex_);
   Object& msg_handler = Object::Handle();
-  for (auto& entry : *ports_) {
-    if (entry.handler == handler) {
-      if (entry.state == kLivePort) {
-        OS::PrintErr("Live Port = %" Pd64 "\n", entry.port);
-        msg_handler = DartLibraryCalls::LookupHandler(entry.port);
-        OS::PrintErr("Handler = %s\n", msg_handler.ToCString());
+  for (intptr_t i = 0; i < kNumShards; i++) {
+    SafepointMutexLocker ml(shards_[i].mutex);
+    for (auto& entry : *shards_[i].ports) {
+      if (entry.handler == handler) {
+        if (entry.state == kLivePort) {
+          OS::PrintErr("Live Port = %" Pd64 "\n", entry.port);
+          msg_handler = DartLibraryCalls::LookupHandler(entry.port);
+          OS::PrintErr("Handler = %s\n", msg_handler.ToCString());
+        }
       }
     }
   }
@@ -84,15 +84,32 @@ class PortMap : public AllStatic {
     PortState state;
   };
 
+  // The map is split into shards by port id, each guarded by its own lock,
+  // so that posting messages to different ports rarely contends.
+  //
+  // Operations which also touch a handler's set of ports (creating and
+  // closing ports) take the handler's [MessageHandler::ports_mutex_] before
+  // any shard lock.
+  struct Shard {
+    Mutex* mutex = nullptr;
+    PortSet<Entry>* ports = nullptr;
+  };
+  static constexpr intptr_t kNumShards = 32;
+  // Port ids are random, any bits above the ones the port sets index by will
+  // do.
+  static constexpr intptr_t kShardShift = 40;
+
+  static Shard* ShardFor(Dart_Port port) {
+    return &shards_[(static_cast<uint64_t>(port) >> kShardShift) &
+                    (kNumShards - 1)];
+  }
+
   static const char* PortStateString(PortState state);
 
-  // Allocate a new unique port.
+  // Allocate a new port id. The caller needs to check it is not in use yet.
   static Dart_Port AllocatePort();
 
-  // Lock protecting access to the port map.
-  static Mutex* mutex_;
-
-  static PortSet<Entry>* ports_;
+  static Shard shards_[kNumShards];
   static MessageHandler* deleted_entry_;
 
   static Random* prng_;
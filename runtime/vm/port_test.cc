@@ -7,6 +7,7 @@
 #include "vm/lockers.h"
 #include "vm/message_handler.h"
 #include "vm/os.h"
+#include "vm/thread_pool.h"
 #include "vm/unit_test.h"
 
 namespace dart {
@@ -15,15 +16,17 @@ namespace dart {
 class PortMapTestPeer {
  public:
   static bool IsActivePort(Dart_Port port) {
-    MutexLocker ml(PortMap::mutex_);
-    auto it = PortMap::ports_->TryLookup(port);
-    return it != PortMap::ports_->end();
+    PortMap::Shard* shard = PortMap::ShardFor(port);
+    MutexLocker ml(shard->mutex);
+    auto it = shard->ports->TryLookup(port);
+    return it != shard->ports->end();
   }
 
   static bool IsLivePort(Dart_Port port) {
-    MutexLocker ml(PortMap::mutex_);
-    auto it = PortMap::ports_->TryLookup(port);
-    if (it == PortMap::ports_->end()) {
+    PortMap::Shard* shard = PortMap::ShardFor(port);
+    MutexLocker ml(shard->mutex);
+    auto it = shard->ports->TryLookup(port);
+    if (it == shard->ports->end()) {
       return false;
     }
     return (*it).state == PortMap::kLivePort;
@@ -130,6 +133,75 @@ TEST_CASE(PortMap_SetPortState) {
   EXPECT(!PortMapTestPeer::IsLivePort(port));
 }
 
+class PortStateTask : public ThreadPool::Task {
+ public:
+  PortStateTask(Dart_Port* ports,
+                intptr_t count,
+                intptr_t iterations,
+                Monitor* monitor,
+                intptr_t* done)
+      : ports_(ports),
+        count_(count),
+        iterations_(iterations),
+        monitor_(monitor),
+        done_(done) {}
+
+  virtual void Run() {
+    for (intptr_t i = 0; i < iterations_; i++) {
+      for (intptr_t j = 0; j < count_; j++) {
+        PortMap::SetPortState(ports_[j], PortMap::kLivePort);
+      }
+      for (intptr_t j = 0; j < count_; j++) {
+        PortMap::SetPortState(ports_[j], PortMap::kInactivePort);
+      }
+    }
+    MonitorLocker ml(monitor_);
+    (*done_)++;
+    ml.Notify();
+  }
+
+ private:
+  Dart_Port* ports_;
+  intptr_t count_;
+  intptr_t iterations_;
+  Monitor* monitor_;
+  intptr_t* done_;
+};
+
+// The ports of a handler are spread over the shards of the port map, but
+// they share its live port count.
+TEST_CASE(PortMap_SetPortStateConcurrently) {
+  PortTestMessageHandler handler;
+  const intptr_t kNumTasks = 4;
+  const intptr_t kPortsPerTask = 16;
+  Dart_Port ports[kNumTasks * kPortsPerTask];
+  for (intptr_t i = 0; i < kNumTasks * kPortsPerTask; i++) {
+    ports[i] = PortMap::CreatePort(&handler);
+  }
+
+  Monitor monitor;
+  intptr_t done = 0;
+  for (intptr_t i = 0; i < kNumTasks; i++) {
+    Dart::thread_pool()->Run<PortStateTask>(&ports[i * kPortsPerTask],
+                                            kPortsPerTask, 1000, &monitor,
+                                            &done);
+  }
+  {
+    MonitorLocker ml(&monitor);
+    while (done < kNumTasks) {
+      ml.Wait();
+    }
+  }
+  EXPECT_EQ(0, handler.live_ports());
+
+  for (intptr_t i = 0; i < kNumTasks * kPortsPerTask; i++) {
+    PortMap::SetPortState(ports[i], PortMap::kLivePort);
+  }
+  EXPECT_EQ(kNumTasks * kPortsPerTask, handler.live_ports());
+  PortMap::ClosePorts(&handler);
+  EXPECT_EQ(0, handler.live_ports());
+}
+
 TEST_CASE(PortMap_PostMessage) {
   PortTestMessageHandler handler;
   Dart_Port port = PortMap::CreatePort(&handler);
@@ -4,6 +4,8 @@
 
 #include "vm/profiler_service.h"
 
+#include <atomic>
+
 #include "platform/text_buffer.h"
 #include "vm/growable_array.h"
 #include "vm/hash_map.h"
@@ -13,9 +15,11 @@
 #include "vm/object.h"
 #include "vm/os.h"
 #include "vm/profiler.h"
+#include "vm/protobuf_writer.h"
 #include "vm/reusable_handles.h"
 #include "vm/scope_timer.h"
 #include "vm/timeline.h"
+#include "vm/zone_text_buffer.h"
 
 namespace dart {
 
@@ -25,6 +29,16 @@ DECLARE_FLAG(bool, profile_vm);
 
 #ifndef PRODUCT
 
+DEFINE_FLAG(charp,
+            profile_output,
+            NULL,
+            "Periodically write pprof profiles of each isolate, and of native "
+            "allocations, to files named after this path.");
+DEFINE_FLAG(int,
+            profile_output_period,
+            60,
+            "Seconds between profiles written for --profile_output.");
+
 ProfileFunctionSourcePosition::ProfileFunctionSourcePosition(
     TokenPosition token_pos)
     : token_pos_(token_pos), exclusive_ticks_(0), inclusive_ticks_(0) {}
@@ -1576,10 +1590,10 @@ void Profile::PrintHeaderJSON(JSONObject* obj) {
   }
 }
 
-void Profile::ProcessSampleFrameJSON(JSONArray* stack,
-                                     ProfileCodeInlinedFunctionsCache* cache_,
-                                     ProcessedSample* sample,
-                                     intptr_t frame_index) {
+void Profile::GetFunctionsAt(ProfileCodeInlinedFunctionsCache* cache,
+                             ProcessedSample* sample,
+                             intptr_t frame_index,
+                             GrowableArray<ProfileFunction*>* functions) {
   const uword pc = sample->At(frame_index);
   ProfileCode* profile_code = GetCodeFromPC(pc, sample->timestamp());
   ASSERT(profile_code != NULL);
@@ -1599,8 +1613,8 @@ void Profile::ProcessSampleFrameJSON(JSONArray* stack,
 
   if (profile_code->code().IsCode()) {
     code ^= profile_code->code().ptr();
-    cache_->Get(pc, code, sample, frame_index, &inlined_functions,
-                &inlined_token_positions, &token_position);
+    cache->Get(pc, code, sample, frame_index, &inlined_functions,
+               &inlined_token_positions, &token_position);
     if (FLAG_trace_profiler_verbose && (inlined_functions != NULL)) {
       for (intptr_t i = 0; i < inlined_functions->length(); i++) {
         const String& name =
@@ -1613,7 +1627,7 @@ void Profile::ProcessSampleFrameJSON(JSONArray* stack,
 
   if (code.IsNull() || (inlined_functions == NULL) ||
       (inlined_functions->length() <= 1)) {
-    PrintFunctionFrameIndexJSON(stack, function);
+    functions->Add(function);
     return;
   }
 
@@ -1634,16 +1648,21 @@ void Profile::ProcessSampleFrameJSON(JSONArray* stack,
     const Function* inlined_function = (*inlined_functions)[i];
     ASSERT(inlined_function != NULL);
     ASSERT(!inlined_function->IsNull());
-    ProcessInlinedFunctionFrameJSON(stack, inlined_function);
+    ProfileFunction* inlined = functions_->LookupOrAdd(*inlined_function);
+    ASSERT(inlined != NULL);
+    functions->Add(inlined);
   }
 }
 
-void Profile::ProcessInlinedFunctionFrameJSON(
-    JSONArray* stack,
-    const Function* inlined_function) {
-  ProfileFunction* function = functions_->LookupOrAdd(*inlined_function);
-  ASSERT(function != NULL);
-  PrintFunctionFrameIndexJSON(stack, function);
+void Profile::ProcessSampleFrameJSON(JSONArray* stack,
+                                     ProfileCodeInlinedFunctionsCache* cache,
+                                     ProcessedSample* sample,
+                                     intptr_t frame_index) {
+  GrowableArray<ProfileFunction*> functions;
+  GetFunctionsAt(cache, sample, frame_index, &functions);
+  for (intptr_t i = 0; i < functions.length(); i++) {
+    PrintFunctionFrameIndexJSON(stack, functions[i]);
+  }
 }
 
 void Profile::PrintFunctionFrameIndexJSON(JSONArray* stack,
@@ -1756,6 +1775,218 @@ void Profile::PrintProfileJSON(JSONStream* stream, bool include_code_samples) {
   PrintSamplesJSON(&obj, include_code_samples);
 }
 
+// Field numbers from the pprof profile proto, see
+// https://github.com/google/pprof/blob/master/proto/profile.proto.
+namespace pprof {
+// message Profile.
+static const intptr_t kSampleType = 1;
+static const intptr_t kSample = 2;
+static const intptr_t kLocation = 4;
+static const intptr_t kFunction = 5;
+static const intptr_t kStringTable = 6;
+static const intptr_t kTimeNanos = 9;
+static const intptr_t kDurationNanos = 10;
+static const intptr_t kPeriodType = 11;
+static const intptr_t kPeriod = 12;
+// message ValueType.
+static const intptr_t kType = 1;
+static const intptr_t kUnit = 2;
+// message Sample.
+static const intptr_t kLocationId = 1;
+static const intptr_t kValue = 2;
+static const intptr_t kLabel = 3;
+// message Label.
+static const intptr_t kKey = 1;
+static const intptr_t kStr = 2;
+// message Location.
+static const intptr_t kLocationIdField = 1;
+static const intptr_t kLine = 4;
+// message Line.
+static const intptr_t kFunctionId = 1;
+// message Function.
+static const intptr_t kFunctionIdField = 1;
+static const intptr_t kName = 2;
+static const intptr_t kSystemName = 3;
+static const intptr_t kFilename = 4;
+}  // namespace pprof
+
+PprofBuilder::PprofBuilder(Zone* zone)
+    : zone_(zone),
+      strings_(zone, 64),
+      string_indices_(zone),
+      function_names_(zone, 64),
+      function_files_(zone, 64),
+      function_ids_(zone),
+      samples_(zone, 64),
+      sample_indices_(zone) {
+  // The first entry of the string table must be the empty string.
+  InternString("");
+  sample_type_names_[kSampleCount] = InternString("samples");
+  sample_type_units_[kSampleCount] = InternString("count");
+  sample_type_names_[kCpuTime] = InternString("cpu");
+  sample_type_units_[kCpuTime] = InternString("nanoseconds");
+  sample_type_names_[kAllocationCount] = InternString("alloc_objects");
+  sample_type_units_[kAllocationCount] = InternString("count");
+  sample_type_names_[kAllocationSize] = InternString("alloc_space");
+  sample_type_units_[kAllocationSize] = InternString("bytes");
+}
+
+intptr_t PprofBuilder::InternString(const char* str) {
+  if (str == NULL) {
+    return 0;
+  }
+  intptr_t index = string_indices_.LookupValue(str);
+  if (index == CStringIntMapKeyValueTrait::kNoValue) {
+    index = strings_.length();
+    strings_.Add(str);
+    string_indices_.Insert({str, index});
+  }
+  return index;
+}
+
+intptr_t PprofBuilder::LocationFor(ProfileFunction* function) {
+  const char* name = function->Name();
+  const char* file = function->ResolvedScriptUrl();
+  const char* key =
+      OS::SCreate(zone_, "%s:%s", file != NULL ? file : "", name);
+  intptr_t id = function_ids_.LookupValue(key);
+  if (id == CStringIntMapKeyValueTrait::kNoValue) {
+    function_names_.Add(InternString(name));
+    function_files_.Add(InternString(file));
+    // Ids must be non-zero.
+    id = function_names_.length();
+    function_ids_.Insert({key, id});
+  }
+  return id;
+}
+
+void PprofBuilder::AddSamples(Profile* profile) {
+  ClassTable* class_table = IsolateGroup::Current()->class_table();
+  Class& cls = Class::Handle(zone_);
+  auto* cache = new ProfileCodeInlinedFunctionsCache();
+  GrowableArray<ProfileFunction*> functions;
+  ZoneTextBuffer key(zone_, 256);
+  AggregatedSample* sample = new (zone_) AggregatedSample(zone_);
+  for (intptr_t sample_index = 0; sample_index < profile->sample_count();
+       sample_index++) {
+    ProcessedSample* processed = profile->SampleAt(sample_index);
+    for (intptr_t frame_index = 0; frame_index < processed->length();
+         frame_index++) {
+      functions.Clear();
+      profile->GetFunctionsAt(cache, processed, frame_index, &functions);
+      for (intptr_t i = 0; i < functions.length(); i++) {
+        sample->locations.Add(LocationFor(functions[i]));
+      }
+    }
+
+    // Samples are aggregated by kind, allocated class and stack.
+    key.Clear();
+    if (processed->is_native_allocation_sample()) {
+      key.AddString("n");
+      sample->values[kAllocationCount] = 1;
+      sample->values[kAllocationSize] =
+          processed->native_allocation_size_bytes();
+    } else if (processed->IsAllocationSample()) {
+      const intptr_t cid = processed->allocation_cid();
+      key.Printf("a%" Pd, cid);
+      sample->values[kAllocationCount] = 1;
+      if (class_table->HasValidClassAt(cid)) {
+        cls = class_table->At(cid);
+        sample->class_name = InternString(cls.ScrubbedNameCString());
+      }
+    } else {
+      key.AddString("c");
+      sample->values[kSampleCount] = 1;
+      sample->values[kCpuTime] =
+          FLAG_profile_period * kNanosecondsPerMicrosecond;
+    }
+    for (intptr_t i = 0; i < sample->locations.length(); i++) {
+      key.Printf(",%" Pd, sample->locations[i]);
+    }
+
+    const intptr_t index = sample_indices_.LookupValue(key.buffer());
+    if (index == CStringIntMapKeyValueTrait::kNoValue) {
+      sample_indices_.Insert({OS::SCreate(zone_, "%s", key.buffer()),
+                              samples_.length()});
+      samples_.Add(sample);
+      sample = new (zone_) AggregatedSample(zone_);
+    } else {
+      AggregatedSample* existing = samples_[index];
+      for (intptr_t i = 0; i < kNumSampleValues; i++) {
+        existing->values[i] += sample->values[i];
+        sample->values[i] = 0;
+      }
+      sample->locations.Clear();
+      sample->class_name = 0;
+    }
+  }
+}
+
+void PprofBuilder::Write(BaseWriteStream* stream,
+                         int64_t time_micros,
+                         int64_t duration_micros) {
+  ZoneWriteStream message(zone_, KB);
+  ZoneWriteStream nested(zone_, KB);
+
+  for (intptr_t i = 0; i < kNumSampleValues; i++) {
+    ProtobufWriter::WriteVarint(&message, pprof::kType, sample_type_names_[i]);
+    ProtobufWriter::WriteVarint(&message, pprof::kUnit, sample_type_units_[i]);
+    ProtobufWriter::WriteMessage(stream, pprof::kSampleType, &message);
+  }
+
+  for (intptr_t i = 0; i < samples_.length(); i++) {
+    AggregatedSample* sample = samples_[i];
+    for (intptr_t j = 0; j < sample->locations.length(); j++) {
+      nested.WriteLEB128(static_cast<uint64_t>(sample->locations[j]));
+    }
+    ProtobufWriter::WriteMessage(&message, pprof::kLocationId, &nested);
+    for (intptr_t j = 0; j < kNumSampleValues; j++) {
+      nested.WriteLEB128(static_cast<uint64_t>(sample->values[j]));
+    }
+    ProtobufWriter::WriteMessage(&message, pprof::kValue, &nested);
+    if (sample->class_name != 0) {
+      ProtobufWriter::WriteVarint(&nested, pprof::kKey,
+                                  InternString("class"));
+      ProtobufWriter::WriteVarint(&nested, pprof::kStr, sample->class_name);
+      ProtobufWriter::WriteMessage(&message, pprof::kLabel, &nested);
+    }
+    ProtobufWriter::WriteMessage(stream, pprof::kSample, &message);
+  }
+
+  for (intptr_t i = 0; i < function_names_.length(); i++) {
+    const intptr_t id = i + 1;
+    ProtobufWriter::WriteVarint(&nested, pprof::kFunctionId, id);
+    ProtobufWriter::WriteVarint(&message, pprof::kLocationIdField, id);
+    ProtobufWriter::WriteMessage(&message, pprof::kLine, &nested);
+    ProtobufWriter::WriteMessage(stream, pprof::kLocation, &message);
+
+    ProtobufWriter::WriteVarint(&message, pprof::kFunctionIdField, id);
+    ProtobufWriter::WriteVarint(&message, pprof::kName, function_names_[i]);
+    ProtobufWriter::WriteVarint(&message, pprof::kSystemName,
+                                function_names_[i]);
+    ProtobufWriter::WriteVarint(&message, pprof::kFilename,
+                                function_files_[i]);
+    ProtobufWriter::WriteMessage(stream, pprof::kFunction, &message);
+  }
+
+  ProtobufWriter::WriteVarint(&message, pprof::kType,
+                              sample_type_names_[kCpuTime]);
+  ProtobufWriter::WriteVarint(&message, pprof::kUnit,
+                              sample_type_units_[kCpuTime]);
+  ProtobufWriter::WriteMessage(stream, pprof::kPeriodType, &message);
+  ProtobufWriter::WriteVarint(stream, pprof::kPeriod,
+                              FLAG_profile_period * kNanosecondsPerMicrosecond);
+  ProtobufWriter::WriteVarint(stream, pprof::kTimeNanos,
+                              time_micros * kNanosecondsPerMicrosecond);
+  ProtobufWriter::WriteVarint(stream, pprof::kDurationNanos,
+                              duration_micros * kNanosecondsPerMicrosecond);
+
+  // All strings are interned by now.
+  for (intptr_t i = 0; i < strings_.length(); i++) {
+    ProtobufWriter::WriteString(stream, pprof::kStringTable, strings_[i]);
+  }
+}
+
 void ProfilerService::PrintJSONImpl(Thread* thread,
                                     JSONStream* stream,
                                     SampleFilter* filter,
@@ -1886,6 +2117,159 @@ void ProfilerService::ClearSamples() {
   sample_buffer->VisitSamples(&clear_profile);
 }
 
+// Inserts "-<pid>-<name>-<index>" before the extension of the file name
+// given by --profile_output.
+static const char* ProfileOutputPath(Zone* zone,
+                                     const char* name,
+                                     intptr_t index) {
+  const char* path = FLAG_profile_output;
+  const char* basename = strrchr(path, '/');
+  basename = (basename == NULL) ? path : basename + 1;
+  const char* extension = strchr(basename, '.');
+  if (extension == NULL) {
+    extension = path + strlen(path);
+  }
+  return OS::SCreate(zone, "%.*s-%" Pd "-%s-%" Pd "%s",
+                     static_cast<int>(extension - path), path, OS::ProcessId(),
+                     name, index, extension);
+}
+
+static void WriteProfileFile(Zone* zone,
+                             const char* path,
+                             PprofBuilder* builder,
+                             int64_t duration) {
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileWriteCallback file_write = Dart::file_write_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  if ((file_open == NULL) || (file_write == NULL) || (file_close == NULL)) {
+    return;
+  }
+  ZoneWriteStream stream(zone, 64 * KB);
+  builder->Write(&stream, OS::GetCurrentTimeMicros() - duration, duration);
+  void* file = (*file_open)(path, true);
+  if (file == NULL) {
+    OS::PrintErr("Failed to write profile file: %s\n", path);
+    return;
+  }
+  (*file_write)(stream.buffer(), stream.bytes_written(), file);
+  (*file_close)(file);
+}
+
+static bool IsProfileOutputDue(int64_t duration, bool force) {
+  const int64_t period =
+      static_cast<int64_t>(FLAG_profile_output_period) * kMicrosecondsPerSecond;
+  return force || (duration >= period);
+}
+
+// Native allocations are not attributed to isolates. They are written to a
+// process-wide profile by whichever isolate first finds it due.
+static std::atomic<int64_t> native_profile_output_micros = {0};
+static std::atomic<intptr_t> native_profile_output_count = {0};
+
+static void WriteNativeAllocationProfileIfDue(Thread* thread,
+                                              Zone* zone,
+                                              int64_t now,
+                                              bool force) {
+  SampleBuffer* allocation_buffer = Profiler::allocation_sample_buffer();
+  if (allocation_buffer == NULL) {
+    return;
+  }
+  int64_t previous = native_profile_output_micros.load();
+  const int64_t start =
+      (previous == 0) ? (now - Dart::UptimeMicros()) : previous;
+  const int64_t duration = now - start;
+  if (!IsProfileOutputDue(duration, force) ||
+      !native_profile_output_micros.compare_exchange_strong(previous, now)) {
+    return;
+  }
+
+  PprofBuilder builder(zone);
+  {
+    Profile profile(thread->isolate());
+    NativeAllocationSampleFilter filter(start, duration);
+    profile.Build(thread, &filter, allocation_buffer);
+    builder.AddSamples(&profile);
+  }
+  const char* path =
+      ProfileOutputPath(zone, "native", native_profile_output_count++);
+  WriteProfileFile(zone, path, &builder, duration);
+}
+
+void ProfilerService::WriteProfileIfDue(Thread* thread, bool force) {
+  SampleBuffer* sample_buffer = Profiler::sample_buffer();
+  if ((FLAG_profile_output == NULL) || (sample_buffer == NULL)) {
+    return;
+  }
+  Isolate* isolate = thread->isolate();
+  if (Isolate::IsSystemIsolate(isolate)) {
+    return;
+  }
+  const int64_t now = OS::GetCurrentMonotonicMicros();
+  int64_t start = isolate->last_profile_output_micros();
+  if (start == 0) {
+    start = now - isolate->UptimeMicros();
+  }
+  const int64_t duration = now - start;
+  if (!IsProfileOutputDue(duration, force)) {
+    return;
+  }
+  isolate->set_last_profile_output_micros(now);
+
+  StackZone stack_zone(thread);
+  Zone* zone = stack_zone.GetZone();
+  HANDLESCOPE(thread);
+  PprofBuilder builder(zone);
+  {
+    Profile profile(isolate);
+    SampleFilter filter(isolate->main_port(), Thread::kMutatorTask, start,
+                        duration);
+    profile.Build(thread, &filter, sample_buffer);
+    builder.AddSamples(&profile);
+  }
+  const char* name = OS::SCreate(zone, "%" Pd64, isolate->main_port());
+  WriteProfileFile(
+      zone, ProfileOutputPath(zone, name, isolate->profile_output_count()),
+      &builder, duration);
+  isolate->increment_profile_output_count();
+
+  WriteNativeAllocationProfileIfDue(thread, zone, now, force);
+}
+
+class ProfileOutputRequestVisitor : public IsolateVisitor {
+ public:
+  ProfileOutputRequestVisitor() {}
+
+  void VisitIsolate(Isolate* isolate) {
+    if (!IsSystemIsolate(isolate)) {
+      isolate->ScheduleInterrupts(Thread::kVMInterrupt);
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ProfileOutputRequestVisitor);
+};
+
+// Only accessed by the thread interrupter.
+static int64_t last_profile_output_request_micros = 0;
+
+void ProfilerService::RequestProfileOutputIfDue() {
+  if (FLAG_profile_output == NULL) {
+    return;
+  }
+  const int64_t now = OS::GetCurrentMonotonicMicros();
+  if (last_profile_output_request_micros == 0) {
+    last_profile_output_request_micros = now;
+    return;
+  }
+  if (!IsProfileOutputDue(now - last_profile_output_request_micros,
+                          /*force=*/false)) {
+    return;
+  }
+  last_profile_output_request_micros = now;
+  ProfileOutputRequestVisitor visitor;
+  Isolate::VisitIsolates(&visitor);
+}
+
 #endif  // !PRODUCT
 
 }  // namespace dart
@@ -10,6 +10,7 @@
 #include "vm/code_observers.h"
 #include "vm/globals.h"
 #include "vm/growable_array.h"
+#include "vm/hash_map.h"
 #include "vm/object.h"
 #include "vm/profiler.h"
 #include "vm/tags.h"
@@ -386,14 +387,20 @@ class Profile : public ValueObject {
 
   ProfileFunction* FindFunction(const Function& function);
 
+  // Adds the functions executing at |frame_index| of |sample| to |functions|,
+  // innermost inlined function first. Adds nothing for stubs and invisible
+  // functions.
+  void GetFunctionsAt(ProfileCodeInlinedFunctionsCache* cache,
+                      ProcessedSample* sample,
+                      intptr_t frame_index,
+                      GrowableArray<ProfileFunction*>* functions);
+
  private:
   void PrintHeaderJSON(JSONObject* obj);
   void ProcessSampleFrameJSON(JSONArray* stack,
                               ProfileCodeInlinedFunctionsCache* cache,
                               ProcessedSample* sample,
                               intptr_t frame_index);
-  void ProcessInlinedFunctionFrameJSON(JSONArray* stack,
-                                       const Function* inlined_function);
   void PrintFunctionFrameIndexJSON(JSONArray* stack, ProfileFunction* function);
   void PrintCodeFrameIndexJSON(JSONArray* stack,
                                ProcessedSample* sample,
@@ -418,6 +425,63 @@ class Profile : public ValueObject {
   friend class ProfileBuilder;
 };
 
+// Builds a profile in the pprof format, see
+// https://github.com/google/pprof/blob/master/proto/profile.proto.
+//
+// Functions are identified by their name and script, so samples of several
+// |Profile|s can be added to one pprof profile. Samples with the same stack
+// are aggregated.
+class PprofBuilder : public ValueObject {
+ public:
+  explicit PprofBuilder(Zone* zone);
+
+  void AddSamples(Profile* profile);
+
+  // Writes the encoded profile. |time_micros| is the wall clock time at
+  // which the profile starts.
+  void Write(BaseWriteStream* stream,
+             int64_t time_micros,
+             int64_t duration_micros);
+
+ private:
+  // The values recorded for each sample, in the order of the sample types.
+  enum SampleValue {
+    kSampleCount,
+    kCpuTime,
+    kAllocationCount,
+    kAllocationSize,
+    kNumSampleValues,
+  };
+
+  struct AggregatedSample : public ZoneAllocated {
+    explicit AggregatedSample(Zone* zone) : locations(zone, 8) {}
+
+    // Location ids, innermost frame first.
+    ZoneGrowableArray<intptr_t> locations;
+    int64_t values[kNumSampleValues] = {};
+    // Index of the allocated class' name in the string table, or 0.
+    intptr_t class_name = 0;
+  };
+
+  intptr_t InternString(const char* str);
+  // Every function has a single location with the same id.
+  intptr_t LocationFor(ProfileFunction* function);
+
+  Zone* zone_;
+  ZoneGrowableArray<const char*> strings_;
+  CStringIntMap string_indices_;
+  // Indices of the name and file name of each function in the string table.
+  ZoneGrowableArray<intptr_t> function_names_;
+  ZoneGrowableArray<intptr_t> function_files_;
+  CStringIntMap function_ids_;
+  ZoneGrowableArray<AggregatedSample*> samples_;
+  CStringIntMap sample_indices_;
+  intptr_t sample_type_names_[kNumSampleValues];
+  intptr_t sample_type_units_[kNumSampleValues];
+
+  DISALLOW_COPY_AND_ASSIGN(PprofBuilder);
+};
+
 class ProfilerService : public AllStatic {
  public:
   static void PrintJSON(JSONStream* stream,
@@ -441,6 +505,17 @@ class ProfilerService : public AllStatic {
 
   static void ClearSamples();
 
+  // Writes a pprof profile of the samples of the current isolate which were
+  // taken since the last call, if --profile_output is set and either
+  // --profile_output_period seconds have passed or |force| is true.
+  static void WriteProfileIfDue(Thread* thread, bool force);
+
+  // Called periodically by the thread interrupter. Once every
+  // --profile_output_period seconds, interrupts the mutators of all isolates
+  // so that those which are busy write their profiles without waiting for
+  // their next message.
+  static void RequestProfileOutputIfDue();
+
  private:
   static void PrintJSONImpl(Thread* thread,
                             JSONStream* stream,
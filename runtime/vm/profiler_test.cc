@@ -21,6 +21,8 @@ DECLARE_FLAG(bool, profile_vm);
 DECLARE_FLAG(bool, profile_vm_allocation);
 DECLARE_FLAG(int, max_profile_depth);
 DECLARE_FLAG(int, optimization_counter_threshold);
+DECLARE_FLAG(charp, profile_output);
+DECLARE_FLAG(int, profile_output_period);
 
 // Some tests are written assuming native stack trace profiling is disabled.
 class DisableNativeProfileScope : public ValueObject {
@@ -478,6 +480,118 @@ ISOLATE_UNIT_TEST_CASE(Profiler_TrivialRecordAllocation) {
   }
 }
 
+static bool ContainsString(const uint8_t* buffer,
+                           intptr_t length,
+                           const char* str) {
+  const intptr_t str_length = strlen(str);
+  for (intptr_t i = 0; i + str_length <= length; i++) {
+    if (memcmp(buffer + i, str, str_length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+ISOLATE_UNIT_TEST_CASE(Profiler_PprofAllocation) {
+  EnableProfiler();
+  DisableNativeProfileScope dnps;
+  DisableBackgroundCompilationScope dbcs;
+  const char* kScript =
+      "class A {\n"
+      "  var a;\n"
+      "  var b;\n"
+      "}\n"
+      "class B {\n"
+      "  static boo() {\n"
+      "    return new A();\n"
+      "  }\n"
+      "}\n"
+      "main() {\n"
+      "  return B.boo();\n"
+      "}\n";
+
+  const Library& root_library = Library::Handle(LoadTestScript(kScript));
+
+  const int64_t before_allocations_micros = Dart_TimelineGetMicros();
+  const Class& class_a = Class::Handle(GetClass(root_library, "A"));
+  EXPECT(!class_a.IsNull());
+  class_a.SetTraceAllocation(true);
+
+  Invoke(root_library, "main");
+
+  const int64_t after_allocations_micros = Dart_TimelineGetMicros();
+  const int64_t allocation_extent_micros =
+      after_allocations_micros - before_allocations_micros;
+  {
+    Thread* thread = Thread::Current();
+    Isolate* isolate = thread->isolate();
+    StackZone zone(thread);
+    HANDLESCOPE(thread);
+    Profile profile(isolate);
+    AllocationFilter filter(isolate->main_port(), class_a.id(),
+                            before_allocations_micros,
+                            allocation_extent_micros);
+    profile.Build(thread, &filter, Profiler::sample_buffer());
+    EXPECT_EQ(1, profile.sample_count());
+
+    PprofBuilder builder(thread->zone());
+    builder.AddSamples(&profile);
+    ZoneWriteStream stream(thread->zone(), KB);
+    builder.Write(&stream, OS::GetCurrentTimeMicros(),
+                  allocation_extent_micros);
+    // The profile starts with its sample types (field 1, length delimited).
+    EXPECT(stream.bytes_written() > 0);
+    EXPECT_EQ(0x0a, stream.buffer()[0]);
+    EXPECT(ContainsString(stream.buffer(), stream.bytes_written(),
+                          "alloc_objects"));
+    EXPECT(ContainsString(stream.buffer(), stream.bytes_written(), "B.boo"));
+    EXPECT(ContainsString(stream.buffer(), stream.bytes_written(), "main"));
+  }
+}
+
+static intptr_t profile_output_files = 0;
+
+static void* ProfileOutputOpen(const char* name, bool write) {
+  EXPECT(write);
+  profile_output_files++;
+  return &profile_output_files;
+}
+
+static void ProfileOutputWrite(const void* data, intptr_t length, void* file) {
+  EXPECT(length > 0);
+}
+
+static void ProfileOutputClose(void* file) {}
+
+// A busy isolate writes its profile when the profiler thread interrupts it,
+// without waiting for a message.
+ISOLATE_UNIT_TEST_CASE(Profiler_ProfileOutputOnInterrupt) {
+  EnableProfiler();
+  DisableNativeProfileScope dnps;
+  SetFlagScope<charp> sfs_output(&FLAG_profile_output, "profile.pb");
+  SetFlagScope<int> sfs_period(&FLAG_profile_output_period, 0);
+  Dart_FileOpenCallback file_open = Dart::file_open_callback();
+  Dart_FileReadCallback file_read = Dart::file_read_callback();
+  Dart_FileWriteCallback file_write = Dart::file_write_callback();
+  Dart_FileCloseCallback file_close = Dart::file_close_callback();
+  Dart::SetFileCallbacks(ProfileOutputOpen, file_read, ProfileOutputWrite,
+                         ProfileOutputClose);
+
+  Isolate* isolate = thread->isolate();
+  const intptr_t count = isolate->profile_output_count();
+  const intptr_t files = profile_output_files;
+  // The first request only starts the period.
+  ProfilerService::RequestProfileOutputIfDue();
+  ProfilerService::RequestProfileOutputIfDue();
+  EXPECT(thread->HasScheduledInterrupts());
+  const Error& error = Error::Handle(thread->HandleInterrupts());
+  EXPECT(error.IsNull());
+  EXPECT_EQ(count + 1, isolate->profile_output_count());
+  EXPECT_LE(files + 1, profile_output_files);
+
+  Dart::SetFileCallbacks(file_open, file_read, file_write, file_close);
+}
+
 #if defined(DART_USE_TCMALLOC) && defined(DART_HOST_OS_LINUX) &&               \
     defined(DEBUG) && defined(HOST_ARCH_X64)
 
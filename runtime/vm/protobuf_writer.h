@@ -0,0 +1,75 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_PROTOBUF_WRITER_H_
+#define RUNTIME_VM_PROTOBUF_WRITER_H_
+
+#include "vm/allocation.h"
+#include "vm/datastream.h"
+
+namespace dart {
+
+// Writes fields in the protocol buffer wire format, see
+// https://developers.google.com/protocol-buffers/docs/encoding.
+//
+// Nested messages are encoded into a separate stream first, since they are
+// prefixed with their length.
+class ProtobufWriter : public AllStatic {
+ public:
+  static void WriteVarint(BaseWriteStream* stream,
+                          intptr_t field,
+                          uint64_t value) {
+    WriteTag(stream, field, kWireTypeVarint);
+    stream->WriteLEB128(value);
+  }
+
+  static void WriteFixed64(BaseWriteStream* stream,
+                           intptr_t field,
+                           uint64_t value) {
+    WriteTag(stream, field, kWireTypeFixed64);
+    // The wire format is little endian.
+    for (intptr_t i = 0; i < 8; i++) {
+      stream->WriteByte(static_cast<uint8_t>(value >> (i * kBitsPerByte)));
+    }
+  }
+
+  static void WriteBytes(BaseWriteStream* stream,
+                         intptr_t field,
+                         const void* bytes,
+                         intptr_t length) {
+    WriteTag(stream, field, kWireTypeLengthDelimited);
+    stream->WriteLEB128(static_cast<uint64_t>(length));
+    stream->WriteBytes(bytes, length);
+  }
+
+  static void WriteString(BaseWriteStream* stream,
+                          intptr_t field,
+                          const char* value) {
+    WriteBytes(stream, field, value, strlen(value));
+  }
+
+  // Writes the message (or packed repeated field) encoded in |message| and
+  // resets |message|.
+  static void WriteMessage(BaseWriteStream* stream,
+                           intptr_t field,
+                           NonStreamingWriteStream* message) {
+    WriteBytes(stream, field, message->buffer(), message->bytes_written());
+    message->SetPosition(0);
+  }
+
+ private:
+  static const intptr_t kWireTypeVarint = 0;
+  static const intptr_t kWireTypeFixed64 = 1;
+  static const intptr_t kWireTypeLengthDelimited = 2;
+
+  static void WriteTag(BaseWriteStream* stream,
+                       intptr_t field,
+                       intptr_t wire_type) {
+    stream->WriteLEB128(static_cast<uint64_t>((field << 3) | wire_type));
+  }
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_PROTOBUF_WRITER_H_
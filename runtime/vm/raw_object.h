@@ -2905,6 +2905,9 @@ class UntaggedTypedDataView : public UntaggedTypedDataBase {
   friend class ObjectPoolSerializationCluster;
   friend class UntaggedObjectPool;
   friend class GCCompactor;
+  friend class GCEvacuator;
+  template <bool>
+  friend class MarkingVisitorBase;
   template <bool>
   friend class ScavengerVisitorBase;
   friend class SnapshotReader;
@@ -93,6 +93,12 @@ DEFINE_FLAG(bool,
             unopt_megamorphic_calls,
             true,
             "Enable specializing megamorphic calls from unoptimized code.");
+DEFINE_FLAG(int,
+            megamorphic_counted_checks,
+            16,
+            "Number of receiver classes, beyond max_polymorphic_checks, whose "
+            "calls an unoptimized megamorphic call site keeps counting before "
+            "it switches to the megamorphic cache, which does not count.");
 DEFINE_FLAG(bool,
             verbose_stack_overflow,
             false,
@@ -423,8 +429,13 @@ DEFINE_RUNTIME_ENTRY(AllocateObject, 2) {
   const Error& error =
       Error::Handle(zone, cls.EnsureIsAllocateFinalized(thread));
   ThrowIfError(error);
-  const Instance& instance =
-      Instance::Handle(zone, Instance::New(cls, SpaceForRuntimeAllocation()));
+  // Classes selected for pretenuring have their allocation stubs fall back to
+  // this runtime entry (--pretenure).
+  const Heap::Space space =
+      thread->heap()->new_space()->ShouldPretenure(cls.id())
+          ? Heap::kOld
+          : SpaceForRuntimeAllocation();
+  const Instance& instance = Instance::Handle(zone, Instance::New(cls, space));
 
   arguments.SetReturn(instance);
   if (cls.NumTypeArguments() == 0) {
@@ -1392,12 +1403,19 @@ static void TrySwitchInstanceCall(Thread* thread,
   // Megamorphic call.
   if (FLAG_unopt_megamorphic_calls &&
       (num_checks > FLAG_max_polymorphic_checks)) {
+    ic_data.set_is_megamorphic(true);
+    // Keep counting the receivers in the ICData for a while, so that the
+    // optimizing compiler sees which classes dominate the site after it went
+    // megamorphic rather than only the calls made before.
+    if (num_checks <=
+        FLAG_max_polymorphic_checks + FLAG_megamorphic_counted_checks) {
+      return;
+    }
     const String& name = String::Handle(zone, ic_data.target_name());
     const Array& descriptor =
         Array::Handle(zone, ic_data.arguments_descriptor());
     const MegamorphicCache& cache = MegamorphicCache::Handle(
         zone, MegamorphicCacheTable::Lookup(thread, name, descriptor));
-    ic_data.set_is_megamorphic(true);
     CodePatcher::PatchInstanceCallAt(caller_frame->pc(), caller_code, cache,
                                      StubCode::MegamorphicCall());
     if (FLAG_trace_ic) {
@@ -16,6 +16,7 @@
 #include "vm/object.h"
 #include "vm/os_thread.h"
 #include "vm/profiler.h"
+#include "vm/profiler_service.h"
 #include "vm/runtime_entry.h"
 #include "vm/stub_code.h"
 #include "vm/symbols.h"
@@ -290,6 +291,11 @@ bool Thread::EnterIsolate(Isolate* isolate, bool is_nested_reenter) {
     ASSERT(thread->isolate() == isolate);
     ASSERT(thread->isolate_group() == isolate->group());
     thread->FinishEntering(kMutatorTask);
+    if (FLAG_pretenure &&
+        thread->heap()->new_space()->HasPendingPretenuringDecisions()) {
+      // Decided by a scavenge while no mutator was scheduled.
+      thread->ScheduleInterrupts(kVMInterrupt);
+    }
     return true;
   }
   return false;
@@ -507,6 +513,15 @@ ErrorPtr Thread::HandleInterrupts() {
       }
       heap()->CollectGarbage(Heap::kNew);
     }
+    if (FLAG_pretenure) {
+      heap()->new_space()->ApplyPretenuringDecisions(this);
+    }
+#if !defined(PRODUCT)
+    // Busy isolates are interrupted periodically to write their profiles.
+    if (IsMutatorThread()) {
+      ProfilerService::WriteProfileIfDue(this, /*force=*/false);
+    }
+#endif
   }
   if ((interrupt_bits & kMessageInterrupt) != 0) {
     MessageHandler::MessageStatus status =
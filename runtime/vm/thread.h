@@ -577,6 +577,12 @@ class Thread : public ThreadState {
   static intptr_t top_offset() { return OFFSET_OF(Thread, top_); }
   static intptr_t end_offset() { return OFFSET_OF(Thread, end_); }
 
+  // Old-space allocation buffer, see PageSpace::TryAllocateInTLAB.
+  uword old_space_top() const { return old_space_top_; }
+  uword old_space_end() const { return old_space_end_; }
+  void set_old_space_top(uword top) { old_space_top_ = top; }
+  void set_old_space_end(uword end) { old_space_end_ = end; }
+
   int32_t no_safepoint_scope_depth() const {
 #if defined(DEBUG)
     return no_safepoint_scope_depth_;
@@ -1099,6 +1105,8 @@ class Thread : public ThreadState {
   TimelineStream* dart_stream_;
   IsolateGroup* isolate_group_ = nullptr;
   mutable Monitor thread_lock_;
+  uword old_space_top_ = 0;
+  uword old_space_end_ = 0;
   ApiLocalScope* api_reusable_scope_;
   int32_t no_callback_scope_depth_;
   intptr_t no_reload_scope_depth_ = 0;
@@ -7,6 +7,7 @@
 #include "vm/flags.h"
 #include "vm/lockers.h"
 #include "vm/os.h"
+#include "vm/profiler_service.h"
 #include "vm/simulator.h"
 
 namespace dart {
@@ -217,6 +218,8 @@ void ThreadInterrupter::ThreadMain(uword parameters) {
         }
       }
 
+      ProfilerService::RequestProfileOutputIfDue();
+
       // Take the monitor lock again.
       wait_ml.Enter();
 
@@ -18,6 +18,7 @@
 #include "vm/lockers.h"
 #include "vm/log.h"
 #include "vm/object.h"
+#include "vm/protobuf_writer.h"
 #include "vm/service.h"
 #include "vm/service_event.h"
 #include "vm/thread.h"
@@ -47,7 +48,8 @@ DEFINE_FLAG(charp,
             timeline_recorder,
             "ring",
             "Select the timeline recorder used. "
-            "Valid values: ring, endless, startup, and systrace.")
+            "Valid values: ring, endless, startup, systrace, and "
+            "perfettofile[:<path>].")
 
 // Implementation notes:
 //
@@ -90,6 +92,10 @@ DEFINE_FLAG(charp,
 //     |Thread::timeline_block_lock_|
 //       |TimelineEventRecorder::lock_|
 //
+// The |TimelineEventPerfettoFileRecorder| does not use its |lock_|. Threads
+// hand their finished blocks to it through a lock-free list, from which they
+// are taken by a background thread that writes them to a file.
+//
 
 static TimelineEventRecorder* CreateTimelineRecorder() {
   // Some flags require that we use the endless recorder.
@@ -132,6 +138,22 @@ static TimelineEventRecorder* CreateTimelineRecorder() {
     }
   }
 
+  if ((flag != NULL) && (strncmp("perfettofile", flag, 12) == 0) &&
+      ((flag[12] == '\0') || (flag[12] == ':'))) {
+    if (FLAG_trace_timeline) {
+      THR_Print("Using the Perfetto file timeline recorder.\n");
+    }
+    if (flag[12] == ':') {
+      return new TimelineEventPerfettoFileRecorder(&flag[13]);
+    }
+    char* path = OS::SCreate(NULL, "dart-timeline-%" Pd ".perfetto-trace",
+                             OS::ProcessId());
+    TimelineEventRecorder* recorder =
+        new TimelineEventPerfettoFileRecorder(path);
+    free(path);
+    return recorder;
+  }
+
   if (use_startup_recorder || (flag != NULL)) {
     if (use_startup_recorder || (strcmp("startup", flag) == 0)) {
       if (FLAG_trace_timeline) {
@@ -970,17 +992,15 @@ TimelineEvent* TimelineEventRecorder::ThreadBlockStartEvent() {
   TimelineEventBlock* thread_block = thread->timeline_block();
 
   if ((thread_block != NULL) && thread_block->IsFull()) {
-    MutexLocker ml(&lock_);
     // Thread has a block and it is full:
     // 1) Mark it as finished.
-    thread_block->Finish();
+    FinishBlock(thread_block);
     // 2) Allocate a new block.
-    thread_block = GetNewBlockLocked();
+    thread_block = GetNewBlock();
     thread->set_timeline_block(thread_block);
   } else if (thread_block == NULL) {
-    MutexLocker ml(&lock_);
     // Thread has no block. Attempt to allocate one.
-    thread_block = GetNewBlockLocked();
+    thread_block = GetNewBlock();
     thread->set_timeline_block(thread_block);
   }
   if (thread_block != NULL) {
@@ -1421,6 +1441,387 @@ void TimelineEventEndlessRecorder::Clear() {
   block_index_ = 0;
 }
 
+// Field numbers and enum values from the Perfetto trace protos, see
+// https://perfetto.dev/docs/reference/trace-packet-proto.
+namespace perfetto {
+// message Trace.
+static const intptr_t kTracePacket = 1;
+// message TracePacket.
+static const intptr_t kClockSnapshot = 6;
+static const intptr_t kTimestamp = 8;
+static const intptr_t kTrustedPacketSequenceId = 10;
+static const intptr_t kTrackEvent = 11;
+static const intptr_t kTimestampClockId = 58;
+static const intptr_t kTrackDescriptor = 60;
+// message ClockSnapshot.
+static const intptr_t kClocks = 1;
+static const intptr_t kPrimaryTraceClock = 2;
+// message ClockSnapshot.Clock.
+static const intptr_t kClockId = 1;
+static const intptr_t kClockTimestamp = 2;
+// message TrackDescriptor.
+static const intptr_t kUuid = 1;
+static const intptr_t kTrackName = 2;
+static const intptr_t kThread = 4;
+// message ThreadDescriptor.
+static const intptr_t kPid = 1;
+static const intptr_t kTid = 2;
+static const intptr_t kThreadName = 5;
+// message TrackEvent.
+static const intptr_t kDebugAnnotations = 4;
+static const intptr_t kType = 9;
+static const intptr_t kTrackUuid = 11;
+static const intptr_t kCategories = 22;
+static const intptr_t kName = 23;
+static const intptr_t kFlowIds = 47;
+static const intptr_t kTerminatingFlowIds = 48;
+// message DebugAnnotation.
+static const intptr_t kStringValue = 6;
+static const intptr_t kAnnotationName = 10;
+
+// enum TrackEvent.Type.
+static const intptr_t kTypeSliceBegin = 1;
+static const intptr_t kTypeSliceEnd = 2;
+static const intptr_t kTypeInstant = 3;
+// enum BuiltinClock. Matches OS::GetCurrentMonotonicMicros.
+static const intptr_t kBuiltinClockMonotonic = 3;
+
+// The tracks of async events are not attached to a thread. Keep their uuids
+// apart from those of thread tracks, which are thread ids.
+static const uint64_t kAsyncTrackUuidBit = static_cast<uint64_t>(1) << 63;
+}  // namespace perfetto
+
+TimelineEventPerfettoFileRecorder::TimelineEventPerfettoFileRecorder(
+    const char* path)
+    : file_(NULL),
+      finished_blocks_(NULL),
+      block_index_(0),
+      flusher_running_(false),
+      shutting_down_(false),
+      flusher_join_id_(OSThread::kInvalidThreadJoinId),
+      output_(16 * KB),
+      packet_(KB),
+      track_event_(KB),
+      message_(KB) {
+  if (path != NULL) {
+    Dart_FileOpenCallback file_open = Dart::file_open_callback();
+    if ((file_open == NULL) || (Dart::file_write_callback() == NULL) ||
+        (Dart::file_close_callback() == NULL)) {
+      OS::PrintErr("Failed to write timeline file: no file callbacks\n");
+    } else {
+      file_ = (*file_open)(path, true);
+      if (file_ == NULL) {
+        OS::PrintErr("Failed to write timeline file: %s\n", path);
+      }
+    }
+  }
+
+  MonitorLocker ml(&flusher_monitor_);
+  WriteClockSnapshot();
+  flusher_running_ = true;
+  int result = OSThread::Start("TimelinePerfettoFileRecorder", &FlusherMain,
+                               reinterpret_cast<uword>(this));
+  if (result != 0) {
+    FATAL1("Could not start timeline flusher thread %d", result);
+  }
+}
+
+TimelineEventPerfettoFileRecorder::~TimelineEventPerfettoFileRecorder() {
+  ShutDown();
+  if (file_ != NULL) {
+    (*Dart::file_close_callback())(file_);
+    file_ = NULL;
+  }
+}
+
+void TimelineEventPerfettoFileRecorder::ShutDown() {
+  {
+    MonitorLocker ml(&flusher_monitor_);
+    if (!flusher_running_) {
+      return;
+    }
+    shutting_down_ = true;
+    ml.Notify();
+    while (flusher_join_id_ == OSThread::kInvalidThreadJoinId) {
+      ml.Wait();
+    }
+  }
+  OSThread::Join(flusher_join_id_);
+
+  // The flusher thread's block was finished when it exited.
+  MonitorLocker ml(&flusher_monitor_);
+  flusher_running_ = false;
+  FlushLocked();
+}
+
+void TimelineEventPerfettoFileRecorder::FlusherMain(uword parameter) {
+  TimelineEventPerfettoFileRecorder* recorder =
+      reinterpret_cast<TimelineEventPerfettoFileRecorder*>(parameter);
+  MonitorLocker ml(&recorder->flusher_monitor_);
+  while (!recorder->shutting_down_) {
+    recorder->FlushLocked();
+    ml.Wait(kFlushIntervalMillis);
+  }
+  recorder->flusher_join_id_ =
+      OSThread::GetCurrentThreadJoinId(OSThread::Current());
+  ml.Notify();
+}
+
+#ifndef PRODUCT
+void TimelineEventPerfettoFileRecorder::PrintJSON(
+    JSONStream* js,
+    TimelineEventFilter* filter) {
+  JSONObject topLevel(js);
+  topLevel.AddProperty("type", "Timeline");
+  {
+    JSONArray events(&topLevel, "traceEvents");
+    PrintJSONMeta(&events);
+  }
+  topLevel.AddPropertyTimeMicros("timeOriginMicros", TimeOriginMicros());
+  topLevel.AddPropertyTimeMicros("timeExtentMicros", TimeExtentMicros());
+}
+
+void TimelineEventPerfettoFileRecorder::PrintTraceEvent(
+    JSONStream* js,
+    TimelineEventFilter* filter) {
+  JSONArray events(js);
+}
+#endif
+
+TimelineEvent* TimelineEventPerfettoFileRecorder::StartEvent() {
+  return ThreadBlockStartEvent();
+}
+
+void TimelineEventPerfettoFileRecorder::CompleteEvent(TimelineEvent* event) {
+  if (event == NULL) {
+    return;
+  }
+  ThreadBlockCompleteEvent(event);
+}
+
+TimelineEventBlock* TimelineEventPerfettoFileRecorder::GetNewBlock() {
+  TimelineEventBlock* block = new TimelineEventBlock(block_index_.fetch_add(1));
+  block->Open();
+  if (FLAG_trace_timeline) {
+    OS::PrintErr("Created new block %p\n", block);
+  }
+  return block;
+}
+
+void TimelineEventPerfettoFileRecorder::FinishBlock(TimelineEventBlock* block) {
+  if (block == NULL) {
+    return;
+  }
+  block->Finish();
+  TimelineEventBlock* head = finished_blocks_.load(std::memory_order_relaxed);
+  do {
+    block->set_next(head);
+  } while (!finished_blocks_.compare_exchange_weak(head, block));
+}
+
+void TimelineEventPerfettoFileRecorder::Flush() {
+  MonitorLocker ml(&flusher_monitor_);
+  FlushLocked();
+}
+
+void TimelineEventPerfettoFileRecorder::FlushLocked() {
+  ASSERT(flusher_monitor_.IsOwnedByCurrentThread());
+  TimelineEventBlock* head = finished_blocks_.exchange(NULL);
+  // Write the blocks in the order they were finished.
+  TimelineEventBlock* reversed = NULL;
+  while (head != NULL) {
+    TimelineEventBlock* next = head->next();
+    head->set_next(reversed);
+    reversed = head;
+    head = next;
+  }
+  while (reversed != NULL) {
+    TimelineEventBlock* next = reversed->next();
+    WriteBlock(reversed);
+    delete reversed;
+    reversed = next;
+  }
+  if (output_.bytes_written() > 0) {
+    Write(output_.buffer(), output_.bytes_written());
+    output_.SetPosition(0);
+  }
+}
+
+void TimelineEventPerfettoFileRecorder::Write(const uint8_t* buffer,
+                                              intptr_t length) {
+  if (file_ != NULL) {
+    (*Dart::file_write_callback())(buffer, length, file_);
+  }
+}
+
+void TimelineEventPerfettoFileRecorder::WriteBlock(TimelineEventBlock* block) {
+  ASSERT(!block->in_use());
+  for (intptr_t i = 0; i < block->length(); i++) {
+    const TimelineEvent* event = block->At(i);
+    if (event->IsValid()) {
+      WriteEvent(event);
+    }
+  }
+}
+
+void TimelineEventPerfettoFileRecorder::WriteEvent(
+    const TimelineEvent* event) {
+  const intptr_t tid = OSThread::ThreadIdToIntPtr(event->thread());
+  const uint64_t thread_track = static_cast<uint64_t>(tid);
+  bool has_thread_track = false;
+  for (intptr_t i = 0; i < thread_tracks_.length(); i++) {
+    if (thread_tracks_[i] == tid) {
+      has_thread_track = true;
+      break;
+    }
+  }
+  if (!has_thread_track) {
+    WriteThreadDescriptor(event->thread());
+    thread_tracks_.Add(tid);
+  }
+
+  const uint64_t async_track =
+      perfetto::kAsyncTrackUuidBit | static_cast<uint64_t>(event->AsyncId());
+  switch (event->event_type()) {
+    case TimelineEvent::kBegin:
+      WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeSliceBegin,
+                      thread_track);
+      break;
+    case TimelineEvent::kEnd:
+      WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeSliceEnd,
+                      thread_track);
+      break;
+    case TimelineEvent::kDuration:
+      if (event->IsFinishedDuration()) {
+        WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeSliceBegin,
+                        thread_track);
+        WriteTrackEvent(event, event->TimeEnd(), perfetto::kTypeSliceEnd,
+                        thread_track);
+      }
+      break;
+    case TimelineEvent::kInstant:
+    case TimelineEvent::kCounter:
+    case TimelineEvent::kFlowBegin:
+    case TimelineEvent::kFlowStep:
+    case TimelineEvent::kFlowEnd:
+      // Counter values and flow ids are attached to an instant.
+      WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeInstant,
+                      thread_track);
+      break;
+    case TimelineEvent::kAsyncBegin:
+      WriteAsyncDescriptor(event);
+      WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeSliceBegin,
+                      async_track);
+      break;
+    case TimelineEvent::kAsyncInstant:
+      WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeInstant,
+                      async_track);
+      break;
+    case TimelineEvent::kAsyncEnd:
+      WriteTrackEvent(event, event->TimeOrigin(), perfetto::kTypeSliceEnd,
+                      async_track);
+      break;
+    default:
+      // Metadata events have no equivalent.
+      break;
+  }
+}
+
+void TimelineEventPerfettoFileRecorder::WriteThreadDescriptor(
+    ThreadId thread) {
+  const intptr_t tid = OSThread::ThreadIdToIntPtr(thread);
+  ProtobufWriter::WriteVarint(&message_, perfetto::kPid, OS::ProcessId());
+  ProtobufWriter::WriteVarint(&message_, perfetto::kTid, tid);
+  {
+    // Only emit a thread name if the thread is alive and a name was set.
+    OSThreadIterator it;
+    while (it.HasNext()) {
+      OSThread* os_thread = it.Next();
+      if ((os_thread->trace_id() == thread) && (os_thread->name() != NULL)) {
+        ProtobufWriter::WriteString(&message_, perfetto::kThreadName,
+                                    os_thread->name());
+        break;
+      }
+    }
+  }
+  ProtobufWriter::WriteVarint(&track_event_, perfetto::kUuid, tid);
+  ProtobufWriter::WriteMessage(&track_event_, perfetto::kThread, &message_);
+  ProtobufWriter::WriteMessage(&packet_, perfetto::kTrackDescriptor,
+                               &track_event_);
+  WritePacket();
+}
+
+void TimelineEventPerfettoFileRecorder::WriteAsyncDescriptor(
+    const TimelineEvent* event) {
+  ProtobufWriter::WriteVarint(
+      &track_event_, perfetto::kUuid,
+      perfetto::kAsyncTrackUuidBit | static_cast<uint64_t>(event->AsyncId()));
+  ProtobufWriter::WriteString(&track_event_, perfetto::kTrackName,
+                              event->label());
+  ProtobufWriter::WriteMessage(&packet_, perfetto::kTrackDescriptor,
+                               &track_event_);
+  WritePacket();
+}
+
+void TimelineEventPerfettoFileRecorder::WriteClockSnapshot() {
+  // Timestamps are taken from the monotonic clock rather than the boot time
+  // clock Perfetto uses by default.
+  ProtobufWriter::WriteVarint(&track_event_, perfetto::kClockId,
+                              perfetto::kBuiltinClockMonotonic);
+  ProtobufWriter::WriteVarint(&track_event_, perfetto::kClockTimestamp,
+                              OS::GetCurrentMonotonicMicros() * 1000);
+  ProtobufWriter::WriteMessage(&message_, perfetto::kClocks, &track_event_);
+  ProtobufWriter::WriteVarint(&message_, perfetto::kPrimaryTraceClock,
+                              perfetto::kBuiltinClockMonotonic);
+  ProtobufWriter::WriteMessage(&packet_, perfetto::kClockSnapshot, &message_);
+  WritePacket();
+}
+
+void TimelineEventPerfettoFileRecorder::WriteTrackEvent(
+    const TimelineEvent* event,
+    int64_t micros,
+    intptr_t type,
+    uint64_t track_uuid) {
+  ProtobufWriter::WriteVarint(&track_event_, perfetto::kType, type);
+  ProtobufWriter::WriteVarint(&track_event_, perfetto::kTrackUuid, track_uuid);
+  if (type != perfetto::kTypeSliceEnd) {
+    if (event->stream_ != NULL) {
+      ProtobufWriter::WriteString(&track_event_, perfetto::kCategories,
+                                  event->stream_->name());
+    }
+    ProtobufWriter::WriteString(&track_event_, perfetto::kName,
+                                event->label());
+    for (intptr_t i = 0; i < event->arguments_length(); i++) {
+      const TimelineEventArgument& argument = event->arguments()[i];
+      ProtobufWriter::WriteString(&message_, perfetto::kAnnotationName,
+                                  argument.name);
+      ProtobufWriter::WriteString(&message_, perfetto::kStringValue,
+                                  argument.value);
+      ProtobufWriter::WriteMessage(&track_event_, perfetto::kDebugAnnotations,
+                                   &message_);
+    }
+    if ((event->event_type() == TimelineEvent::kFlowBegin) ||
+        (event->event_type() == TimelineEvent::kFlowStep)) {
+      ProtobufWriter::WriteFixed64(&track_event_, perfetto::kFlowIds,
+                                   event->AsyncId());
+    } else if (event->event_type() == TimelineEvent::kFlowEnd) {
+      ProtobufWriter::WriteFixed64(&track_event_,
+                                   perfetto::kTerminatingFlowIds,
+                                   event->AsyncId());
+    }
+  }
+  ProtobufWriter::WriteVarint(&packet_, perfetto::kTimestamp, micros * 1000);
+  ProtobufWriter::WriteVarint(&packet_, perfetto::kTimestampClockId,
+                              perfetto::kBuiltinClockMonotonic);
+  ProtobufWriter::WriteMessage(&packet_, perfetto::kTrackEvent, &track_event_);
+  WritePacket();
+}
+
+void TimelineEventPerfettoFileRecorder::WritePacket() {
+  ProtobufWriter::WriteVarint(&packet_, perfetto::kTrustedPacketSequenceId, 1);
+  ProtobufWriter::WriteMessage(&output_, perfetto::kTracePacket, &packet_);
+}
+
 TimelineEventBlock::TimelineEventBlock(intptr_t block_index)
     : next_(NULL),
       length_(0),
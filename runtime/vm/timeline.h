@@ -10,6 +10,7 @@
 #include "platform/atomic.h"
 #include "vm/allocation.h"
 #include "vm/bitfield.h"
+#include "vm/datastream.h"
 #include "vm/globals.h"
 #include "vm/growable_array.h"
 #include "vm/os.h"
@@ -51,6 +52,7 @@ class Zone;
 #define ENDLESS_RECORDER_NAME "Endless"
 #define FUCHSIA_RECORDER_NAME "Fuchsia"
 #define MACOS_RECORDER_NAME "Macos"
+#define PERFETTO_FILE_RECORDER_NAME "PerfettoFile"
 #define RING_RECORDER_NAME "Ring"
 #define STARTUP_RECORDER_NAME "Startup"
 #define SYSTRACE_RECORDER_NAME "Systrace"
@@ -482,6 +484,7 @@ class TimelineEvent {
   friend class TimelineEventPlatformRecorder;
   friend class TimelineEventFuchsiaRecorder;
   friend class TimelineEventMacosRecorder;
+  friend class TimelineEventPerfettoFileRecorder;
   friend class TimelineStream;
   friend class TimelineTestHelper;
   DISALLOW_COPY_AND_ASSIGN(TimelineEvent);
@@ -647,6 +650,7 @@ class TimelineEventBlock : public MallocAllocated {
   friend class TimelineEventRingRecorder;
   friend class TimelineEventStartupRecorder;
   friend class TimelineEventPlatformRecorder;
+  friend class TimelineEventPerfettoFileRecorder;
   friend class TimelineTestHelper;
   friend class JSONStream;
 
@@ -713,7 +717,7 @@ class TimelineEventRecorder : public MallocAllocated {
   TimelineEventRecorder();
   virtual ~TimelineEventRecorder() {}
 
-  TimelineEventBlock* GetNewBlock();
+  virtual TimelineEventBlock* GetNewBlock();
 
   // Interface method(s) which must be implemented.
 #ifndef PRODUCT
@@ -723,7 +727,7 @@ class TimelineEventRecorder : public MallocAllocated {
   virtual const char* name() const = 0;
   int64_t GetNextAsyncId();
 
-  void FinishBlock(TimelineEventBlock* block);
+  virtual void FinishBlock(TimelineEventBlock* block);
 
   virtual intptr_t Size() = 0;
 
@@ -887,6 +891,88 @@ class TimelineEventEndlessRecorder : public TimelineEventRecorder {
   friend class TimelineTestHelper;
 };
 
+// A recorder that streams events to a file in the Perfetto protobuf trace
+// format (https://perfetto.dev/docs/reference/trace-packet-proto).
+//
+// Threads write events into their own blocks, as with the other block based
+// recorders, but full blocks are handed over to a background thread through a
+// lock-free list instead of being kept by the recorder. The background thread
+// periodically encodes them, appends them to the file and frees them, so the
+// memory used by the recorder stays bounded and no events are dropped.
+class TimelineEventPerfettoFileRecorder : public TimelineEventRecorder {
+ public:
+  static const int64_t kFlushIntervalMillis = 100;
+
+  // Events are written to the file at |path|. If |path| is NULL, the encoded
+  // events are only passed to |Write|.
+  explicit TimelineEventPerfettoFileRecorder(const char* path);
+  virtual ~TimelineEventPerfettoFileRecorder();
+
+#ifndef PRODUCT
+  void PrintJSON(JSONStream* js, TimelineEventFilter* filter);
+  void PrintTraceEvent(JSONStream* js, TimelineEventFilter* filter);
+#endif
+
+  const char* name() const { return PERFETTO_FILE_RECORDER_NAME; }
+  intptr_t Size() { return 0; }
+
+  TimelineEventBlock* GetNewBlock();
+  void FinishBlock(TimelineEventBlock* block);
+
+  // Writes out all finished blocks.
+  void Flush();
+
+  // Stops the background thread and writes out all finished blocks. Must be
+  // called by the destructor of subclasses which override |Write|.
+  void ShutDown();
+
+ protected:
+  TimelineEvent* StartEvent();
+  void CompleteEvent(TimelineEvent* event);
+  TimelineEventBlock* GetHeadBlockLocked() { return NULL; }
+  TimelineEventBlock* GetNewBlockLocked() { return GetNewBlock(); }
+  void Clear() {}
+
+  // Called with a sequence of encoded trace packets.
+  virtual void Write(const uint8_t* buffer, intptr_t length);
+
+ private:
+  static void FlusherMain(uword parameter);
+
+  void FlushLocked();
+  void WriteBlock(TimelineEventBlock* block);
+  void WriteEvent(const TimelineEvent* event);
+  void WriteThreadDescriptor(ThreadId thread);
+  void WriteAsyncDescriptor(const TimelineEvent* event);
+  void WriteClockSnapshot();
+  void WriteTrackEvent(const TimelineEvent* event,
+                       int64_t micros,
+                       intptr_t type,
+                       uint64_t track_uuid);
+  void WritePacket();
+
+  void* file_;
+  // Blocks which are ready to be written, most recently finished first.
+  AcqRelAtomic<TimelineEventBlock*> finished_blocks_;
+  RelaxedAtomic<intptr_t> block_index_;
+
+  // The fields below are protected by |flusher_monitor_|.
+  Monitor flusher_monitor_;
+  bool flusher_running_;
+  bool shutting_down_;
+  ThreadJoinId flusher_join_id_;
+  // Threads which already have a track in the trace.
+  MallocGrowableArray<intptr_t> thread_tracks_;
+  // The encoded packets which have not been written yet and scratch space
+  // for encoding a single packet.
+  MallocWriteStream output_;
+  MallocWriteStream packet_;
+  MallocWriteStream track_event_;
+  MallocWriteStream message_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimelineEventPerfettoFileRecorder);
+};
+
 // An iterator for blocks.
 class TimelineEventBlockIterator {
  public:
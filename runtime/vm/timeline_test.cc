@@ -375,6 +375,77 @@ TEST_CASE(TimelineRingRecorderJSONOrder) {
   EXPECT(alpha < beta);
 }
 
+// A Perfetto recorder which keeps the encoded trace in memory.
+class PerfettoBufferRecorder : public TimelineEventPerfettoFileRecorder {
+ public:
+  PerfettoBufferRecorder()
+      : TimelineEventPerfettoFileRecorder(NULL), output_(KB) {}
+  ~PerfettoBufferRecorder() { ShutDown(); }
+
+  // Returns the number of occurrences of |str| in the trace.
+  intptr_t Count(const char* str) {
+    MutexLocker ml(&output_lock_);
+    const intptr_t length = strlen(str);
+    const uint8_t* buffer = output_.buffer();
+    intptr_t count = 0;
+    for (intptr_t i = 0; i + length <= output_.bytes_written(); i++) {
+      if (memcmp(&buffer[i], str, length) == 0) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  uint8_t FirstByte() {
+    MutexLocker ml(&output_lock_);
+    return output_.buffer()[0];
+  }
+
+ protected:
+  void Write(const uint8_t* buffer, intptr_t length) {
+    MutexLocker ml(&output_lock_);
+    output_.WriteBytes(buffer, length);
+  }
+
+ private:
+  Mutex output_lock_;
+  MallocWriteStream output_;
+};
+
+TEST_CASE(TimelinePerfettoFileRecorder) {
+  TimelineStream stream("testStream", "testStream", true);
+  PerfettoBufferRecorder* recorder = new PerfettoBufferRecorder();
+  TimelineRecorderOverride<PerfettoBufferRecorder> override(recorder);
+
+  // Fill several blocks.
+  const intptr_t kNumEvents = 3 * TimelineEventBlock::kBlockSize;
+  for (intptr_t i = 0; i < kNumEvents; i++) {
+    TimelineEvent* event = stream.StartEvent();
+    ASSERT(event != NULL);
+    event->Duration("cabbage", i + 1, i + 2);
+    event->Complete();
+  }
+  TimelineEvent* event = stream.StartEvent();
+  ASSERT(event != NULL);
+  event->Instant("carrot");
+  event->SetNumArguments(1);
+  event->CopyArgument(0, "color", "orange");
+  event->Complete();
+
+  Timeline::ReclaimCachedBlocksFromThreads();
+  recorder->Flush();
+
+  // A trace is a sequence of length delimited packets (field 1).
+  EXPECT_EQ(0x0a, recorder->FirstByte());
+  // Durations are written as a begin and an end slice. Only the begin slice
+  // has a name.
+  EXPECT_EQ(kNumEvents, recorder->Count("cabbage"));
+  EXPECT_EQ(1, recorder->Count("carrot"));
+  EXPECT_EQ(1, recorder->Count("color"));
+  EXPECT_EQ(1, recorder->Count("orange"));
+  EXPECT_EQ(kNumEvents + 1, recorder->Count("testStream"));
+}
+
 #endif  // !PRODUCT
 
 }  // namespace dart
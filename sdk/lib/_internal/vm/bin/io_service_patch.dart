@@ -34,7 +34,9 @@ class _IOServicePorts {
   }
 
   void _returnPort(int forRequestId) {
-    final SendPort port = _usedPorts.remove(forRequestId)!;
+    // Requests performed with io_uring were not given a port.
+    final SendPort? port = _usedPorts.remove(forRequestId);
+    if (port == null) return;
     if (!_usedPorts.values.contains(port)) {
       _freePorts.add(port);
     }
@@ -51,17 +53,23 @@ class _IOService {
   static HashMap<int, Completer> _messageMap = new HashMap<int, Completer>();
   static int _id = 0;
 
+  static final bool _ioUringSupported = _ioUringIsSupported();
+  static bool _ioUringSubmitScheduled = false;
+
   @patch
   static Future _dispatch(int request, List data) {
     int id;
     do {
       id = _getNextId();
     } while (_messageMap.containsKey(id));
-    final SendPort servicePort = _servicePorts._getPort(id);
     _ensureInitialize();
     final Completer completer = new Completer();
     _messageMap[id] = completer;
     try {
+      if (_ioUringSupported && _submitToIOUring(id, request, data)) {
+        return completer.future;
+      }
+      final SendPort servicePort = _servicePorts._getPort(id);
       servicePort.send(<dynamic>[id, _replyToPort, request, data]);
     } catch (error) {
       _messageMap.remove(id)!.complete(error);
@@ -72,6 +80,37 @@ class _IOService {
     return completer.future;
   }
 
+  // Queues the file reads, writes and flushes which io_uring can perform.
+  // Their responses are the same as the IO service ones. The requests queued
+  // while running the current task are submitted together.
+  static bool _submitToIOUring(int id, int request, List data) {
+    bool accepted;
+    switch (request) {
+      case _IOService.fileRead:
+      case _IOService.fileReadInto:
+        accepted = _ioUringRead(data[0], data[1],
+            request == _IOService.fileReadInto, id, _replyToPort);
+        break;
+      case _IOService.fileWriteFrom:
+        accepted = _ioUringWrite(
+            data[0], data[1], data[2], data[3], id, _replyToPort);
+        break;
+      case _IOService.fileFlush:
+        accepted = _ioUringFlush(data[0], id, _replyToPort);
+        break;
+      default:
+        return false;
+    }
+    if (accepted && !_ioUringSubmitScheduled) {
+      _ioUringSubmitScheduled = true;
+      scheduleMicrotask(() {
+        _ioUringSubmitScheduled = false;
+        _ioUringSubmit();
+      });
+    }
+    return accepted;
+  }
+
   static void _ensureInitialize() {
     if (_receivePort == null) {
       _receivePort = new RawReceivePort(null, 'IO Service');
@@ -97,4 +136,13 @@ class _IOService {
     if (_id == 0x7FFFFFFF) _id = 0;
     return _id++;
   }
+
+  static bool _ioUringIsSupported() native "IOUring_IsSupported";
+  static bool _ioUringRead(int pointer, int length, bool into, int id,
+      SendPort replyPort) native "IOUring_Read";
+  static bool _ioUringWrite(int pointer, List<int> buffer, int start, int end,
+      int id, SendPort replyPort) native "IOUring_Write";
+  static bool _ioUringFlush(int pointer, int id, SendPort replyPort)
+      native "IOUring_Flush";
+  static void _ioUringSubmit() native "IOUring_Submit";
 }
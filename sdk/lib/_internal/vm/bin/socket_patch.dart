@@ -477,6 +477,15 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
   // Only used for UDP sockets.
   bool _availableDatagram = false;
 
+  // The datagrams received by the last batch and not returned by receive yet.
+  // Datagrams without data are null. Only used for UDP sockets.
+  Queue<Datagram?>? _receivedDatagrams;
+
+  // The number of datagrams requested by the next batch. It grows while the
+  // batches are full, up to _maxReceiveBatchSize.
+  int _receiveBatchSize = 1;
+  static const int _maxReceiveBatchSize = 16;
+
   // The number of incoming connnections for Listening socket.
   int connections = 0;
 
@@ -1064,12 +1073,16 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
   Datagram? receive() {
     if (isClosing || isClosed) return null;
     try {
-      Datagram? result = nativeRecvFrom();
+      final datagrams = _receivedDatagrams ??= new Queue<Datagram?>();
+      if (datagrams.isEmpty) {
+        _receiveBatch(datagrams);
+      }
+      Datagram? result = datagrams.isEmpty ? null : datagrams.removeFirst();
       if (!const bool.fromEnvironment("dart.vm.product")) {
         _SocketProfile.collectStatistic(nativeGetSocketId(),
             _SocketProfileType.readBytes, result?.data.length);
       }
-      _availableDatagram = nativeAvailableDatagram();
+      _availableDatagram = datagrams.isNotEmpty || nativeAvailableDatagram();
       return result;
     } catch (e) {
       reportError(e, StackTrace.current, "Receive failed");
@@ -1077,6 +1090,29 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
     }
   }
 
+  // Receives the available datagrams with a single native call.
+  void _receiveBatch(Queue<Datagram?> datagrams) {
+    const int argumentCount = 5;
+    final List<Object?>? batch = nativeRecvFromBatch(_receiveBatchSize);
+    if (batch == null) return;
+    for (int i = 0; i < batch.length; i += argumentCount) {
+      if (batch[i] == null) {
+        datagrams.add(null);
+        continue;
+      }
+      datagrams.add(_makeDatagram(
+          batch[i] as Uint8List,
+          batch[i + 1] as String,
+          batch[i + 2] as Uint8List,
+          batch[i + 3] as int,
+          batch[i + 4] as int));
+    }
+    if (batch.length == _receiveBatchSize * argumentCount &&
+        _receiveBatchSize < _maxReceiveBatchSize) {
+      _receiveBatchSize *= 2;
+    }
+  }
+
   static int _fixOffset(int? offset) => offset ?? 0;
 
   int write(List<int> buffer, int offset, int? bytes) {
@@ -1122,6 +1158,42 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
     }
   }
 
+  // Writes [count] buffers, the first one from [offset], with a single call
+  // to writev instead of one write for each buffer.
+  int writeList(List<List<int>> buffers, int offset, int count) {
+    if (isClosing || isClosed) return 0;
+    try {
+      final list = new List<Object>.filled(count * 3, 0);
+      int bytes = 0;
+      for (int i = 0; i < count; i++) {
+        final buffer = buffers[i];
+        final start = (i == 0) ? offset : 0;
+        _BufferAndStart bufferAndStart =
+            _ensureFastAndSerializableByteData(buffer, start, buffer.length);
+        final length = buffer.length - start;
+        list[i * 3] = bufferAndStart.buffer;
+        list[i * 3 + 1] = bufferAndStart.start;
+        list[i * 3 + 2] = bufferAndStart.start + length;
+        bytes += length;
+      }
+      if (!const bool.fromEnvironment("dart.vm.product")) {
+        _SocketProfile.collectStatistic(
+            nativeGetSocketId(), _SocketProfileType.writeBytes, bytes);
+      }
+      int result = nativeWriteVector(list);
+      // As in write, a negative result is a forced short write.
+      if (result >= 0 && result < bytes) {
+        writeAvailable = false;
+      }
+      if (result < 0) result = -result;
+      return result;
+    } catch (e) {
+      StackTrace st = StackTrace.current;
+      scheduleMicrotask(() => reportError(e, st, "Write failed"));
+      return 0;
+    }
+  }
+
   int send(List<int> buffer, int offset, int bytes, InternetAddress address,
       int port) {
     _throwOnBadPort(port);
@@ -1145,6 +1217,30 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
     }
   }
 
+  // Sends up to [count] bytes of [file] from [position] without copying them
+  // through Dart. Returns the number of bytes sent, which is 0 at the end of
+  // the file, null if nothing could be sent until the next write event, or -1
+  // if the file cannot be sent this way, e.g. because it is not a regular
+  // file.
+  int? sendFile(_RandomAccessFile file, int position, int count) {
+    if (isClosing || isClosed) return null;
+    try {
+      int? result = nativeSendFile(file._pointer(), position, count);
+      if (result == null) {
+        writeAvailable = false;
+      } else if (result > 0 &&
+          !const bool.fromEnvironment("dart.vm.product")) {
+        _SocketProfile.collectStatistic(
+            nativeGetSocketId(), _SocketProfileType.writeBytes, result);
+      }
+      return result;
+    } catch (e) {
+      StackTrace st = StackTrace.current;
+      scheduleMicrotask(() => reportError(e, st, "Write failed"));
+      return null;
+    }
+  }
+
   _NativeSocket? accept() {
     // Don't issue accept if we're closing.
     if (isClosing || isClosed) return null;
@@ -1273,7 +1369,10 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
             connections++;
           } else {
             if (isUdp) {
-              _availableDatagram = nativeAvailableDatagram();
+              // Datagrams received by an earlier batch are still available
+              // when the kernel has none.
+              _availableDatagram = (_receivedDatagrams?.isNotEmpty ?? false) ||
+                  nativeAvailableDatagram();
             } else {
               available = nativeAvailable();
             }
@@ -1529,11 +1628,14 @@ class _NativeSocket extends _NativeSocketNativeWrapper with _ServiceObject {
   int nativeAvailable() native "Socket_Available";
   bool nativeAvailableDatagram() native "Socket_AvailableDatagram";
   Uint8List? nativeRead(int len) native "Socket_Read";
-  Datagram? nativeRecvFrom() native "Socket_RecvFrom";
+  List<Object?>? nativeRecvFromBatch(int count) native "Socket_RecvFromBatch";
   int nativeWrite(List<int> buffer, int offset, int bytes)
       native "Socket_WriteList";
   int nativeSendTo(List<int> buffer, int offset, int bytes, Uint8List address,
       int port) native "Socket_SendTo";
+  int nativeWriteVector(List<Object> buffers) native "Socket_WriteVector";
+  int? nativeSendFile(int pointer, int position, int count)
+      native "Socket_SendFile";
   nativeCreateConnect(Uint8List addr, int port, int scope_id)
       native "Socket_CreateConnect";
   nativeCreateUnixDomainConnect(String addr, _Namespace namespace)
@@ -1897,39 +1999,109 @@ class Socket {
 }
 
 class _SocketStreamConsumer extends StreamConsumer<List<int>> {
+  // The most bytes of a file sent before yielding to other events.
+  static const int _maxFileBytesPerTurn = 64 * 1024 * 1024;
+
+  // The size of the blocks in which files that cannot be sent with sendfile
+  // are read.
+  static const int _readBlockSize = 64 * 1024;
+
+  // The most buffers written with a single call to writev.
+  static const int _maxWriteVectorCount = 64;
+
   StreamSubscription? subscription;
   final _Socket socket;
-  int? offset;
-  List<int>? buffer;
+  // Buffers added but not yet written, the first one from [offset]. Buffers
+  // added in the same turn are written together in a microtask.
+  final List<List<int>> buffers = <List<int>>[];
+  int offset = 0;
+  bool flushScheduled = false;
+  bool streamDone = false;
   bool paused = false;
   Completer<Socket>? streamCompleter;
 
+  // The file being sent with sendfile, its position and end.
+  _RandomAccessFile? file;
+  int filePosition = 0;
+  int? fileEnd;
+
   _SocketStreamConsumer(this.socket);
 
   Future<Socket> addStream(Stream<List<int>> stream) {
     socket._ensureRawSocketSubscription();
     final completer = streamCompleter = new Completer<Socket>();
+    if (stream is _FileStream && _canSendFile(stream)) {
+      _addFileStream(stream);
+    } else {
+      _listen(stream);
+    }
+    return completer.future;
+  }
+
+  void _listen(Stream<List<int>> stream) {
     if (socket._raw != null) {
+      streamDone = false;
       subscription = stream.listen((data) {
         assert(!paused);
-        assert(buffer == null);
-        buffer = data;
-        offset = 0;
-        try {
-          write();
-        } catch (e) {
-          socket.destroy();
-          stop();
-          done(e);
+        buffers.add(data);
+        if (buffers.length >= _maxWriteVectorCount) {
+          _flush();
+        } else if (!flushScheduled) {
+          flushScheduled = true;
+          scheduleMicrotask(() {
+            flushScheduled = false;
+            _flush();
+          });
         }
       }, onError: (error, [stackTrace]) {
-        socket.destroy();
-        done(error, stackTrace);
+        _fail(error, stackTrace);
       }, onDone: () {
-        done();
+        streamDone = true;
+        if (buffers.isEmpty) {
+          done();
+        } else {
+          _flush();
+        }
       }, cancelOnError: true);
     }
-    return completer.future;
+  }
+
+  // Files read with File.openRead are sent by the kernel instead of being
+  // read into Dart and written to the socket.
+  bool _canSendFile(_FileStream stream) =>
+      stream._path != null &&
+      socket._raw is _RawSocket &&
+      (Platform.isLinux || Platform.isAndroid);
+
+  void _addFileStream(_FileStream stream) {
+    final start = stream._position;
+    final end = stream._end;
+    if (start < 0) {
+      done(new RangeError("Bad start position: $start"));
+      return;
+    }
+    if (end != null && end < start) {
+      done(new RangeError("Bad end position: $end"));
+      return;
+    }
+    new File(stream._path!).open().then((RandomAccessFile opened) {
+      if (streamCompleter == null) {
+        // The socket was closed while the file was being opened.
+        opened.close().catchError((_) {});
+        return;
+      }
+      if (opened is! _RandomAccessFile) {
+        // Files of IOOverrides are read through their own implementation.
+        _listen(_readFile(opened, start, end));
+        return;
+      }
+      file = opened;
+      filePosition = start;
+      fileEnd = end;
+      write();
+    }, onError: (e, s) {
+      _fail(e, s);
+    });
   }
 
   Future<Socket> close() {
@@ -1937,28 +2109,147 @@ class _SocketStreamConsumer extends StreamConsumer<List<int>> {
     return new Future.value(socket);
   }
 
+  void _flush() {
+    try {
+      write();
+    } catch (e, s) {
+      _fail(e, s);
+    }
+  }
+
+  // Destroys the socket after writing to it or reading the stream failed.
+  // The buffers not written yet are dropped rather than written to the
+  // socket being torn down.
+  void _fail(error, [stackTrace]) {
+    buffers.clear();
+    offset = 0;
+    socket.destroy();
+    stop();
+    done(error, stackTrace);
+  }
+
   void write() {
+    if (file != null) {
+      _writeFile();
+      return;
+    }
     final sub = subscription;
     if (sub == null) return;
     // Write as much as possible.
-    offset =
-        offset! + socket._write(buffer!, offset!, buffer!.length - offset!);
-    if (offset! < buffer!.length) {
+    while (buffers.isNotEmpty) {
+      final count = min(buffers.length, _maxWriteVectorCount);
+      int length = -offset;
+      for (int i = 0; i < count; i++) {
+        length += buffers[i].length;
+      }
+      final written = socket._writeList(buffers, offset, count);
+      // Drop the buffers which have been written completely.
+      offset += written;
+      int i = 0;
+      while (i < buffers.length && offset >= buffers[i].length) {
+        offset -= buffers[i].length;
+        i++;
+      }
+      buffers.removeRange(0, i);
+      if (written < length) break;
+    }
+    if (buffers.isNotEmpty) {
       if (!paused) {
         paused = true;
         sub.pause();
       }
       socket._enableWriteEvent();
     } else {
-      buffer = null;
+      offset = 0;
       if (paused) {
         paused = false;
         sub.resume();
       }
+      if (streamDone) done();
+    }
+  }
+
+  void _writeFile() {
+    final rawSocket = socket._raw;
+    if (rawSocket is! _RawSocket) {
+      _closeFile();
+      return;
+    }
+    try {
+      int sent = 0;
+      while (true) {
+        final end = fileEnd;
+        if (end != null && filePosition >= end) break;
+        final count = end == null
+            ? _maxFileBytesPerTurn
+            : min(end - filePosition, _maxFileBytesPerTurn);
+        final result = rawSocket._socket.sendFile(file!, filePosition, count);
+        if (result == null) {
+          socket._enableWriteEvent();
+          return;
+        }
+        if (result < 0) {
+          _copyFile();
+          return;
+        }
+        if (result == 0) break;
+        filePosition += result;
+        sent += result;
+        if (sent >= _maxFileBytesPerTurn) {
+          // Let other events run before sending more.
+          Timer.run(() {
+            if (file != null) _writeFile();
+          });
+          return;
+        }
+      }
+    } catch (e, s) {
+      _fail(e, s);
+      return;
+    }
+    _closeFile();
+    done();
+  }
+
+  // Reads the rest of a file which the kernel cannot send, e.g. a pipe, and
+  // writes it to the socket like any other stream. The opened file is read
+  // rather than opened again, which would lose the data of a pipe.
+  void _copyFile() {
+    final opened = file!;
+    file = null;
+    _listen(_readFile(opened, filePosition, fileEnd));
+  }
+
+  static Stream<List<int>> _readFile(
+      RandomAccessFile file, int position, int? end) async* {
+    try {
+      if (position > 0) await file.setPosition(position);
+      while (end == null || position < end) {
+        final count = end == null
+            ? _readBlockSize
+            : min(end - position, _readBlockSize);
+        final data = await file.read(count);
+        if (data.isEmpty) break;
+        position += data.length;
+        yield data;
+      }
+    } finally {
+      await file.close().catchError((_) {});
+    }
+  }
+
+  void _closeFile() {
+    final opened = file;
+    if (opened != null) {
+      file = null;
+      opened.close().catchError((_) {});
     }
   }
 
   void done([error, stackTrace]) {
+    _closeFile();
+    buffers.clear();
+    offset = 0;
     final completer = streamCompleter;
     if (completer != null) {
       if (error != null) {
@@ -1971,6 +2262,19 @@ class _SocketStreamConsumer extends StreamConsumer<List<int>> {
   }
 
   void stop() {
+    _closeFile();
+    if (buffers.isNotEmpty && !paused) {
+      // The socket is destroyed by the user. Write the buffers added in this
+      // turn, which would have been written when they were added if they were
+      // not batched.
+      try {
+        write();
+      } catch (e, s) {
+        done(e, s);
+      }
+    }
+    buffers.clear();
+    offset = 0;
     final sub = subscription;
     if (sub == null) return;
     sub.cancel();
@@ -2112,7 +2416,7 @@ class _Socket extends Stream<Uint8List> implements Socket {
     _detachReady = new Completer();
     _sink.close();
     return _detachReady.future.then((_) {
-      assert(_consumer.buffer == null);
+      assert(_consumer.buffers.isEmpty);
       var raw = _raw;
       _raw = null;
       return [raw, _subscription];
@@ -2191,12 +2495,25 @@ class _Socket extends Stream<Uint8List> implements Socket {
     _consumer.done(error, stackTrace);
   }
 
-  int _write(List<int> data, int offset, int length) {
+  // Writes [count] buffers, the first one from [offset], and returns the
+  // number of bytes written.
+  int _writeList(List<List<int>> buffers, int offset, int count) {
     final raw = _raw;
+    if (raw is _RawSocket) {
+      return raw._socket.writeList(buffers, offset, count);
+    }
+    // Secure sockets write the buffers one at a time.
+    int written = 0;
     if (raw != null) {
-      return raw.write(data, offset, length);
+      for (int i = 0; i < count; i++) {
+        final start = (i == 0) ? offset : 0;
+        final length = buffers[i].length - start;
+        final result = raw.write(buffers[i], start, length);
+        written += result;
+        if (result < length) break;
+      }
     }
-    return 0;
+    return written;
   }
 
   void _enableWriteEvent() {
@@ -2378,7 +2695,6 @@ class _RawDatagramSocket extends Stream<RawSocketEvent>
   void setRawOption(RawSocketOption option) => _socket.setRawOption(option);
 }
 
-@pragma("vm:entry-point", "call")
 Datagram _makeDatagram(
     Uint8List data, String address, Uint8List in_addr, int port, int type) {
   return new Datagram(
@@ -11,6 +11,7 @@
 // VMOptions=--short_socket_read
 // VMOptions=--short_socket_write
 // VMOptions=--short_socket_read --short_socket_write
+// VMOptions=--event_handler_threads=4
 
 library ServerTest;
 
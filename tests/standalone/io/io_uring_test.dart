@@ -0,0 +1,99 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+//
+// Tests the reads, writes and flushes of RandomAccessFile with the io_uring
+// backend, including writes which the kernel only partially performs.
+
+import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
+
+import "package:expect/expect.dart";
+
+Future<void> expectFileSystemException(Future future) async {
+  try {
+    await future;
+  } on FileSystemException {
+    return;
+  }
+  Expect.fail('Expected a FileSystemException');
+}
+
+Future<void> readWriteFlush(Directory dir) async {
+  final data = Uint8List(1 << 20);
+  for (int i = 0; i < data.length; i++) {
+    data[i] = i % 251;
+  }
+
+  final file = File("${dir.path}${Platform.pathSeparator}file");
+  var raf = await file.open(mode: FileMode.write);
+  await raf.writeFrom(data, 1, data.length - 1);
+  await raf.writeFrom(data, 0, 1);
+  await raf.writeFrom(data, 0, 0);
+  await raf.flush();
+  Expect.equals(data.length, await raf.position());
+  Expect.equals(data.length, await raf.length());
+
+  await raf.setPosition(0);
+  final read = await raf.read(data.length);
+  Expect.listEquals(data.sublist(1), read.sublist(0, data.length - 1));
+  Expect.equals(data[0], read[data.length - 1]);
+
+  await raf.setPosition(1);
+  final buffer = Uint8List(1000);
+  Expect.equals(buffer.length, await raf.readInto(buffer));
+  Expect.listEquals(data.sublist(2, 1002), buffer);
+  await raf.setPosition(data.length - 10);
+  Expect.equals(10, await raf.readInto(buffer));
+  Expect.equals(0, (await raf.read(10)).length);
+  await raf.close();
+
+  // Errors are reported by the kernel.
+  raf = await file.open(mode: FileMode.writeOnly);
+  await expectFileSystemException(raf.read(10));
+  await expectFileSystemException(raf.readInto(buffer));
+  await raf.close();
+  raf = await file.open(mode: FileMode.read);
+  await expectFileSystemException(raf.writeFrom(data));
+  await raf.close();
+}
+
+Future<void> child() async {
+  final dir = Directory.systemTemp.createTempSync('dart_io_uring');
+  try {
+    await readWriteFlush(dir);
+  } finally {
+    dir.deleteSync(recursive: true);
+  }
+}
+
+Future<void> runChild(List<String> options) async {
+  final result = await Process.run(Platform.executable, [
+    ...Platform.executableArguments,
+    '--force_io_uring',
+    ...options,
+    Platform.script.toFilePath(),
+    'child',
+  ]);
+  if (result.exitCode != 0 &&
+      result.stderr.contains('io_uring is not available')) {
+    print('Skipping $options: io_uring is not available.');
+    return;
+  }
+  if (result.exitCode != 0) {
+    print(result.stdout);
+    print(result.stderr);
+  }
+  Expect.equals(0, result.exitCode);
+}
+
+main(List<String> args) async {
+  if (args.contains('child')) {
+    await child();
+    return;
+  }
+  if (!Platform.isLinux) return;
+  await runChild([]);
+  await runChild(['--short_io_uring_write']);
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Tests that a burst of datagrams, which are received in batches, is received
+// in order and with the data of each datagram, also when the subscription is
+// paused while datagrams of a batch are still queued.
+
+import "dart:async";
+import "dart:io";
+import "dart:typed_data";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+const int count = 100;
+
+Future receiveBurst({bool pause: false}) async {
+  var address = InternetAddress.loopbackIPv4;
+  var sender = await RawDatagramSocket.bind(address, 0);
+  var receiver = await RawDatagramSocket.bind(address, 0);
+  var completer = new Completer();
+
+  int received = 0;
+  var sub;
+  sub = receiver.listen((event) {
+    if (event != RawSocketEvent.read) return;
+    var datagram = receiver.receive();
+    if (datagram == null) return;
+    Expect.equals(received % 50 + 1, datagram.data.length);
+    Expect.equals(received % 256, datagram.data[0]);
+    Expect.equals(datagram.data.length, datagram.data.buffer.lengthInBytes);
+    Expect.equals(sender.port, datagram.port);
+    received++;
+    if (received == count) {
+      receiver.close();
+      sub.cancel();
+      completer.complete();
+    } else if (pause && received % 10 == 0) {
+      // The rest of the batch must still be delivered after resuming,
+      // although no more datagrams arrive.
+      sub.pause();
+      Timer.run(sub.resume);
+    }
+  });
+
+  // Send the datagrams before they are received, so that several of them are
+  // available at once.
+  for (int i = 0; i < count; i++) {
+    var data = new Uint8List(i % 50 + 1);
+    data[0] = i % 256;
+    Expect.equals(data.length, sender.send(data, address, receiver.port));
+  }
+  sender.close();
+  await completer.future;
+}
+
+main() async {
+  asyncStart();
+  await receiveBurst();
+  await receiveBurst(pause: true);
+  asyncEnd();
+}
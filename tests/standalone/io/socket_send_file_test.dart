@@ -0,0 +1,144 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Tests piping files to sockets, which is done with sendfile where it is
+// available, including ranges of files and data written before the file, and
+// files which are copied instead, like pipes and files of IOOverrides.
+//
+// VMOptions=
+// VMOptions=--short_socket_write
+
+import "dart:async";
+import "dart:io";
+import "dart:typed_data";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+const int fileSize = 3 * 1024 * 1024 + 17;
+
+Future<List<int>> receive(ServerSocket server) async {
+  var socket = await server.first;
+  var builder = new BytesBuilder(copy: false);
+  await for (var data in socket) {
+    builder.add(data);
+  }
+  return builder.takeBytes();
+}
+
+// A RandomAccessFile of IOOverrides, which cannot be sent with sendfile.
+class OverriddenRandomAccessFile implements RandomAccessFile {
+  final RandomAccessFile file;
+
+  OverriddenRandomAccessFile(this.file);
+
+  Future<Uint8List> read(int count) => file.read(count);
+
+  Future<RandomAccessFile> setPosition(int position) async {
+    await file.setPosition(position);
+    return this;
+  }
+
+  Future<void> close() => file.close();
+
+  noSuchMethod(Invocation invocation) => super.noSuchMethod(invocation);
+}
+
+class OverriddenFile implements File {
+  final File file;
+
+  // Files created outside of the IOOverrides zone are not overridden.
+  OverriddenFile(String path) : file = Zone.root.run(() => new File(path));
+
+  Future<RandomAccessFile> open({FileMode mode = FileMode.read}) async =>
+      new OverriddenRandomAccessFile(await file.open(mode: mode));
+
+  noSuchMethod(Invocation invocation) => super.noSuchMethod(invocation);
+}
+
+Future<List<int>> send(
+    InternetAddress address, Future write(Socket socket)) async {
+  var server = await ServerSocket.bind(address, 0);
+  var received = receive(server);
+  var socket = await Socket.connect(address, server.port);
+  await write(socket);
+  await socket.close();
+  var result = await received;
+  await server.close();
+  return result;
+}
+
+main() async {
+  asyncStart();
+  var tempDir = Directory.systemTemp.createTempSync('dart_socket_send_file');
+  var file = new File("${tempDir.path}/data");
+  var content = new Uint8List(fileSize);
+  for (int i = 0; i < content.length; i++) {
+    content[i] = i & 0xff;
+  }
+  file.writeAsBytesSync(content);
+  var address = InternetAddress.loopbackIPv4;
+
+  // The whole file.
+  var received = await send(address, (socket) => file.openRead().pipe(socket));
+  Expect.listEquals(content, received);
+
+  // A range of the file.
+  received = await send(
+      address, (socket) => socket.addStream(file.openRead(1000, 70000)));
+  Expect.listEquals(content.sublist(1000, 70000), received);
+
+  // From a position to the end of the file.
+  received = await send(
+      address, (socket) => socket.addStream(file.openRead(fileSize - 10)));
+  Expect.listEquals(content.sublist(fileSize - 10), received);
+
+  // Data written before and after the file.
+  received = await send(address, (socket) async {
+    socket.add([1, 2, 3]);
+    await socket.addStream(file.openRead(0, 5));
+    socket.add([4, 5]);
+  });
+  Expect.listEquals([1, 2, 3, 0, 1, 2, 3, 4, 4, 5], received);
+
+  // An empty file.
+  var empty = new File("${tempDir.path}/empty")..createSync();
+  received =
+      await send(address, (socket) => socket.addStream(empty.openRead()));
+  Expect.listEquals([], received);
+
+  // A file of IOOverrides.
+  var stream = file.openRead(1000, 70000);
+  received = await send(
+      address,
+      (socket) => IOOverrides.runZoned(() => socket.addStream(stream),
+          createFile: (path) => new OverriddenFile(path)));
+  Expect.listEquals(content.sublist(1000, 70000), received);
+
+  // A pipe, which sendfile does not support.
+  if (Platform.isLinux) {
+    var fifo = "${tempDir.path}/fifo";
+    Expect.equals(0, Process.runSync("mkfifo", [fifo]).exitCode);
+    var writer = await Process.start("sh", ["-c", "printf hello > \$0", fifo]);
+    received = await send(
+        address, (socket) => socket.addStream(new File(fifo).openRead()));
+    Expect.listEquals("hello".codeUnits, received);
+    Expect.equals(0, await writer.exitCode);
+  }
+
+  // A file which does not exist.
+  var missing = new File("${tempDir.path}/missing");
+  var server = await ServerSocket.bind(address, 0);
+  server.listen((socket) => socket.listen(null, onError: (_) {}));
+  var socket = await Socket.connect(address, server.port);
+  try {
+    await socket.addStream(missing.openRead());
+    Expect.fail("Expected a FileSystemException");
+  } on FileSystemException catch (_) {}
+  socket.destroy();
+  await server.close();
+
+  tempDir.deleteSync(recursive: true);
+  asyncEnd();
+}
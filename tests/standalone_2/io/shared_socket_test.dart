@@ -6,6 +6,7 @@
 
 // VMOptions=--enable-isolate-groups --experimental-enable-isolate-groups-jit
 // VMOptions=--no-enable-isolate-groups
+// VMOptions=--no-enable-isolate-groups --event_handler_threads=4
 
 import 'dart:async';
 import 'dart:io';
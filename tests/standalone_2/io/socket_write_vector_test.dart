@@ -0,0 +1,76 @@
+// Copyright (c) 2021, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// @dart = 2.9
+
+// Tests that many small buffers added to a socket, which are written together
+// with writev, arrive in order, including views, plain lists and buffers
+// added more than once.
+//
+// VMOptions=
+// VMOptions=--short_socket_write
+
+import "dart:async";
+import "dart:io";
+import "dart:typed_data";
+
+import "package:async_helper/async_helper.dart";
+import "package:expect/expect.dart";
+
+main() async {
+  asyncStart();
+  var server = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+  var received = server.first.then((socket) async {
+    var builder = new BytesBuilder(copy: false);
+    await for (var data in socket) {
+      builder.add(data);
+    }
+    return builder.takeBytes();
+  });
+
+  var socket = await Socket.connect(InternetAddress.loopbackIPv4, server.port);
+  var expected = <int>[];
+  var shared = new Uint8List.fromList([7, 8, 9]);
+  var backing = new Uint8List(256);
+  for (int i = 0; i < backing.length; i++) {
+    backing[i] = i;
+  }
+  for (int i = 0; i < 1000; i++) {
+    List<int> data;
+    switch (i % 5) {
+      case 0:
+        data = new Uint8List.fromList([i & 0xff, (i >> 8) & 0xff]);
+        break;
+      case 1:
+        data = new Uint8List.view(backing.buffer, i % 200, i % 50);
+        break;
+      case 2:
+        data = [1, 2, 3, i & 0xff];
+        break;
+      case 3:
+        data = shared;
+        break;
+      default:
+        data = new Uint8List(0);
+    }
+    socket.add(data);
+    expected.addAll(data);
+    // Let some of the buffers be written before adding more.
+    if (i % 97 == 0) await new Future.delayed(Duration.zero);
+  }
+  // A large buffer after many small ones.
+  var large = new Uint8List(1024 * 1024);
+  for (int i = 0; i < large.length; i++) {
+    large[i] = i & 0xff;
+  }
+  socket.add(large);
+  expected.addAll(large);
+  socket.add([42]);
+  expected.add(42);
+  await socket.close();
+
+  Expect.listEquals(expected, await received);
+  await server.close();
+  asyncEnd();
+}